@@ -46,6 +46,8 @@ namespace Game {
 		this->world = NULL;
 		this->
 			pauseNetworkCommands = false;
+		this->replayCommandIndex = 0;
+		this->replayFastForwardFrame = -1;
 	}
 
 	Commander::~
@@ -708,34 +710,30 @@ namespace Game {
 		Commander::getReplayCommandListForFrame(int worldFrameCount) {
 		bool
 			haveReplyCommands = false;
-		if (replayCommandList.empty() == false) {
+		if (replayCommandIndex < replayCommandList.size()) {
 			if (SystemFlags::VERBOSE_MODE_ENABLED)
 				printf("worldFrameCount = %d replayCommandList.size() = "
 					SIZE_T_SPECIFIER "\n", worldFrameCount,
-					replayCommandList.size());
-
-			std::vector < NetworkCommand > replayList;
-			for (unsigned int i = 0; i < replayCommandList.size(); ++i) {
-				std::pair < int,
-					NetworkCommand > &
-					cmd = replayCommandList[i];
-				if (cmd.first <= worldFrameCount) {
-					replayList.push_back(cmd.second);
-					haveReplyCommands = true;
-				}
+					replayCommandList.size() - replayCommandIndex);
+
+			// The list is in frame order so only the front is due
+			unsigned int
+				endIndex = replayCommandIndex;
+			while (endIndex < replayCommandList.size()
+				&& replayCommandList[endIndex].first <= worldFrameCount) {
+				endIndex++;
 			}
-			if (haveReplyCommands == true) {
-				replayCommandList.erase(replayCommandList.begin(),
-					replayCommandList.begin() +
-					replayList.size());
+			if (endIndex > replayCommandIndex) {
+				haveReplyCommands = true;
 
 				if (SystemFlags::VERBOSE_MODE_ENABLED)
 					printf
 					("worldFrameCount = %d GIVING COMMANDS replayList.size() = "
-						SIZE_T_SPECIFIER "\n", worldFrameCount,
-						replayList.size());
-				for (int i = 0; i < (int) replayList.size(); ++i) {
-					giveNetworkCommand(&replayList[i]);
+						"%u\n", worldFrameCount,
+						endIndex - replayCommandIndex);
+				for (; replayCommandIndex < endIndex; ++replayCommandIndex) {
+					giveNetworkCommand(&replayCommandList[replayCommandIndex].
+						second);
 				}
 				GameNetworkInterface *
 					gameNetworkInterface =
@@ -748,14 +746,23 @@ namespace Game {
 
 	bool
 		Commander::hasReplayCommandListForFrame() const {
-		return (replayCommandList.empty() == false);
+		if (isReplayPlaying() == false) {
+			return false;
+		}
+		return (replayFastForwardFrame < 0 || world == NULL
+			|| world->getFrameCount() < replayFastForwardFrame);
 	}
 
 	int
 		Commander::getReplayCommandListForFrameCount() const {
 		return (int)
-			replayCommandList.
-			size();
+			(replayCommandList.
+				size() - replayCommandIndex);
+	}
+
+	bool
+		Commander::isReplayPlaying() const {
+		return (replayCommandIndex < replayCommandList.size());
 	}
 
 	void
@@ -798,6 +805,15 @@ namespace Game {
 					//update the keyframe
 					gameNetworkInterface->updateKeyframe(world->
 						getFrameCount());
+
+					// The server may announce a new keyframe spacing with
+					// this keyframe, it applies from the next frame on
+					int
+						networkFramePeriod =
+						gameNetworkInterface->takeNetworkFramePeriodChange();
+					if (networkFramePeriod > 0) {
+						gameSettings->setNetworkFramePeriod(networkFramePeriod);
+					}
 					if (SystemFlags::
 						getSystemSettingType(SystemFlags::debugPerformance).
 						enabled && perfTimer.getMillis() > 0)
@@ -79,6 +79,13 @@ namespace Game {
 			std::pair < int,
 			NetworkCommand > >
 			replayCommandList;
+		// Next command to give, commands before it were already played
+		unsigned int
+			replayCommandIndex;
+		// Frame up to which replay commands are played as fast as
+		// possible, -1 plays all of them that way
+		int
+			replayFastForwardFrame;
 
 		bool
 			pauseNetworkCommands;
@@ -114,6 +121,12 @@ namespace Game {
 			hasReplayCommandListForFrame() const;
 		int
 			getReplayCommandListForFrameCount() const;
+		bool
+			isReplayPlaying() const;
+		void
+			setReplayFastForwardFrame(int frame) {
+			this->replayFastForwardFrame = frame;
+		}
 
 		std::pair <
 			CommandResult,
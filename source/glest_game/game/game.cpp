@@ -36,6 +36,8 @@
 #include "video_player.h"
 #include "compression_utils.h"
 #include "cache_manager.h"
+#include "virtual_file_system.h"
+#include "observer_relay.h"
 #include "conversion.h"
 #include "steam.h"
 #include "shared_const.h"
@@ -137,6 +139,8 @@ namespace Game {
 
 		highlightCellTexture = NULL;
 		lastMasterServerGameStatsDump = 0;
+		saveGameThread = NULL;
+		lastAutoSaveTime = 0;
 		lastMaxUnitCalcTime = 0;
 		lastRenderLog2d = 0;
 		playerIndexDisconnect = 0;
@@ -179,6 +183,8 @@ namespace Game {
 
 		loadGameNode = NULL;
 		lastworldFrameCountForReplay = -1;
+		lastReplayKeyframeFrame = 0;
+		replaySeekRequestFrame = -1;
 		lastNetworkPlayerConnectionCheck = time(NULL);
 		inJoinGameLoading = false;
 		quitGameCalled = false;
@@ -214,6 +220,8 @@ namespace Game {
 		lastRenderLog2d = 0;
 		playerIndexDisconnect = 0;
 		lastMasterServerGameStatsDump = 0;
+		saveGameThread = NULL;
+		lastAutoSaveTime = 0;
 		highlightCellTexture = NULL;
 		totalRenderFps = 0;
 		lastMaxUnitCalcTime = 0;
@@ -306,6 +314,8 @@ namespace Game {
 
 		loadGameNode = NULL;
 		lastworldFrameCountForReplay = -1;
+		lastReplayKeyframeFrame = 0;
+		replaySeekRequestFrame = -1;
 
 		lastNetworkPlayerConnectionCheck = time(NULL);
 
@@ -533,6 +543,14 @@ namespace Game {
 
 		quitGame();
 
+		if (saveGameThread != NULL) {
+			// Lets queued saves finish before the thread exits
+			if (saveGameThread->shutdownAndWait() == true) {
+				delete saveGameThread;
+			}
+			saveGameThread = NULL;
+		}
+
 		Object::setStateCallback(NULL);
 		thisGamePtr = NULL;
 		if (originalDisplayMsgCallback != NULL) {
@@ -2290,6 +2308,16 @@ namespace Game {
 				clientInterface->sendResumeGameMessage();
 				//this->initialResumeSpeedLoops = true;
 			}
+
+			// Viewers of a relay take over our slot, so only observers relay
+			int observerRelayPort =
+				Config::getInstance().getInt("ObserverRelayPort", "0");
+			if (clientInterface != NULL && observerRelayPort > 0
+				&& gameSettings.getFactionTypeName(gameSettings.
+					getThisFactionIndex()) ==
+				formatString(GameConstants::OBSERVER_SLOTNAME)) {
+				clientInterface->startObserverRelay(observerRelayPort);
+			}
 		}
 
 		printf("Game unique identifier is: %s\n",
@@ -2562,6 +2590,15 @@ namespace Game {
 	//update
 	void Game::update() {
 		try {
+			if (replaySeekRequestFrame >= 0) {
+				string seekFile = replayPlaybackFile;
+				int seekFrame = replaySeekRequestFrame;
+				replaySeekRequestFrame = -1;
+				// Replaces and deletes this game, nothing may touch it after
+				loadReplay(seekFile, seekFrame, program, masterserverMode);
+				return;
+			}
+
 			if (currentUIState != NULL) {
 				currentUIState->update();
 			}
@@ -2669,6 +2706,9 @@ namespace Game {
 			//console
 			console.update();
 
+			updateBackgroundSaves();
+			updateReplayKeyframes();
+
 			// b) Updates depandant on speed
 			int updateLoops = getUpdateLoops();
 
@@ -2918,7 +2958,7 @@ namespace Game {
 						}
 
 						//AiInterface
-						if (commander.hasReplayCommandListForFrame() == false) {
+						if (commander.isReplayPlaying() == false) {
 							chronoGamePerformanceCounts.start();
 
 							processNetworkSynchChecksIfRequired();
@@ -3170,6 +3210,7 @@ namespace Game {
 
 						if (pendingQuitError == false) {
 							commander.signalNetworkUpdate(this);
+							updateObserverRelay();
 						}
 
 						addPerformanceCount("ProcessNetworkUpdate",
@@ -3624,13 +3665,80 @@ namespace Game {
 								}
 							}
 
+							if (saveNetworkGame == true) {
+								// Joining clients that negotiated npfStreamedJoinSnapshot get
+								// the game streamed from memory over their game socket, the
+								// others still download the zipped save through FTP
+								bool streamSnapshot = false;
+								bool saveSnapshotFile = false;
+								for (int i = 0; i < world.getFactionCount(); ++i) {
+									Faction *faction = world.getFaction(i);
+
+									MutexSafeWrapper
+										safeMutex(server->getSlotMutex
+										(faction->getStartLocationIndex()),
+											CODE_AT_LINE);
+									ConnectionSlot *slot =
+										server->getSlot(faction->getStartLocationIndex(),
+											false);
+									if (slot != NULL
+										&& slot->getJoinGameInProgress() == true
+										&& slot->getSentSavedGameInfo() == false) {
+										if ((slot->getProtocolFeatures() & npfStreamedJoinSnapshot) != 0) {
+											streamSnapshot = true;
+										} else {
+											saveSnapshotFile = true;
+										}
+									}
+								}
+
+								if (streamSnapshot == true) {
+									Chrono chronoSnapshot;
+									chronoSnapshot.start();
+
+									std::vector<char> snapshot;
+									{
+										XmlTree xmlTree;
+										saveGameToXmlTree(xmlTree);
+										xmlTree.saveToBinary(snapshot);
+									}
+
+									for (int i = 0; i < world.getFactionCount(); ++i) {
+										Faction *faction = world.getFaction(i);
+
+										MutexSafeWrapper
+											safeMutex(server->getSlotMutex
+											(faction->getStartLocationIndex()),
+												CODE_AT_LINE);
+										ConnectionSlot *slot =
+											server->getSlot(faction->getStartLocationIndex(),
+												false);
+										if (slot != NULL
+											&& slot->getJoinGameInProgress() == true
+											&& slot->getSentSavedGameInfo() == false
+											&& (slot->getProtocolFeatures() & npfStreamedJoinSnapshot) != 0) {
+											slot->sendGameSnapshot(snapshot);
+											slot->setSentSavedGameInfo(true);
+										}
+									}
+
+									if (SystemFlags::VERBOSE_MODE_ENABLED)
+										printf
+										("Built join game snapshot of " SIZE_T_SPECIFIER " bytes in %lld msecs\n",
+											snapshot.size(), (long long int) chronoSnapshot.getMillis());
+								}
+								saveNetworkGame = saveSnapshotFile;
+							}
+
 							if (saveNetworkGame == true) {
 								//printf("Saved network game to disk\n");
 
+								// Clients without the streamed snapshot load
+								// this over FTP and only understand XML
 								string
 									file =
 									this->saveGame(GameConstants::saveNetworkGameFileServer,
-										"temp/");
+										"temp/", true);
 
 								string saveGameFilePath = "temp/";
 								string
@@ -4317,6 +4425,46 @@ namespace Game {
 		}
 	}
 
+	void Game::updateObserverRelay() {
+		NetworkManager & networkManager = NetworkManager::getInstance();
+		if (networkManager.getNetworkRole() != nrClient) {
+			return;
+		}
+		ClientInterface *clientInterface =
+			dynamic_cast <ClientInterface *>(networkManager.getClientInterface());
+		if (clientInterface == NULL) {
+			return;
+		}
+		ObserverRelay *observerRelay = clientInterface->getObserverRelay();
+
+		// Snapshots are only taken right after a keyframe's commands were
+		// given so viewers can pick up the stream with the next list
+		int frameCount = world.getFrameCount();
+		if (observerRelay == NULL
+			|| observerRelay->isSnapshotDue(frameCount) == false) {
+			return;
+		}
+
+		Chrono chronoSnapshot;
+		chronoSnapshot.start();
+
+		std::vector<char> snapshot;
+		{
+			XmlTree xmlTree;
+			saveGameToXmlTree(xmlTree);
+			xmlTree.saveToBinary(snapshot);
+		}
+		observerRelay->addSnapshot(frameCount, gameSettings, snapshot);
+
+		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).
+			enabled)
+			SystemFlags::OutputDebug(SystemFlags::debugNetwork,
+				"In [%s::%s Line: %d] relay snapshot for frame %d took %lld msecs\n",
+				extractFileFromDirectoryPath(__FILE__).c_str(),
+				__FUNCTION__, __LINE__, frameCount,
+				(long long int) chronoSnapshot.getMillis());
+	}
+
 	void Game::addOrReplaceInHighlightedCells(MarkedCell mc) {
 		if (mc.getFactionIndex() >= 0) {
 			for (int i = (int) highlightedCells.size() - 1; i >= 0; i--) {
@@ -6532,6 +6680,19 @@ namespace Game {
 				if (isKeyPressed(configKeys.getSDLKey("SaveGame"), key) == true) {
 					saveGame();
 				}
+
+				if (replayPlaybackFile != "") {
+					int seekSeconds =
+						Config::getInstance().getInt("ReplaySeekSeconds", "60");
+					if (isKeyPressed(configKeys.getSDLKey("ReplaySeekBack"), key) ==
+						true) {
+						requestReplaySeek(-seekSeconds);
+					} else
+						if (isKeyPressed
+						(configKeys.getSDLKey("ReplaySeekForward"), key) == true) {
+							requestReplaySeek(seekSeconds);
+						}
+				}
 			}
 		} catch (const exception & ex) {
 			char szBuf[8096] = "";
@@ -7478,6 +7639,9 @@ namespace Game {
 			str +=
 				"Triangle count: " + intToStr(renderer.getTriangleCount()) + "\n";
 			str += "Vertex count: " + intToStr(renderer.getPointCount()) + "\n";
+			str += "Texture residency: " + renderer.getTextureResidencyStats() + "\n";
+			str += "Sound cache: " + SoundRenderer::getInstance().getSoundCacheStats() + "\n";
+			str += "Data archives: " + VirtualFileSystem::getStats() + "\n";
 		}
 
 		str += "Frame count:" + intToStr(world.getFrameCount()) + "\n";
@@ -8649,103 +8813,11 @@ namespace Game {
 	}
 
 	void Game::saveGame() {
-		string file = this->saveGame(GameConstants::saveGameFilePattern);
-		char szBuf[8096] = "";
-		Lang & lang = Lang::getInstance();
-		snprintf(szBuf, 8096, lang.getString("GameSaved", "").c_str(),
-			file.c_str());
-		console.addLine(szBuf);
-
-		Config & config = Config::getInstance();
-		config.setString("LastSavedGame", file);
-		config.save();
+		// Reported on the console once the save thread has written it
+		this->saveGameInBackground(GameConstants::saveGameFilePattern);
 	}
 
-	string Game::saveGame(string name, const string & path) {
-		Config & config = Config::getInstance();
-		// auto name file if using saved file pattern string
-		if (name == GameConstants::saveGameFilePattern) {
-			//time_t curTime = time(NULL);
-			//struct tm *loctime = localtime (&curTime);
-			struct tm loctime = threadsafe_localtime(systemtime_now());
-			char szBuf2[100] = "";
-			strftime(szBuf2, 100, "%Y%m%d_%H%M%S", &loctime);
-
-			char szBuf[8096] = "";
-			snprintf(szBuf, 8096, name.c_str(), szBuf2);
-			name = szBuf;
-		} else if (name == GameConstants::saveGameFileAutoTestDefault) {
-			//time_t curTime = time(NULL);
-			//struct tm *loctime = localtime (&curTime);
-			struct tm loctime = threadsafe_localtime(systemtime_now());
-			char szBuf2[100] = "";
-			strftime(szBuf2, 100, "%Y%m%d_%H%M%S", &loctime);
-
-			char szBuf[8096] = "";
-			snprintf(szBuf, 8096, name.c_str(), szBuf2);
-			name = szBuf;
-		}
-
-		// Save the file now
-		string saveGameFile = path + name;
-		if (getGameReadWritePath(GameConstants::path_logs_CacheLookupKey) !=
-			"") {
-			saveGameFile =
-				getGameReadWritePath(GameConstants::path_logs_CacheLookupKey) +
-				saveGameFile;
-		} else {
-			string userData = config.getString("UserData_Root", "");
-			if (userData != "") {
-				endPathWithSlash(userData);
-			}
-			saveGameFile = userData + saveGameFile;
-		}
-		if (SystemFlags::VERBOSE_MODE_ENABLED)
-			printf("Saving game to [%s]\n", saveGameFile.c_str());
-
-		// This condition will re-play all the commands from a replay file
-		// INSTEAD of saving from a saved game.
-		if (config.getBool("SaveCommandsForReplay", "false") == true) {
-			std::map < string, string > mapTagReplacements;
-			XmlTree xmlTreeSaveGame(XML_RAPIDXML_ENGINE);
-
-			xmlTreeSaveGame.init("zetaglest-saved-game");
-			XmlNode *rootNodeReplay = xmlTreeSaveGame.getRootNode();
-
-			//std::map<string,string> mapTagReplacements;
-			//time_t now = time(NULL);
-			//struct tm *loctime = localtime (&now);
-			struct tm loctime = threadsafe_localtime(systemtime_now());
-			char szBuf[4096] = "";
-			strftime(szBuf, 4095, "%Y-%m-%d %H:%M:%S", &loctime);
-
-			rootNodeReplay->addAttribute("version", GameVersionString,
-				mapTagReplacements);
-			rootNodeReplay->addAttribute("timestamp", szBuf, mapTagReplacements);
-
-			XmlNode *gameNodeReplay = rootNodeReplay->addChild("Game");
-			gameSettings.saveGame(gameNodeReplay);
-
-			gameNodeReplay->addAttribute("LastWorldFrameCount",
-				intToStr(world.getFrameCount()),
-				mapTagReplacements);
-
-			for (unsigned int i = 0; i < replayCommandList.size(); ++i) {
-				std::pair < int, NetworkCommand > & cmd = replayCommandList[i];
-				XmlNode *networkCommandNode = cmd.second.saveGame(gameNodeReplay);
-				networkCommandNode->addAttribute("worldFrameCount",
-					intToStr(cmd.first),
-					mapTagReplacements);
-			}
-
-			string replayFile = saveGameFile + ".replay";
-			if (SystemFlags::VERBOSE_MODE_ENABLED)
-				printf("Saving game replay commands to [%s]\n",
-					replayFile.c_str());
-			xmlTreeSaveGame.save(replayFile);
-		}
-
-		XmlTree xmlTree;
+	void Game::saveGameToXmlTree(XmlTree & xmlTree) {
 		xmlTree.init("zetaglest-saved-game");
 		XmlNode *rootNode = xmlTree.getRootNode();
 
@@ -8946,9 +9018,173 @@ namespace Game {
 		gameNode->addAttribute("disableSpeedChange",
 			intToStr(disableSpeedChange),
 			mapTagReplacements);
+	}
+
+	string Game::getSaveGameFile(string name, const string & path) {
+		Config & config = Config::getInstance();
+		// auto name file if using saved file pattern string
+		if (name == GameConstants::saveGameFilePattern) {
+			//time_t curTime = time(NULL);
+			//struct tm *loctime = localtime (&curTime);
+			struct tm loctime = threadsafe_localtime(systemtime_now());
+			char szBuf2[100] = "";
+			strftime(szBuf2, 100, "%Y%m%d_%H%M%S", &loctime);
+
+			char szBuf[8096] = "";
+			snprintf(szBuf, 8096, name.c_str(), szBuf2);
+			name = szBuf;
+		} else if (name == GameConstants::saveGameFileAutoTestDefault) {
+			//time_t curTime = time(NULL);
+			//struct tm *loctime = localtime (&curTime);
+			struct tm loctime = threadsafe_localtime(systemtime_now());
+			char szBuf2[100] = "";
+			strftime(szBuf2, 100, "%Y%m%d_%H%M%S", &loctime);
+
+			char szBuf[8096] = "";
+			snprintf(szBuf, 8096, name.c_str(), szBuf2);
+			name = szBuf;
+		}
+
+		// Save the file now
+		string saveGameFile = path + name;
+		if (getGameReadWritePath(GameConstants::path_logs_CacheLookupKey) !=
+			"") {
+			saveGameFile =
+				getGameReadWritePath(GameConstants::path_logs_CacheLookupKey) +
+				saveGameFile;
+		} else {
+			string userData = config.getString("UserData_Root", "");
+			if (userData != "") {
+				endPathWithSlash(userData);
+			}
+			saveGameFile = userData + saveGameFile;
+		}
+		return saveGameFile;
+	}
+
+	void Game::saveReplayToXmlTree(XmlTree & xmlTreeSaveGame,
+		bool includeCommands) {
+		std::map < string, string > mapTagReplacements;
+
+		xmlTreeSaveGame.init("zetaglest-saved-game");
+		XmlNode *rootNodeReplay = xmlTreeSaveGame.getRootNode();
+
+		//std::map<string,string> mapTagReplacements;
+		//time_t now = time(NULL);
+		//struct tm *loctime = localtime (&now);
+		struct tm loctime = threadsafe_localtime(systemtime_now());
+		char szBuf[4096] = "";
+		strftime(szBuf, 4095, "%Y-%m-%d %H:%M:%S", &loctime);
+
+		rootNodeReplay->addAttribute("version", GameVersionString,
+			mapTagReplacements);
+		rootNodeReplay->addAttribute("timestamp", szBuf, mapTagReplacements);
+
+		XmlNode *gameNodeReplay = rootNodeReplay->addChild("Game");
+		gameSettings.saveGame(gameNodeReplay);
+
+		gameNodeReplay->addAttribute("LastWorldFrameCount",
+			intToStr(world.getFrameCount()),
+			mapTagReplacements);
+
+		for (unsigned int i = 0;
+			includeCommands == true && i < replayCommandList.size(); ++i) {
+			std::pair < int, NetworkCommand > & cmd = replayCommandList[i];
+			XmlNode *networkCommandNode = cmd.second.saveGame(gameNodeReplay);
+			networkCommandNode->addAttribute("worldFrameCount",
+				intToStr(cmd.first),
+				mapTagReplacements);
+		}
+	}
+
+	void Game::saveReplayToBuffer(std::vector < char >&buffer) {
+		collectReplayKeyframes(false);
 
-		xmlTree.save(saveGameFile);
+		XmlTree xmlTreeHeader(XML_RAPIDXML_ENGINE);
+		saveReplayToXmlTree(xmlTreeHeader, false);
+		std::vector < char >settingsData;
+		xmlTreeHeader.saveToBinary(settingsData);
 
+		ReplayFile::save(buffer, settingsData, world.getFrameCount(),
+			replayCommandList, replayKeyframeList);
+	}
+
+	void Game::startSaveGameThread() {
+		if (saveGameThread == NULL) {
+			saveGameThread = new SaveGameThread();
+			saveGameThread->start();
+		}
+	}
+
+	void Game::collectReplayKeyframes(bool waitForPending) {
+		if (saveGameThread == NULL) {
+			return;
+		}
+		// Without waiting a keyframe still being built is left out of
+		// this save, seeking then starts from the one before it
+		for (; waitForPending == true
+			&& saveGameThread->getPendingKeyframeCount() > 0;) {
+			sleep(1);
+		}
+		saveGameThread->getCompletedKeyframes(replayKeyframeList);
+	}
+
+	void Game::updateReplayKeyframes() {
+		collectReplayKeyframes(false);
+
+		Config & config = Config::getInstance();
+		if (gameStarted == false
+			|| config.getBool("SaveCommandsForReplay", "false") == false
+			|| config.getString("SaveGameFormat", "binary") == "xml"
+			|| commander.isReplayPlaying() == true) {
+			return;
+		}
+
+		int keyframeInterval =
+			config.getInt("ReplayKeyframeIntervalSeconds",
+				"300") * GameConstants::updateFps;
+		if (keyframeInterval <= 0
+			|| world.getFrameCount() < lastReplayKeyframeFrame + keyframeInterval) {
+			return;
+		}
+		lastReplayKeyframeFrame = world.getFrameCount();
+
+		Chrono chrono;
+		chrono.start();
+
+		// Only the tree is built here, the save thread serializes and
+		// compresses it into the keyframe
+		startSaveGameThread();
+		SaveGameThread::SaveJob job;
+		job.xmlTree = new XmlTree();
+		job.buffer = NULL;
+		saveGameToXmlTree(*job.xmlTree);
+		job.binaryFormat = false;
+		job.compressionLevel = 0;
+		job.announce = false;
+		job.replayKeyframe = true;
+		job.keyframeFrame = world.getFrameCount();
+		job.keyframeCommandIndex = (uint32) replayCommandList.size();
+		saveGameThread->queueSave(job);
+
+		if (SystemFlags::VERBOSE_MODE_ENABLED)
+			printf("Captured replay keyframe at frame %d in %lld msecs\n",
+				world.getFrameCount(), (long long int) chrono.getMillis());
+	}
+
+	void Game::requestReplaySeek(int seconds) {
+		int
+			seekFrame = world.getFrameCount() + seconds * GameConstants::updateFps;
+		if (seconds > 0) {
+			// Going forward only needs the commands already loaded
+			commander.setReplayFastForwardFrame(seekFrame);
+		} else {
+			replaySeekRequestFrame = max(0, seekFrame);
+		}
+	}
+
+	void Game::saveGameScreenshot(const string & saveGameFile) {
+		Config & config = Config::getInstance();
 		if (masterserverMode == false) {
 			// take Screenshot
 			string jpgFileName = saveGameFile + ".jpg";
@@ -8963,79 +9199,178 @@ namespace Game {
 				("SaveGameScreenshotHeight",
 					"600"));
 		}
-
-		return saveGameFile;
 	}
 
-	void
-		Game::loadGame(string name, Program * programPtr,
-			bool isMasterserverMode,
-			const GameSettings * joinGameSettings) {
+	string Game::saveGame(string name, const string & path, bool xmlFormat) {
 		Config & config = Config::getInstance();
+		if (config.getString("SaveGameFormat", "binary") == "xml") {
+			xmlFormat = true;
+		}
+		string saveGameFile = getSaveGameFile(name, path);
+		if (SystemFlags::VERBOSE_MODE_ENABLED)
+			printf("Saving game to [%s]\n", saveGameFile.c_str());
+
 		// This condition will re-play all the commands from a replay file
 		// INSTEAD of saving from a saved game.
-		if (joinGameSettings == NULL
-			&& config.getBool("SaveCommandsForReplay", "false") == true) {
-			XmlTree xmlTreeReplay(XML_RAPIDXML_ENGINE);
-			std::map < string, string > mapExtraTagReplacementValues;
-			xmlTreeReplay.load(name + ".replay",
-				Properties::getTagReplacementValues
-				(&mapExtraTagReplacementValues), true);
+		if (config.getBool("SaveCommandsForReplay", "false") == true) {
+			string replayFile = saveGameFile + ".replay";
+			if (SystemFlags::VERBOSE_MODE_ENABLED)
+				printf("Saving game replay commands to [%s]\n",
+					replayFile.c_str());
+			if (xmlFormat == true) {
+				XmlTree xmlTreeSaveGame(XML_RAPIDXML_ENGINE);
+				saveReplayToXmlTree(xmlTreeSaveGame);
+				xmlTreeSaveGame.save(replayFile);
+			} else {
+				std::vector < char >buffer;
+				collectReplayKeyframes(true);
+				saveReplayToBuffer(buffer);
+				SaveGameThread::writeBuffer(replayFile, buffer);
+			}
+		}
 
-			const XmlNode *rootNode = xmlTreeReplay.getRootNode();
+		XmlTree xmlTree;
+		saveGameToXmlTree(xmlTree);
+		// The chunked binary file is much smaller and quicker to write and
+		// read back, XML stays available for inspecting saves by hand
+		if (xmlFormat == true) {
+			xmlTree.save(saveGameFile);
+		} else {
+			xmlTree.saveToChunkedBinaryFile(saveGameFile,
+				config.getInt("SaveGameCompressionLevel", "1"));
+		}
 
-			if (rootNode->hasChild("zetaglest-saved-game") == true) {
-				rootNode = rootNode->getChild("zetaglest-saved-game");
-			}
+		saveGameScreenshot(saveGameFile);
 
-			//const XmlNode *versionNode= rootNode->getChild("zetaglest-saved-game");
-			const XmlNode *versionNode = rootNode;
+		return saveGameFile;
+	}
 
-			Lang & lang = Lang::getInstance();
-			string gameVer = versionNode->getAttribute("version")->getValue();
-			if (checkVersionCompatibility(gameVer, GameVersionString) == false) {
-				char szBuf[8096] = "";
-				snprintf(szBuf, 8096,
-					lang.getString("SavedGameBadVersion").c_str(),
-					gameVer.c_str(), GameVersionString.c_str());
-				throw game_runtime_error(szBuf, true);
+	string Game::saveGameInBackground(string name, const string & path,
+		bool announce, bool takeScreenshot) {
+		Config & config = Config::getInstance();
+		startSaveGameThread();
+
+		string saveGameFile = getSaveGameFile(name, path);
+		if (SystemFlags::VERBOSE_MODE_ENABLED)
+			printf("Saving game to [%s] in the background\n",
+				saveGameFile.c_str());
+
+		// Only capturing the state into the trees happens on the game
+		// thread, writing them out is left to the save thread
+		SaveGameThread::SaveJob job;
+		job.xmlTree = NULL;
+		job.buffer = NULL;
+		job.replayKeyframe = false;
+		if (config.getBool("SaveCommandsForReplay", "false") == true) {
+			if (config.getString("SaveGameFormat", "binary") == "xml") {
+				job.xmlTree = new XmlTree(XML_RAPIDXML_ENGINE);
+				saveReplayToXmlTree(*job.xmlTree);
+			} else {
+				job.buffer = new std::vector < char >();
+				saveReplayToBuffer(*job.buffer);
 			}
+			job.file = saveGameFile + ".replay";
+			job.binaryFormat = false;
+			job.compressionLevel = 0;
+			job.announce = false;
+			saveGameThread->queueSave(job);
+		}
 
-			if (SystemFlags::VERBOSE_MODE_ENABLED)
-				printf
-				("Found saved game version that matches your application version: [%s] --> [%s]\n",
-					gameVer.c_str(), GameVersionString.c_str());
+		job.buffer = NULL;
+		job.xmlTree = new XmlTree();
+		saveGameToXmlTree(*job.xmlTree);
+		job.file = saveGameFile;
+		job.binaryFormat =
+			(config.getString("SaveGameFormat", "binary") != "xml");
+		job.compressionLevel = config.getInt("SaveGameCompressionLevel", "1");
+		job.announce = announce;
+		saveGameThread->queueSave(job);
 
-			XmlNode *gameNode = rootNode->getChild("Game");
+		if (takeScreenshot == true) {
+			saveGameScreenshot(saveGameFile);
+		}
 
-			GameSettings newGameSettingsReplay;
-			newGameSettingsReplay.loadGame(gameNode);
-			//printf("Loading scenario [%s]\n",newGameSettingsReplay.getScenarioDir().c_str());
-			if (newGameSettingsReplay.getScenarioDir() != ""
-				&& fileExists(newGameSettingsReplay.getScenarioDir()) == false) {
-				newGameSettingsReplay.setScenarioDir(Scenario::getScenarioPath
-				(Config::
-					getInstance
-					().getPathListForType
-					(ptScenarios),
-					newGameSettingsReplay.getScenario
-					()));
+		return saveGameFile;
+	}
 
-				//printf("Loading scenario #2 [%s]\n",newGameSettingsReplay.getScenarioDir().c_str());
+	void Game::updateBackgroundSaves() {
+		Config & config = Config::getInstance();
+		int autoSaveInterval = config.getInt("AutoSaveIntervalSeconds", "0");
+		if (autoSaveInterval > 0 && gameStarted == true && gameOver == false
+			&& getPaused() == false) {
+			if (lastAutoSaveTime == 0) {
+				lastAutoSaveTime = time(NULL);
+			} else if (difftime((long int) time(NULL), lastAutoSaveTime) >=
+				autoSaveInterval) {
+				// Skip a turn rather than pile up saves on a slow disk
+				if (saveGameThread == NULL
+					|| saveGameThread->getPendingCount() == 0) {
+					lastAutoSaveTime = time(NULL);
+					saveGameInBackground(GameConstants::saveGameFileAutoSave,
+						"saved/", false, false);
+				}
 			}
+		}
 
-			//GameSettings newGameSettings;
-			//newGameSettings.loadGame(gameNode);
-			//if(SystemFlags::VERBOSE_MODE_ENABLED) printf("Game settings loaded\n");
+		if (saveGameThread == NULL) {
+			return;
+		}
+		vector < SaveGameThread::SaveResult > results;
+		saveGameThread->getCompletedSaves(results);
+		Lang & lang = Lang::getInstance();
+		for (unsigned int i = 0; i < results.size(); ++i) {
+			const SaveGameThread::SaveResult & result = results[i];
+			char szBuf[8096] = "";
+			if (result.succeeded == false) {
+				if (lang.hasString("GameSaveError") == true) {
+					snprintf(szBuf, 8096,
+						lang.getString("GameSaveError").c_str(),
+						result.error.c_str());
+				} else {
+					snprintf(szBuf, 8096, "Error saving game: %s",
+						result.error.c_str());
+				}
+				console.addLine(szBuf);
+				continue;
+			}
 
-			NetworkManager & networkManager = NetworkManager::getInstance();
-			networkManager.end();
-			networkManager.init(nrServer, true);
+			snprintf(szBuf, 8096, lang.getString("GameSaved", "").c_str(),
+				result.file.c_str());
+			console.addLine(szBuf);
+
+			config.setString("LastSavedGame", result.file);
+			config.save();
+		}
+	}
+
+	void
+		Game::loadGame(string name, Program * programPtr,
+			bool isMasterserverMode,
+			const GameSettings * joinGameSettings) {
+		Config & config = Config::getInstance();
+		// This condition will re-play all the commands from a replay file
+		// INSTEAD of saving from a saved game.
+		if (joinGameSettings == NULL
+			&& config.getBool("SaveCommandsForReplay", "false") == true) {
+			string replayFile = name + ".replay";
+			if (ReplayFile::isReplayFile(replayFile) == true) {
+				loadReplay(replayFile, -1, programPtr, isMasterserverMode);
+				return;
+			}
+
+			XmlTree xmlTreeReplay(XML_RAPIDXML_ENGINE);
+			std::map < string, string > mapExtraTagReplacementValues;
+			xmlTreeReplay.load(replayFile,
+				Properties::getTagReplacementValues
+				(&mapExtraTagReplacementValues), true);
 
 			Game *newGame =
-				new Game(programPtr, &newGameSettingsReplay, isMasterserverMode);
-			newGame->lastworldFrameCountForReplay =
-				gameNode->getAttribute("LastWorldFrameCount")->getIntValue();
+				createReplayGame(xmlTreeReplay, programPtr, isMasterserverMode);
+			XmlNode *gameNode = xmlTreeReplay.getRootNode();
+			if (gameNode->hasChild("zetaglest-saved-game") == true) {
+				gameNode = gameNode->getChild("zetaglest-saved-game");
+			}
+			gameNode = gameNode->getChild("Game");
 
 			vector < XmlNode * >networkCommandNodeList =
 				gameNode->getChildList("NetworkCommand");
@@ -9062,12 +9397,152 @@ namespace Game {
 		if (SystemFlags::VERBOSE_MODE_ENABLED)
 			printf("Before load of XML\n");
 		std::map < string, string > mapExtraTagReplacementValues;
-		xmlTree.load(name,
-			Properties::getTagReplacementValues
-			(&mapExtraTagReplacementValues), true);
+		if (XmlTree::isChunkedBinaryFile(name) == true) {
+			xmlTree.loadFromChunkedBinaryFile(name,
+				Properties::getTagReplacementValues
+				(&mapExtraTagReplacementValues));
+		} else {
+			xmlTree.load(name,
+				Properties::getTagReplacementValues
+				(&mapExtraTagReplacementValues), true);
+		}
 		if (SystemFlags::VERBOSE_MODE_ENABLED)
 			printf("After load of XML\n");
 
+		loadGameFromXmlTree(xmlTree, programPtr, isMasterserverMode, joinGameSettings);
+	}
+
+	Game *
+		Game::createReplayGame(const XmlTree & xmlTreeReplay,
+			Program * programPtr, bool isMasterserverMode) {
+		const XmlNode *rootNode = xmlTreeReplay.getRootNode();
+
+		if (rootNode->hasChild("zetaglest-saved-game") == true) {
+			rootNode = rootNode->getChild("zetaglest-saved-game");
+		}
+
+		//const XmlNode *versionNode= rootNode->getChild("zetaglest-saved-game");
+		const XmlNode *versionNode = rootNode;
+
+		Lang & lang = Lang::getInstance();
+		string gameVer = versionNode->getAttribute("version")->getValue();
+		if (checkVersionCompatibility(gameVer, GameVersionString) == false) {
+			char szBuf[8096] = "";
+			snprintf(szBuf, 8096,
+				lang.getString("SavedGameBadVersion").c_str(),
+				gameVer.c_str(), GameVersionString.c_str());
+			throw game_runtime_error(szBuf, true);
+		}
+
+		if (SystemFlags::VERBOSE_MODE_ENABLED)
+			printf
+			("Found saved game version that matches your application version: [%s] --> [%s]\n",
+				gameVer.c_str(), GameVersionString.c_str());
+
+		XmlNode *gameNode = rootNode->getChild("Game");
+
+		GameSettings newGameSettingsReplay;
+		newGameSettingsReplay.loadGame(gameNode);
+		//printf("Loading scenario [%s]\n",newGameSettingsReplay.getScenarioDir().c_str());
+		if (newGameSettingsReplay.getScenarioDir() != ""
+			&& fileExists(newGameSettingsReplay.getScenarioDir()) == false) {
+			newGameSettingsReplay.setScenarioDir(Scenario::getScenarioPath
+			(Config::
+				getInstance
+				().getPathListForType
+				(ptScenarios),
+				newGameSettingsReplay.getScenario
+				()));
+
+			//printf("Loading scenario #2 [%s]\n",newGameSettingsReplay.getScenarioDir().c_str());
+		}
+
+		//GameSettings newGameSettings;
+		//newGameSettings.loadGame(gameNode);
+		//if(SystemFlags::VERBOSE_MODE_ENABLED) printf("Game settings loaded\n");
+
+		NetworkManager & networkManager = NetworkManager::getInstance();
+		networkManager.end();
+		networkManager.init(nrServer, true);
+
+		Game *newGame =
+			new Game(programPtr, &newGameSettingsReplay, isMasterserverMode);
+		newGame->lastworldFrameCountForReplay =
+			gameNode->getAttribute("LastWorldFrameCount")->getIntValue();
+
+		return newGame;
+	}
+
+	void
+		Game::loadReplay(const string & replayFile, int seekFrame,
+			Program * programPtr, bool isMasterserverMode) {
+		Chrono chrono;
+		chrono.start();
+
+		ReplayFile replay;
+		replay.load(replayFile, seekFrame);
+
+		std::map < string, string > mapExtraTagReplacementValues;
+		Game *newGame = NULL;
+		if (replay.getKeyframeFrame() >= 0) {
+			// Start from the snapshot closest to the frame asked for and
+			// run the commands since then forward to it
+			const std::vector < char >&snapshot = replay.getKeyframeSnapshot();
+			XmlTree xmlTree(XML_RAPIDXML_ENGINE);
+			xmlTree.loadFromBinary(&snapshot[0], snapshot.size(),
+				Properties::getTagReplacementValues
+				(&mapExtraTagReplacementValues));
+			newGame =
+				loadGameFromXmlTree(xmlTree, programPtr, isMasterserverMode, NULL);
+		} else {
+			const std::vector < char >&settingsData = replay.getSettingsData();
+			XmlTree xmlTreeReplay(XML_RAPIDXML_ENGINE);
+			xmlTreeReplay.loadFromBinary(settingsData.empty() ? NULL :
+				&settingsData[0], settingsData.size(),
+				Properties::getTagReplacementValues
+				(&mapExtraTagReplacementValues));
+			newGame =
+				createReplayGame(xmlTreeReplay, programPtr, isMasterserverMode);
+			programPtr->setState(newGame);
+		}
+
+		newGame->lastworldFrameCountForReplay = replay.getLastWorldFrameCount();
+		newGame->replayPlaybackFile = replayFile;
+		newGame->commander.setReplayFastForwardFrame(seekFrame);
+		const std::vector < std::pair < int, NetworkCommand > >&commandList =
+			replay.getCommandList();
+		for (unsigned int i = 0; i < commandList.size(); ++i) {
+			NetworkCommand command = commandList[i].second;
+			newGame->commander.addToReplayCommandList(command,
+				commandList[i].first);
+		}
+
+		if (SystemFlags::VERBOSE_MODE_ENABLED)
+			printf("Loaded replay [%s] at frame %d from keyframe %d with "
+				SIZE_T_SPECIFIER " commands in %lld msecs\n",
+				replayFile.c_str(), seekFrame, replay.getKeyframeFrame(),
+				commandList.size(), (long long int) chrono.getMillis());
+	}
+
+	void
+		Game::loadGameFromSnapshot(const std::vector<char> &snapshot, Program * programPtr,
+			bool isMasterserverMode,
+			const GameSettings * joinGameSettings) {
+		XmlTree xmlTree(XML_RAPIDXML_ENGINE);
+		std::map < string, string > mapExtraTagReplacementValues;
+		xmlTree.loadFromBinary(snapshot.empty() ? NULL : &snapshot[0], snapshot.size(),
+			Properties::getTagReplacementValues
+			(&mapExtraTagReplacementValues));
+
+		// The new game reads loadGameNode while starting so the tree has to
+		// stay alive until setState returns
+		loadGameFromXmlTree(xmlTree, programPtr, isMasterserverMode, joinGameSettings);
+	}
+
+	Game *
+		Game::loadGameFromXmlTree(XmlTree & xmlTree, Program * programPtr,
+			bool isMasterserverMode,
+			const GameSettings * joinGameSettings) {
 		const XmlNode *rootNode = xmlTree.getRootNode();
 		if (rootNode->hasChild("zetaglest-saved-game") == true) {
 			rootNode = rootNode->getChild("zetaglest-saved-game");
@@ -9350,5 +9825,6 @@ namespace Game {
 		if (SystemFlags::VERBOSE_MODE_ENABLED)
 			printf("Starting Game ...\n");
 		programPtr->setState(newGame);
+		return newGame;
 	}
 } //end namespace
@@ -37,6 +37,8 @@
 #include "network_interface.h"
 #include "data_types.h"
 #include "selection.h"
+#include "save_game_thread.h"
+#include "replay_file.h"
 #include "leak_dumper.h"
 
 using std::vector;
@@ -212,9 +214,17 @@ namespace Game {
 
 		time_t lastMasterServerGameStatsDump;
 
+		SaveGameThread *saveGameThread;
+		time_t lastAutoSaveTime;
+
 		XmlNode *loadGameNode;
 		int lastworldFrameCountForReplay;
 		std::vector < std::pair < int, NetworkCommand > > replayCommandList;
+		std::vector < ReplayFile::Keyframe > replayKeyframeList;
+		int lastReplayKeyframeFrame;
+		// Replay being watched and where to seek it to on the next update
+		string replayPlaybackFile;
+		int replaySeekRequestFrame;
 
 		std::vector < string > streamingVideos;
 		::Shared::Graphics::VideoPlayer * videoPlayer;
@@ -435,10 +445,29 @@ namespace Game {
 		void stopStreamingVideo(const string & playVideo);
 		void stopAllVideo();
 
-		string saveGame(string name, const string & path = "saved/");
+		// xmlFormat overrides SaveGameFormat, for files older clients read
+		string saveGame(string name, const string & path = "saved/",
+			bool xmlFormat = false);
+		// Captures the game now and writes it on the save thread
+		string saveGameInBackground(string name, const string & path =
+			"saved/", bool announce = true, bool takeScreenshot = true);
+		void saveGameToXmlTree(XmlTree & xmlTree);
+		void saveReplayToXmlTree(XmlTree & xmlTreeSaveGame,
+			bool includeCommands = true);
+		void saveReplayToBuffer(std::vector < char >&buffer);
 		static void
 			loadGame(string name, Program * programPtr, bool isMasterserverMode,
 				const GameSettings * joinGameSettings = NULL);
+		// Loads a game from a XmlTree::saveToBinary snapshot held in memory
+		static void
+			loadGameFromSnapshot(const std::vector<char> &snapshot, Program * programPtr,
+				bool isMasterserverMode,
+				const GameSettings * joinGameSettings = NULL);
+		// Plays a binary replay from the keyframe closest to seekFrame
+		// and fast forwards to it, -1 fast forwards through all of it
+		static void
+			loadReplay(const string & replayFile, int seekFrame,
+				Program * programPtr, bool isMasterserverMode);
 
 		void
 			addNetworkCommandToReplayList(NetworkCommand * networkCommand,
@@ -476,6 +505,14 @@ namespace Game {
 			ReplaceDisconnectedNetworkPlayersWithAI(bool isNetworkGame, NetworkRole role, bool showMessage);
 
 	private:
+		static Game *
+			loadGameFromXmlTree(XmlTree & xmlTree, Program * programPtr,
+				bool isMasterserverMode, const GameSettings * joinGameSettings);
+		// Game from the settings of a replay, not yet started
+		static Game *
+			createReplayGame(const XmlTree & xmlTreeReplay, Program * programPtr,
+				bool isMasterserverMode);
+
 		//render
 		void render3d();
 		void render2d();
@@ -519,6 +556,15 @@ namespace Game {
 		void updateNetworkMarkedCells();
 		void updateNetworkUnMarkedCells();
 		void updateNetworkHighligtedCells();
+		void updateObserverRelay();
+		void updateBackgroundSaves();
+		void startSaveGameThread();
+		void updateReplayKeyframes();
+		void collectReplayKeyframes(bool waitForPending);
+		void requestReplaySeek(int seconds);
+
+		string getSaveGameFile(string name, const string & path);
+		void saveGameScreenshot(const string & saveGameFile);
 
 		virtual void processInputText(string text, bool cancelled);
 
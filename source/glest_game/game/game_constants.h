@@ -251,6 +251,8 @@ namespace Game {
 			saveGameFileAutoTestDefault;
 		static const char *
 			saveGameFilePattern;
+		static const char *
+			saveGameFileAutoSave;
 
 		// VC++ Chokes on init of non integral static types
 		static const float
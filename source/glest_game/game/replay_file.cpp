@@ -0,0 +1,292 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+
+#include "replay_file.h"
+
+#include "network_protocol.h"
+#include "compression_utils.h"
+#include "conversion.h"
+#include "platform_util.h"
+#include "util.h"
+#include <stdio.h>
+#include <string.h>
+#include <set>
+#include <map>
+
+#include "leak_dumper.h"
+
+using namespace Shared::Util;
+using namespace Shared::Platform;
+
+namespace Game {
+
+	// File layout, all numbers little endian uint32:
+	//   magic, version, index offset, end of the command batches,
+	//   last world frame, settings size and data
+	//   command batches: frame, count and the packed commands
+	//   keyframes: raw size, stored size and the compressed snapshot
+	//   index: keyframe count, then frame, snapshot offset, offset of
+	//   the first batch after the snapshot and its command index
+	static const char replayFileMagic[4] = { 'Z', 'G', 'R', 'P' };
+	static const char replayFileVersion = 1;
+	static const uint32 replayFileHeaderSize = 4 + 1 + 4 * 3;
+	static const uint32 replayFileMaxCommandsPerBatch = 100000;
+
+	static void writeReplayUInt32(vector<char> &buffer, uint32 value) {
+		for (int i = 0; i < 4; ++i) {
+			buffer.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+		}
+	}
+
+	static void patchReplayUInt32(vector<char> &buffer, size_t offset, uint32 value) {
+		for (int i = 0; i < 4; ++i) {
+			buffer[offset + i] = static_cast<char>((value >> (i * 8)) & 0xFF);
+		}
+	}
+
+	static uint32 readReplayUInt32(FILE *file) {
+		unsigned char data[4];
+		if (fread(data, sizeof(data), 1, file) != 1) {
+			throw game_runtime_error("Error reading replay, truncated data");
+		}
+		return (uint32) data[0] | ((uint32) data[1] << 8) | ((uint32) data[2] << 16) | ((uint32) data[3] << 24);
+	}
+
+	static void readReplayBytes(FILE *file, vector<char> &buffer, uint32 size) {
+		buffer.resize(size);
+		if (size > 0 && fread(&buffer[0], size, 1, file) != 1) {
+			throw game_runtime_error("Error reading replay, truncated data");
+		}
+	}
+
+	static void seekReplay(FILE *file, uint32 offset) {
+		if (fseek(file, (long) offset, SEEK_SET) != 0) {
+			throw game_runtime_error("Error reading replay, invalid offset: " + uIntToStr(offset));
+		}
+	}
+
+	// =====================================================
+	//	class ReplayFile
+	// =====================================================
+
+	ReplayFile::ReplayFile() {
+		lastWorldFrameCount = 0;
+		keyframeFrame = -1;
+	}
+
+	bool ReplayFile::isReplayFile(const string &path) {
+#ifdef WIN32
+		FILE *file = _wfopen(utf8_decode(path).c_str(), L"rb");
+#else
+		FILE *file = fopen(path.c_str(), "rb");
+#endif
+		if (file == NULL) {
+			return false;
+		}
+		char magic[sizeof(replayFileMagic)];
+		bool result = (fread(magic, sizeof(magic), 1, file) == 1 &&
+			memcmp(magic, replayFileMagic, sizeof(replayFileMagic)) == 0);
+		fclose(file);
+		return result;
+	}
+
+	ReplayFile::Keyframe ReplayFile::createKeyframe(int frame, uint32 commandIndex, const vector<char> &snapshot) {
+		Keyframe keyframe;
+		keyframe.frame = frame;
+		keyframe.commandIndex = commandIndex;
+		keyframe.rawSize = (uint32) snapshot.size();
+		if (snapshot.empty() == false) {
+			std::pair<unsigned char *, unsigned long> compressed =
+				Shared::CompressionUtil::compressMemoryToMemory(
+					reinterpret_cast<unsigned char *>(const_cast<char *>(&snapshot[0])),
+					(unsigned long) snapshot.size(), 1);
+			keyframe.snapshot.assign(compressed.first, compressed.first + compressed.second);
+			delete[] compressed.first;
+		}
+		return keyframe;
+	}
+
+	void ReplayFile::save(vector<char> &buffer, const vector<char> &settingsData, int lastWorldFrameCount,
+		const vector<std::pair<int, NetworkCommand> > &commandList, const vector<Keyframe> &keyframeList) {
+		buffer.clear();
+		buffer.insert(buffer.end(), replayFileMagic, replayFileMagic + sizeof(replayFileMagic));
+		buffer.push_back(replayFileVersion);
+		const size_t indexOffsetPosition = buffer.size();
+		writeReplayUInt32(buffer, 0);
+		const size_t commandEndPosition = buffer.size();
+		writeReplayUInt32(buffer, 0);
+		writeReplayUInt32(buffer, (uint32) lastWorldFrameCount);
+		writeReplayUInt32(buffer, (uint32) settingsData.size());
+		buffer.insert(buffer.end(), settingsData.begin(), settingsData.end());
+
+		// A keyframe must start a batch so its commands can be read on
+		// their own
+		std::set<uint32> batchStarts;
+		for (unsigned int i = 0; i < keyframeList.size(); ++i) {
+			batchStarts.insert(keyframeList[i].commandIndex);
+		}
+
+		std::map<uint32, uint32> batchOffsets;
+		NetworkPackedSize packedSize;
+		NetworkCommand sizeCommand;
+		sizeCommand.serialize(packedSize);
+		for (uint32 start = 0; start < commandList.size();) {
+			uint32 end = start + 1;
+			while (end < commandList.size() && end - start < replayFileMaxCommandsPerBatch &&
+				commandList[end].first == commandList[start].first &&
+				batchStarts.find(end) == batchStarts.end()) {
+				end++;
+			}
+
+			batchOffsets[start] = (uint32) buffer.size();
+			writeReplayUInt32(buffer, (uint32) commandList[start].first);
+			writeReplayUInt32(buffer, end - start);
+			size_t offset = buffer.size();
+			buffer.resize(offset + (end - start) * packedSize.getSize());
+			for (uint32 i = start; i < end; ++i) {
+				NetworkCommand command = commandList[i].second;
+				NetworkPackWriter writer(reinterpret_cast<unsigned char *>(&buffer[offset]));
+				command.serialize(writer);
+				offset += packedSize.getSize();
+			}
+			start = end;
+		}
+		const uint32 commandEndOffset = (uint32) buffer.size();
+		patchReplayUInt32(buffer, commandEndPosition, commandEndOffset);
+
+		vector<uint32> snapshotOffsets;
+		for (unsigned int i = 0; i < keyframeList.size(); ++i) {
+			const Keyframe &keyframe = keyframeList[i];
+			snapshotOffsets.push_back((uint32) buffer.size());
+			writeReplayUInt32(buffer, keyframe.rawSize);
+			writeReplayUInt32(buffer, (uint32) keyframe.snapshot.size());
+			buffer.insert(buffer.end(), keyframe.snapshot.begin(), keyframe.snapshot.end());
+		}
+
+		patchReplayUInt32(buffer, indexOffsetPosition, (uint32) buffer.size());
+		writeReplayUInt32(buffer, (uint32) keyframeList.size());
+		for (unsigned int i = 0; i < keyframeList.size(); ++i) {
+			const Keyframe &keyframe = keyframeList[i];
+			std::map<uint32, uint32>::iterator iterFind = batchOffsets.find(keyframe.commandIndex);
+			writeReplayUInt32(buffer, (uint32) keyframe.frame);
+			writeReplayUInt32(buffer, snapshotOffsets[i]);
+			writeReplayUInt32(buffer, (iterFind != batchOffsets.end() ? iterFind->second : commandEndOffset));
+			writeReplayUInt32(buffer, keyframe.commandIndex);
+		}
+	}
+
+	void ReplayFile::load(const string &path, int seekFrame) {
+		settingsData.clear();
+		keyframeSnapshot.clear();
+		commandList.clear();
+		keyframeFrame = -1;
+
+#ifdef WIN32
+		FILE *file = _wfopen(utf8_decode(path).c_str(), L"rb");
+#else
+		FILE *file = fopen(path.c_str(), "rb");
+#endif
+		if (file == NULL) {
+			throw game_runtime_error("Can not open replay file: [" + path + "]");
+		}
+
+		try {
+			char magic[sizeof(replayFileMagic) + 1];
+			if (fread(magic, sizeof(magic), 1, file) != 1 ||
+				memcmp(magic, replayFileMagic, sizeof(replayFileMagic)) != 0) {
+				throw game_runtime_error("Error reading replay, bad header");
+			}
+			if (magic[sizeof(replayFileMagic)] != replayFileVersion) {
+				throw game_runtime_error("Error reading replay, unsupported version: " + intToStr(magic[sizeof(replayFileMagic)]));
+			}
+			uint32 indexOffset = readReplayUInt32(file);
+			uint32 commandEndOffset = readReplayUInt32(file);
+			lastWorldFrameCount = (int) readReplayUInt32(file);
+			uint32 settingsSize = readReplayUInt32(file);
+			if (settingsSize > indexOffset) {
+				throw game_runtime_error("Error reading replay, invalid settings size");
+			}
+			readReplayBytes(file, settingsData, settingsSize);
+			uint32 commandOffset = replayFileHeaderSize + 4 + settingsSize;
+
+			if (seekFrame >= 0) {
+				seekReplay(file, indexOffset);
+				uint32 keyframeCount = readReplayUInt32(file);
+				uint32 snapshotOffset = 0;
+				for (uint32 i = 0; i < keyframeCount; ++i) {
+					int frame = (int) readReplayUInt32(file);
+					uint32 offset = readReplayUInt32(file);
+					uint32 batchOffset = readReplayUInt32(file);
+					readReplayUInt32(file);
+					if (frame <= seekFrame && frame > keyframeFrame) {
+						keyframeFrame = frame;
+						snapshotOffset = offset;
+						commandOffset = batchOffset;
+					}
+				}
+
+				if (keyframeFrame >= 0) {
+					seekReplay(file, snapshotOffset);
+					uint32 rawSize = readReplayUInt32(file);
+					uint32 storedSize = readReplayUInt32(file);
+					if (storedSize == 0) {
+						throw game_runtime_error("Error reading replay, empty keyframe");
+					}
+					vector<char> stored;
+					readReplayBytes(file, stored, storedSize);
+					std::pair<unsigned char *, unsigned long> extracted =
+						Shared::CompressionUtil::extractMemoryToMemory(
+							reinterpret_cast<unsigned char *>(&stored[0]), storedSize, rawSize);
+					keyframeSnapshot.assign(extracted.first, extracted.first + extracted.second);
+					delete[] extracted.first;
+					if (keyframeSnapshot.size() != rawSize) {
+						throw game_runtime_error("Error reading replay, bad keyframe");
+					}
+				}
+			}
+
+			NetworkPackedSize packedSize;
+			NetworkCommand sizeCommand;
+			sizeCommand.serialize(packedSize);
+			vector<char> batch;
+			seekReplay(file, commandOffset);
+			for (uint32 offset = commandOffset; offset < commandEndOffset;) {
+				int frame = (int) readReplayUInt32(file);
+				uint32 count = readReplayUInt32(file);
+				if (count > replayFileMaxCommandsPerBatch) {
+					throw game_runtime_error("Error reading replay, invalid batch size");
+				}
+				readReplayBytes(file, batch, count * packedSize.getSize());
+				for (uint32 i = 0; i < count; ++i) {
+					NetworkCommand command;
+					NetworkPackReader reader(reinterpret_cast<const unsigned char *>(&batch[i * packedSize.getSize()]), packedSize.getSize());
+					command.serialize(reader);
+					commandList.push_back(std::make_pair(frame, command));
+				}
+				offset += 8 + count * packedSize.getSize();
+			}
+		} catch (...) {
+			fclose(file);
+			throw;
+		}
+		fclose(file);
+	}
+
+} //end namespace
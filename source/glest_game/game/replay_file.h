@@ -0,0 +1,97 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+
+#ifndef _REPLAYFILE_H_
+#define _REPLAYFILE_H_
+
+#include "network_types.h"
+#include "data_types.h"
+#include <vector>
+#include <string>
+
+#include "leak_dumper.h"
+
+using Shared::Platform::uint32;
+using std::string;
+using std::vector;
+
+namespace Game {
+
+	// =====================================================
+	//	class ReplayFile
+	//
+	//	Binary replay: the game settings, every command given
+	//	grouped per frame, and a world snapshot every few
+	//	minutes with an index so playback can start from the
+	//	snapshot closest to any frame instead of frame zero
+	// =====================================================
+
+	class ReplayFile {
+	public:
+		struct Keyframe {
+			int frame;
+			// Index of the first command given after the snapshot
+			uint32 commandIndex;
+			uint32 rawSize;
+			// XmlTree::saveToBinary of the saved game, compressed
+			vector<char> snapshot;
+		};
+
+	private:
+		vector<char> settingsData;
+		int lastWorldFrameCount;
+		int keyframeFrame;
+		vector<char> keyframeSnapshot;
+		vector<std::pair<int, NetworkCommand> > commandList;
+
+	public:
+		ReplayFile();
+
+		static bool isReplayFile(const string &path);
+		static Keyframe createKeyframe(int frame, uint32 commandIndex, const vector<char> &snapshot);
+		// settingsData is XmlTree::saveToBinary of the replay header tree
+		static void save(vector<char> &buffer, const vector<char> &settingsData, int lastWorldFrameCount,
+			const vector<std::pair<int, NetworkCommand> > &commandList, const vector<Keyframe> &keyframeList);
+
+		// Reads the latest snapshot at or before seekFrame (none when
+		// seekFrame is negative) and only the commands given after it
+		void load(const string &path, int seekFrame);
+
+		const vector<char> &getSettingsData() const {
+			return settingsData;
+		}
+		int getLastWorldFrameCount() const {
+			return lastWorldFrameCount;
+		}
+		// -1 when playback starts from the beginning of the game
+		int getKeyframeFrame() const {
+			return keyframeFrame;
+		}
+		const vector<char> &getKeyframeSnapshot() const {
+			return keyframeSnapshot;
+		}
+		const vector<std::pair<int, NetworkCommand> > &getCommandList() const {
+			return commandList;
+		}
+	};
+
+} //end namespace
+
+#endif
@@ -0,0 +1,220 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+
+#include "save_game_thread.h"
+
+#include "conversion.h"
+#include "platform_common.h"
+#include "platform_util.h"
+#include "util.h"
+#include <stdio.h>
+
+#include "leak_dumper.h"
+
+using namespace Shared::Platform;
+using namespace Shared::Util;
+using namespace Shared::PlatformCommon;
+
+namespace Game {
+
+	// =====================================================
+	//	class SaveGameThread
+	// =====================================================
+
+	SaveGameThread::SaveGameThread() : BaseThread() {
+		mutexJobs = new Mutex(CODE_AT_LINE);
+		pendingCount = 0;
+		pendingKeyframeCount = 0;
+		setUniqueID("SaveGameThread");
+	}
+
+	SaveGameThread::~SaveGameThread() {
+		// Anything left over was never written, the game is going away
+		MutexSafeWrapper safeMutex(mutexJobs, CODE_AT_LINE);
+		for (unsigned int i = 0; i < jobList.size(); ++i) {
+			delete jobList[i].xmlTree;
+			delete jobList[i].buffer;
+		}
+		jobList.clear();
+		safeMutex.ReleaseLock();
+
+		delete mutexJobs;
+		mutexJobs = NULL;
+	}
+
+	void SaveGameThread::signalQuit() {
+		BaseThread::signalQuit();
+		semTaskSignalled.signal();
+	}
+
+	void SaveGameThread::queueSave(const SaveJob &job) {
+		MutexSafeWrapper safeMutex(mutexJobs, CODE_AT_LINE);
+		jobList.push_back(job);
+		if (job.replayKeyframe == true) {
+			pendingKeyframeCount++;
+		} else {
+			pendingCount++;
+		}
+		safeMutex.ReleaseLock();
+
+		semTaskSignalled.signal();
+	}
+
+	int SaveGameThread::getPendingCount() {
+		MutexSafeWrapper safeMutex(mutexJobs, CODE_AT_LINE);
+		return pendingCount;
+	}
+
+	void SaveGameThread::getCompletedSaves(vector<SaveResult> &results) {
+		MutexSafeWrapper safeMutex(mutexJobs, CODE_AT_LINE);
+		results.insert(results.end(), resultList.begin(), resultList.end());
+		resultList.clear();
+	}
+
+	int SaveGameThread::getPendingKeyframeCount() {
+		MutexSafeWrapper safeMutex(mutexJobs, CODE_AT_LINE);
+		return pendingKeyframeCount;
+	}
+
+	void SaveGameThread::getCompletedKeyframes(vector<ReplayFile::Keyframe> &keyframes) {
+		MutexSafeWrapper safeMutex(mutexJobs, CODE_AT_LINE);
+		keyframes.insert(keyframes.end(), keyframeList.begin(), keyframeList.end());
+		keyframeList.clear();
+	}
+
+	void SaveGameThread::writeBuffer(const string &file, const vector<char> &buffer) {
+#ifdef WIN32
+		FILE *fp = _wfopen(utf8_decode(file).c_str(), L"wb");
+#else
+		FILE *fp = fopen(file.c_str(), "wb");
+#endif
+		if (fp == NULL) {
+			throw game_runtime_error("Can not open file: [" + file + "]");
+		}
+		size_t written = (buffer.empty() ? 0 : fwrite(&buffer[0], 1, buffer.size(), fp));
+		fclose(fp);
+		if (written != buffer.size()) {
+			throw game_runtime_error("Error writing file: [" + file + "]");
+		}
+	}
+
+	void SaveGameThread::writeJob(SaveJob &job) {
+		Chrono chrono;
+		chrono.start();
+
+		SaveResult result;
+		result.file = job.file;
+		result.succeeded = false;
+
+		// Write next to the target and swap it in at the end so a crash
+		// while saving never leaves a half written file behind
+		string tempFile = job.file + ".tmp";
+		try {
+			if (job.xmlTree == NULL) {
+				writeBuffer(tempFile, *job.buffer);
+			} else if (job.binaryFormat == true) {
+				job.xmlTree->saveToChunkedBinaryFile(tempFile, job.compressionLevel);
+			} else {
+				job.xmlTree->save(tempFile);
+			}
+#ifdef WIN32
+			// Only POSIX rename replaces an existing target atomically
+			removeFile(job.file);
+#endif
+			result.succeeded = renameFile(tempFile, job.file);
+			if (result.succeeded == false) {
+				result.error = "Could not rename [" + tempFile + "]";
+			}
+		} catch (const exception &ex) {
+			SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error saving [%s]: %s\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, job.file.c_str(), ex.what());
+			removeFile(tempFile);
+			result.error = ex.what();
+		}
+
+		if (SystemFlags::VERBOSE_MODE_ENABLED) printf("Saved game to [%s] in the background in %lld msecs\n", job.file.c_str(), (long long int) chrono.getMillis());
+
+		delete job.xmlTree;
+		job.xmlTree = NULL;
+		delete job.buffer;
+		job.buffer = NULL;
+
+		MutexSafeWrapper safeMutex(mutexJobs, CODE_AT_LINE);
+		pendingCount--;
+		if (job.announce == true) {
+			resultList.push_back(result);
+		}
+	}
+
+	void SaveGameThread::buildKeyframe(SaveJob &job) {
+		Chrono chrono;
+		chrono.start();
+
+		ReplayFile::Keyframe keyframe;
+		try {
+			vector<char> snapshot;
+			job.xmlTree->saveToBinary(snapshot);
+			keyframe = ReplayFile::createKeyframe(job.keyframeFrame, job.keyframeCommandIndex, snapshot);
+		} catch (const exception &ex) {
+			SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error building replay keyframe for frame %d: %s\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, job.keyframeFrame, ex.what());
+		}
+
+		if (SystemFlags::VERBOSE_MODE_ENABLED) printf("Built replay keyframe at frame %d, " SIZE_T_SPECIFIER " bytes in %lld msecs\n", job.keyframeFrame, keyframe.snapshot.size(), (long long int) chrono.getMillis());
+
+		delete job.xmlTree;
+		job.xmlTree = NULL;
+
+		MutexSafeWrapper safeMutex(mutexJobs, CODE_AT_LINE);
+		pendingKeyframeCount--;
+		// A keyframe that failed is left out, playback then starts from
+		// the one before it
+		if (keyframe.snapshot.empty() == false) {
+			keyframeList.push_back(keyframe);
+		}
+	}
+
+	void SaveGameThread::execute() {
+		RunningStatusSafeWrapper runningStatus(this);
+
+		for (;;) {
+			semTaskSignalled.waitTillSignalled(250);
+
+			MutexSafeWrapper safeMutex(mutexJobs, CODE_AT_LINE);
+			if (jobList.empty() == true) {
+				safeMutex.ReleaseLock();
+				// Queued saves are always finished before quitting
+				if (getQuitStatus() == true) {
+					break;
+				}
+				continue;
+			}
+			SaveJob job = jobList.front();
+			jobList.erase(jobList.begin());
+			safeMutex.ReleaseLock();
+
+			ExecutingTaskSafeWrapper safeExecutingTaskMutex(this);
+			if (job.replayKeyframe == true) {
+				buildKeyframe(job);
+			} else {
+				writeJob(job);
+			}
+		}
+	}
+
+} //end namespace
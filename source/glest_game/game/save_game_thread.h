@@ -0,0 +1,104 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+
+#ifndef _SAVEGAMETHREAD_H_
+#define _SAVEGAMETHREAD_H_
+
+#include "base_thread.h"
+#include "xml_parser.h"
+#include "replay_file.h"
+#include <vector>
+#include <string>
+
+#include "leak_dumper.h"
+
+using Shared::PlatformCommon::BaseThread;
+using Shared::Platform::Semaphore;
+using Shared::Xml::XmlTree;
+using std::string;
+using std::vector;
+
+namespace Game {
+
+	// =====================================================
+	//	class SaveGameThread
+	//
+	//	Writes saved games captured on the game thread to disk
+	//	so the simulation does not wait on serialization and I/O
+	// =====================================================
+
+	class SaveGameThread : public BaseThread {
+	public:
+		struct SaveJob {
+			// Owned by the thread once queued, buffer is written as is
+			// when there is no tree
+			XmlTree *xmlTree;
+			vector<char> *buffer;
+			string file;
+			bool binaryFormat;
+			int compressionLevel;
+			// Reported back through getCompletedSaves when true
+			bool announce;
+			// The tree is turned into a replay keyframe handed back
+			// through getCompletedKeyframes instead of being written
+			bool replayKeyframe;
+			int keyframeFrame;
+			uint32 keyframeCommandIndex;
+		};
+
+		struct SaveResult {
+			string file;
+			bool succeeded;
+			string error;
+		};
+
+	private:
+		Semaphore semTaskSignalled;
+		Mutex *mutexJobs;
+		vector<SaveJob> jobList;
+		vector<SaveResult> resultList;
+		int pendingCount;
+		vector<ReplayFile::Keyframe> keyframeList;
+		int pendingKeyframeCount;
+
+		void writeJob(SaveJob &job);
+		void buildKeyframe(SaveJob &job);
+
+	public:
+		SaveGameThread();
+		virtual ~SaveGameThread();
+
+		virtual void execute();
+		virtual void signalQuit();
+
+		static void writeBuffer(const string &file, const vector<char> &buffer);
+
+		void queueSave(const SaveJob &job);
+		// Number of queued or running saves
+		int getPendingCount();
+		void getCompletedSaves(vector<SaveResult> &results);
+		// Keyframes come back in the order they were queued
+		int getPendingKeyframeCount();
+		void getCompletedKeyframes(vector<ReplayFile::Keyframe> &keyframes);
+	};
+
+} //end namespace
+
+#endif
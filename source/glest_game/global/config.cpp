@@ -98,6 +98,7 @@ namespace Game {
 	const char *GameConstants::saveGameFileAutoTestDefault =
 		"zetaglest-auto-saved_%s.xml";
 	const char *GameConstants::saveGameFilePattern = "zetaglest-saved_%s.xml";
+	const char *GameConstants::saveGameFileAutoSave = "zetaglest-autosave.xml";
 
 	const char *Config::glest_ini_filename = "glest.ini";
 	const char *Config::glestuser_ini_filename = "glestuser.ini";
@@ -26,6 +26,7 @@
 #include "components.h"
 #include "time_flow.h"
 #include "graphics_interface.h"
+#include "texture_decoder.h"
 #include "object.h"
 #include "core_data.h"
 #include "game.h"
@@ -127,6 +128,7 @@ namespace Game {
 		focusArrows = false;
 		pointCount = 0;
 		maxLights = 0;
+		textureUploadMillis = 0;
 		waterAnim = 0;
 
 		this->allowRenderUnitTitles = false;
@@ -198,6 +200,7 @@ namespace Game {
 				modelManager[i] = graphicsFactory->newModelManager();
 				textureManager[i] = graphicsFactory->newTextureManager();
 				modelManager[i]->setTextureManager(textureManager[i]);
+				textureResidency.addManager(textureManager[i]);
 				fontManager[i] = graphicsFactory->newFontManager();
 			}
 			particleManager[i] = graphicsFactory->newParticleManager();
@@ -657,6 +660,7 @@ namespace Game {
 		if (particleManager[rsGlobal]) {
 			particleManager[rsGlobal]->end();
 		}
+		TextureDecoder::shutdown();
 
 		//delete 2d list
 		//if(list2dValid == true) {
@@ -870,6 +874,28 @@ namespace Game {
 		return textureManager[rs]->newTexture2D();
 	}
 
+	void Renderer::loadTexture2DAsync(ResourceScope rs, Texture2D *texture, const string &path) {
+		if (texture != NULL) {
+			textureManager[rs]->loadTexture2DAsync(texture, path);
+		}
+	}
+
+	void Renderer::initDecodedTextures() {
+		// Uploads share one budget per frame, 0 uploads whatever is ready
+		Chrono chrono;
+		chrono.start();
+		for (int i = 0; i < rsCount; ++i) {
+			int64 remainingMillis = -1;
+			if (textureUploadMillis > 0) {
+				remainingMillis = textureUploadMillis - chrono.getMillis();
+				if (remainingMillis <= 0) {
+					break;
+				}
+			}
+			textureManager[i]->initDecodedTextures(remainingMillis);
+		}
+	}
+
 	Texture3D *Renderer::newTexture3D(ResourceScope rs) {
 		if (GlobalStaticFlags::getIsNonGraphicalModeEnabled() == true) {
 			return NULL;
@@ -957,6 +983,8 @@ namespace Game {
 		//glFlush();
 
 		GraphicsInterface::getInstance().getCurrentContext()->swapBuffers();
+		initDecodedTextures();
+		textureResidency.update();
 	}
 
 	// ==================== lighting ====================
@@ -7506,6 +7534,15 @@ namespace Game {
 				textureManager[i]->setFilter(textureFilter);
 				textureManager[i]->setMaxAnisotropy(maxAnisotropy);
 			}
+
+			// Image decoding threads, 0 picks one per cpu and -1 decodes on
+			// the main thread
+			TextureDecoder::setThreadCount(config.getInt("TextureDecodeThreads", "0"));
+			textureUploadMillis = config.getInt("TextureUploadMillisPerFrame", "4");
+
+			// Model textures beyond the budget are evicted least recently
+			// drawn first, 0 keeps everything resident
+			textureResidency.setBudget((std::size_t) config.getInt("TextureMemoryBudgetMB", "0") * 1024 * 1024);
 		}
 	}
 
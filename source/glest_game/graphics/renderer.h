@@ -36,6 +36,7 @@
 #include "components.h"
 #include "texture.h"
 #include "model_manager.h"
+#include "texture_residency.h"
 #include "graphics_factory_gl.h"
 #include "model_renderer_gl.h"
 #include "font_manager.h"
@@ -246,6 +247,7 @@ namespace Game {
 		bool textures3D;
 		Shadows shadows;
 		int maxConsoleLines;
+		int textureUploadMillis;
 
 		//game
 		const Game *game;
@@ -271,6 +273,7 @@ namespace Game {
 		//texture managers
 		ModelManager *modelManager[rsCount];
 		TextureManager *textureManager[rsCount];
+		TextureResidency textureResidency;
 		FontManager *fontManager[rsCount];
 		ParticleManager *particleManager[rsCount];
 
@@ -468,6 +471,8 @@ namespace Game {
 		void endLastModel(ResourceScope rs, bool mustExistInList = false);
 
 		Texture2D *newTexture2D(ResourceScope rs);
+		void loadTexture2DAsync(ResourceScope rs, Texture2D *texture, const string &path);
+		void initDecodedTextures();
 		Texture3D *newTexture3D(ResourceScope rs);
 		Font2D *newFont(ResourceScope rs);
 		Font3D *newFont3D(ResourceScope rs);
@@ -661,6 +666,9 @@ namespace Game {
 		void removeUnitFromQuadCache(const Unit *unit);
 
 		std::size_t getCurrentPixelByteCount(ResourceScope rs = rsGame) const;
+		string getTextureResidencyStats() const {
+			return textureResidency.getStats();
+		}
 		unsigned int getSaveScreenQueueSize();
 
 		//Texture2D *saveScreenToTexture(int x, int y, int width, int height);
@@ -60,6 +60,7 @@
 #include "font_gl.h"
 #include "FileReader.h"
 #include "cache_manager.h"
+#include "virtual_file_system.h"
 #include <iterator>
 #include "core_data.h"
 #include "font_text.h"
@@ -304,6 +305,7 @@ namespace Game {
 			printf("#4 IRCCLient Cache SHUTDOWN\n");
 
 		cleanupCRCThread();
+		SocketLinkSimulator::shutdown();
 		if (SystemFlags::VERBOSE_MODE_ENABLED)
 			printf("In [%s::%s Line: %d]\n", __FILE__, __FUNCTION__, __LINE__);
 
@@ -6296,6 +6298,20 @@ namespace Game {
 				()).c_str()));
 
 			Socket::disableNagle = config.getBool("DisableNagle", "true");
+
+			// Optional simulated link for testing lag handling on localhost
+			SocketLinkConditions linkConditions;
+			linkConditions.latencyMilliseconds = config.getInt("NetworkSimulationLatency", "0");
+			linkConditions.jitterMilliseconds = config.getInt("NetworkSimulationJitter", "0");
+			linkConditions.bandwidthKbps = config.getInt("NetworkSimulationBandwidthKbps", "0");
+			linkConditions.lossPercent = config.getInt("NetworkSimulationLossPercent", "0");
+			Socket::setDefaultLinkConditions(linkConditions);
+			if (linkConditions.isEnabled() == true) {
+				printf
+				("*WARNING simulating network link latency: %d jitter: %d bandwidth kbps: %d loss percent: %d\n",
+					linkConditions.latencyMilliseconds, linkConditions.jitterMilliseconds,
+					linkConditions.bandwidthKbps, linkConditions.lossPercent);
+			}
 			Socket::DEFAULT_SOCKET_SENDBUF_SIZE =
 				config.getInt("DefaultSocketSendBufferSize",
 					intToStr(Socket::DEFAULT_SOCKET_SENDBUF_SIZE).
@@ -6381,6 +6397,18 @@ namespace Game {
 				removeFile(binaryNameOld);
 			}
 
+			// Index the tech and tileset folders up front so file lookups are
+			// answered from memory and zipped content can be loaded in place
+			if (config.getBool("MountDataArchives", "true") == true) {
+				bool indexDataFolders = config.getBool("IndexDataFolders", "false");
+				vector<string> mountPaths = config.getPathListForType(ptTechs);
+				vector<string> tilesetPaths = config.getPathListForType(ptTilesets);
+				mountPaths.insert(mountPaths.end(), tilesetPaths.begin(), tilesetPaths.end());
+				for (unsigned int i = 0; i < mountPaths.size(); ++i) {
+					VirtualFileSystem::mount(mountPaths[i], indexDataFolders);
+				}
+			}
+
 			string
 				netInterfaces = config.getString("NetworkInterfaces", "");
 			if (netInterfaces != "") {
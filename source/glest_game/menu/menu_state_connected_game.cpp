@@ -779,6 +779,11 @@ namespace Game {
 				fileArchiveExtractCommandParameters,
 				fileArchiveExtractCommandSuccessResult,
 				tempFilePath);
+			if ((clientInterface->getProtocolFeatures() & npfContentTransfer) != 0) {
+				ftpClientThread->setContentTransferPort(
+					ContentTransferServerThread::getPortForFTPPort(portNumber, GameConstants::maxPlayers),
+					config.getInt("ContentTransferConnections", "4"));
+			}
 			ftpClientThread->start();
 		}
 		// Start http meta data thread
@@ -2014,6 +2019,11 @@ namespace Game {
 					fileArchiveExtractCommandParameters,
 					fileArchiveExtractCommandSuccessResult,
 					tempFilePath);
+				if ((clientInterface->getProtocolFeatures() & npfContentTransfer) != 0) {
+					ftpClientThread->setContentTransferPort(
+						ContentTransferServerThread::getPortForFTPPort(portNumber, GameConstants::maxPlayers),
+						config.getInt("ContentTransferConnections", "4"));
+				}
 				ftpClientThread->start();
 
 				Lang & lang = Lang::getInstance();
@@ -5253,6 +5263,21 @@ namespace Game {
 					&& chrono.getMillis() > 0)
 					chrono.start();
 
+				// check if the server streamed the in progress game to us, an
+				// observer relay does so right after the handshake unasked
+				if (clientInterface->getJoinGameInProgress() == true &&
+					clientInterface->getReadyForInGameJoin() == true) {
+					std::vector<char> joinGameSnapshot;
+					if (clientInterface->takeJoinGameSnapshot(joinGameSnapshot) == true) {
+						GameSettings
+							gameSettings = *clientInterface->getGameSettings();
+						loadGameSettings(&gameSettings);
+
+						Game::loadGameFromSnapshot(joinGameSnapshot, program, false, &gameSettings);
+						return;
+					}
+				}
+
 				// check if we are joining an in progress game
 				if (clientInterface->getJoinGameInProgress() == true &&
 					clientInterface->getJoinGameInProgressLaunch() == true &&
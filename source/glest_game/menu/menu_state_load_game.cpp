@@ -369,11 +369,18 @@ namespace Game {
 								printf("Before load of XML\n");
 							std::map < string, string > mapExtraTagReplacementValues;
 							try {
-								xmlTree.load(filename,
-									Properties::
-									getTagReplacementValues
-									(&mapExtraTagReplacementValues), true, false,
-									true);
+								if (XmlTree::isChunkedBinaryFile(filename) == true) {
+									xmlTree.loadFromChunkedBinaryFile(filename,
+										Properties::
+										getTagReplacementValues
+										(&mapExtraTagReplacementValues));
+								} else {
+									xmlTree.load(filename,
+										Properties::
+										getTagReplacementValues
+										(&mapExtraTagReplacementValues), true, false,
+										true);
+								}
 
 								if (SystemFlags::VERBOSE_MODE_ENABLED)
 									printf("After load of XML\n");
@@ -597,6 +597,7 @@ namespace Game {
 						"In [%s::%s Line: %d]\n", __FILE__,
 						__FUNCTION__, __LINE__);
 			} else {
+				updateFromMasterserverThread->setOverrideShutdownTask(shutdownTaskStatic);
 				updateFromMasterserverThread->setDeleteSelfOnExecutionDone(true);
 				updateFromMasterserverThread->setDeleteAfterExecute(true);
 			}
@@ -672,6 +673,7 @@ namespace Game {
 			delete serverLines.back();
 			serverLines.pop_back();
 		}
+		serverLineEntries.clear();
 	}
 
 	void MenuStateMasterserver::clearUserButtons() {
@@ -1235,6 +1237,23 @@ namespace Game {
 		}
 	}
 
+	// The update thread keeps one curl handle so the masterserver
+	// connection is reused between refreshes
+	void MenuStateMasterserver::setupTask(BaseThread * callingThread,
+		void *userdata) {
+		CURL *handle = SystemFlags::initHTTP();
+		callingThread->setGenericData < CURL >(handle);
+	}
+	void MenuStateMasterserver::shutdownTask(BaseThread * callingThread,
+		void *userdata) {
+		MenuStateMasterserver::shutdownTaskStatic(callingThread);
+	}
+	void MenuStateMasterserver::shutdownTaskStatic(BaseThread * callingThread) {
+		CURL *handle = callingThread->getGenericData < CURL >();
+		SystemFlags::cleanupHTTP(&handle);
+		callingThread->setGenericData < CURL >(NULL);
+	}
+
 	void MenuStateMasterserver::simpleTask(BaseThread * callingThread,
 		void *userdata) {
 		if (callingThread->getQuitStatus() == true) {
@@ -1274,7 +1293,7 @@ namespace Game {
 					if (Config::getInstance().getString("Masterserver", "") != "") {
 
 						safeMutex.ReleaseLock(true);
-						CURL *handle = SystemFlags::initHTTP();
+						CURL *handle = callingThread->getGenericData < CURL >();
 
 						string playerUUID =
 							"?uuid=" +
@@ -1287,13 +1306,25 @@ namespace Game {
 							endPathWithSlash(baseURL, false);
 						}
 
+						// Unchanged lists come back as a bodyless 304, or as the
+						// same text from masterservers that send no ETag
+						bool notModified = false;
+						CURLcode curlResult = CURLE_OK;
 						std::string localServerInfoString =
-							SystemFlags::getHTTP(baseURL + "showServersForGlest.php" +
-								playerUUID, handle);
-						SystemFlags::cleanupHTTP(&handle);
+							SystemFlags::getHTTPIfChanged(baseURL + "showServersForGlest.php" +
+								playerUUID, serverListETag, notModified, handle, -1, &curlResult);
 						if (callingThread->getQuitStatus() == true) {
 							return;
 						}
+						if (curlResult != CURLE_OK) {
+							serverListETag = "";
+							lastServerInfoString = "";
+						} else if (notModified == true ||
+							localServerInfoString == lastServerInfoString) {
+							return;
+						} else {
+							lastServerInfoString = localServerInfoString;
+						}
 						safeMutex.Lock();
 
 						serverInfoString = localServerInfoString;
@@ -1326,7 +1357,20 @@ namespace Game {
 
 	void MenuStateMasterserver::rebuildServerLines(const string & serverInfo) {
 		int numberOfOldServerLines = (int) serverLines.size();
-		clearServerLines();
+
+		// Lines whose masterserver entry did not change are kept, only new
+		// or changed entries are parsed into new ServerLines
+		std::map < string, ServerLine * > reusableServerLines;
+		for (int i = 0; i < (int) serverLines.size(); ++i) {
+			if (reusableServerLines.find(serverLineEntries[i]) == reusableServerLines.end()) {
+				reusableServerLines[serverLineEntries[i]] = serverLines[i];
+			} else {
+				delete serverLines[i];
+			}
+		}
+		serverLines.clear();
+		serverLineEntries.clear();
+
 		Lang & lang = Lang::getInstance();
 		try {
 			if (serverInfo != "") {
@@ -1346,6 +1390,14 @@ namespace Game {
 					if (trim(server) == "") {
 						continue;
 					}
+					std::map < string, ServerLine * >::iterator iterFind =
+						reusableServerLines.find(server);
+					if (iterFind != reusableServerLines.end()) {
+						serverLines.push_back(iterFind->second);
+						serverLineEntries.push_back(server);
+						reusableServerLines.erase(iterFind);
+						continue;
+					}
 					std::vector < std::string > serverEntities;
 					Tokenize(server, serverEntities, "|");
 					const int MIN_FIELDS_EXPECTED = 14;
@@ -1411,6 +1463,7 @@ namespace Game {
 							push_back(new
 								ServerLine(masterServerInfo, i, serverLinesYBase,
 									serverLinesLineHeight, containerName));
+						serverLineEntries.push_back(server);
 						delete masterServerInfo;
 					} else {
 						if (SystemFlags::
@@ -1465,6 +1518,12 @@ namespace Game {
 				ex.what());
 		}
 
+		for (std::map < string, ServerLine * >::iterator iterMap =
+			reusableServerLines.begin();
+			iterMap != reusableServerLines.end(); ++iterMap) {
+			delete iterMap->second;
+		}
+
 		if ((int) serverLines.size() > numberOfOldServerLines) {
 			playServerFoundSound = true;
 		}
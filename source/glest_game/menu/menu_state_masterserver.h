@@ -88,7 +88,12 @@ namespace Game {
 		SimpleTaskThread *updateFromMasterserverThread;
 		bool playServerFoundSound;
 		ServerLines serverLines;
+		// The masterserver entry each of serverLines was built from
+		std::vector < string > serverLineEntries;
 		string serverInfoString;
+		// Only touched by updateFromMasterserverThread
+		string serverListETag;
+		string lastServerInfoString;
 		int serverLinesToRender;
 		int serverLinesYBase;
 		int serverLinesLineHeight;
@@ -134,6 +139,9 @@ namespace Game {
 		virtual void keyDown(SDL_KeyboardEvent key);
 
 		virtual void simpleTask(BaseThread * callingThread, void *userdata);
+		virtual void setupTask(BaseThread * callingThread, void *userdata);
+		virtual void shutdownTask(BaseThread * callingThread, void *userdata);
+		static void shutdownTaskStatic(BaseThread * callingThread);
 		virtual bool isInSpecialKeyCaptureEvent() {
 			return chatManager.getEditEnabled();
 		}
@@ -23,6 +23,7 @@
 #include "window.h"
 
 #include "platform_util.h"
+#include "compression_utils.h"
 #include "network_manager.h"
 #include "game_util.h"
 #include "conversion.h"
@@ -34,6 +35,7 @@
 #include "shared_const.h"
 #include "leak_dumper.h"
 #include "game.h"
+#include "observer_relay.h"
 
 using namespace std;
 using namespace Shared;
@@ -206,6 +208,9 @@ namespace Game {
 		this->joinGameInProgressLaunch = false;
 		this->readyForInGameJoin = false;
 		this->resumeInGameJoin = false;
+		this->joinGameSnapshotSize = 0;
+		this->joinGameSnapshotUncompressedSize = 0;
+		this->observerRelay = NULL;
 
 		quitThreadAccessor = new Mutex(CODE_AT_LINE);
 		setQuitThread(false);
@@ -294,6 +299,14 @@ namespace Game {
 		shutdownNetworkCommandListThread(safeMutex);
 		//printf("A === Client destructor\n");
 
+		if (observerRelay != NULL) {
+			observerRelay->signalQuit();
+			if (observerRelay->shutdownAndWait() == true) {
+				delete observerRelay;
+			}
+			observerRelay = NULL;
+		}
+
 		if (SystemFlags::VERBOSE_MODE_ENABLED) printf("%s Line: %d\n", __FUNCTION__, __LINE__);
 
 		if (clientSocket != NULL &&
@@ -382,6 +395,74 @@ namespace Game {
 		return readyForInGameJoin;
 	}
 
+	bool ClientInterface::takeJoinGameSnapshot(std::vector<char> &snapshot) {
+		MutexSafeWrapper safeMutex(flagAccessor, CODE_AT_LINE);
+		if (joinGameSnapshotSize == 0 || joinGameSnapshot.size() != joinGameSnapshotSize) {
+			return false;
+		}
+
+		std::pair<unsigned char *, unsigned long> decompressedBuffer =
+			::Shared::CompressionUtil::extractMemoryToMemory((unsigned char *) &joinGameSnapshot[0],
+				joinGameSnapshotSize, joinGameSnapshotUncompressedSize);
+		uint32 expectedSize = joinGameSnapshotUncompressedSize;
+
+		std::vector<char>().swap(joinGameSnapshot);
+		joinGameSnapshotSize = 0;
+		joinGameSnapshotUncompressedSize = 0;
+		safeMutex.ReleaseLock();
+
+		if (decompressedBuffer.second != expectedSize) {
+			delete[] decompressedBuffer.first;
+			throw game_runtime_error("Error inflating join game snapshot, expected " + uIntToStr(expectedSize) + " bytes but got " + uIntToStr((uint32) decompressedBuffer.second));
+		}
+		snapshot.assign((const char *) decompressedBuffer.first, (const char *) decompressedBuffer.first + decompressedBuffer.second);
+		delete[] decompressedBuffer.first;
+		return true;
+	}
+
+	void ClientInterface::receiveGameSnapshotChunks() {
+		// The snapshot arrives back to back, take all chunks already here
+		// instead of one per lobby update
+		for (NetworkMessageType networkMessageType = nmtGameSnapshotChunk;;) {
+			NetworkMessageGameSnapshotChunk networkMessageGameSnapshotChunk;
+			if (receiveMessage(&networkMessageGameSnapshotChunk) == false) {
+				return;
+			}
+			this->setLastPingInfoToNow();
+
+			MutexSafeWrapper safeMutexFlags(flagAccessor, CODE_AT_LINE);
+			if (networkMessageGameSnapshotChunk.getOffset() == 0) {
+				joinGameSnapshot.clear();
+				joinGameSnapshot.reserve(networkMessageGameSnapshotChunk.getSnapshotSize());
+				joinGameSnapshotSize = networkMessageGameSnapshotChunk.getSnapshotSize();
+				joinGameSnapshotUncompressedSize = networkMessageGameSnapshotChunk.getUncompressedSize();
+			}
+			if (networkMessageGameSnapshotChunk.getSnapshotSize() != joinGameSnapshotSize ||
+				networkMessageGameSnapshotChunk.getOffset() != joinGameSnapshot.size()) {
+				throw game_runtime_error("Error receiving join game snapshot, unexpected chunk at offset " + uIntToStr(networkMessageGameSnapshotChunk.getOffset()));
+			}
+			const std::vector<char> &chunk = networkMessageGameSnapshotChunk.getChunk();
+			joinGameSnapshot.insert(joinGameSnapshot.end(), chunk.begin(), chunk.end());
+			bool completed = (joinGameSnapshot.size() == joinGameSnapshotSize);
+			safeMutexFlags.ReleaseLock();
+
+			if (completed == true) {
+				if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] received join game snapshot of %u bytes\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, joinGameSnapshotSize);
+				return;
+			}
+
+			networkMessageType = getNextMessageType();
+			if (networkMessageType != nmtGameSnapshotChunk) {
+				// Put the type back so the next update reads the message
+				if (networkMessageType != nmtInvalid && getSocket() != NULL) {
+					int8 messageType = static_cast<int8>(networkMessageType);
+					getSocket()->unreadData(&messageType, sizeof(messageType));
+				}
+				return;
+			}
+		}
+	}
+
 	bool ClientInterface::getResumeInGameJoin() {
 		MutexSafeWrapper safeMutex(flagAccessor, CODE_AT_LINE);
 		return resumeInGameJoin;
@@ -554,6 +635,7 @@ namespace Game {
 					serverUUID = networkMessageIntro.getPlayerUUID();
 					serverPlatform = networkMessageIntro.getPlayerPlatform();
 					serverFTPPort = networkMessageIntro.getFtpPort();
+					setProtocolFeatures(networkMessageIntro.getSupportedProtocolFeatures() & getLocalProtocolFeatures());
 
 					if (playerIndex < 0 || playerIndex >= GameConstants::maxPlayers) {
 						printf("playerIndex < 0 || playerIndex >= GameConstants::maxPlayers\n");
@@ -608,7 +690,8 @@ namespace Game {
 							lang.getLanguage(),
 							networkMessageIntro.getGameInProgress(),
 							Config::getInstance().getString("PlayerId", ""),
-							getPlatformNameString());
+							getPlatformNameString(),
+							getProtocolFeatures());
 						sendMessage(&sendNetworkMessageIntro);
 
 						//printf("Got intro sending client details to server\n");
@@ -977,13 +1060,20 @@ namespace Game {
 			}
 			break;
 
+			case nmtGameSnapshotChunk:
+			{
+				receiveGameSnapshotChunks();
+			}
+			break;
+
 			case nmtCommandList:
+			case nmtCommandListCompact:
 			{
 
 				//make sure we read the message
 				//time_t receiveTimeElapsed = time(NULL);
 				NetworkMessageCommandList networkMessageCommandList;
-				bool gotCmd = receiveMessage(&networkMessageCommandList);
+				bool gotCmd = receiveMessage(&networkMessageCommandList, networkMessageType);
 				if (gotCmd == false) {
 					printf("Server has interrupted network connection...\n");
 					return;
@@ -1026,6 +1116,17 @@ namespace Game {
 			}
 			break;
 
+			case nmtIntroLegacy:
+			{
+				string sErr = "The server runs an older network protocol version.\nYou have to use the exactly same versions!";
+				DisplayErrorMessage(sErr);
+				sleep(1);
+
+				setQuit(true);
+				close();
+			}
+			break;
+
 			default:
 			{
 				string sErr = string(extractFileFromDirectoryPath(__FILE__).c_str()) + "::" + string(__FUNCTION__) + " Unexpected network message: " + intToStr(networkMessageType);
@@ -1089,12 +1190,13 @@ namespace Game {
 
 				switch (networkMessageType) {
 					case nmtCommandList:
+					case nmtCommandListCompact:
 					{
 
 						//make sure we read the message
 						//time_t receiveTimeElapsed = time(NULL);
 						NetworkMessageCommandList networkMessageCommandList;
-						bool gotCmd = receiveMessage(&networkMessageCommandList);
+						bool gotCmd = receiveMessage(&networkMessageCommandList, networkMessageType);
 						if (gotCmd == false) {
 							SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] error retrieving nmtCommandList returned false!\n", __FILE__, __FUNCTION__, __LINE__);
 							printf("Network connection has been interrupted...\n");
@@ -1146,6 +1248,9 @@ namespace Game {
 						}
 
 						cachedPendingCommands[networkMessageCommandList.getFrameCount()].reserve(networkMessageCommandList.getCommandCount());
+						if (networkMessageCommandList.getNetworkFramePeriod() > 0) {
+							cachedPendingFramePeriods[networkMessageCommandList.getFrameCount()] = networkMessageCommandList.getNetworkFramePeriod();
+						}
 
 						// give all commands
 						for (int i = 0; i < networkMessageCommandList.getCommandCount(); ++i) {
@@ -1164,6 +1269,9 @@ namespace Game {
 								}
 							}
 						}
+						if (observerRelay != NULL) {
+							observerRelay->addCommandList(networkMessageCommandList);
+						}
 						safeMutex.ReleaseLock();
 
 						done = true;
@@ -1178,6 +1286,11 @@ namespace Game {
 						if (receiveMessage(&networkMessagePing)) {
 							if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
 							this->setLastPingInfo(networkMessagePing);
+
+							// Round trip probe from the server, answer right away
+							if (networkMessagePing.getPingFrequency() == networkPingProbeFrequency) {
+								sendMessage(&networkMessagePing);
+							}
 						}
 					}
 					break;
@@ -1199,6 +1312,13 @@ namespace Game {
 							//gameSettings.setMasterserver_admin(getSessionKey());
 							//gameSettings.setMasterserver_admin_faction_index(getPlayerIndex());
 						}
+
+						MutexSafeWrapper safeMutex(networkCommandListThreadAccessor, CODE_AT_LINE);
+						if (observerRelay != NULL) {
+							observerRelay->addQuit();
+						}
+						safeMutex.ReleaseLock();
+
 						if (!done) {
 							setQuit(true);
 							done = true;
@@ -1429,6 +1549,17 @@ namespace Game {
 						}
 						cachedPendingCommandCRCs.erase(frameCount);
 					}
+
+					// The server switches period right after this frame so we
+					// must do the same to keep the keyframes in lockstep
+					std::map<int, int>::iterator iterFindPeriod = cachedPendingFramePeriods.find(frameCount);
+					if (iterFindPeriod != cachedPendingFramePeriods.end()) {
+						if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] frame: %d network frame period changes from %d to %d\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, frameCount, gameSettings.getNetworkFramePeriod(), iterFindPeriod->second);
+
+						networkFramePeriodChange = iterFindPeriod->second;
+						gameSettings.setNetworkFramePeriod(iterFindPeriod->second);
+						cachedPendingFramePeriods.erase(iterFindPeriod);
+					}
 					if (waitForData == true) {
 						timeClientWaitedForLastMessage = chrono.getMillis();
 						chrono.stop();
@@ -1579,10 +1710,11 @@ namespace Game {
 						return;
 
 					}
-				} else if (networkMessageType == nmtCommandList) {
+				} else if (networkMessageType == nmtCommandList ||
+					networkMessageType == nmtCommandListCompact) {
 					//make sure we read the message
 					NetworkMessageCommandList networkMessageCommandList;
-					bool gotCmd = receiveMessage(&networkMessageCommandList);
+					bool gotCmd = receiveMessage(&networkMessageCommandList, networkMessageType);
 					if (gotCmd == false) {
 						printf("Server has interrupted network connection...\n");
 						return;
@@ -1858,6 +1990,28 @@ namespace Game {
 		sendMessage(&networkMessageReady);
 	}
 
+	void ClientInterface::startObserverRelay(int port) {
+		MutexSafeWrapper safeMutex(networkCommandListThreadAccessor, CODE_AT_LINE);
+		if (observerRelay != NULL) {
+			return;
+		}
+
+		try {
+			observerRelay = new ObserverRelay(port, playerIndex, sessionKey, serverName, getProtocolFeatures());
+			observerRelay->start();
+
+			if (SystemFlags::VERBOSE_MODE_ENABLED) printf("Observer relay is listening on port %d\n", port);
+		} catch (const exception &ex) {
+			observerRelay = NULL;
+			SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error starting observer relay on port %d [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, port, ex.what());
+		}
+	}
+
+	ObserverRelay * ClientInterface::getObserverRelay() {
+		MutexSafeWrapper safeMutex(networkCommandListThreadAccessor, CODE_AT_LINE);
+		return observerRelay;
+	}
+
 	void ClientInterface::sendTextMessage(const string &text, int teamIndex, bool echoLocal,
 		string targetLanguage) {
 
@@ -2037,6 +2191,9 @@ namespace Game {
 		this->joinGameInProgress = false;
 		this->joinGameInProgressLaunch = false;
 		this->readyForInGameJoin = false;
+		std::vector<char>().swap(this->joinGameSnapshot);
+		this->joinGameSnapshotSize = 0;
+		this->joinGameSnapshotUncompressedSize = 0;
 
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] END\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
 	}
@@ -2098,6 +2255,13 @@ namespace Game {
 				this->receiveMessage(&msg);
 			}
 			break;
+			case nmtGameSnapshotChunk:
+			{
+				discard = true;
+				NetworkMessageGameSnapshotChunk msg = NetworkMessageGameSnapshotChunk();
+				this->receiveMessage(&msg);
+			}
+			break;
 			case nmtText:
 			{
 				if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] got nmtText\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
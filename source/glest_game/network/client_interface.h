@@ -36,6 +36,7 @@ using std::vector;
 
 namespace Game {
 	class ClientInterface;
+	class ObserverRelay;
 
 	class ClientInterfaceThread : public BaseThread, public SlaveThreadControllerInterface {
 	protected:
@@ -98,6 +99,7 @@ namespace Game {
 		Mutex *networkCommandListThreadAccessor;
 		std::map<int, Commands> cachedPendingCommands;	//commands ready to be given
 		std::map<int, vector<uint32> > cachedPendingCommandCRCs;	//commands ready to be given
+		std::map<int, int> cachedPendingFramePeriods;	//network frame period announced per frame
 		uint64 cachedPendingCommandsIndex;
 		uint64 cachedLastPendingFrameCount;
 		int64 timeClientWaitedForLastMessage;
@@ -108,6 +110,17 @@ namespace Game {
 		bool readyForInGameJoin;
 		bool resumeInGameJoin;
 
+		// Deflated join in progress snapshot streamed by the server
+		std::vector<char> joinGameSnapshot;
+		uint32 joinGameSnapshotSize;
+		uint32 joinGameSnapshotUncompressedSize;
+
+		void receiveGameSnapshotChunks();
+
+		// Re-broadcasts what we watch to downstream observers, see
+		// ObserverRelay
+		ObserverRelay *observerRelay;
+
 		Mutex *quitThreadAccessor;
 		bool quitThread;
 
@@ -130,10 +143,16 @@ namespace Game {
 		bool getJoinGameInProgressLaunch();
 
 		bool getReadyForInGameJoin();
+		// Inflates a completely received join snapshot into snapshot and
+		// releases it, returns false if none was streamed
+		bool takeJoinGameSnapshot(std::vector<char> &snapshot);
 
 		bool getResumeInGameJoin();
 		void sendResumeGameMessage();
 
+		void startObserverRelay(int port);
+		ObserverRelay * getObserverRelay();
+
 		uint64 getCachedLastPendingFrameCount();
 		int64 getTimeClientWaitedForLastMessage();
 
@@ -25,6 +25,8 @@
 #include "server_interface.h"
 #include "network_message.h"
 #include "platform_util.h"
+#include "compression_utils.h"
+#include "network_telemetry.h"
 #include <stdexcept>
 #include "shared_const.h"
 
@@ -231,6 +233,13 @@ namespace Game {
 					if (getGameStarted() == true) {
 						//printf("#A Checking action for slot: %d\n",slotIndex);
 
+						// The reactor thread reads all in game sockets so just
+						// idle until told to quit
+						if (this->slotInterface->getNetworkReactorEnabled() == true) {
+							semTaskSignalled.waitTillSignalled(250);
+							continue;
+						}
+
 						if (getQuitStatus() == true) {
 							if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d]\n", __FILE__, __FUNCTION__, __LINE__);
 							break;
@@ -355,6 +364,188 @@ namespace Game {
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s] Line: %d\n", __FILE__, __FUNCTION__, __LINE__);
 	}
 
+	// =====================================================
+	//	class ConnectionSlotReactorThread
+	// =====================================================
+
+	static const PLATFORM_SOCKET REACTOR_UNREGISTERED_SOCKET = (PLATFORM_SOCKET) (~0);
+
+	ConnectionSlotReactorThread::ConnectionSlotReactorThread(ConnectionSlotCallbackInterface *slotInterface) :
+		BaseThread(), signalledSlotQueue(1024), signalledSlotQueueOverflow(false) {
+		this->slotInterface = slotInterface;
+		uniqueID = "ConnectionSlotReactorThread";
+
+		for (int index = 0; index < GameConstants::maxPlayers; ++index) {
+			registeredSockets[index] = REACTOR_UNREGISTERED_SOCKET;
+		}
+	}
+
+	ConnectionSlotReactorThread::~ConnectionSlotReactorThread() {
+	}
+
+	bool ConnectionSlotReactorThread::canShutdown(bool deleteSelfIfShutdownDelayed) {
+		bool ret = (getExecutingTask() == false);
+		if (ret == false && deleteSelfIfShutdownDelayed == true) {
+			setDeleteSelfOnExecutionDone(deleteSelfIfShutdownDelayed);
+			deleteSelfIfRequired();
+			signalQuit();
+		}
+
+		return ret;
+	}
+
+	bool ConnectionSlotReactorThread::popSignalledSlot(int &slotIndex) {
+		return signalledSlotQueue.pop(slotIndex);
+	}
+
+	bool ConnectionSlotReactorThread::getSignalledSlotQueueOverflow(bool clearFlag) {
+		if (clearFlag == true) {
+			return signalledSlotQueueOverflow.exchange(false);
+		}
+		return signalledSlotQueueOverflow.load();
+	}
+
+	void ConnectionSlotReactorThread::updateRegisteredSockets() {
+		// Sockets stay registered between waits, we only touch the reactor
+		// when a slot connects, disconnects or starts playing
+		for (int index = 0; index < GameConstants::maxPlayers; ++index) {
+			PLATFORM_SOCKET socketId = REACTOR_UNREGISTERED_SOCKET;
+
+			MutexSafeWrapper safeMutex(this->slotInterface->getSlotMutex(index), CODE_AT_LINE);
+			ConnectionSlot *slot = this->slotInterface->getSlot(index, false);
+			if (slot != NULL && slot->getGameStarted() == true) {
+				socketId = slot->getSocketId();
+			}
+			safeMutex.ReleaseLock();
+
+			if (socketId != registeredSockets[index]) {
+				if (Socket::isSocketValid(&registeredSockets[index]) == true) {
+					reactor.removeSocket(registeredSockets[index]);
+				}
+				registeredSockets[index] = REACTOR_UNREGISTERED_SOCKET;
+
+				if (Socket::isSocketValid(&socketId) == true &&
+					reactor.addSocket(socketId, index) == true) {
+					registeredSockets[index] = socketId;
+
+					// Edge triggered sockets only signal new data so pick up
+					// anything that arrived before registration
+					updateSlot(index);
+				}
+			}
+		}
+	}
+
+	void ConnectionSlotReactorThread::updateSlot(int slotIndex) {
+		const int MAX_SLOT_DRAIN_COUNT = 100;
+
+		PLATFORM_SOCKET socketId = registeredSockets[slotIndex];
+		bool socketHasReadData = true;
+		for (int drainCount = 0; socketHasReadData == true &&
+			drainCount < MAX_SLOT_DRAIN_COUNT && getQuitStatus() == false; ++drainCount) {
+
+			ConnectionSlotEvent eventCopy;
+			eventCopy.eventType = eReceiveSocketData;
+			eventCopy.connectionSlot = this->slotInterface->getSlot(slotIndex, true);
+			eventCopy.eventId = slotIndex;
+			eventCopy.socketTriggered = true;
+
+			if (eventCopy.connectionSlot == NULL) {
+				break;
+			}
+			eventCopy.connectionSlot->updateSlot(&eventCopy);
+
+			// ConnectionSlot::update stops after each command list, with edge
+			// triggering we must keep reading until the socket is empty
+			socketHasReadData = (Socket::isSocketValid(&socketId) == true &&
+				Socket::hasDataToRead(socketId) == true);
+		}
+
+		if (signalledSlotQueue.push(slotIndex) == false) {
+			signalledSlotQueueOverflow = true;
+		}
+	}
+
+	void ConnectionSlotReactorThread::execute() {
+		RunningStatusSafeWrapper runningStatus(this);
+		try {
+			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] edgeTriggered = %d\n", __FILE__, __FUNCTION__, __LINE__, SocketReactor::isEdgeTriggered());
+
+			std::vector<int> triggeredSlotList;
+			for (; this->slotInterface != NULL && getQuitStatus() == false;) {
+				ExecutingTaskSafeWrapper safeExecutingTaskMutex(this);
+
+				updateRegisteredSockets();
+				if (reactor.wait(triggeredSlotList, 50) < 0) {
+					sleep(5);
+					continue;
+				}
+
+				for (unsigned int index = 0; index < triggeredSlotList.size() && getQuitStatus() == false; ++index) {
+					int slotIndex = triggeredSlotList[index];
+					if (slotIndex >= 0 && slotIndex < GameConstants::maxPlayers) {
+						updateSlot(slotIndex);
+					}
+				}
+			}
+
+			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d]\n", __FILE__, __FUNCTION__, __LINE__);
+		} catch (const exception &ex) {
+			SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error [%s]\n", __FILE__, __FUNCTION__, __LINE__, ex.what());
+			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d]\n", __FILE__, __FUNCTION__, __LINE__);
+
+			throw game_runtime_error(ex.what());
+		}
+	}
+
+	// =====================================================
+	//	class GameSnapshotSendThread
+	// =====================================================
+
+	GameSnapshotSendThread::GameSnapshotSendThread(ConnectionSlot *slot, const std::vector<char> &snapshot) : BaseThread() {
+		this->slot = slot;
+		this->snapshot = snapshot;
+		setUniqueID("GameSnapshotSendThread");
+	}
+
+	void GameSnapshotSendThread::execute() {
+		RunningStatusSafeWrapper runningStatus(this);
+		ExecutingTaskSafeWrapper safeExecutingTaskMutex(this);
+
+		try {
+			if (snapshot.empty() == true || getQuitStatus() == true) {
+				return;
+			}
+
+			Chrono chrono;
+			chrono.start();
+
+			std::pair<unsigned char *, unsigned long> compressionResult =
+				Shared::CompressionUtil::compressMemoryToMemory((unsigned char *) &snapshot[0], (unsigned long) snapshot.size());
+			uint32 uncompressedSize = (uint32) snapshot.size();
+			uint32 snapshotSize = (uint32) compressionResult.second;
+			snapshot.clear();
+
+			for (uint32 offset = 0; offset < snapshotSize && getQuitStatus() == false;) {
+				uint32 chunkSize = min((uint32) maxGameSnapshotChunkSize, snapshotSize - offset);
+				NetworkMessageGameSnapshotChunk networkMessageGameSnapshotChunk(snapshotSize, uncompressedSize,
+					offset, (const char *) compressionResult.first + offset, chunkSize);
+				slot->sendMessage(&networkMessageGameSnapshotChunk);
+				offset += chunkSize;
+			}
+			delete[] compressionResult.first;
+
+			if (getQuitStatus() == false) {
+				NetworkMessageReady networkMessageReady(0);
+				slot->sendMessage(&networkMessageReady);
+			}
+
+			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] sent game snapshot of %u bytes (%u deflated) in %lld msecs\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, uncompressedSize, snapshotSize, (long long int) chrono.getMillis());
+		} catch (const exception &ex) {
+			SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, ex.what());
+		}
+	}
+
 	// =====================================================
 	//	class ConnectionSlot
 	// =====================================================
@@ -386,6 +577,12 @@ namespace Game {
 		this->skipLagCheck = true;
 		this->joinGameInProgress = false;
 		this->canAcceptConnections = true;
+		this->lastPingProbeTime = 0;
+		this->pingProbePending = false;
+		this->smoothedRoundTripMillis = 0;
+		this->roundTripVarianceMillis = 0;
+		this->hasRoundTripSample = false;
+		this->gameSnapshotSendThread = NULL;
 		this->startInGameConnectionLaunch = false;
 		this->pauseForInGameConnection = false;
 		this->unPauseForInGameConnection = false;
@@ -536,6 +733,7 @@ namespace Game {
 	}
 
 	void ConnectionSlot::update(bool checkForNewClients, int lockedSlotIndex) {
+		NetworkTelemetryScopeTimer telemetryTimer(playerIndex);
 		try {
 			clearThreadErrorList();
 
@@ -628,7 +826,8 @@ namespace Game {
 								"",
 								serverInterface->getGameHasBeenInitiated(),
 								Config::getInstance().getString("PlayerId", ""),
-								getPlatformNameString());
+								getPlatformNameString(),
+								getLocalProtocolFeatures());
 							sendMessage(&networkMessageIntro);
 
 							if (this->serverInterface->getGameHasBeenInitiated() == true) {
@@ -682,6 +881,14 @@ namespace Game {
 								if (receiveMessage(&networkMessagePing)) {
 									if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d]\n", __FILE__, __FUNCTION__, __LINE__);
 									lastPingInfo = networkMessagePing;
+
+									// Echo of one of our probes, the client answers from its
+									// network thread so this includes its processing delay
+									if (networkMessagePing.getPingFrequency() == networkPingProbeFrequency &&
+										networkMessagePing.getPingTime() == lastPingProbeTime) {
+										pingProbePending = false;
+										addRoundTripSample(Chrono::getCurMillis() - lastPingProbeTime);
+									}
 								} else {
 									if (SystemFlags::getSystemSettingType(SystemFlags::debugError).enabled) SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d]\nInvalid message type before intro handshake [%d]\nDisconnecting socket for slot: %d [%s].\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, networkMessageType, this->playerIndex, this->getIpAddress().c_str());
 									this->serverInterface->notifyBadClientConnectAttempt(this->getIpAddress());
@@ -800,13 +1007,14 @@ namespace Game {
 							break;
 
 							//command list
-							case nmtCommandList: {
+							case nmtCommandList:
+							case nmtCommandListCompact: {
 
 								if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] got nmtCommandList gotIntro = %d\n", __FILE__, __FUNCTION__, __LINE__, gotIntro);
 
 								if (gotIntro == true) {
 									NetworkMessageCommandList networkMessageCommandList;
-									if (receiveMessage(&networkMessageCommandList)) {
+									if (receiveMessage(&networkMessageCommandList, networkMessageType)) {
 										currentFrameCount = networkMessageCommandList.getFrameCount();
 										lastReceiveCommandListTime = time(NULL);
 
@@ -848,6 +1056,7 @@ namespace Game {
 									this->playerLanguage = networkMessageIntro.getPlayerLanguage();
 									this->playerUUID = networkMessageIntro.getPlayerUUID();
 									this->platform = networkMessageIntro.getPlayerPlatform();
+									this->setProtocolFeatures(networkMessageIntro.getSupportedProtocolFeatures() & getLocalProtocolFeatures());
 
 									//printf("Got uuid from client [%s]\n",this->playerUUID.c_str());
 									if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s] got name [%s] versionString [%s], msgSessionId = %d\n", __FILE__, __FUNCTION__, name.c_str(), versionString.c_str(), msgSessionId);
@@ -1296,6 +1505,16 @@ namespace Game {
 							case nmtLoadingStatusMessage:
 								break;
 
+							case nmtIntroLegacy:
+							{
+								string sErr = "Client at " + this->getIpAddress() + " runs an older network protocol version, disconnecting";
+								printf("%s\n", sErr.c_str());
+								if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] %s\n", __FILE__, __FUNCTION__, __LINE__, sErr.c_str());
+
+								close();
+								return;
+							}
+
 							default:
 							{
 								if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] networkMessageType = %d\n", __FILE__, __FUNCTION__, __LINE__, networkMessageType);
@@ -1414,6 +1633,51 @@ namespace Game {
 		this->sentSavedGameInfo = false;
 	}
 
+	void ConnectionSlot::sendPingProbe() {
+		lastPingProbeTime = Chrono::getCurMillis();
+		pingProbePending = true;
+		NetworkMessagePing networkMessagePing(networkPingProbeFrequency, lastPingProbeTime);
+		sendMessage(&networkMessagePing);
+	}
+
+	void ConnectionSlot::sendGameSnapshot(const std::vector<char> &snapshot) {
+		stopGameSnapshotSend();
+
+		gameSnapshotSendThread = new GameSnapshotSendThread(this, snapshot);
+		gameSnapshotSendThread->start();
+	}
+
+	void ConnectionSlot::stopGameSnapshotSend() {
+		if (gameSnapshotSendThread != NULL) {
+			// The sender stops after the chunk it is writing
+			gameSnapshotSendThread->signalQuit();
+			if (gameSnapshotSendThread->shutdownAndWait() == true) {
+				delete gameSnapshotSendThread;
+			}
+			gameSnapshotSendThread = NULL;
+		}
+	}
+
+	void ConnectionSlot::addRoundTripSample(int64 roundTripMillis) {
+		if (roundTripMillis < 0) {
+			return;
+		}
+		if (NetworkTelemetry::isEnabled() == true) {
+			NetworkTelemetry::recordRoundTrip(playerIndex, roundTripMillis);
+		}
+		if (hasRoundTripSample == false) {
+			smoothedRoundTripMillis = roundTripMillis;
+			roundTripVarianceMillis = roundTripMillis / 2;
+			hasRoundTripSample = true;
+		} else {
+			int64 deviation = roundTripMillis - smoothedRoundTripMillis;
+			smoothedRoundTripMillis += deviation / 8;
+			roundTripVarianceMillis += ((deviation < 0 ? -deviation : deviation) - roundTripVarianceMillis) / 4;
+		}
+
+		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] playerIndex = %d, roundTripMillis = %lld, smoothed = %lld, variance = %lld\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, playerIndex, (long long int) roundTripMillis, (long long int) smoothedRoundTripMillis, (long long int) roundTripVarianceMillis);
+	}
+
 	void ConnectionSlot::close() {
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s LINE: %d]\n", __FILE__, __FUNCTION__, __LINE__);
 
@@ -1423,10 +1687,15 @@ namespace Game {
 		//}
 		//printf("ConnectionSlot::close() #1 this->getSocket() = %p\n",this->getSocket());
 
+		stopGameSnapshotSend();
+
 		this->gotIntro = false;
 		this->skipLagCheck = true;
 		this->joinGameInProgress = false;
 		this->sentSavedGameInfo = false;
+		this->lastPingProbeTime = 0;
+		this->pingProbePending = false;
+		this->hasRoundTripSample = false;
 		this->pauseForInGameConnection = false;
 		this->unPauseForInGameConnection = false;
 		this->ready = false;
@@ -1573,6 +1842,7 @@ namespace Game {
 
 	void ConnectionSlot::deleteSocket() {
 		MutexSafeWrapper safeMutexSlot(mutexSocket, CODE_AT_LINE);
+		NetworkTelemetry::removeSocket(socket);
 		delete socket;
 		socket = NULL;
 	}
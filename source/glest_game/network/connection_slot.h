@@ -23,6 +23,7 @@
 #include "socket.h"
 #include "network_interface.h"
 #include "base_thread.h"
+#include "lock_free_queue.h"
 #include <time.h>
 #include <vector>
 
@@ -30,6 +31,8 @@
 
 using Shared::Platform::ServerSocket;
 using Shared::Platform::Socket;
+using Shared::Platform::SocketReactor;
+using Shared::PlatformCommon::LockFreeQueue;
 using std::vector;
 
 namespace Game {
@@ -79,6 +82,9 @@ namespace Game {
 		virtual Mutex *getSlotMutex(int index) = 0;
 
 		virtual void slotUpdateTask(ConnectionSlotEvent *event) = 0;
+		virtual bool getNetworkReactorEnabled() const {
+			return false;
+		}
 		virtual ~ConnectionSlotCallbackInterface() {
 		}
 	};
@@ -132,6 +138,58 @@ namespace Game {
 		virtual bool canShutdown(bool deleteSelfIfShutdownDelayed = false);
 	};
 
+	// =====================================================
+	//	class ConnectionSlotReactorThread
+	//
+	//	Drives the socket reads of all in game connection slots
+	//	from a single thread using a SocketReactor instead of
+	//	one polling ConnectionSlotThread per slot. Slots that
+	//	received data are reported to the game thread through
+	//	a lock free queue.
+	// =====================================================
+
+	class ConnectionSlotReactorThread : public BaseThread {
+	protected:
+
+		ConnectionSlotCallbackInterface * slotInterface;
+		SocketReactor reactor;
+		PLATFORM_SOCKET registeredSockets[GameConstants::maxPlayers];
+		LockFreeQueue<int> signalledSlotQueue;
+		std::atomic<bool> signalledSlotQueueOverflow;
+
+		void updateRegisteredSockets();
+		void updateSlot(int slotIndex);
+
+	public:
+		explicit ConnectionSlotReactorThread(ConnectionSlotCallbackInterface *slotInterface);
+		virtual ~ConnectionSlotReactorThread();
+
+		virtual void execute();
+		virtual bool canShutdown(bool deleteSelfIfShutdownDelayed = false);
+
+		// Called from the game thread only
+		bool popSignalledSlot(int &slotIndex);
+		bool getSignalledSlotQueueOverflow(bool clearFlag);
+	};
+
+	// =====================================================
+	//	class GameSnapshotSendThread
+	//
+	//	Deflates the snapshot of a game in progress and streams
+	//	it to a joining client in chunks, followed by the ready
+	//	message, without holding up the game thread
+	// =====================================================
+
+	class GameSnapshotSendThread : public BaseThread {
+	protected:
+		ConnectionSlot *slot;
+		std::vector<char> snapshot;
+
+	public:
+		GameSnapshotSendThread(ConnectionSlot *slot, const std::vector<char> &snapshot);
+		virtual void execute();
+	};
+
 	// =====================================================
 	//	class ConnectionSlot
 	// =====================================================
@@ -178,6 +236,18 @@ namespace Game {
 
 		int autoPauseGameCountForLag;
 
+		// Round trip estimate from in game ping probes, smoothed like TCP
+		int64 lastPingProbeTime;
+		bool pingProbePending;
+		int64 smoothedRoundTripMillis;
+		int64 roundTripVarianceMillis;
+		bool hasRoundTripSample;
+
+		GameSnapshotSendThread *gameSnapshotSendThread;
+
+		void addRoundTripSample(int64 roundTripMillis);
+		void stopGameSnapshotSend();
+
 	public:
 		ConnectionSlot(ServerInterface* serverInterface, int playerIndex);
 		~ConnectionSlot();
@@ -226,9 +296,27 @@ namespace Game {
 		bool getSentSavedGameInfo() const {
 			return sentSavedGameInfo;
 		}
+
+		void sendPingProbe();
+		int64 getLastPingProbeTime() const {
+			return lastPingProbeTime;
+		}
+		bool getPingProbePending() const {
+			return pingProbePending;
+		}
+		bool getHasRoundTripSample() const {
+			return hasRoundTripSample;
+		}
+		// Smoothed round trip plus twice its mean deviation
+		int64 getRoundTripDelayMillis() const {
+			return smoothedRoundTripMillis + 2 * roundTripVarianceMillis;
+		}
 		void setSentSavedGameInfo(bool value) {
 			sentSavedGameInfo = value;
 		}
+		// Streams the binary snapshot to a slot that negotiated
+		// npfStreamedJoinSnapshot instead of sending it through FTP
+		void sendGameSnapshot(const std::vector<char> &snapshot);
 
 		ConnectionSlotThread *getWorkerThread() {
 			return slotThreadWorker;
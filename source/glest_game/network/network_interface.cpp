@@ -27,7 +27,8 @@
 #include "platform_util.h"
 #include <fstream>
 #include "util.h"
-#include "network_protocol.h"
+#include "config.h"
+#include "network_telemetry.h"
 #include "leak_dumper.h"
 
 using namespace Shared::Platform;
@@ -59,6 +60,7 @@ namespace Game {
 		for (unsigned int index = 0; index < (unsigned int) GameConstants::maxPlayers; ++index) {
 			networkPlayerFactionCRC[index] = 0;
 		}
+		protocolFeatures = npfNone;
 	}
 
 	void NetworkInterface::init() {
@@ -75,6 +77,7 @@ namespace Game {
 		for (unsigned int index = 0; index < (unsigned int) GameConstants::maxPlayers; ++index) {
 			networkPlayerFactionCRC[index] = 0;
 		}
+		protocolFeatures = npfNone;
 	}
 
 	NetworkInterface::~NetworkInterface() {
@@ -118,10 +121,38 @@ namespace Game {
 		unmarkedCellList.push_back(msg);
 	}
 
+	uint32 NetworkInterface::getLocalProtocolFeatures() {
+		uint32 features = npfNone;
+		if (Config::getInstance().getBool("EnableCompactCommandList", "true") == true) {
+			features |= npfCompactCommandList;
+		}
+		if (Config::getInstance().getBool("EnableNetworkCompression", "true") == true) {
+			features |= npfCompression;
+		}
+		// The announced period travels in the compact command list only
+		if ((features & npfCompactCommandList) != 0 &&
+			Config::getInstance().getBool("EnableAdaptiveNetworkFramePeriod", "true") == true) {
+			features |= npfAdaptiveFramePeriod;
+		}
+		if (Config::getInstance().getBool("EnableStreamedJoinSnapshot", "true") == true) {
+			features |= npfStreamedJoinSnapshot;
+		}
+		if (Config::getInstance().getBool("EnableContentTransfer", "true") == true) {
+			features |= npfContentTransfer;
+		}
+		return features;
+	}
+
 	void NetworkInterface::sendMessage(NetworkMessage* networkMessage) {
 		Socket* socket = getSocket(false);
 
-		networkMessage->send(socket);
+		networkMessage->setProtocolFeatures(protocolFeatures);
+		if (socket == NULL || networkMessage->sendShared(socket) == false) {
+			networkMessage->sendNegotiated(socket);
+		}
+		if (socket != NULL && NetworkTelemetry::isEnabled() == true) {
+			NetworkTelemetry::recordSend(socket, networkMessage->getNetworkMessageType(), 0, true);
+		}
 	}
 
 	NetworkMessageType NetworkInterface::getNextMessageType(int waitMilliseconds) {
@@ -176,6 +207,7 @@ namespace Game {
 			(waitMilliseconds > 0 && socket->hasDataToReadWithWait(waitMilliseconds) == true))) {
 			//peek message type
 			int dataSize = socket->getDataToRead();
+			int bytesReceived = 0;
 			if (dataSize >= (int)sizeof(messageType)) {
 				//if(SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork,"In [%s::%s Line: %d] socket->getDataToRead() dataSize = %d\n",extractFileFromDirectoryPath(__FILE__).c_str(),__FUNCTION__,__LINE__,dataSize);
 				if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] before recv\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
@@ -183,7 +215,7 @@ namespace Game {
 				//			int iPeek = socket->peek(&messageType, sizeof(messageType));
 				//			if(SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork,"In [%s::%s Line: %d] socket->getDataToRead() iPeek = %d, messageType = %d [size = %d]\n",extractFileFromDirectoryPath(__FILE__).c_str(),__FUNCTION__,__LINE__,iPeek,messageType,sizeof(messageType));
 				//			if(iPeek > 0) {
-				int bytesReceived = socket->receive(&messageType, sizeof(messageType), true);
+				bytesReceived = socket->receive(&messageType, sizeof(messageType), true);
 				if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] socket->getDataToRead() iPeek = %d, messageType = %d [size = %d]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, bytesReceived, messageType, sizeof(messageType));
 				//}
 			}
@@ -194,6 +226,11 @@ namespace Game {
 			if (socket->isSocketValid() == false) {
 				return nmtInvalid;
 			}
+			if (messageType == nmtCompressedPacket) {
+				messageType = NetworkMessage::receiveCompressedPacket(socket);
+			} else if (bytesReceived > 0 && NetworkTelemetry::isEnabled() == true) {
+				NetworkTelemetry::recordReceive(socket, static_cast<NetworkMessageType>(messageType), bytesReceived, true);
+			}
 			//sanity check new message type
 			if (messageType < 0 || messageType >= nmtCount) {
 				if (getConnectHasHandshaked() == true) {
@@ -213,6 +250,7 @@ namespace Game {
 
 		Socket* socket = getSocket(false);
 
+		networkMessage->setProtocolFeatures(protocolFeatures);
 		return networkMessage->receive(socket);
 	}
 
@@ -221,6 +259,7 @@ namespace Game {
 
 		Socket* socket = getSocket(false);
 
+		networkMessage->setProtocolFeatures(protocolFeatures);
 		return networkMessage->receive(socket, type);
 	}
 
@@ -405,6 +444,7 @@ namespace Game {
 
 	GameNetworkInterface::GameNetworkInterface() {
 		quit = false;
+		networkFramePeriodChange = 0;
 	}
 
 	void GameNetworkInterface::requestCommand(const NetworkCommand *networkCommand, bool insertAtStart) {
@@ -240,6 +240,8 @@ namespace Game {
 		Mutex *networkPlayerFactionCRCMutex;
 		uint32 networkPlayerFactionCRC[GameConstants::maxPlayers];
 
+		uint32 protocolFeatures;
+
 	public:
 		static const int readyWaitTimeout;
 		GameSettings gameSettings;
@@ -262,6 +264,16 @@ namespace Game {
 
 		virtual Socket* getSocket(bool mutexLock = true) = 0;
 
+		// Protocol features this build offers in its intro message
+		static uint32 getLocalProtocolFeatures();
+		// Features both ends support, set once the peer's intro arrives
+		uint32 getProtocolFeatures() const {
+			return protocolFeatures;
+		}
+		void setProtocolFeatures(uint32 value) {
+			protocolFeatures = value;
+		}
+
 		virtual void close() = 0;
 		virtual string getHumanPlayerName(int index = -1) = 0;
 		virtual int getHumanPlayerIndex() const = 0;
@@ -390,6 +402,7 @@ namespace Game {
 		Commands requestedCommands;	//commands requested by the user
 		Commands pendingCommands;	//commands ready to be given
 		bool quit;
+		int networkFramePeriodChange;	//period announced with the last keyframe, 0 if unchanged
 
 	public:
 		GameNetworkInterface();
@@ -430,6 +443,14 @@ namespace Game {
 		bool getQuit() const {
 			return quit;
 		}
+
+		// Returns the network frame period the server announced with the
+		// keyframe just processed (0 if unchanged) and clears it
+		int takeNetworkFramePeriodChange() {
+			int result = networkFramePeriodChange;
+			networkFramePeriodChange = 0;
+			return result;
+		}
 	};
 
 	// =====================================================
@@ -25,8 +25,8 @@
 #include "checksum.h"
 #include "platform_util.h"
 #include "config.h"
-#include "network_protocol.h"
 #include "compression_utils.h"
+#include "network_telemetry.h"
 #include <algorithm>
 #include <cassert>
 #include <stdexcept>
@@ -54,7 +54,12 @@ namespace Game {
 
 	bool NetworkMessage::receive(Socket* socket, void* data, int dataSize, bool tryReceiveUntilDataSizeMet) {
 		if (socket != NULL) {
+			// Bytes unwrapped from a compressed envelope were counted on arrival
+			bool fromWire = (socket->hasUnreadData() == false);
 			int dataReceived = socket->receive(data, dataSize, tryReceiveUntilDataSizeMet);
+			if (fromWire == true && dataReceived > 0 && NetworkTelemetry::isEnabled() == true) {
+				NetworkTelemetry::recordReceive(socket, getNetworkMessageType(), dataReceived, false);
+			}
 			if (dataReceived != dataSize) {
 				if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] WARNING, dataReceived = %d dataSize = %d\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, dataReceived, dataSize);
 				if (SystemFlags::VERBOSE_MODE_ENABLED) printf("\nIn [%s::%s Line: %d] WARNING, dataReceived = %d dataSize = %d\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, dataReceived, dataSize);
@@ -79,17 +84,21 @@ namespace Game {
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] socket = %p, data = %p, dataSize = %d\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, socket, data, dataSize);
 
 		if (socket != NULL) {
-			dump_packet("\nOUTGOING PACKET:\n", data, dataSize, true);
-			int sendResult = socket->send(data, dataSize);
-			if (sendResult != dataSize) {
-				if (socket != NULL && socket->isSocketValid() == true) {
-					char szBuf[8096] = "";
-					snprintf(szBuf, 8096, "Error sending NetworkMessage, sendResult = %d, dataSize = %d", sendResult, dataSize);
-					throw game_runtime_error(szBuf);
-				} else {
-					if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s] Line: %d socket has been disconnected\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
+			// A copy is only needed when the payload outlives this call
+			if (serializeBufferList == NULL && capturingSharedSend == false &&
+				sendQueueBufferList == NULL && socket->isSendBatchEnabled() == false) {
+				dump_packet("\nOUTGOING PACKET:\n", data, dataSize, true);
+				int sendResult = socket->send(data, dataSize);
+				if (sendResult > 0 && NetworkTelemetry::isEnabled() == true) {
+					NetworkTelemetry::recordSend(socket, getNetworkMessageType(), sendResult, false);
 				}
+				checkSendResult(socket, sendResult, dataSize);
+				return;
 			}
+
+			const char *dataBuffer = (const char *) data;
+			std::vector<char> *out_buffer = new std::vector<char>(dataBuffer, dataBuffer + dataSize);
+			sendBuffer(socket, SocketSendBuffer(out_buffer));
 		}
 	}
 
@@ -100,24 +109,11 @@ namespace Game {
 			int msgTypeSize = sizeof(messageType);
 			int fullMsgSize = msgTypeSize + dataSize;
 
-			char *out_buffer = new char[fullMsgSize];
-			memcpy(out_buffer, &messageType, msgTypeSize);
-			memcpy(&out_buffer[msgTypeSize], (const char *) data, dataSize);
+			std::vector<char> *out_buffer = new std::vector<char>(fullMsgSize);
+			memcpy(&(*out_buffer)[0], &messageType, msgTypeSize);
+			memcpy(&(*out_buffer)[msgTypeSize], (const char *) data, dataSize);
 
-			dump_packet("\nOUTGOING PACKET:\n", out_buffer, fullMsgSize, true);
-			int sendResult = socket->send(out_buffer, fullMsgSize);
-			if (sendResult != fullMsgSize) {
-				delete[] out_buffer;
-				if (socket != NULL && socket->isSocketValid() == true) {
-					char szBuf[8096] = "";
-					snprintf(szBuf, 8096, "Error sending NetworkMessage, sendResult = %d, dataSize = %d", sendResult, fullMsgSize);
-					throw game_runtime_error(szBuf);
-				} else {
-					if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s] Line: %d socket has been disconnected\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
-				}
-			} else {
-				delete[] out_buffer;
-			}
+			sendBuffer(socket, SocketSendBuffer(out_buffer));
 		}
 	}
 
@@ -129,26 +125,191 @@ namespace Game {
 			int compressedSize = sizeof(compressedLength);
 			int fullMsgSize = msgTypeSize + compressedSize + dataSize;
 
-			char *out_buffer = new char[fullMsgSize];
-			memcpy(out_buffer, &messageType, msgTypeSize);
-			memcpy(&out_buffer[msgTypeSize], &compressedLength, compressedSize);
-			memcpy(&out_buffer[msgTypeSize + compressedSize], (const char *) data, dataSize);
+			std::vector<char> *out_buffer = new std::vector<char>(fullMsgSize);
+			memcpy(&(*out_buffer)[0], &messageType, msgTypeSize);
+			memcpy(&(*out_buffer)[msgTypeSize], &compressedLength, compressedSize);
+			memcpy(&(*out_buffer)[msgTypeSize + compressedSize], (const char *) data, dataSize);
 
-			dump_packet("\nOUTGOING PACKET:\n", out_buffer, fullMsgSize, true);
-			int sendResult = socket->send(out_buffer, fullMsgSize);
-			if (sendResult != fullMsgSize) {
-				delete[] out_buffer;
-				if (socket != NULL && socket->isSocketValid() == true) {
-					char szBuf[8096] = "";
-					snprintf(szBuf, 8096, "Error sending NetworkMessage, sendResult = %d, dataSize = %d", sendResult, fullMsgSize);
-					throw game_runtime_error(szBuf);
-				} else {
-					if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s] Line: %d socket has been disconnected\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
-				}
+			sendBuffer(socket, SocketSendBuffer(out_buffer));
+		}
+	}
+
+	void NetworkMessage::sendBuffer(Socket* socket, const SocketSendBuffer &buffer) {
+		if (serializeBufferList != NULL) {
+			serializeBufferList->push_back(buffer);
+			return;
+		}
+		if (capturingSharedSend == true) {
+			sharedSendBufferList.push_back(buffer);
+		}
+		if (sendQueueBufferList != NULL) {
+			sendQueueBufferList->push_back(buffer);
+			return;
+		}
+
+		int fullMsgSize = (int) buffer->size();
+		dump_packet("\nOUTGOING PACKET:\n", &(*buffer)[0], fullMsgSize, true);
+		int sendResult = socket->sendBuffer(buffer);
+		if (sendResult > 0 && NetworkTelemetry::isEnabled() == true) {
+			NetworkTelemetry::recordSend(socket, getNetworkMessageType(), sendResult, false);
+		}
+		checkSendResult(socket, sendResult, fullMsgSize);
+	}
+
+	void NetworkMessage::checkSendResult(Socket* socket, int sendResult, int dataSize) {
+		if (sendResult != dataSize) {
+			if (socket != NULL && socket->isSocketValid() == true) {
+				char szBuf[8096] = "";
+				snprintf(szBuf, 8096, "Error sending NetworkMessage, sendResult = %d, dataSize = %d", sendResult, dataSize);
+				throw game_runtime_error(szBuf);
 			} else {
-				delete[] out_buffer;
+				if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s] Line: %d socket has been disconnected\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
+			}
+		}
+	}
+
+	void NetworkMessage::beginSharedSend() {
+		sharedSendBufferList.clear();
+		captureSharedSend = true;
+	}
+
+	void NetworkMessage::endSharedSend() {
+		captureSharedSend = false;
+		capturingSharedSend = false;
+		sharedSendBufferList.clear();
+	}
+
+	bool NetworkMessage::sendShared(Socket* socket) {
+		if (captureSharedSend == false) {
+			return false;
+		}
+
+		// The first send is serialized and captured, later sends with the same
+		// negotiated features replay the captured buffers
+		if (sharedSendBufferList.empty() == true) {
+			sharedSendProtocolFeatures = protocolFeatures;
+			capturingSharedSend = true;
+			try {
+				sendNegotiated(socket);
+			} catch (...) {
+				capturingSharedSend = false;
+				throw;
+			}
+			capturingSharedSend = false;
+			return true;
+		} else if (sharedSendProtocolFeatures != protocolFeatures) {
+			return false;
+		}
+
+		for (unsigned int index = 0; index < sharedSendBufferList.size(); ++index) {
+			sendBuffer(socket, sharedSendBufferList[index]);
+		}
+		return true;
+	}
+
+	void NetworkMessage::sendNegotiated(Socket* socket) {
+		if (socket == NULL || (protocolFeatures & npfCompression) == 0) {
+			send(socket);
+			return;
+		}
+
+		vector<SocketSendBuffer> bufferList;
+		serializeBufferList = &bufferList;
+		try {
+			send(socket);
+		} catch (...) {
+			serializeBufferList = NULL;
+			throw;
+		}
+		serializeBufferList = NULL;
+
+		size_t totalSize = 0;
+		for (unsigned int index = 0; index < bufferList.size(); ++index) {
+			totalSize += bufferList[index]->size();
+		}
+
+		if (totalSize >= (size_t) minCompressedPacketSize && totalSize <= (size_t) maxCompressedPacketSize) {
+			std::vector<unsigned char> rawMessage;
+			rawMessage.reserve(totalSize);
+			for (unsigned int index = 0; index < bufferList.size(); ++index) {
+				rawMessage.insert(rawMessage.end(), bufferList[index]->begin(), bufferList[index]->end());
 			}
+
+			std::pair<unsigned char *, unsigned long> compressionResult =
+				Shared::CompressionUtil::compressMemoryToMemory(&rawMessage[0], (unsigned long) totalSize);
+
+			// Already compressed payloads (e.g. launch) go out unwrapped
+			const int envelopeHeaderSize = sizeof(int8) + sizeof(uint32) * 2;
+			if (compressionResult.second + envelopeHeaderSize < totalSize) {
+				uint32 compressedSize = (uint32) compressionResult.second;
+				uint32 uncompressedSize = (uint32) totalSize;
+
+				std::vector<char> *envelope = new std::vector<char>(envelopeHeaderSize + compressedSize);
+				(*envelope)[0] = static_cast<char>(nmtCompressedPacket);
+				for (int byteIndex = 0; byteIndex < 4; ++byteIndex) {
+					(*envelope)[1 + byteIndex] = static_cast<char>((compressedSize >> (byteIndex * 8)) & 0xFF);
+					(*envelope)[5 + byteIndex] = static_cast<char>((uncompressedSize >> (byteIndex * 8)) & 0xFF);
+				}
+				memcpy(&(*envelope)[envelopeHeaderSize], compressionResult.first, compressedSize);
+				delete[] compressionResult.first;
+
+				if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] compressed messageType = %d from %u to %u bytes\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, getNetworkMessageType(), uncompressedSize, compressedSize);
+
+				sendBuffer(socket, SocketSendBuffer(envelope));
+				return;
+			}
+			delete[] compressionResult.first;
+		}
+
+		for (unsigned int index = 0; index < bufferList.size(); ++index) {
+			sendBuffer(socket, bufferList[index]);
+		}
+	}
+
+	NetworkMessageType NetworkMessage::receiveCompressedPacket(Socket* socket) {
+		unsigned char header[sizeof(uint32) * 2];
+		if (socket == NULL || socket->receive(header, sizeof(header), true) != (int) sizeof(header)) {
+			return nmtInvalid;
+		}
+
+		uint32 compressedSize = 0;
+		uint32 uncompressedSize = 0;
+		for (int byteIndex = 0; byteIndex < 4; ++byteIndex) {
+			compressedSize |= static_cast<uint32>(header[byteIndex]) << (byteIndex * 8);
+			uncompressedSize |= static_cast<uint32>(header[4 + byteIndex]) << (byteIndex * 8);
+		}
+		if (compressedSize == 0 || uncompressedSize < 1 ||
+			compressedSize > (uint32) maxCompressedPacketSize ||
+			uncompressedSize > (uint32) maxCompressedPacketSize) {
+			throw game_runtime_error("Error receiving compressed NetworkMessage, compressedSize = " + uIntToStr(compressedSize) + ", uncompressedSize = " + uIntToStr(uncompressedSize));
+		}
+
+		std::vector<unsigned char> compressedMessage(compressedSize);
+		if (socket->receive(&compressedMessage[0], compressedSize, true) != (int) compressedSize) {
+			return nmtInvalid;
 		}
+
+		std::pair<unsigned char *, unsigned long> decompressedBuffer =
+			Shared::CompressionUtil::extractMemoryToMemory(&compressedMessage[0], compressedSize, uncompressedSize);
+		if (decompressedBuffer.second != uncompressedSize) {
+			delete[] decompressedBuffer.first;
+			throw game_runtime_error("Error receiving compressed NetworkMessage, expected " + uIntToStr(uncompressedSize) + " bytes but got " + uIntToStr((uint32) decompressedBuffer.second));
+		}
+
+		// First byte is the wrapped message type, the rest is read by the
+		// message's own receive() as if it came from the socket
+		NetworkMessageType messageType = static_cast<NetworkMessageType>(static_cast<int8>(decompressedBuffer.first[0]));
+		socket->unreadData(decompressedBuffer.first + 1, (int) uncompressedSize - 1);
+		delete[] decompressedBuffer.first;
+
+		if (NetworkTelemetry::isEnabled() == true) {
+			NetworkTelemetry::recordReceive(socket, messageType, (int) (sizeof(int8) + sizeof(header) + compressedSize), true);
+		}
+
+		if (messageType == nmtCompressedPacket) {
+			throw game_runtime_error("Error receiving compressed NetworkMessage, nested envelope");
+		}
+		return messageType;
 	}
 
 	void NetworkMessage::resetNetworkPacketStats() {
@@ -315,6 +476,7 @@ namespace Game {
 		data.externalIp = 0;
 		data.ftpPort = 0;
 		data.gameInProgress = 0;
+		data.supportedProtocolFeatures = npfNone;
 	}
 
 	NetworkMessageIntro::NetworkMessageIntro(int32 sessionId, const string &versionString,
@@ -324,7 +486,7 @@ namespace Game {
 		uint32 ftpPort,
 		const string &playerLanguage,
 		int gameInProgress, const string &playerUUID,
-		const string &platform) {
+		const string &platform, uint32 supportedProtocolFeatures) {
 		messageType = nmtIntro;
 		data.sessionId = sessionId;
 		data.versionString = versionString;
@@ -337,78 +499,24 @@ namespace Game {
 		data.gameInProgress = gameInProgress;
 		data.playerUUID = playerUUID;
 		data.platform = platform;
-	}
-
-	const char * NetworkMessageIntro::getPackedMessageFormat() const {
-		return "cl128s32shcLL60sc60s60s";
-	}
-
-	unsigned int NetworkMessageIntro::getPackedSize() {
-		static unsigned int result = 0;
-		if (result == 0) {
-			Data packedData;
-			packedData.externalIp = 0;
-			packedData.ftpPort = 0;
-			packedData.gameInProgress = 0;
-			packedData.gameState = 0;
-			messageType = nmtIntro;
-			packedData.playerIndex = 0;
-			packedData.sessionId = 0;
-
-			unsigned char *buf = new unsigned char[sizeof(packedData) * 3];
-			result = pack(buf, getPackedMessageFormat(),
-				messageType,
-				packedData.sessionId,
-				packedData.versionString.getBuffer(),
-				packedData.name.getBuffer(),
-				packedData.playerIndex,
-				packedData.gameState,
-				packedData.externalIp,
-				packedData.ftpPort,
-				packedData.language.getBuffer(),
-				data.gameInProgress,
-				packedData.playerUUID.getBuffer(),
-				packedData.platform.getBuffer());
-			delete[] buf;
-		}
-		return result;
-	}
-	void NetworkMessageIntro::unpackMessage(unsigned char *buf) {
-		if (SystemFlags::VERBOSE_MODE_ENABLED) printf("\nIn [%s] about to unpack...\n", __FUNCTION__);
-		unpack(buf, getPackedMessageFormat(),
-			&messageType,
-			&data.sessionId,
-			data.versionString.getBuffer(),
-			data.name.getBuffer(),
-			&data.playerIndex,
-			&data.gameState,
-			&data.externalIp,
-			&data.ftpPort,
-			data.language.getBuffer(),
-			&data.gameInProgress,
-			data.playerUUID.getBuffer(),
-			data.platform.getBuffer());
-		if (SystemFlags::VERBOSE_MODE_ENABLED) printf("In [%s] unpacked data:\n%s\n", __FUNCTION__, this->toString().c_str());
-	}
-
-	unsigned char * NetworkMessageIntro::packMessage() {
-		unsigned char *buf = new unsigned char[getPackedSize() + 1];
-
-		if (SystemFlags::VERBOSE_MODE_ENABLED) printf("\nIn [%s] about to pack...\n", __FUNCTION__);
-		pack(buf, getPackedMessageFormat(),
-			messageType,
-			data.sessionId,
-			data.versionString.getBuffer(),
-			data.name.getBuffer(),
-			data.playerIndex,
-			data.gameState,
-			data.externalIp,
-			data.ftpPort,
-			data.language.getBuffer(),
-			data.gameInProgress,
-			data.playerUUID.getBuffer(),
-			data.platform.getBuffer());
-		return buf;
+		data.supportedProtocolFeatures = supportedProtocolFeatures;
+	}
+
+	template <typename Archive>
+	void NetworkMessageIntro::serialize(Archive &archive) {
+		archive.field(messageType);
+		archive.field(data.sessionId);
+		archive.field(data.versionString);
+		archive.field(data.name);
+		archive.field(data.playerIndex);
+		archive.field(data.gameState);
+		archive.field(data.externalIp);
+		archive.field(data.ftpPort);
+		archive.field(data.language);
+		archive.field(data.gameInProgress);
+		archive.field(data.playerUUID);
+		archive.field(data.platform);
+		archive.field(data.supportedProtocolFeatures);
 	}
 
 	string NetworkMessageIntro::toString() const {
@@ -424,6 +532,7 @@ namespace Game {
 		result += " gameInProgress = " + uIntToStr(data.gameInProgress);
 		result += " playerUUID = " + data.playerUUID.getString();
 		result += " platform = " + data.platform.getString();
+		result += " supportedProtocolFeatures = " + uIntToStr(data.supportedProtocolFeatures);
 
 		return result;
 	}
@@ -435,14 +544,10 @@ namespace Game {
 			if (result == true) {
 				messageType = this->getNetworkMessageType();
 			}
+			fromEndian();
 		} else {
-			unsigned char *buf = new unsigned char[getPackedSize() + 1];
-			result = NetworkMessage::receive(socket, buf, getPackedSize(), true);
-			unpackMessage(buf);
-			//printf("Got packet size = %u data.messageType = %d\n%s\n",getPackedSize(),data.messageType,buf);
-			delete[] buf;
+			result = receivePacked(socket, *this);
 		}
-		fromEndian();
 
 		data.name.nullTerminate();
 		data.versionString.nullTerminate();
@@ -457,17 +562,13 @@ namespace Game {
 	void NetworkMessageIntro::send(Socket* socket) {
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] sending nmtIntro, data.playerIndex = %d, data.sessionId = %d\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, data.playerIndex, data.sessionId);
 		assert(messageType == nmtIntro);
-		toEndian();
 
 		if (useOldProtocol == true) {
+			toEndian();
 			//NetworkMessage::send(socket, &messageType, sizeof(messageType));
 			NetworkMessage::send(socket, &data, sizeof(data), messageType);
 		} else {
-			unsigned char *buf = packMessage();
-			//printf("Send packet size = %u data.messageType = %d\n[%s]\n",getPackedSize(),data.messageType,buf);
-			//NetworkMessage::send(socket, &data, sizeof(data));
-			NetworkMessage::send(socket, buf, getPackedSize());
-			delete[] buf;
+			sendPacked(socket, *this);
 		}
 	}
 
@@ -482,6 +583,7 @@ namespace Game {
 			data.ftpPort = Shared::PlatformByteOrder::toCommonEndian(data.ftpPort);
 
 			data.gameInProgress = Shared::PlatformByteOrder::toCommonEndian(data.gameInProgress);
+			data.supportedProtocolFeatures = Shared::PlatformByteOrder::toCommonEndian(data.supportedProtocolFeatures);
 		}
 	}
 	void NetworkMessageIntro::fromEndian() {
@@ -495,6 +597,7 @@ namespace Game {
 			data.ftpPort = Shared::PlatformByteOrder::fromCommonEndian(data.ftpPort);
 
 			data.gameInProgress = Shared::PlatformByteOrder::fromCommonEndian(data.gameInProgress);
+			data.supportedProtocolFeatures = Shared::PlatformByteOrder::fromCommonEndian(data.supportedProtocolFeatures);
 		}
 	}
 
@@ -516,40 +619,11 @@ namespace Game {
 		pingReceivedLocalTime = 0;
 	}
 
-	const char * NetworkMessagePing::getPackedMessageFormat() const {
-		return "clq";
-	}
-
-	unsigned int NetworkMessagePing::getPackedSize() {
-		static unsigned int result = 0;
-		if (result == 0) {
-			Data packedData;
-			messageType = 0;
-			packedData.pingFrequency = 0;
-			packedData.pingTime = 0;
-			unsigned char *buf = new unsigned char[sizeof(packedData) * 3];
-			result = pack(buf, getPackedMessageFormat(),
-				messageType,
-				packedData.pingFrequency,
-				packedData.pingTime);
-			delete[] buf;
-		}
-		return result;
-	}
-	void NetworkMessagePing::unpackMessage(unsigned char *buf) {
-		unpack(buf, getPackedMessageFormat(),
-			&messageType,
-			&data.pingFrequency,
-			&data.pingTime);
-	}
-
-	unsigned char * NetworkMessagePing::packMessage() {
-		unsigned char *buf = new unsigned char[getPackedSize() + 1];
-		pack(buf, getPackedMessageFormat(),
-			messageType,
-			data.pingFrequency,
-			data.pingTime);
-		return buf;
+	template <typename Archive>
+	void NetworkMessagePing::serialize(Archive &archive) {
+		archive.field(messageType);
+		archive.field(data.pingFrequency);
+		archive.field(data.pingTime);
 	}
 
 	bool NetworkMessagePing::receive(Socket* socket) {
@@ -559,14 +633,10 @@ namespace Game {
 			if (result == true) {
 				messageType = this->getNetworkMessageType();
 			}
+			fromEndian();
 		} else {
-			unsigned char *buf = new unsigned char[getPackedSize() + 1];
-			result = NetworkMessage::receive(socket, buf, getPackedSize(), true);
-			unpackMessage(buf);
-			//printf("Got packet size = %u data.messageType = %d\n%s\n",getPackedSize(),data.messageType,buf);
-			delete[] buf;
+			result = receivePacked(socket, *this);
 		}
-		fromEndian();
 
 		pingReceivedLocalTime = time(NULL);
 		return result;
@@ -575,17 +645,13 @@ namespace Game {
 	void NetworkMessagePing::send(Socket* socket) {
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] nmtPing\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
 		assert(messageType == nmtPing);
-		toEndian();
 
 		if (useOldProtocol == true) {
+			toEndian();
 			//NetworkMessage::send(socket, &messageType, sizeof(messageType));
 			NetworkMessage::send(socket, &data, sizeof(data), messageType);
 		} else {
-			unsigned char *buf = packMessage();
-			//printf("Send packet size = %u data.messageType = %d\n[%s]\n",getPackedSize(),data.messageType,buf);
-			//NetworkMessage::send(socket, &data, sizeof(data));
-			NetworkMessage::send(socket, buf, getPackedSize());
-			delete[] buf;
+			sendPacked(socket, *this);
 		}
 	}
 
@@ -620,36 +686,10 @@ namespace Game {
 		data.checksum = checksum;
 	}
 
-	const char * NetworkMessageReady::getPackedMessageFormat() const {
-		return "cL";
-	}
-
-	unsigned int NetworkMessageReady::getPackedSize() {
-		static unsigned int result = 0;
-		if (result == 0) {
-			Data packedData;
-			packedData.checksum = 0;
-			messageType = 0;
-			unsigned char *buf = new unsigned char[sizeof(packedData) * 3];
-			result = pack(buf, getPackedMessageFormat(),
-				messageType,
-				packedData.checksum);
-			delete[] buf;
-		}
-		return result;
-	}
-	void NetworkMessageReady::unpackMessage(unsigned char *buf) {
-		unpack(buf, getPackedMessageFormat(),
-			&messageType,
-			&data.checksum);
-	}
-
-	unsigned char * NetworkMessageReady::packMessage() {
-		unsigned char *buf = new unsigned char[getPackedSize() + 1];
-		pack(buf, getPackedMessageFormat(),
-			messageType,
-			data.checksum);
-		return buf;
+	template <typename Archive>
+	void NetworkMessageReady::serialize(Archive &archive) {
+		archive.field(messageType);
+		archive.field(data.checksum);
 	}
 
 	bool NetworkMessageReady::receive(Socket* socket) {
@@ -659,31 +699,23 @@ namespace Game {
 			if (result == true) {
 				messageType = this->getNetworkMessageType();
 			}
+			fromEndian();
 		} else {
-			unsigned char *buf = new unsigned char[getPackedSize() + 1];
-			//bool result = NetworkMessage::receive(socket, buf, getPackedSize(), true);
-			NetworkMessage::receive(socket, buf, getPackedSize(), true);
-			unpackMessage(buf);
-			//printf("Got packet size = %u data.messageType = %d\n%s\n",getPackedSize(),data.messageType,buf);
-			delete[] buf;
-		}
-		fromEndian();
+			result = receivePacked(socket, *this);
+		}
 		return result;
 	}
 
 	void NetworkMessageReady::send(Socket* socket) {
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] nmtReady\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
 		assert(messageType == nmtReady);
-		toEndian();
 
 		if (useOldProtocol == true) {
+			toEndian();
 			//NetworkMessage::send(socket, &messageType, sizeof(messageType));
 			NetworkMessage::send(socket, &data, sizeof(data), messageType);
 		} else {
-			unsigned char *buf = packMessage();
-			//printf("Send packet size = %u data.messageType = %d\n[%s]\n",getPackedSize(),data.messageType,buf);
-			NetworkMessage::send(socket, buf, getPackedSize());
-			delete[] buf;
+			sendPacked(socket, *this);
 		}
 	}
 
@@ -857,512 +889,49 @@ namespace Game {
 		return factionCRCList;
 	}
 
-	const char * NetworkMessageLaunch::getPackedMessageFormat() const {
-		return "c256s60s60s60s60s60s60s60s60s60s60s60s60s60s60s60s60s60s60s60s60s60s60s60s60s60s60s60sllllllll60s60s60s60s60s60s60s60sLLL60s60s60s60s60s60s60s60s60s60s60s60s60s60s60s60s60s60s60s60sLLLLLLLLLLLLLLLLLLLLcccccccccccccccccccccccccccccccccccccccccCccLccll256s60s60s60s60s60s60s60s60sc60s";
-	}
-
-	unsigned int NetworkMessageLaunch::getPackedSize() {
-		static unsigned int result = 0;
-		if (result == 0) {
-			Data packedData;
-			packedData.aiAcceptSwitchTeamPercentChance = 0;
-			packedData.allowObservers = 0;
-			packedData.cpuReplacementMultiplierIndex = 0;
-			packedData.defaultResources = 0;
-			packedData.defaultUnits = 0;
-			packedData.defaultVictoryConditions = 0;
-			packedData.enableObserverModeAtEndGame = 0;
-			packedData.enableServerControlledAI = 0;
-			for (unsigned int index = 0; index < (unsigned int) maxFactionCRCCount; ++index) {
-				packedData.factionCRCList[index] = 0;
-			}
-			for (unsigned int index = 0; index < (unsigned int) GameConstants::maxPlayers; ++index) {
-				packedData.factionControls[index] = 0;
-				packedData.networkPlayerStatuses[index] = npst_None;
-				packedData.resourceMultiplierIndex[index] = 0;
-				packedData.startLocationIndex[index] = 0;
-				packedData.teams[index] = 0;
-			}
-			packedData.factionCount = 0;
-			packedData.flagTypes1 = 0;
-			packedData.fogOfWar = 0;
-			packedData.mapCRC = 0;
-			packedData.mapFilter = 0;
-			packedData.masterserver_admin = 0;
-			packedData.masterserver_admin_factionIndex = 0;
-			messageType = 0;
-			packedData.networkAllowNativeLanguageTechtree = 0;
-			packedData.networkFramePeriod = 0;
-			packedData.networkPauseGameForLaggedClients = 0;
-			packedData.pathFinderType = 0;
-			packedData.techCRC = 0;
-			packedData.thisFactionIndex = 0;
-			packedData.tilesetCRC = 0;
-
-			unsigned char *buf = new unsigned char[sizeof(packedData) * 3];
-			result = pack(buf, getPackedMessageFormat(),
-				messageType,
-				packedData.description.getBuffer(),
-				packedData.map.getBuffer(),
-				packedData.tileset.getBuffer(),
-				packedData.tech.getBuffer(),
-				packedData.factionTypeNames[0].getBuffer(),
-				packedData.factionTypeNames[1].getBuffer(),
-				packedData.factionTypeNames[2].getBuffer(),
-				packedData.factionTypeNames[3].getBuffer(),
-				packedData.factionTypeNames[4].getBuffer(),
-				packedData.factionTypeNames[5].getBuffer(),
-				packedData.factionTypeNames[6].getBuffer(),
-				packedData.factionTypeNames[7].getBuffer(),
-				packedData.networkPlayerNames[0].getBuffer(),
-				packedData.networkPlayerNames[1].getBuffer(),
-				packedData.networkPlayerNames[2].getBuffer(),
-				packedData.networkPlayerNames[3].getBuffer(),
-				packedData.networkPlayerNames[4].getBuffer(),
-				packedData.networkPlayerNames[5].getBuffer(),
-				packedData.networkPlayerNames[6].getBuffer(),
-				packedData.networkPlayerNames[7].getBuffer(),
-				packedData.networkPlayerPlatform[0].getBuffer(),
-				packedData.networkPlayerPlatform[1].getBuffer(),
-				packedData.networkPlayerPlatform[2].getBuffer(),
-				packedData.networkPlayerPlatform[3].getBuffer(),
-				packedData.networkPlayerPlatform[4].getBuffer(),
-				packedData.networkPlayerPlatform[5].getBuffer(),
-				packedData.networkPlayerPlatform[6].getBuffer(),
-				packedData.networkPlayerPlatform[7].getBuffer(),
-				packedData.networkPlayerStatuses[0],
-				packedData.networkPlayerStatuses[1],
-				packedData.networkPlayerStatuses[2],
-				packedData.networkPlayerStatuses[3],
-				packedData.networkPlayerStatuses[4],
-				packedData.networkPlayerStatuses[5],
-				packedData.networkPlayerStatuses[6],
-				packedData.networkPlayerStatuses[7],
-				packedData.networkPlayerLanguages[0].getBuffer(),
-				packedData.networkPlayerLanguages[1].getBuffer(),
-				packedData.networkPlayerLanguages[2].getBuffer(),
-				packedData.networkPlayerLanguages[3].getBuffer(),
-				packedData.networkPlayerLanguages[4].getBuffer(),
-				packedData.networkPlayerLanguages[5].getBuffer(),
-				packedData.networkPlayerLanguages[6].getBuffer(),
-				packedData.networkPlayerLanguages[7].getBuffer(),
-				packedData.mapCRC,
-				packedData.mapFilter,
-				packedData.tilesetCRC,
-				packedData.techCRC,
-				packedData.factionNameList[0].getBuffer(),
-				packedData.factionNameList[1].getBuffer(),
-				packedData.factionNameList[2].getBuffer(),
-				packedData.factionNameList[3].getBuffer(),
-				packedData.factionNameList[4].getBuffer(),
-				packedData.factionNameList[5].getBuffer(),
-				packedData.factionNameList[6].getBuffer(),
-				packedData.factionNameList[7].getBuffer(),
-				packedData.factionNameList[8].getBuffer(),
-				packedData.factionNameList[9].getBuffer(),
-				packedData.factionNameList[10].getBuffer(),
-				packedData.factionNameList[11].getBuffer(),
-				packedData.factionNameList[12].getBuffer(),
-				packedData.factionNameList[13].getBuffer(),
-				packedData.factionNameList[14].getBuffer(),
-				packedData.factionNameList[15].getBuffer(),
-				packedData.factionNameList[16].getBuffer(),
-				packedData.factionNameList[17].getBuffer(),
-				packedData.factionNameList[18].getBuffer(),
-				packedData.factionNameList[19].getBuffer(),
-				packedData.factionCRCList[0],
-				packedData.factionCRCList[1],
-				packedData.factionCRCList[2],
-				packedData.factionCRCList[3],
-				packedData.factionCRCList[4],
-				packedData.factionCRCList[5],
-				packedData.factionCRCList[6],
-				packedData.factionCRCList[7],
-				packedData.factionCRCList[8],
-				packedData.factionCRCList[9],
-				packedData.factionCRCList[10],
-				packedData.factionCRCList[11],
-				packedData.factionCRCList[12],
-				packedData.factionCRCList[13],
-				packedData.factionCRCList[14],
-				packedData.factionCRCList[15],
-				packedData.factionCRCList[16],
-				packedData.factionCRCList[17],
-				packedData.factionCRCList[18],
-				packedData.factionCRCList[19],
-				packedData.factionControls[0],
-				packedData.factionControls[1],
-				packedData.factionControls[2],
-				packedData.factionControls[3],
-				packedData.factionControls[4],
-				packedData.factionControls[5],
-				packedData.factionControls[6],
-				packedData.factionControls[7],
-				packedData.resourceMultiplierIndex[0],
-				packedData.resourceMultiplierIndex[1],
-				packedData.resourceMultiplierIndex[2],
-				packedData.resourceMultiplierIndex[3],
-				packedData.resourceMultiplierIndex[4],
-				packedData.resourceMultiplierIndex[5],
-				packedData.resourceMultiplierIndex[6],
-				packedData.resourceMultiplierIndex[7],
-				packedData.thisFactionIndex,
-				packedData.factionCount,
-				packedData.teams[0],
-				packedData.teams[1],
-				packedData.teams[2],
-				packedData.teams[3],
-				packedData.teams[4],
-				packedData.teams[5],
-				packedData.teams[6],
-				packedData.teams[7],
-				packedData.startLocationIndex[0],
-				packedData.startLocationIndex[1],
-				packedData.startLocationIndex[2],
-				packedData.startLocationIndex[3],
-				packedData.startLocationIndex[4],
-				packedData.startLocationIndex[5],
-				packedData.startLocationIndex[6],
-				packedData.startLocationIndex[7],
-				packedData.defaultResources,
-				packedData.defaultUnits,
-				packedData.defaultVictoryConditions,
-				packedData.fogOfWar,
-				packedData.allowObservers,
-				packedData.enableObserverModeAtEndGame,
-				packedData.enableServerControlledAI,
-				packedData.networkFramePeriod,
-				packedData.networkPauseGameForLaggedClients,
-				packedData.pathFinderType,
-				packedData.flagTypes1,
-				packedData.aiAcceptSwitchTeamPercentChance,
-				packedData.cpuReplacementMultiplierIndex,
-				packedData.masterserver_admin,
-				packedData.masterserver_admin_factionIndex,
-				packedData.scenario.getBuffer(),
-				packedData.networkPlayerUUID[0].getBuffer(),
-				packedData.networkPlayerUUID[1].getBuffer(),
-				packedData.networkPlayerUUID[2].getBuffer(),
-				packedData.networkPlayerUUID[3].getBuffer(),
-				packedData.networkPlayerUUID[4].getBuffer(),
-				packedData.networkPlayerUUID[5].getBuffer(),
-				packedData.networkPlayerUUID[6].getBuffer(),
-				packedData.networkPlayerUUID[7].getBuffer(),
-				packedData.networkAllowNativeLanguageTechtree,
-				packedData.gameUUID.getBuffer()
-			);
-			delete[] buf;
-		}
-		return result;
-	}
-	void NetworkMessageLaunch::unpackMessage(unsigned char *buf) {
-		unpack(buf, getPackedMessageFormat(),
-			&messageType,
-			data.description.getBuffer(),
-			data.map.getBuffer(),
-			data.tileset.getBuffer(),
-			data.tech.getBuffer(),
-			data.factionTypeNames[0].getBuffer(),
-			data.factionTypeNames[1].getBuffer(),
-			data.factionTypeNames[2].getBuffer(),
-			data.factionTypeNames[3].getBuffer(),
-			data.factionTypeNames[4].getBuffer(),
-			data.factionTypeNames[5].getBuffer(),
-			data.factionTypeNames[6].getBuffer(),
-			data.factionTypeNames[7].getBuffer(),
-			data.networkPlayerNames[0].getBuffer(),
-			data.networkPlayerNames[1].getBuffer(),
-			data.networkPlayerNames[2].getBuffer(),
-			data.networkPlayerNames[3].getBuffer(),
-			data.networkPlayerNames[4].getBuffer(),
-			data.networkPlayerNames[5].getBuffer(),
-			data.networkPlayerNames[6].getBuffer(),
-			data.networkPlayerNames[7].getBuffer(),
-			data.networkPlayerPlatform[0].getBuffer(),
-			data.networkPlayerPlatform[1].getBuffer(),
-			data.networkPlayerPlatform[2].getBuffer(),
-			data.networkPlayerPlatform[3].getBuffer(),
-			data.networkPlayerPlatform[4].getBuffer(),
-			data.networkPlayerPlatform[5].getBuffer(),
-			data.networkPlayerPlatform[6].getBuffer(),
-			data.networkPlayerPlatform[7].getBuffer(),
-			&data.networkPlayerStatuses[0],
-			&data.networkPlayerStatuses[1],
-			&data.networkPlayerStatuses[2],
-			&data.networkPlayerStatuses[3],
-			&data.networkPlayerStatuses[4],
-			&data.networkPlayerStatuses[5],
-			&data.networkPlayerStatuses[6],
-			&data.networkPlayerStatuses[7],
-			data.networkPlayerLanguages[0].getBuffer(),
-			data.networkPlayerLanguages[1].getBuffer(),
-			data.networkPlayerLanguages[2].getBuffer(),
-			data.networkPlayerLanguages[3].getBuffer(),
-			data.networkPlayerLanguages[4].getBuffer(),
-			data.networkPlayerLanguages[5].getBuffer(),
-			data.networkPlayerLanguages[6].getBuffer(),
-			data.networkPlayerLanguages[7].getBuffer(),
-			&data.mapFilter,
-			&data.mapCRC,
-			&data.tilesetCRC,
-			&data.techCRC,
-			data.factionNameList[0].getBuffer(),
-			data.factionNameList[1].getBuffer(),
-			data.factionNameList[2].getBuffer(),
-			data.factionNameList[3].getBuffer(),
-			data.factionNameList[4].getBuffer(),
-			data.factionNameList[5].getBuffer(),
-			data.factionNameList[6].getBuffer(),
-			data.factionNameList[7].getBuffer(),
-			data.factionNameList[8].getBuffer(),
-			data.factionNameList[9].getBuffer(),
-			data.factionNameList[10].getBuffer(),
-			data.factionNameList[11].getBuffer(),
-			data.factionNameList[12].getBuffer(),
-			data.factionNameList[13].getBuffer(),
-			data.factionNameList[14].getBuffer(),
-			data.factionNameList[15].getBuffer(),
-			data.factionNameList[16].getBuffer(),
-			data.factionNameList[17].getBuffer(),
-			data.factionNameList[18].getBuffer(),
-			data.factionNameList[19].getBuffer(),
-			&data.factionCRCList[0],
-			&data.factionCRCList[1],
-			&data.factionCRCList[2],
-			&data.factionCRCList[3],
-			&data.factionCRCList[4],
-			&data.factionCRCList[5],
-			&data.factionCRCList[6],
-			&data.factionCRCList[7],
-			&data.factionCRCList[8],
-			&data.factionCRCList[9],
-			&data.factionCRCList[10],
-			&data.factionCRCList[11],
-			&data.factionCRCList[12],
-			&data.factionCRCList[13],
-			&data.factionCRCList[14],
-			&data.factionCRCList[15],
-			&data.factionCRCList[16],
-			&data.factionCRCList[17],
-			&data.factionCRCList[18],
-			&data.factionCRCList[19],
-			&data.factionControls[0],
-			&data.factionControls[1],
-			&data.factionControls[2],
-			&data.factionControls[3],
-			&data.factionControls[4],
-			&data.factionControls[5],
-			&data.factionControls[6],
-			&data.factionControls[7],
-			&data.resourceMultiplierIndex[0],
-			&data.resourceMultiplierIndex[1],
-			&data.resourceMultiplierIndex[2],
-			&data.resourceMultiplierIndex[3],
-			&data.resourceMultiplierIndex[4],
-			&data.resourceMultiplierIndex[5],
-			&data.resourceMultiplierIndex[6],
-			&data.resourceMultiplierIndex[7],
-			&data.thisFactionIndex,
-			&data.factionCount,
-			&data.teams[0],
-			&data.teams[1],
-			&data.teams[2],
-			&data.teams[3],
-			&data.teams[4],
-			&data.teams[5],
-			&data.teams[6],
-			&data.teams[7],
-			&data.startLocationIndex[0],
-			&data.startLocationIndex[1],
-			&data.startLocationIndex[2],
-			&data.startLocationIndex[3],
-			&data.startLocationIndex[4],
-			&data.startLocationIndex[5],
-			&data.startLocationIndex[6],
-			&data.startLocationIndex[7],
-			&data.defaultResources,
-			&data.defaultUnits,
-			&data.defaultVictoryConditions,
-			&data.fogOfWar,
-			&data.allowObservers,
-			&data.enableObserverModeAtEndGame,
-			&data.enableServerControlledAI,
-			&data.networkFramePeriod,
-			&data.networkPauseGameForLaggedClients,
-			&data.pathFinderType,
-			&data.flagTypes1,
-			&data.aiAcceptSwitchTeamPercentChance,
-			&data.cpuReplacementMultiplierIndex,
-			&data.masterserver_admin,
-			&data.masterserver_admin_factionIndex,
-			data.scenario.getBuffer(),
-			data.networkPlayerUUID[0].getBuffer(),
-			data.networkPlayerUUID[1].getBuffer(),
-			data.networkPlayerUUID[2].getBuffer(),
-			data.networkPlayerUUID[3].getBuffer(),
-			data.networkPlayerUUID[4].getBuffer(),
-			data.networkPlayerUUID[5].getBuffer(),
-			data.networkPlayerUUID[6].getBuffer(),
-			data.networkPlayerUUID[7].getBuffer(),
-			&data.networkAllowNativeLanguageTechtree,
-			data.gameUUID.getBuffer()
-		);
-	}
-
-	unsigned char * NetworkMessageLaunch::packMessage() {
-		unsigned char *buf = new unsigned char[getPackedSize() + 1];
-		pack(buf, getPackedMessageFormat(),
-			messageType,
-			data.description.getBuffer(),
-			data.map.getBuffer(),
-			data.tileset.getBuffer(),
-			data.tech.getBuffer(),
-			data.factionTypeNames[0].getBuffer(),
-			data.factionTypeNames[1].getBuffer(),
-			data.factionTypeNames[2].getBuffer(),
-			data.factionTypeNames[3].getBuffer(),
-			data.factionTypeNames[4].getBuffer(),
-			data.factionTypeNames[5].getBuffer(),
-			data.factionTypeNames[6].getBuffer(),
-			data.factionTypeNames[7].getBuffer(),
-			data.networkPlayerNames[0].getBuffer(),
-			data.networkPlayerNames[1].getBuffer(),
-			data.networkPlayerNames[2].getBuffer(),
-			data.networkPlayerNames[3].getBuffer(),
-			data.networkPlayerNames[4].getBuffer(),
-			data.networkPlayerNames[5].getBuffer(),
-			data.networkPlayerNames[6].getBuffer(),
-			data.networkPlayerNames[7].getBuffer(),
-			data.networkPlayerPlatform[0].getBuffer(),
-			data.networkPlayerPlatform[1].getBuffer(),
-			data.networkPlayerPlatform[2].getBuffer(),
-			data.networkPlayerPlatform[3].getBuffer(),
-			data.networkPlayerPlatform[4].getBuffer(),
-			data.networkPlayerPlatform[5].getBuffer(),
-			data.networkPlayerPlatform[6].getBuffer(),
-			data.networkPlayerPlatform[7].getBuffer(),
-			data.networkPlayerStatuses[0],
-			data.networkPlayerStatuses[1],
-			data.networkPlayerStatuses[2],
-			data.networkPlayerStatuses[3],
-			data.networkPlayerStatuses[4],
-			data.networkPlayerStatuses[5],
-			data.networkPlayerStatuses[6],
-			data.networkPlayerStatuses[7],
-			data.networkPlayerLanguages[0].getBuffer(),
-			data.networkPlayerLanguages[1].getBuffer(),
-			data.networkPlayerLanguages[2].getBuffer(),
-			data.networkPlayerLanguages[3].getBuffer(),
-			data.networkPlayerLanguages[4].getBuffer(),
-			data.networkPlayerLanguages[5].getBuffer(),
-			data.networkPlayerLanguages[6].getBuffer(),
-			data.networkPlayerLanguages[7].getBuffer(),
-			data.mapFilter,
-			data.mapCRC,
-			data.tilesetCRC,
-			data.techCRC,
-			data.factionNameList[0].getBuffer(),
-			data.factionNameList[1].getBuffer(),
-			data.factionNameList[2].getBuffer(),
-			data.factionNameList[3].getBuffer(),
-			data.factionNameList[4].getBuffer(),
-			data.factionNameList[5].getBuffer(),
-			data.factionNameList[6].getBuffer(),
-			data.factionNameList[7].getBuffer(),
-			data.factionNameList[8].getBuffer(),
-			data.factionNameList[9].getBuffer(),
-			data.factionNameList[10].getBuffer(),
-			data.factionNameList[11].getBuffer(),
-			data.factionNameList[12].getBuffer(),
-			data.factionNameList[13].getBuffer(),
-			data.factionNameList[14].getBuffer(),
-			data.factionNameList[15].getBuffer(),
-			data.factionNameList[16].getBuffer(),
-			data.factionNameList[17].getBuffer(),
-			data.factionNameList[18].getBuffer(),
-			data.factionNameList[19].getBuffer(),
-			data.factionCRCList[0],
-			data.factionCRCList[1],
-			data.factionCRCList[2],
-			data.factionCRCList[3],
-			data.factionCRCList[4],
-			data.factionCRCList[5],
-			data.factionCRCList[6],
-			data.factionCRCList[7],
-			data.factionCRCList[8],
-			data.factionCRCList[9],
-			data.factionCRCList[10],
-			data.factionCRCList[11],
-			data.factionCRCList[12],
-			data.factionCRCList[13],
-			data.factionCRCList[14],
-			data.factionCRCList[15],
-			data.factionCRCList[16],
-			data.factionCRCList[17],
-			data.factionCRCList[18],
-			data.factionCRCList[19],
-			data.factionControls[0],
-			data.factionControls[1],
-			data.factionControls[2],
-			data.factionControls[3],
-			data.factionControls[4],
-			data.factionControls[5],
-			data.factionControls[6],
-			data.factionControls[7],
-			data.resourceMultiplierIndex[0],
-			data.resourceMultiplierIndex[1],
-			data.resourceMultiplierIndex[2],
-			data.resourceMultiplierIndex[3],
-			data.resourceMultiplierIndex[4],
-			data.resourceMultiplierIndex[5],
-			data.resourceMultiplierIndex[6],
-			data.resourceMultiplierIndex[7],
-			data.thisFactionIndex,
-			data.factionCount,
-			data.teams[0],
-			data.teams[1],
-			data.teams[2],
-			data.teams[3],
-			data.teams[4],
-			data.teams[5],
-			data.teams[6],
-			data.teams[7],
-			data.startLocationIndex[0],
-			data.startLocationIndex[1],
-			data.startLocationIndex[2],
-			data.startLocationIndex[3],
-			data.startLocationIndex[4],
-			data.startLocationIndex[5],
-			data.startLocationIndex[6],
-			data.startLocationIndex[7],
-			data.defaultResources,
-			data.defaultUnits,
-			data.defaultVictoryConditions,
-			data.fogOfWar,
-			data.allowObservers,
-			data.enableObserverModeAtEndGame,
-			data.enableServerControlledAI,
-			data.networkFramePeriod,
-			data.networkPauseGameForLaggedClients,
-			data.pathFinderType,
-			data.flagTypes1,
-			data.aiAcceptSwitchTeamPercentChance,
-			data.cpuReplacementMultiplierIndex,
-			data.masterserver_admin,
-			data.masterserver_admin_factionIndex,
-			data.scenario.getBuffer(),
-			data.networkPlayerUUID[0].getBuffer(),
-			data.networkPlayerUUID[1].getBuffer(),
-			data.networkPlayerUUID[2].getBuffer(),
-			data.networkPlayerUUID[3].getBuffer(),
-			data.networkPlayerUUID[4].getBuffer(),
-			data.networkPlayerUUID[5].getBuffer(),
-			data.networkPlayerUUID[6].getBuffer(),
-			data.networkPlayerUUID[7].getBuffer(),
-			data.networkAllowNativeLanguageTechtree,
-			data.gameUUID.getBuffer()
-		);
-		return buf;
+	template <typename Archive>
+	void NetworkMessageLaunch::serialize(Archive &archive) {
+		archive.field(messageType);
+		archive.field(data.description);
+		archive.field(data.map);
+		archive.field(data.tileset);
+		archive.field(data.tech);
+		archive.fieldArray(data.factionTypeNames, GameConstants::maxPlayers);
+		archive.fieldArray(data.networkPlayerNames, GameConstants::maxPlayers);
+		archive.fieldArray(data.networkPlayerPlatform, GameConstants::maxPlayers);
+		archive.fieldArray(data.networkPlayerStatuses, GameConstants::maxPlayers);
+		archive.fieldArray(data.networkPlayerLanguages, GameConstants::maxPlayers);
+		archive.field(data.mapFilter);
+		archive.field(data.mapCRC);
+		archive.field(data.tilesetCRC);
+		archive.field(data.techCRC);
+		archive.fieldArray(data.factionNameList, maxFactionCRCCount);
+		archive.fieldArray(data.factionCRCList, maxFactionCRCCount);
+		archive.fieldArray(data.factionControls, GameConstants::maxPlayers);
+		archive.fieldArray(data.resourceMultiplierIndex, GameConstants::maxPlayers);
+		archive.field(data.thisFactionIndex);
+		archive.field(data.factionCount);
+		archive.fieldArray(data.teams, GameConstants::maxPlayers);
+		archive.fieldArray(data.startLocationIndex, GameConstants::maxPlayers);
+		archive.field(data.defaultResources);
+		archive.field(data.defaultUnits);
+		archive.field(data.defaultVictoryConditions);
+		archive.field(data.fogOfWar);
+		archive.field(data.allowObservers);
+		archive.field(data.enableObserverModeAtEndGame);
+		archive.field(data.enableServerControlledAI);
+		archive.field(data.networkFramePeriod);
+		archive.field(data.networkPauseGameForLaggedClients);
+		archive.field(data.pathFinderType);
+		archive.field(data.flagTypes1);
+		archive.field(data.aiAcceptSwitchTeamPercentChance);
+		archive.field(data.cpuReplacementMultiplierIndex);
+		archive.field(data.masterserver_admin);
+		archive.field(data.masterserver_admin_factionIndex);
+		archive.field(data.scenario);
+		archive.fieldArray(data.networkPlayerUUID, GameConstants::maxPlayers);
+		archive.field(data.networkAllowNativeLanguageTechtree);
+		archive.field(data.gameUUID);
 	}
 
 	bool NetworkMessageLaunch::receive(Socket* socket, NetworkMessageType type) {
@@ -1442,14 +1011,10 @@ namespace Game {
 				if (SystemFlags::getSystemSettingType(SystemFlags::debugPerformance).enabled && chrono.getMillis() > 0) SystemFlags::OutputDebug(SystemFlags::debugPerformance, "In [%s::%s Line: %d] took msecs: %lld\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, chrono.getMillis());
 				if (SystemFlags::getSystemSettingType(SystemFlags::debugPerformance).enabled && chrono.getMillis() > 0) chrono.start();
 			}
+			fromEndian();
 		} else {
-			unsigned char *buf = new unsigned char[getPackedSize() + 1];
-			result = NetworkMessage::receive(socket, buf, getPackedSize(), true);
-			unpackMessage(buf);
-			//printf("Got packet size = %u data.messageType = %d\n%s\n",getPackedSize(),data.messageType,buf);
-			delete[] buf;
+			result = receivePacked(socket, *this);
 		}
-		fromEndian();
 
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugPerformance).enabled && chrono.getMillis() > 0) SystemFlags::OutputDebug(SystemFlags::debugPerformance, "In [%s::%s Line: %d] took msecs: %lld\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, chrono.getMillis());
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugPerformance).enabled && chrono.getMillis() > 0) chrono.start();
@@ -1509,9 +1074,9 @@ namespace Game {
 		} else {
 			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] messageType = %d\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, messageType);
 		}
-		toEndian();
 
 		if (useOldProtocol == true) {
+			toEndian();
 			////NetworkMessage::send(socket, &messageType, sizeof(messageType));
 			//NetworkMessage::send(socket, &data, sizeof(data), messageType);
 
@@ -1542,10 +1107,7 @@ namespace Game {
 			delete[] compressionResult.first;
 			//printf("Compressed launch packet SENT\n");
 		} else {
-			unsigned char *buf = packMessage();
-			//printf("Send packet size = %u data.messageType = %d\n[%s]\n",getPackedSize(),data.messageType,buf);
-			NetworkMessage::send(socket, buf, getPackedSize());
-			delete[] buf;
+			sendPacked(socket, *this);
 		}
 	}
 
@@ -1640,6 +1202,7 @@ namespace Game {
 		for (int index = 0; index < GameConstants::maxPlayers; ++index) {
 			data.header.networkPlayerFactionCRC[index] = 0;
 		}
+		networkFramePeriod = 0;
 	}
 
 	bool NetworkMessageCommandList::addCommand(const NetworkCommand* networkCommand) {
@@ -1648,153 +1211,34 @@ namespace Game {
 		return true;
 	}
 
-	const char * NetworkMessageCommandList::getPackedMessageFormatHeader() const {
-		return "cHlLLLLLLLL";
-	}
-
-	unsigned int NetworkMessageCommandList::getPackedSizeHeader() {
-		static unsigned int result = 0;
-		if (result == 0) {
-			Data packedData;
-			init(packedData);
-			unsigned char *buf = new unsigned char[sizeof(packedData) * 3];
-			result = pack(buf, getPackedMessageFormatHeader(),
-				packedData.messageType,
-				packedData.header.commandCount,
-				packedData.header.frameCount,
-				packedData.header.networkPlayerFactionCRC[0],
-				packedData.header.networkPlayerFactionCRC[1],
-				packedData.header.networkPlayerFactionCRC[2],
-				packedData.header.networkPlayerFactionCRC[3],
-				packedData.header.networkPlayerFactionCRC[4],
-				packedData.header.networkPlayerFactionCRC[5],
-				packedData.header.networkPlayerFactionCRC[6],
-				packedData.header.networkPlayerFactionCRC[7]);
-			delete[] buf;
-		}
-		return result;
+	template <typename Archive>
+	void NetworkMessageCommandList::serialize(Archive &archive) {
+		archive.field(data.messageType);
+		archive.field(data.header.commandCount);
+		archive.field(data.header.frameCount);
+		archive.fieldArray(data.header.networkPlayerFactionCRC, GameConstants::maxPlayers);
 	}
-	void NetworkMessageCommandList::unpackMessageHeader(unsigned char *buf) {
-		unpack(buf, getPackedMessageFormatHeader(),
-			&data.messageType,
-			&data.header.commandCount,
-			&data.header.frameCount,
-			&data.header.networkPlayerFactionCRC[0],
-			&data.header.networkPlayerFactionCRC[1],
-			&data.header.networkPlayerFactionCRC[2],
-			&data.header.networkPlayerFactionCRC[3],
-			&data.header.networkPlayerFactionCRC[4],
-			&data.header.networkPlayerFactionCRC[5],
-			&data.header.networkPlayerFactionCRC[6],
-			&data.header.networkPlayerFactionCRC[7]);
-	}
-
-	unsigned char * NetworkMessageCommandList::packMessageHeader() {
-		unsigned char *buf = new unsigned char[getPackedSizeHeader() + 1];
-		pack(buf, getPackedMessageFormatHeader(),
-			data.messageType,
-			data.header.commandCount,
-			data.header.frameCount,
-			data.header.networkPlayerFactionCRC[0],
-			data.header.networkPlayerFactionCRC[1],
-			data.header.networkPlayerFactionCRC[2],
-			data.header.networkPlayerFactionCRC[3],
-			data.header.networkPlayerFactionCRC[4],
-			data.header.networkPlayerFactionCRC[5],
-			data.header.networkPlayerFactionCRC[6],
-			data.header.networkPlayerFactionCRC[7]);
-		return buf;
-	}
-
-	const char * NetworkMessageCommandList::getPackedMessageFormatDetail() const {
-		return "hlhhhhlccHccll";
-	}
-
-	unsigned int NetworkMessageCommandList::getPackedSizeDetail(int count) {
-		unsigned int result = 0;
-		//if(result == 0) {
-		for (unsigned int i = 0; i < (unsigned int) count; ++i) {
-			NetworkCommand packedData;
-			unsigned char *buf = new unsigned char[sizeof(NetworkCommand) * 3];
-			result += pack(buf, getPackedMessageFormatDetail(),
-				packedData.networkCommandType,
-				packedData.unitId,
-				packedData.unitTypeId,
-				packedData.commandTypeId,
-				packedData.positionX,
-				packedData.positionY,
-				packedData.targetId,
-				packedData.wantQueue,
-				packedData.fromFactionIndex,
-				packedData.unitFactionUnitCount,
-				packedData.unitFactionIndex,
-				packedData.commandStateType,
-				packedData.commandStateValue,
-				packedData.unitCommandGroupId);
-			delete[] buf;
+
+	// The packed commands that follow a command list header
+	class NetworkCommandListDetail {
+	private:
+		NetworkCommand *commands;
+		int count;
+
+	public:
+		NetworkCommandListDetail(NetworkCommand *commands, int count) {
+			this->commands = commands;
+			this->count = count;
 		}
-		//}
-		return result;
-	}
-	void NetworkMessageCommandList::unpackMessageDetail(unsigned char *buf, int count) {
-		data.commands.clear();
-		data.commands.resize(count);
-		//unsigned int bytes_processed_total = 0;
-		unsigned char *bufMove = buf;
-		for (unsigned int i = 0; i < (unsigned int) count; ++i) {
-			unsigned int bytes_processed = unpack(bufMove, getPackedMessageFormatDetail(),
-				&data.commands[i].networkCommandType,
-				&data.commands[i].unitId,
-				&data.commands[i].unitTypeId,
-				&data.commands[i].commandTypeId,
-				&data.commands[i].positionX,
-				&data.commands[i].positionY,
-				&data.commands[i].targetId,
-				&data.commands[i].wantQueue,
-				&data.commands[i].fromFactionIndex,
-				&data.commands[i].unitFactionUnitCount,
-				&data.commands[i].unitFactionIndex,
-				&data.commands[i].commandStateType,
-				&data.commands[i].commandStateValue,
-				&data.commands[i].unitCommandGroupId);
-			bufMove += bytes_processed;
-			//bytes_processed_total += bytes_processed;
-		}
-		//printf("\nUnPacked detail size = %u\n",bytes_processed_total);
-	}
-
-	unsigned char * NetworkMessageCommandList::packMessageDetail(uint16 totalCommand) {
-		int packetSize = getPackedSizeDetail(totalCommand) + 1;
-		unsigned char *buf = new unsigned char[packetSize];
-		unsigned char *bufMove = buf;
-		//unsigned int bytes_processed_total = 0;
-		for (unsigned int i = 0; i < totalCommand; ++i) {
-			unsigned int bytes_processed = pack(bufMove, getPackedMessageFormatDetail(),
-				data.commands[i].networkCommandType,
-				data.commands[i].unitId,
-				data.commands[i].unitTypeId,
-				data.commands[i].commandTypeId,
-				data.commands[i].positionX,
-				data.commands[i].positionY,
-				data.commands[i].targetId,
-				data.commands[i].wantQueue,
-				data.commands[i].fromFactionIndex,
-				data.commands[i].unitFactionUnitCount,
-				data.commands[i].unitFactionIndex,
-				data.commands[i].commandStateType,
-				data.commands[i].commandStateValue,
-				data.commands[i].unitCommandGroupId);
-			bufMove += bytes_processed;
-			//bytes_processed_total += bytes_processed;
-		}
-		//printf("\nPacked detail size = %u, allocated = %d\n",bytes_processed_total,packetSize);
-		return buf;
-	}
+
+		template <typename Archive> void serialize(Archive &archive) {
+			serializeObjects(archive, commands, count);
+		}
+	};
 
 	bool NetworkMessageCommandList::receive(Socket* socket) {
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
 
-		unsigned char *buf = NULL;
 		bool result = false;
 		if (useOldProtocol == true) {
 			result = NetworkMessage::receive(socket, &data.header, commandListHeaderSize, true);
@@ -1803,14 +1247,10 @@ namespace Game {
 			}
 
 			//printf("!!! =====> IN Network hdr cmd get frame: %d data.header.commandCount: %u\n",data.header.frameCount,data.header.commandCount);
+			fromEndianHeader();
 		} else {
-			buf = new unsigned char[getPackedSizeHeader() + 1];
-			result = NetworkMessage::receive(socket, buf, getPackedSizeHeader(), true);
-			unpackMessageHeader(buf);
-			//if(data.header.commandCount) printf("\n\nGot packet size = %u data.messageType = %d\n%s\ncommandcount [%u] framecount [%d]\n",getPackedSizeHeader(),data.header.messageType,buf,data.header.commandCount,data.header.frameCount);
-			delete[] buf;
+			result = receivePacked(socket, *this);
 		}
-		fromEndianHeader();
 
 		if (result == true) {
 			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] got header, messageType = %d, commandCount = %u, frameCount = %d\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, data.messageType, data.header.commandCount, data.header.frameCount);
@@ -1827,16 +1267,11 @@ namespace Game {
 					//				if(data.commands[0].getNetworkCommandType() == nctPauseResume) {
 					//					printf("=====> IN Network cmd type: %d [%d] frame: %d\n",data.commands[0].getNetworkCommandType(),nctPauseResume,data.header.frameCount);
 					//				}
+					fromEndianDetail();
 				} else {
-					//int totalMsgSize = (sizeof(NetworkCommand) * data.header.commandCount);
-					//result = NetworkMessage::receive(socket, &data.commands[0], totalMsgSize, true);
-					buf = new unsigned char[getPackedSizeDetail(data.header.commandCount) + 1];
-					result = NetworkMessage::receive(socket, buf, getPackedSizeDetail(data.header.commandCount), true);
-					unpackMessageDetail(buf, data.header.commandCount);
-					//printf("Got packet size = %u data.messageType = %d\n%s\n",getPackedSize(),data.messageType,buf);
-					delete[] buf;
+					NetworkCommandListDetail detail(&data.commands[0], data.header.commandCount);
+					result = receivePacked(socket, detail);
 				}
-				fromEndianDetail();
 
 				//	        for(int idx = 0 ; idx < data.header.commandCount; ++idx) {
 				//	            const NetworkCommand &cmd = data.commands[idx];
@@ -1864,6 +1299,181 @@ namespace Game {
 
 	}
 
+	bool NetworkMessageCommandList::receive(Socket* socket, NetworkMessageType type) {
+		if (type == nmtCommandListCompact) {
+			return receiveCompact(socket);
+		}
+		return receive(socket);
+	}
+
+	// Compact command list encoding helpers, all values are written as
+	// little endian base 128 varints and signed values are zigzag encoded
+	static const uint32 maxCompactCommandListBodySize = 1024 * 1024;
+
+	static void writeCompactVarint(std::vector<char> &buffer, uint64 value) {
+		while (value >= 0x80) {
+			buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+			value >>= 7;
+		}
+		buffer.push_back(static_cast<char>(value));
+	}
+
+	static void writeCompactSigned(std::vector<char> &buffer, int64 value) {
+		writeCompactVarint(buffer, (static_cast<uint64>(value) << 1) ^ static_cast<uint64>(value >> 63));
+	}
+
+	static uint64 readCompactVarint(const unsigned char *buffer, uint32 bufferSize, uint32 &offset) {
+		uint64 value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			if (offset >= bufferSize) {
+				throw game_runtime_error("Error decoding compact NetworkMessageCommandList, truncated varint");
+			}
+			unsigned char byte = buffer[offset++];
+			value |= static_cast<uint64>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0) {
+				return value;
+			}
+		}
+		throw game_runtime_error("Error decoding compact NetworkMessageCommandList, varint too long");
+	}
+
+	static int64 readCompactSigned(const unsigned char *buffer, uint32 bufferSize, uint32 &offset) {
+		uint64 value = readCompactVarint(buffer, bufferSize, offset);
+		return static_cast<int64>(value >> 1) ^ -static_cast<int64>(value & 1);
+	}
+
+	void NetworkMessageCommandList::sendCompact(Socket* socket) {
+		std::vector<char> body;
+		body.reserve(16 + data.header.commandCount * 16);
+
+		writeCompactSigned(body, data.header.frameCount);
+		writeCompactVarint(body, data.header.commandCount);
+
+		uint32 crcMask = 0;
+		for (int index = 0; index < GameConstants::maxPlayers; ++index) {
+			if (data.header.networkPlayerFactionCRC[index] != 0) {
+				crcMask |= (1 << index);
+			}
+		}
+		writeCompactVarint(body, crcMask);
+		for (int index = 0; index < GameConstants::maxPlayers; ++index) {
+			if ((crcMask & (1 << index)) != 0) {
+				uint32 crc = data.header.networkPlayerFactionCRC[index];
+				for (int byteIndex = 0; byteIndex < 4; ++byteIndex) {
+					body.push_back(static_cast<char>((crc >> (byteIndex * 8)) & 0xFF));
+				}
+			}
+		}
+
+		// Mass orders share the command type and target with sequential unit
+		// ids so most deltas fit in a single byte
+		NetworkCommand previous;
+		for (int index = 0; index < data.header.commandCount; ++index) {
+			const NetworkCommand &cmd = data.commands[index];
+			writeCompactSigned(body, (int64) cmd.networkCommandType - previous.networkCommandType);
+			writeCompactSigned(body, (int64) cmd.unitId - previous.unitId);
+			writeCompactSigned(body, (int64) cmd.unitTypeId - previous.unitTypeId);
+			writeCompactSigned(body, (int64) cmd.commandTypeId - previous.commandTypeId);
+			writeCompactSigned(body, (int64) cmd.positionX - previous.positionX);
+			writeCompactSigned(body, (int64) cmd.positionY - previous.positionY);
+			writeCompactSigned(body, (int64) cmd.targetId - previous.targetId);
+			writeCompactSigned(body, (int64) cmd.wantQueue - previous.wantQueue);
+			writeCompactSigned(body, (int64) cmd.fromFactionIndex - previous.fromFactionIndex);
+			writeCompactSigned(body, (int64) cmd.unitFactionUnitCount - previous.unitFactionUnitCount);
+			writeCompactSigned(body, (int64) cmd.unitFactionIndex - previous.unitFactionIndex);
+			writeCompactSigned(body, (int64) cmd.commandStateType - previous.commandStateType);
+			writeCompactSigned(body, (int64) cmd.commandStateValue - previous.commandStateValue);
+			writeCompactSigned(body, (int64) cmd.unitCommandGroupId - previous.unitCommandGroupId);
+			previous = cmd;
+		}
+
+		// Optional trailing fields, older readers stop after the commands
+		if ((protocolFeatures & npfAdaptiveFramePeriod) != 0 && networkFramePeriod > 0) {
+			writeCompactVarint(body, networkFramePeriod);
+		}
+
+		uint32 bodySize = (uint32) body.size();
+		unsigned char sizeBuffer[4];
+		for (int byteIndex = 0; byteIndex < 4; ++byteIndex) {
+			sizeBuffer[byteIndex] = static_cast<unsigned char>((bodySize >> (byteIndex * 8)) & 0xFF);
+		}
+		body.insert(body.begin(), sizeBuffer, sizeBuffer + 4);
+
+		NetworkMessage::send(socket, &body[0], (int) body.size(), (int8) nmtCommandListCompact);
+	}
+
+	bool NetworkMessageCommandList::receiveCompact(Socket* socket) {
+		unsigned char sizeBuffer[4];
+		if (NetworkMessage::receive(socket, sizeBuffer, sizeof(sizeBuffer), true) == false) {
+			return false;
+		}
+		uint32 bodySize = 0;
+		for (int byteIndex = 0; byteIndex < 4; ++byteIndex) {
+			bodySize |= static_cast<uint32>(sizeBuffer[byteIndex]) << (byteIndex * 8);
+		}
+		if (bodySize == 0 || bodySize > maxCompactCommandListBodySize) {
+			throw game_runtime_error("Error receiving compact NetworkMessageCommandList, invalid body size = " + uIntToStr(bodySize));
+		}
+
+		std::vector<unsigned char> body(bodySize);
+		if (NetworkMessage::receive(socket, &body[0], bodySize, true) == false) {
+			return false;
+		}
+
+		uint32 offset = 0;
+		data.messageType = nmtCommandList;
+		data.header.frameCount = (int32) readCompactSigned(&body[0], bodySize, offset);
+		data.header.commandCount = (uint16) readCompactVarint(&body[0], bodySize, offset);
+
+		uint32 crcMask = (uint32) readCompactVarint(&body[0], bodySize, offset);
+		for (int index = 0; index < GameConstants::maxPlayers; ++index) {
+			data.header.networkPlayerFactionCRC[index] = 0;
+			if ((crcMask & (1 << index)) != 0) {
+				if (offset + 4 > bodySize) {
+					throw game_runtime_error("Error decoding compact NetworkMessageCommandList, truncated crc");
+				}
+				uint32 crc = 0;
+				for (int byteIndex = 0; byteIndex < 4; ++byteIndex) {
+					crc |= static_cast<uint32>(body[offset++]) << (byteIndex * 8);
+				}
+				data.header.networkPlayerFactionCRC[index] = crc;
+			}
+		}
+
+		data.commands.resize(data.header.commandCount);
+		NetworkCommand previous;
+		for (int index = 0; index < data.header.commandCount; ++index) {
+			NetworkCommand &cmd = data.commands[index];
+			cmd.networkCommandType = (int16) (previous.networkCommandType + readCompactSigned(&body[0], bodySize, offset));
+			cmd.unitId = (int32) (previous.unitId + readCompactSigned(&body[0], bodySize, offset));
+			cmd.unitTypeId = (int16) (previous.unitTypeId + readCompactSigned(&body[0], bodySize, offset));
+			cmd.commandTypeId = (int16) (previous.commandTypeId + readCompactSigned(&body[0], bodySize, offset));
+			cmd.positionX = (int16) (previous.positionX + readCompactSigned(&body[0], bodySize, offset));
+			cmd.positionY = (int16) (previous.positionY + readCompactSigned(&body[0], bodySize, offset));
+			cmd.targetId = (int32) (previous.targetId + readCompactSigned(&body[0], bodySize, offset));
+			cmd.wantQueue = (int8) (previous.wantQueue + readCompactSigned(&body[0], bodySize, offset));
+			cmd.fromFactionIndex = (int8) (previous.fromFactionIndex + readCompactSigned(&body[0], bodySize, offset));
+			cmd.unitFactionUnitCount = (uint16) (previous.unitFactionUnitCount + readCompactSigned(&body[0], bodySize, offset));
+			cmd.unitFactionIndex = (int8) (previous.unitFactionIndex + readCompactSigned(&body[0], bodySize, offset));
+			cmd.commandStateType = (int8) (previous.commandStateType + readCompactSigned(&body[0], bodySize, offset));
+			cmd.commandStateValue = (int32) (previous.commandStateValue + readCompactSigned(&body[0], bodySize, offset));
+			cmd.unitCommandGroupId = (int32) (previous.unitCommandGroupId + readCompactSigned(&body[0], bodySize, offset));
+			previous = cmd;
+		}
+
+		networkFramePeriod = 0;
+		if (offset < bodySize) {
+			uint64 period = readCompactVarint(&body[0], bodySize, offset);
+			if (period == 0 || period > 255) {
+				throw game_runtime_error("Error decoding compact NetworkMessageCommandList, invalid network frame period = " + uIntToStr((uint32) period));
+			}
+			networkFramePeriod = (int32) period;
+		}
+
+		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] got compact command list, bodySize = %u, commandCount = %u, frameCount = %d\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, bodySize, data.header.commandCount, data.header.frameCount);
+		return true;
+	}
+
 	unsigned char * NetworkMessageCommandList::getData() {
 		int headerSize = sizeof(data.header);
 		uint16 totalCommand = data.header.commandCount;
@@ -1880,13 +1490,18 @@ namespace Game {
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] nmtCommandList, frameCount = %d, data.header.commandCount = %d, data.header.messageType = %d\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, data.header.frameCount, data.header.commandCount, data.messageType);
 
 		assert(data.messageType == nmtCommandList);
+		if ((protocolFeatures & npfCompactCommandList) != 0) {
+			sendCompact(socket);
+			return;
+		}
+
 		uint16 totalCommand = data.header.commandCount;
-		toEndianHeader();
-		toEndianDetail(totalCommand);
 
-		unsigned char *buf = NULL;
 		//bool result = false;
 		if (useOldProtocol == true) {
+			toEndianHeader();
+			toEndianDetail(totalCommand);
+
 			//printf("<===== OUT Network hdr cmd type: frame: %d totalCommand: %u [%u]\n",data.header.frameCount,totalCommand,data.header.commandCount);
 			//NetworkMessage::send(socket, &data.messageType, sizeof(data.messageType));
 
@@ -1899,11 +1514,7 @@ namespace Game {
 			NetworkMessage::send(socket, send_buffer, fullBufferSize, data.messageType);
 			delete[] send_buffer;
 		} else {
-			//NetworkMessage::send(socket, &data.header, commandListHeaderSize);
-			buf = packMessageHeader();
-			//if(totalCommand) printf("\n\nSend packet size = %u data.messageType = %d\n%s\ncommandcount [%u] framecount [%d]\n",getPackedSizeHeader(),data.header.messageType,buf,totalCommand,data.header.frameCount);
-			NetworkMessage::send(socket, buf, getPackedSizeHeader());
-			delete[] buf;
+			sendPacked(socket, *this);
 		}
 
 		if (totalCommand > 0) {
@@ -1918,13 +1529,8 @@ namespace Game {
 				//			}
 							//NetworkMessage::send(socket, &data.commands[0], (sizeof(NetworkCommand) * totalCommand));
 			} else {
-				buf = packMessageDetail(totalCommand);
-				//printf("\n#4 Send packet commandcount [%u] framecount [%d]\n",totalCommand,data.header.frameCount);
-				//printf("Send packet size = %u data.messageType = %d\n[%s]\n",getPackedSize(),data.messageType,buf);
-				NetworkMessage::send(socket, buf, getPackedSizeDetail(totalCommand));
-				//printf("\n#5 Send packet commandcount [%u] framecount [%d]\n",totalCommand,data.header.frameCount);
-				delete[] buf;
-				//printf("\n#6 Send packet commandcount [%u] framecount [%d]\n",totalCommand,data.header.frameCount);
+				NetworkCommandListDetail detail(&data.commands[0], totalCommand);
+				sendPacked(socket, detail);
 
 		//        for(int idx = 0 ; idx < totalCommand; ++idx) {
 		//            const NetworkCommand &cmd = data.commands[idx];
@@ -2023,46 +1629,13 @@ namespace Game {
 		return copy;
 	}
 
-	const char * NetworkMessageText::getPackedMessageFormat() const {
-		return "c500scc60s";
-	}
-
-	unsigned int NetworkMessageText::getPackedSize() {
-		static unsigned int result = 0;
-		if (result == 0) {
-			Data packedData;
-			messageType = nmtText;
-			packedData.playerIndex = 0;
-			packedData.teamIndex = 0;
-			unsigned char *buf = new unsigned char[sizeof(packedData) * 3];
-			result = pack(buf, getPackedMessageFormat(),
-				messageType,
-				packedData.text.getBuffer(),
-				packedData.teamIndex,
-				packedData.playerIndex,
-				packedData.targetLanguage.getBuffer());
-			delete[] buf;
-		}
-		return result;
-	}
-	void NetworkMessageText::unpackMessage(unsigned char *buf) {
-		unpack(buf, getPackedMessageFormat(),
-			&messageType,
-			data.text.getBuffer(),
-			&data.teamIndex,
-			&data.playerIndex,
-			data.targetLanguage.getBuffer());
-	}
-
-	unsigned char * NetworkMessageText::packMessage() {
-		unsigned char *buf = new unsigned char[getPackedSize() + 1];
-		pack(buf, getPackedMessageFormat(),
-			messageType,
-			data.text.getBuffer(),
-			data.teamIndex,
-			data.playerIndex,
-			data.targetLanguage.getBuffer());
-		return buf;
+	template <typename Archive>
+	void NetworkMessageText::serialize(Archive &archive) {
+		archive.field(messageType);
+		archive.field(data.text);
+		archive.field(data.teamIndex);
+		archive.field(data.playerIndex);
+		archive.field(data.targetLanguage);
 	}
 
 	bool NetworkMessageText::receive(Socket* socket) {
@@ -2072,14 +1645,10 @@ namespace Game {
 			if (result == true) {
 				messageType = this->getNetworkMessageType();
 			}
+			fromEndian();
 		} else {
-			unsigned char *buf = new unsigned char[getPackedSize() + 1];
-			result = NetworkMessage::receive(socket, buf, getPackedSize(), true);
-			unpackMessage(buf);
-			//printf("Got packet size = %u data.messageType = %d\n%s\n",getPackedSize(),data.messageType,buf);
-			delete[] buf;
+			result = receivePacked(socket, *this);
 		}
-		fromEndian();
 
 		data.text.nullTerminate();
 		data.targetLanguage.nullTerminate();
@@ -2091,16 +1660,13 @@ namespace Game {
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] nmtText\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
 
 		assert(messageType == nmtText);
-		toEndian();
 
 		if (useOldProtocol == true) {
+			toEndian();
 			//NetworkMessage::send(socket, &messageType, sizeof(messageType));
 			NetworkMessage::send(socket, &data, sizeof(data), messageType);
 		} else {
-			unsigned char *buf = packMessage();
-			//printf("Send packet size = %u data.messageType = %d\n[%s]\n",getPackedSize(),data.messageType,buf);
-			NetworkMessage::send(socket, buf, getPackedSize());
-			delete[] buf;
+			sendPacked(socket, *this);
 		}
 	}
 
@@ -2129,47 +1695,19 @@ namespace Game {
 		messageType = nmtQuit;
 	}
 
-	const char * NetworkMessageQuit::getPackedMessageFormat() const {
-		return "c";
-	}
-
-	unsigned int NetworkMessageQuit::getPackedSize() {
-		static unsigned int result = 0;
-		if (result == 0) {
-			//Data packedData;
-			messageType = 0;
-			unsigned char *buf = new unsigned char[sizeof(messageType) * 3];
-			result = pack(buf, getPackedMessageFormat(),
-				messageType);
-			delete[] buf;
-		}
-		return result;
-	}
-	void NetworkMessageQuit::unpackMessage(unsigned char *buf) {
-		unpack(buf, getPackedMessageFormat(),
-			&messageType);
-	}
-
-	unsigned char * NetworkMessageQuit::packMessage() {
-		unsigned char *buf = new unsigned char[getPackedSize() + 1];
-		pack(buf, getPackedMessageFormat(),
-			messageType);
-		return buf;
+	template <typename Archive>
+	void NetworkMessageQuit::serialize(Archive &archive) {
+		archive.field(messageType);
 	}
 
 	bool NetworkMessageQuit::receive(Socket* socket) {
 		bool result = false;
 		if (useOldProtocol == true) {
 			result = NetworkMessage::receive(socket, &messageType, sizeof(messageType), true);
+			fromEndian();
 		} else {
-			//fromEndian();
-			unsigned char *buf = new unsigned char[getPackedSize() + 1];
-			result = NetworkMessage::receive(socket, buf, getPackedSize(), true);
-			unpackMessage(buf);
-			//printf("Got packet size = %u data.messageType = %d\n%s\n",getPackedSize(),data.messageType,buf);
-			delete[] buf;
+			result = receivePacked(socket, *this);
 		}
-		fromEndian();
 
 		return result;
 	}
@@ -2178,15 +1716,12 @@ namespace Game {
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] nmtQuit\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
 
 		assert(messageType == nmtQuit);
-		toEndian();
 
 		if (useOldProtocol == true) {
+			toEndian();
 			NetworkMessage::send(socket, &messageType, sizeof(messageType));
 		} else {
-			unsigned char *buf = packMessage();
-			//printf("Send packet size = %u data.messageType = %d\n[%s]\n",getPackedSize(),data.messageType,buf);
-			NetworkMessage::send(socket, buf, getPackedSize());
-			delete[] buf;
+			sendPacked(socket, *this);
 		}
 	}
 
@@ -2313,111 +1848,6 @@ namespace Game {
 		return result;
 	}
 
-	const char * NetworkMessageSynchNetworkGameData::getPackedMessageFormatHeader() const {
-		return "c255s255s255sLLLL";
-	}
-
-	unsigned int NetworkMessageSynchNetworkGameData::getPackedSizeHeader() {
-		static unsigned int result = 0;
-		if (result == 0) {
-			Data packedData;
-			packedData.messageType = 0;
-			unsigned char *buf = new unsigned char[sizeof(packedData) * 3];
-			result = pack(buf, getPackedMessageFormatHeader(),
-				packedData.messageType,
-				packedData.header.map.getBuffer(),
-				packedData.header.tileset.getBuffer(),
-				packedData.header.tech.getBuffer(),
-				packedData.header.mapCRC,
-				packedData.header.tilesetCRC,
-				packedData.header.techCRC,
-				packedData.header.techCRCFileCount);
-			delete[] buf;
-		}
-		return result;
-	}
-	void NetworkMessageSynchNetworkGameData::unpackMessageHeader(unsigned char *buf) {
-		unpack(buf, getPackedMessageFormatHeader(),
-			&data.messageType,
-			data.header.map.getBuffer(),
-			data.header.tileset.getBuffer(),
-			data.header.tech.getBuffer(),
-			&data.header.mapCRC,
-			&data.header.tilesetCRC,
-			&data.header.techCRC,
-			&data.header.techCRCFileCount);
-	}
-
-	unsigned char * NetworkMessageSynchNetworkGameData::packMessageHeader() {
-		unsigned char *buf = new unsigned char[getPackedSizeHeader() + 1];
-		pack(buf, getPackedMessageFormatHeader(),
-			data.messageType,
-			data.header.map.getBuffer(),
-			data.header.tileset.getBuffer(),
-			data.header.tech.getBuffer(),
-			data.header.mapCRC,
-			data.header.tilesetCRC,
-			data.header.techCRC,
-			data.header.techCRCFileCount);
-
-		return buf;
-	}
-
-	unsigned int NetworkMessageSynchNetworkGameData::getPackedSizeDetail() {
-		static unsigned int result = 0;
-		if (result == 0) {
-			DataDetail packedData;
-			for (unsigned int index = 0; index < (unsigned int) maxFileCRCCount; ++index) {
-				packedData.techCRCFileCRCList[index] = 0;
-			}
-			unsigned char *buf = new unsigned char[sizeof(DataDetail) * 3];
-
-			for (unsigned int i = 0; i < (unsigned int) maxFileCRCCount; ++i) {
-				result += pack(buf, "255s",
-					packedData.techCRCFileList[i].getBuffer());
-				buf += result;
-			}
-			for (unsigned int i = 0; i < (unsigned int) maxFileCRCCount; ++i) {
-				result += pack(buf, "L",
-					packedData.techCRCFileCRCList[i]);
-				buf += result;
-			}
-
-			delete[] buf;
-		}
-		return result;
-	}
-	void NetworkMessageSynchNetworkGameData::unpackMessageDetail(unsigned char *buf) {
-		for (unsigned int i = 0; i < (unsigned int) maxFileCRCCount; ++i) {
-			unsigned int bytes_processed = unpack(buf, "255s",
-				data.detail.techCRCFileList[i].getBuffer());
-			buf += bytes_processed;
-		}
-		for (unsigned int i = 0; i < (unsigned int) maxFileCRCCount; ++i) {
-			unsigned int bytes_processed = unpack(buf, "L",
-				&data.detail.techCRCFileCRCList[i]);
-			buf += bytes_processed;
-		}
-	}
-
-	unsigned char * NetworkMessageSynchNetworkGameData::packMessageDetail() {
-		unsigned char *buf = new unsigned char[sizeof(DataDetail) * 3 + 1];
-		unsigned char *bufMove = buf;
-		for (unsigned int i = 0; i < (unsigned int) maxFileCRCCount; ++i) {
-			unsigned int bytes_processed = pack(bufMove, "255s",
-				data.detail.techCRCFileList[i].getBuffer());
-			bufMove += bytes_processed;
-		}
-		for (unsigned int i = 0; i < (unsigned int) maxFileCRCCount; ++i) {
-			unsigned int bytes_processed = pack(bufMove, "L",
-				data.detail.techCRCFileCRCList[i]);
-			bufMove += bytes_processed;
-		}
-
-		return buf;
-	}
-
-
 	bool NetworkMessageSynchNetworkGameData::receive(Socket* socket) {
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] about to get nmtSynchNetworkGameData\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
 
@@ -2752,62 +2182,23 @@ namespace Game {
 		data.fileName = fileName;
 	}
 
-	const char * NetworkMessageSynchNetworkGameDataFileCRCCheck::getPackedMessageFormat() const {
-		return "cLLL256s";
-	}
-
-	unsigned int NetworkMessageSynchNetworkGameDataFileCRCCheck::getPackedSize() {
-		static unsigned int result = 0;
-		if (result == 0) {
-			Data packedData;
-			packedData.fileCRC = 0;
-			packedData.fileIndex = 0;
-			messageType = nmtSynchNetworkGameDataFileCRCCheck;
-			packedData.totalFileCount = 0;
-
-			unsigned char *buf = new unsigned char[sizeof(packedData) * 3];
-			result = pack(buf, getPackedMessageFormat(),
-				messageType,
-				packedData.totalFileCount,
-				packedData.fileIndex,
-				packedData.fileCRC,
-				packedData.fileName.getBuffer());
-			delete[] buf;
-		}
-		return result;
-	}
-	void NetworkMessageSynchNetworkGameDataFileCRCCheck::unpackMessage(unsigned char *buf) {
-		unpack(buf, getPackedMessageFormat(),
-			&messageType,
-			&data.totalFileCount,
-			&data.fileIndex,
-			&data.fileCRC,
-			data.fileName.getBuffer());
-	}
-
-	unsigned char * NetworkMessageSynchNetworkGameDataFileCRCCheck::packMessage() {
-		unsigned char *buf = new unsigned char[getPackedSize() + 1];
-		pack(buf, getPackedMessageFormat(),
-			messageType,
-			data.totalFileCount,
-			data.fileIndex,
-			data.fileCRC,
-			data.fileName.getBuffer());
-		return buf;
+	template <typename Archive>
+	void NetworkMessageSynchNetworkGameDataFileCRCCheck::serialize(Archive &archive) {
+		archive.field(messageType);
+		archive.field(data.totalFileCount);
+		archive.field(data.fileIndex);
+		archive.field(data.fileCRC);
+		archive.field(data.fileName);
 	}
 
 	bool NetworkMessageSynchNetworkGameDataFileCRCCheck::receive(Socket* socket) {
 		bool result = false;
 		if (useOldProtocol == true) {
 			result = NetworkMessage::receive(socket, &data, sizeof(data), true);
+			fromEndian();
 		} else {
-			unsigned char *buf = new unsigned char[getPackedSize() + 1];
-			result = NetworkMessage::receive(socket, buf, getPackedSize(), true);
-			unpackMessage(buf);
-			//printf("Got packet size = %u data.messageType = %d\n%s\n",getPackedSize(),data.messageType,buf);
-			delete[] buf;
+			result = receivePacked(socket, *this);
 		}
-		fromEndian();
 		data.fileName.nullTerminate();
 
 		return result;
@@ -2817,16 +2208,13 @@ namespace Game {
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] nmtSynchNetworkGameDataFileCRCCheck\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
 
 		assert(messageType == nmtSynchNetworkGameDataFileCRCCheck);
-		toEndian();
 
 		if (useOldProtocol == true) {
+			toEndian();
 			//NetworkMessage::send(socket, &messageType, sizeof(messageType));
 			NetworkMessage::send(socket, &data, sizeof(data), messageType);
 		} else {
-			unsigned char *buf = packMessage();
-			//printf("Send packet size = %u data.messageType = %d\n[%s]\n",getPackedSize(),data.messageType,buf);
-			NetworkMessage::send(socket, buf, getPackedSize());
-			delete[] buf;
+			sendPacked(socket, *this);
 		}
 	}
 
@@ -2860,49 +2248,20 @@ namespace Game {
 		data.fileName = fileName;
 	}
 
-	const char * NetworkMessageSynchNetworkGameDataFileGet::getPackedMessageFormat() const {
-		return "c256s";
-	}
-
-	unsigned int NetworkMessageSynchNetworkGameDataFileGet::getPackedSize() {
-		static unsigned int result = 0;
-		if (result == 0) {
-			Data packedData;
-			messageType = nmtSynchNetworkGameDataFileGet;
-			unsigned char *buf = new unsigned char[sizeof(packedData) * 3];
-			result = pack(buf, getPackedMessageFormat(),
-				messageType,
-				packedData.fileName.getBuffer());
-			delete[] buf;
-		}
-		return result;
-	}
-	void NetworkMessageSynchNetworkGameDataFileGet::unpackMessage(unsigned char *buf) {
-		unpack(buf, getPackedMessageFormat(),
-			&messageType,
-			data.fileName.getBuffer());
-	}
-
-	unsigned char * NetworkMessageSynchNetworkGameDataFileGet::packMessage() {
-		unsigned char *buf = new unsigned char[getPackedSize() + 1];
-		pack(buf, getPackedMessageFormat(),
-			messageType,
-			data.fileName.getBuffer());
-		return buf;
+	template <typename Archive>
+	void NetworkMessageSynchNetworkGameDataFileGet::serialize(Archive &archive) {
+		archive.field(messageType);
+		archive.field(data.fileName);
 	}
 
 	bool NetworkMessageSynchNetworkGameDataFileGet::receive(Socket* socket) {
 		bool result = false;
 		if (useOldProtocol == true) {
 			result = NetworkMessage::receive(socket, &data, sizeof(data), true);
+			fromEndian();
 		} else {
-			unsigned char *buf = new unsigned char[getPackedSize() + 1];
-			result = NetworkMessage::receive(socket, buf, getPackedSize(), true);
-			unpackMessage(buf);
-			//printf("Got packet size = %u data.messageType = %d\n%s\n",getPackedSize(),data.messageType,buf);
-			delete[] buf;
+			result = receivePacked(socket, *this);
 		}
-		fromEndian();
 		data.fileName.nullTerminate();
 
 		return result;
@@ -2912,15 +2271,12 @@ namespace Game {
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] nmtSynchNetworkGameDataFileGet\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
 
 		assert(messageType == nmtSynchNetworkGameDataFileGet);
-		toEndian();
 		if (useOldProtocol == true) {
+			toEndian();
 			//NetworkMessage::send(socket, &messageType, sizeof(messageType));
 			NetworkMessage::send(socket, &data, sizeof(data), messageType);
 		} else {
-			unsigned char *buf = packMessage();
-			//printf("Send packet size = %u data.messageType = %d\n[%s]\n",getPackedSize(),data.messageType,buf);
-			NetworkMessage::send(socket, buf, getPackedSize());
-			delete[] buf;
+			sendPacked(socket, *this);
 		}
 	}
 
@@ -2969,62 +2325,17 @@ namespace Game {
 		data.language = language;
 	}
 
-	const char * SwitchSetupRequest::getPackedMessageFormat() const {
-		return "c256sccc80scc60s";
-	}
-
-	unsigned int SwitchSetupRequest::getPackedSize() {
-		static unsigned int result = 0;
-		if (result == 0) {
-			Data packedData;
-			packedData.currentSlotIndex = 0;
-			messageType = nmtSwitchSetupRequest;
-			packedData.networkPlayerStatus = npst_None;
-			packedData.switchFlags = 0;
-			packedData.toSlotIndex = 0;
-			packedData.toTeam = 0;
-
-			unsigned char *buf = new unsigned char[sizeof(Data) * 3];
-			result = pack(buf, getPackedMessageFormat(),
-				messageType,
-				packedData.selectedFactionName.getBuffer(),
-				packedData.currentSlotIndex,
-				packedData.toSlotIndex,
-				packedData.toTeam,
-				packedData.networkPlayerName.getBuffer(),
-				packedData.networkPlayerStatus,
-				packedData.switchFlags,
-				packedData.language.getBuffer());
-			delete[] buf;
-		}
-		return result;
-	}
-	void SwitchSetupRequest::unpackMessage(unsigned char *buf) {
-		unpack(buf, getPackedMessageFormat(),
-			&messageType,
-			data.selectedFactionName.getBuffer(),
-			&data.currentSlotIndex,
-			&data.toSlotIndex,
-			&data.toTeam,
-			data.networkPlayerName.getBuffer(),
-			&data.networkPlayerStatus,
-			&data.switchFlags,
-			data.language.getBuffer());
-	}
-
-	unsigned char * SwitchSetupRequest::packMessage() {
-		unsigned char *buf = new unsigned char[getPackedSize() + 1];
-		pack(buf, getPackedMessageFormat(),
-			messageType,
-			data.selectedFactionName.getBuffer(),
-			data.currentSlotIndex,
-			data.toSlotIndex,
-			data.toTeam,
-			data.networkPlayerName.getBuffer(),
-			data.networkPlayerStatus,
-			data.switchFlags,
-			data.language.getBuffer());
-		return buf;
+	template <typename Archive>
+	void SwitchSetupRequest::serialize(Archive &archive) {
+		archive.field(messageType);
+		archive.field(data.selectedFactionName);
+		archive.field(data.currentSlotIndex);
+		archive.field(data.toSlotIndex);
+		archive.field(data.toTeam);
+		archive.field(data.networkPlayerName);
+		archive.field(data.networkPlayerStatus);
+		archive.field(data.switchFlags);
+		archive.field(data.language);
 	}
 
 	bool SwitchSetupRequest::receive(Socket* socket) {
@@ -3036,15 +2347,10 @@ namespace Game {
 				messageType = nmtSwitchSetupRequest;
 			}
 
+			fromEndian();
 		} else {
-			//fromEndian();
-			unsigned char *buf = new unsigned char[getPackedSize() + 1];
-			result = NetworkMessage::receive(socket, buf, getPackedSize(), true);
-			unpackMessage(buf);
-			//printf("Got packet size = %u data.messageType = %d\n%s\nTeam = %d faction [%s] currentFactionIndex = %d toFactionIndex = %d\n",getPackedSize(),data.messageType,buf,data.toTeam,data.selectedFactionName.getBuffer(),data.currentFactionIndex,data.toFactionIndex);
-			delete[] buf;
+			result = receivePacked(socket, *this);
 		}
-		fromEndian();
 
 		data.selectedFactionName.nullTerminate();
 		data.networkPlayerName.nullTerminate();
@@ -3059,16 +2365,13 @@ namespace Game {
 		assert(messageType == nmtSwitchSetupRequest);
 
 		if (SystemFlags::VERBOSE_MODE_ENABLED) printf("In [%s::%s Line %d] data.networkPlayerName [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, data.networkPlayerName.getString().c_str());
-		toEndian();
 
 		if (useOldProtocol == true) {
+			toEndian();
 			//NetworkMessage::send(socket, &messageType, sizeof(messageType));
 			NetworkMessage::send(socket, &data, sizeof(data), messageType);
 		} else {
-			unsigned char *buf = packMessage();
-			//printf("Send packet size = %u data.messageType = %d\n%s\nTeam = %d faction [%s] currentFactionIndex = %d toFactionIndex = %d\n",getPackedSize(),data.messageType,buf,data.toTeam,data.selectedFactionName.getBuffer(),data.currentFactionIndex,data.toFactionIndex);
-			NetworkMessage::send(socket, buf, getPackedSize());
-			delete[] buf;
+			sendPacked(socket, *this);
 		}
 	}
 
@@ -3103,36 +2406,10 @@ namespace Game {
 		data.playerIndex = playerIndex;
 	}
 
-	const char * PlayerIndexMessage::getPackedMessageFormat() const {
-		return "ch";
-	}
-
-	unsigned int PlayerIndexMessage::getPackedSize() {
-		static unsigned int result = 0;
-		if (result == 0) {
-			Data packedData;
-			messageType = 0;
-			packedData.playerIndex = 0;
-			unsigned char *buf = new unsigned char[sizeof(packedData) * 3];
-			result = pack(buf, getPackedMessageFormat(),
-				messageType,
-				packedData.playerIndex);
-			delete[] buf;
-		}
-		return result;
-	}
-	void PlayerIndexMessage::unpackMessage(unsigned char *buf) {
-		unpack(buf, getPackedMessageFormat(),
-			&messageType,
-			&data.playerIndex);
-	}
-
-	unsigned char * PlayerIndexMessage::packMessage() {
-		unsigned char *buf = new unsigned char[getPackedSize() + 1];
-		pack(buf, getPackedMessageFormat(),
-			messageType,
-			data.playerIndex);
-		return buf;
+	template <typename Archive>
+	void PlayerIndexMessage::serialize(Archive &archive) {
+		archive.field(messageType);
+		archive.field(data.playerIndex);
 	}
 
 	bool PlayerIndexMessage::receive(Socket* socket) {
@@ -3143,32 +2420,23 @@ namespace Game {
 				messageType = nmtPlayerIndexMessage;
 			}
 
+			fromEndian();
 		} else {
-			//fromEndian();
-			unsigned char *buf = new unsigned char[getPackedSize() + 1];
-			result = NetworkMessage::receive(socket, buf, getPackedSize(), true);
-			unpackMessage(buf);
-			//printf("Got packet size = %u data.messageType = %d\n%s\n",getPackedSize(),data.messageType,buf);
-			delete[] buf;
+			result = receivePacked(socket, *this);
 		}
-		fromEndian();
 
 		return result;
 	}
 
 	void PlayerIndexMessage::send(Socket* socket) {
 		assert(messageType == nmtPlayerIndexMessage);
-		toEndian();
 
 		if (useOldProtocol == true) {
+			toEndian();
 			//NetworkMessage::send(socket, &messageType, sizeof(messageType));
 			NetworkMessage::send(socket, &data, sizeof(data), messageType);
 		} else {
-			unsigned char *buf = packMessage();
-			//printf("Send packet size = %u data.messageType = %d\n[%s]\n",getPackedSize(),data.messageType,buf);
-			//NetworkMessage::send(socket, &data, sizeof(data));
-			NetworkMessage::send(socket, buf, getPackedSize());
-			delete[] buf;
+			sendPacked(socket, *this);
 		}
 	}
 
@@ -3195,36 +2463,10 @@ namespace Game {
 		data.status = status;
 	}
 
-	const char * NetworkMessageLoadingStatus::getPackedMessageFormat() const {
-		return "cL";
-	}
-
-	unsigned int NetworkMessageLoadingStatus::getPackedSize() {
-		static unsigned int result = 0;
-		if (result == 0) {
-			Data packedData;
-			messageType = 0;
-			packedData.status = 0;
-			unsigned char *buf = new unsigned char[sizeof(packedData) * 3];
-			result = pack(buf, getPackedMessageFormat(),
-				messageType,
-				packedData.status);
-			delete[] buf;
-		}
-		return result;
-	}
-	void NetworkMessageLoadingStatus::unpackMessage(unsigned char *buf) {
-		unpack(buf, getPackedMessageFormat(),
-			&messageType,
-			&data.status);
-	}
-
-	unsigned char * NetworkMessageLoadingStatus::packMessage() {
-		unsigned char *buf = new unsigned char[getPackedSize() + 1];
-		pack(buf, getPackedMessageFormat(),
-			messageType,
-			data.status);
-		return buf;
+	template <typename Archive>
+	void NetworkMessageLoadingStatus::serialize(Archive &archive) {
+		archive.field(messageType);
+		archive.field(data.status);
 	}
 
 	bool NetworkMessageLoadingStatus::receive(Socket* socket) {
@@ -3234,31 +2476,23 @@ namespace Game {
 			if (result == true) {
 				messageType = nmtLoadingStatusMessage;
 			}
+			fromEndian();
 		} else {
-			//fromEndian();
-			unsigned char *buf = new unsigned char[getPackedSize() + 1];
-			result = NetworkMessage::receive(socket, buf, getPackedSize(), true);
-			unpackMessage(buf);
-			//printf("Got packet size = %u data.messageType = %d\n%s\n",getPackedSize(),data.messageType,buf);
-			delete[] buf;
+			result = receivePacked(socket, *this);
 		}
-		fromEndian();
 
 		return result;
 	}
 
 	void NetworkMessageLoadingStatus::send(Socket* socket) {
 		assert(messageType == nmtLoadingStatusMessage);
-		toEndian();
 
 		if (useOldProtocol == true) {
+			toEndian();
 			//NetworkMessage::send(socket, &messageType, sizeof(messageType));
 			NetworkMessage::send(socket, &data, sizeof(data), messageType);
 		} else {
-			unsigned char *buf = packMessage();
-			//printf("Send packet size = %u data.messageType = %d\n[%s]\n",getPackedSize(),data.messageType,buf);
-			NetworkMessage::send(socket, buf, getPackedSize());
-			delete[] buf;
+			sendPacked(socket, *this);
 		}
 	}
 
@@ -3303,54 +2537,14 @@ namespace Game {
 		return copy;
 	}
 
-	const char * NetworkMessageMarkCell::getPackedMessageFormat() const {
-		return "chhcc500s";
-	}
-
-	unsigned int NetworkMessageMarkCell::getPackedSize() {
-		static unsigned int result = 0;
-		if (result == 0) {
-			Data packedData;
-			packedData.factionIndex = 0;
-			messageType = nmtMarkCell;
-			packedData.playerIndex = 0;
-			packedData.targetX = 0;
-			packedData.targetY = 0;
-
-			unsigned char *buf = new unsigned char[sizeof(packedData) * 3];
-			result = pack(buf, getPackedMessageFormat(),
-				messageType,
-				packedData.targetX,
-				packedData.targetY,
-				packedData.factionIndex,
-				packedData.playerIndex,
-				packedData.text.getBuffer());
-			delete[] buf;
-		}
-		return result;
-	}
-	void NetworkMessageMarkCell::unpackMessage(unsigned char *buf) {
-		unpack(buf, getPackedMessageFormat(),
-			&messageType,
-			&data.targetX,
-			&data.targetY,
-			&data.factionIndex,
-			&data.playerIndex,
-			data.text.getBuffer());
-
-	}
-
-	unsigned char * NetworkMessageMarkCell::packMessage() {
-		unsigned char *buf = new unsigned char[getPackedSize() + 1];
-		pack(buf, getPackedMessageFormat(),
-			messageType,
-			data.targetX,
-			data.targetY,
-			data.factionIndex,
-			data.playerIndex,
-			data.text.getBuffer());
-
-		return buf;
+	template <typename Archive>
+	void NetworkMessageMarkCell::serialize(Archive &archive) {
+		archive.field(messageType);
+		archive.field(data.targetX);
+		archive.field(data.targetY);
+		archive.field(data.factionIndex);
+		archive.field(data.playerIndex);
+		archive.field(data.text);
 	}
 
 	bool NetworkMessageMarkCell::receive(Socket* socket) {
@@ -3360,14 +2554,10 @@ namespace Game {
 			if (result == true) {
 				messageType = nmtMarkCell;
 			}
+			fromEndian();
 		} else {
-			unsigned char *buf = new unsigned char[getPackedSize() + 1];
-			result = NetworkMessage::receive(socket, buf, getPackedSize(), true);
-			unpackMessage(buf);
-			//printf("Got packet size = %u data.messageType = %d\n%s\n",getPackedSize(),data.messageType,buf);
-			delete[] buf;
+			result = receivePacked(socket, *this);
 		}
-		fromEndian();
 
 		data.text.nullTerminate();
 		return result;
@@ -3377,16 +2567,13 @@ namespace Game {
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] nmtMarkCell\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
 
 		assert(messageType == nmtMarkCell);
-		toEndian();
 
 		if (useOldProtocol == true) {
+			toEndian();
 			//NetworkMessage::send(socket, &messageType, sizeof(messageType));
 			NetworkMessage::send(socket, &data, sizeof(data), messageType);
 		} else {
-			unsigned char *buf = packMessage();
-			//printf("Send packet size = %u data.messageType = %d\n[%s]\n",getPackedSize(),data.messageType,buf);
-			NetworkMessage::send(socket, buf, getPackedSize());
-			delete[] buf;
+			sendPacked(socket, *this);
 		}
 	}
 
@@ -3435,46 +2622,12 @@ namespace Game {
 		return copy;
 	}
 
-	const char * NetworkMessageUnMarkCell::getPackedMessageFormat() const {
-		return "chhc";
-	}
-
-	unsigned int NetworkMessageUnMarkCell::getPackedSize() {
-		static unsigned int result = 0;
-		if (result == 0) {
-			Data packedData;
-			packedData.factionIndex = 0;
-			messageType = 0;
-			packedData.targetX = 0;
-			packedData.targetY = 0;
-			unsigned char *buf = new unsigned char[sizeof(packedData) * 3];
-			result = pack(buf, getPackedMessageFormat(),
-				messageType,
-				packedData.targetX,
-				packedData.targetY,
-				packedData.factionIndex);
-			delete[] buf;
-		}
-		return result;
-	}
-	void NetworkMessageUnMarkCell::unpackMessage(unsigned char *buf) {
-		unpack(buf, getPackedMessageFormat(),
-			&messageType,
-			&data.targetX,
-			&data.targetY,
-			&data.factionIndex);
-
-	}
-
-	unsigned char * NetworkMessageUnMarkCell::packMessage() {
-		unsigned char *buf = new unsigned char[getPackedSize() + 1];
-		pack(buf, getPackedMessageFormat(),
-			messageType,
-			data.targetX,
-			data.targetY,
-			data.factionIndex);
-
-		return buf;
+	template <typename Archive>
+	void NetworkMessageUnMarkCell::serialize(Archive &archive) {
+		archive.field(messageType);
+		archive.field(data.targetX);
+		archive.field(data.targetY);
+		archive.field(data.factionIndex);
 	}
 
 	bool NetworkMessageUnMarkCell::receive(Socket* socket) {
@@ -3484,14 +2637,10 @@ namespace Game {
 			if (result == true) {
 				messageType = nmtUnMarkCell;
 			}
+			fromEndian();
 		} else {
-			unsigned char *buf = new unsigned char[getPackedSize() + 1];
-			result = NetworkMessage::receive(socket, buf, getPackedSize(), true);
-			unpackMessage(buf);
-			//printf("Got packet size = %u data.messageType = %d\n%s\n",getPackedSize(),data.messageType,buf);
-			delete[] buf;
+			result = receivePacked(socket, *this);
 		}
-		fromEndian();
 
 		return result;
 	}
@@ -3500,16 +2649,13 @@ namespace Game {
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] nmtUnMarkCell\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
 
 		assert(messageType == nmtUnMarkCell);
-		toEndian();
 
 		if (useOldProtocol == true) {
+			toEndian();
 			//NetworkMessage::send(socket, &messageType, sizeof(messageType));
 			NetworkMessage::send(socket, &data, sizeof(data), messageType);
 		} else {
-			unsigned char *buf = packMessage();
-			//printf("Send packet size = %u data.messageType = %d\n[%s]\n",getPackedSize(),data.messageType,buf);
-			NetworkMessage::send(socket, buf, getPackedSize());
-			delete[] buf;
+			sendPacked(socket, *this);
 		}
 	}
 
@@ -3550,46 +2696,12 @@ namespace Game {
 		data.factionIndex = factionIndex;
 	}
 
-	const char * NetworkMessageHighlightCell::getPackedMessageFormat() const {
-		return "chhc";
-	}
-
-	unsigned int NetworkMessageHighlightCell::getPackedSize() {
-		static unsigned int result = 0;
-		if (result == 0) {
-			Data packedData;
-			packedData.factionIndex = 0;
-			messageType = 0;
-			packedData.targetX = 0;
-			packedData.targetY = 0;
-			unsigned char *buf = new unsigned char[sizeof(packedData) * 3];
-			result = pack(buf, getPackedMessageFormat(),
-				messageType,
-				packedData.targetX,
-				packedData.targetY,
-				packedData.factionIndex);
-			delete[] buf;
-		}
-		return result;
-	}
-	void NetworkMessageHighlightCell::unpackMessage(unsigned char *buf) {
-		unpack(buf, getPackedMessageFormat(),
-			&messageType,
-			&data.targetX,
-			&data.targetY,
-			&data.factionIndex);
-
-	}
-
-	unsigned char * NetworkMessageHighlightCell::packMessage() {
-		unsigned char *buf = new unsigned char[getPackedSize() + 1];
-		pack(buf, getPackedMessageFormat(),
-			messageType,
-			data.targetX,
-			data.targetY,
-			data.factionIndex);
-
-		return buf;
+	template <typename Archive>
+	void NetworkMessageHighlightCell::serialize(Archive &archive) {
+		archive.field(messageType);
+		archive.field(data.targetX);
+		archive.field(data.targetY);
+		archive.field(data.factionIndex);
 	}
 
 	bool NetworkMessageHighlightCell::receive(Socket* socket) {
@@ -3599,14 +2711,10 @@ namespace Game {
 			if (result == true) {
 				messageType = nmtHighlightCell;
 			}
+			fromEndian();
 		} else {
-			unsigned char *buf = new unsigned char[getPackedSize() + 1];
-			result = NetworkMessage::receive(socket, buf, getPackedSize(), true);
-			unpackMessage(buf);
-			//printf("Got packet size = %u data.messageType = %d\n%s\n",getPackedSize(),data.messageType,buf);
-			delete[] buf;
+			result = receivePacked(socket, *this);
 		}
-		fromEndian();
 		return result;
 	}
 
@@ -3614,16 +2722,13 @@ namespace Game {
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] nmtMarkCell\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
 
 		assert(messageType == nmtHighlightCell);
-		toEndian();
 
 		if (useOldProtocol == true) {
+			toEndian();
 			//NetworkMessage::send(socket, &messageType, sizeof(messageType));
 			NetworkMessage::send(socket, &data, sizeof(data), messageType);
 		} else {
-			unsigned char *buf = packMessage();
-			//printf("Send packet size = %u data.messageType = %d\n[%s]\n",getPackedSize(),data.messageType,buf);
-			NetworkMessage::send(socket, buf, getPackedSize());
-			delete[] buf;
+			sendPacked(socket, *this);
 		}
 	}
 
@@ -3646,4 +2751,66 @@ namespace Game {
 		}
 	}
 
+	// =====================================================
+	//	class NetworkMessageGameSnapshotChunk
+	// =====================================================
+
+	NetworkMessageGameSnapshotChunk::NetworkMessageGameSnapshotChunk() {
+		snapshotSize = 0;
+		uncompressedSize = 0;
+		offset = 0;
+	}
+
+	NetworkMessageGameSnapshotChunk::NetworkMessageGameSnapshotChunk(uint32 snapshotSize,
+		uint32 uncompressedSize, uint32 offset, const char *data, uint32 dataSize) {
+		this->snapshotSize = snapshotSize;
+		this->uncompressedSize = uncompressedSize;
+		this->offset = offset;
+		this->chunk.assign(data, data + dataSize);
+	}
+
+	bool NetworkMessageGameSnapshotChunk::receive(Socket* socket) {
+		unsigned char header[sizeof(uint32) * 4];
+		if (NetworkMessage::receive(socket, header, sizeof(header), true) == false) {
+			return false;
+		}
+
+		uint32 values[4] = { 0, 0, 0, 0 };
+		for (int valueIndex = 0; valueIndex < 4; ++valueIndex) {
+			for (int byteIndex = 0; byteIndex < 4; ++byteIndex) {
+				values[valueIndex] |= static_cast<uint32>(header[valueIndex * 4 + byteIndex]) << (byteIndex * 8);
+			}
+		}
+		snapshotSize = values[0];
+		uncompressedSize = values[1];
+		offset = values[2];
+		uint32 chunkSize = values[3];
+
+		if (snapshotSize == 0 || snapshotSize > (uint32) maxGameSnapshotSize ||
+			uncompressedSize == 0 || uncompressedSize > (uint32) maxGameSnapshotSize ||
+			chunkSize == 0 || chunkSize > (uint32) maxGameSnapshotChunkSize ||
+			offset > snapshotSize || chunkSize > snapshotSize - offset) {
+			throw game_runtime_error("Error receiving NetworkMessageGameSnapshotChunk, snapshotSize = " + uIntToStr(snapshotSize) + ", offset = " + uIntToStr(offset) + ", chunkSize = " + uIntToStr(chunkSize));
+		}
+
+		chunk.resize(chunkSize);
+		return NetworkMessage::receive(socket, &chunk[0], chunkSize, true);
+	}
+
+	void NetworkMessageGameSnapshotChunk::send(Socket* socket) {
+		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] nmtGameSnapshotChunk offset = %u, size = %u of %u\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, offset, (uint32) chunk.size(), snapshotSize);
+
+		const uint32 values[4] = { snapshotSize, uncompressedSize, offset, (uint32) chunk.size() };
+		std::vector<char> body(sizeof(values) + chunk.size());
+		for (int valueIndex = 0; valueIndex < 4; ++valueIndex) {
+			for (int byteIndex = 0; byteIndex < 4; ++byteIndex) {
+				body[valueIndex * 4 + byteIndex] = static_cast<char>((values[valueIndex] >> (byteIndex * 8)) & 0xFF);
+			}
+		}
+		if (chunk.empty() == false) {
+			memcpy(&body[sizeof(values)], &chunk[0], chunk.size());
+		}
+		NetworkMessage::send(socket, &body[0], (int) body.size(), (int8) nmtGameSnapshotChunk);
+	}
+
 } //end namespace
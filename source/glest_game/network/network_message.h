@@ -23,6 +23,7 @@
 #include "socket.h"
 #include "game_constants.h"
 #include "network_types.h"
+#include "network_protocol.h"
 #include "byte_order.h"
 #include <map>
 #include "common_scoped_ptr.h"
@@ -36,9 +37,11 @@ using Shared::Platform::int16;
 namespace Game {
 	class GameSettings;
 
+	// nmtIntro moved to a new id when it gained the protocol feature bits,
+	// older peers fail on the unknown id instead of misreading the intro
 	enum NetworkMessageType {
 		nmtInvalid,
-		nmtIntro,
+		nmtIntroLegacy,
 		nmtPing,
 		nmtReady,
 		nmtLaunch,
@@ -56,7 +59,10 @@ namespace Game {
 		nmtMarkCell,
 		nmtUnMarkCell,
 		nmtHighlightCell,
-		//	nmtCompressedPacket,
+		nmtCommandListCompact,
+		nmtCompressedPacket,
+		nmtGameSnapshotChunk,
+		nmtIntro,
 
 		nmtCount
 	};
@@ -69,9 +75,33 @@ namespace Game {
 		nmgstCount
 	};
 
+	// Optional wire features offered in NetworkMessageIntro, a sender only
+	// uses a feature the other side has offered as well
+	enum NetworkProtocolFeatureType {
+		npfNone = 0x00,
+		npfCompactCommandList = 0x01,
+		npfCompression = 0x02,
+		npfAdaptiveFramePeriod = 0x04,
+		npfStreamedJoinSnapshot = 0x08,
+		npfContentTransfer = 0x10
+	};
+
 	static const int maxLanguageStringSize = 60;
 	static const int maxNetworkMessageSize = 20000;
 
+	// Messages at least this large are sent inside a nmtCompressedPacket
+	// envelope when npfCompression was negotiated
+	static const int minCompressedPacketSize = 512;
+	static const int maxCompressedPacketSize = 16 * 1024 * 1024;
+
+	// Pings with this frequency are round trip probes sent by the server
+	// in game, clients echo them back unchanged
+	static const int32 networkPingProbeFrequency = -1;
+
+	// A join in progress snapshot is sent in chunks of at most this size
+	static const int maxGameSnapshotChunkSize = 16 * 1024;
+	static const int maxGameSnapshotSize = 256 * 1024 * 1024;
+
 	// =====================================================
 	//	class NetworkMessage
 	// =====================================================
@@ -116,6 +146,14 @@ namespace Game {
 		static string getNetworkPacketStats();
 
 		static bool useOldProtocol;
+		NetworkMessage() {
+			protocolFeatures = npfNone;
+			captureSharedSend = false;
+			capturingSharedSend = false;
+			sharedSendProtocolFeatures = npfNone;
+			serializeBufferList = NULL;
+			sendQueueBufferList = NULL;
+		}
 		virtual ~NetworkMessage() {
 		}
 		virtual bool receive(Socket* socket) = 0;
@@ -131,19 +169,80 @@ namespace Game {
 
 		virtual NetworkMessageType getNetworkMessageType() const = 0;
 
+		// Features negotiated with the peer this message is sent to or read from
+		uint32 getProtocolFeatures() const {
+			return protocolFeatures;
+		}
+		void setProtocolFeatures(uint32 value) {
+			protocolFeatures = value;
+		}
+
 		void dump_packet(string label, const void* data, int dataSize, bool isSend);
 
+		// Between beginSharedSend and endSharedSend the bytes produced by the
+		// first send() are kept so the same message can be sent to other
+		// sockets (broadcasts) without serializing it again
+		void beginSharedSend();
+		void endSharedSend();
+		bool sendShared(Socket* socket);
+
+		// send() wrapped in the envelopes allowed by the negotiated features
+		void sendNegotiated(Socket* socket);
+		// While set, finished wire buffers are appended to the list for the
+		// caller to write later instead of being sent to the socket
+		void setSendQueue(vector<SocketSendBuffer> *bufferList) {
+			sendQueueBufferList = bufferList;
+		}
+		// Reads a nmtCompressedPacket envelope (type byte already consumed),
+		// queues the inflated message on the socket and returns its type
+		static NetworkMessageType receiveCompressedPacket(Socket* socket);
+
 	protected:
+		uint32 protocolFeatures;
+
+		bool captureSharedSend;
+		bool capturingSharedSend;
+		uint32 sharedSendProtocolFeatures;
+		vector<SocketSendBuffer> sharedSendBufferList;
+
+		// When set sendBuffer collects output here instead of writing it
+		vector<SocketSendBuffer> *serializeBufferList;
+		vector<SocketSendBuffer> *sendQueueBufferList;
+
 		//bool peek(Socket* socket, void* data, int dataSize);
 		bool receive(Socket* socket, void* data, int dataSize, bool tryReceiveUntilDataSizeMet);
 		void send(Socket* socket, const void* data, int dataSize);
 		void send(Socket* socket, const void* data, int dataSize, int8 messageType);
 		void send(Socket* socket, const void* data, int dataSize, int8 messageType, uint32 compressedLength);
-
-		virtual const char * getPackedMessageFormat() const = 0;
-		virtual unsigned int getPackedSize() = 0;
-		virtual void unpackMessage(unsigned char *buf) = 0;
-		virtual unsigned char * packMessage() = 0;
+		void sendBuffer(Socket* socket, const SocketSendBuffer &buffer);
+		void checkSendResult(Socket* socket, int sendResult, int dataSize);
+
+		// Packs the fields listed by message.serialize() straight into the
+		// buffer handed to the socket
+		template <typename Message>
+		void sendPacked(Socket* socket, Message &message) {
+			NetworkPackedSize packedSize;
+			message.serialize(packedSize);
+
+			std::vector<char> *out_buffer = new std::vector<char>(packedSize.getSize());
+			NetworkPackWriter writer(reinterpret_cast<unsigned char *>(&(*out_buffer)[0]));
+			message.serialize(writer);
+			sendBuffer(socket, SocketSendBuffer(out_buffer));
+		}
+
+		template <typename Message>
+		bool receivePacked(Socket* socket, Message &message) {
+			NetworkPackedSize packedSize;
+			message.serialize(packedSize);
+
+			std::vector<unsigned char> buffer(packedSize.getSize());
+			if (receive(socket, &buffer[0], (int) buffer.size(), true) == false) {
+				return false;
+			}
+			NetworkPackReader reader(&buffer[0], (unsigned int) buffer.size());
+			message.serialize(reader);
+			return reader.isValid();
+		}
 	};
 
 	// =====================================================
@@ -174,6 +273,7 @@ namespace Game {
 			int8 gameInProgress;
 			NetworkString<maxSmallStringSize> playerUUID;
 			NetworkString<maxSmallStringSize> platform;
+			uint32 supportedProtocolFeatures;
 		};
 
 		void toEndian();
@@ -182,20 +282,17 @@ namespace Game {
 	private:
 		Data data;
 
-	protected:
-
 	public:
 		NetworkMessageIntro();
 		NetworkMessageIntro(int32 sessionId, const string &versionString,
 			const string &name, int playerIndex, NetworkGameStateType gameState,
 			uint32 externalIp, uint32 ftpPort, const string &playerLanguage,
-			int gameInProgress, const string &playerUUID, const string &platform);
+			int gameInProgress, const string &playerUUID, const string &platform,
+			uint32 supportedProtocolFeatures = npfNone);
 
 
-		virtual const char * getPackedMessageFormat() const;
-		virtual unsigned int getPackedSize();
-		virtual void unpackMessage(unsigned char *buf);
-		virtual unsigned char * packMessage();
+		// Field layout of the packed (non legacy) protocol
+		template <typename Archive> void serialize(Archive &archive);
 
 		virtual size_t getDataSize() const {
 			return sizeof(Data);
@@ -239,6 +336,9 @@ namespace Game {
 		string getPlayerPlatform() const {
 			return data.platform.getString();
 		}
+		uint32 getSupportedProtocolFeatures() const {
+			return data.supportedProtocolFeatures;
+		}
 
 		virtual bool receive(Socket* socket);
 		virtual void send(Socket* socket);
@@ -268,13 +368,10 @@ namespace Game {
 		Data data;
 		int64 pingReceivedLocalTime;
 
-	protected:
-		virtual const char * getPackedMessageFormat() const;
-		virtual unsigned int getPackedSize();
-		virtual void unpackMessage(unsigned char *buf);
-		virtual unsigned char * packMessage();
-
 	public:
+		// Field layout of the packed (non legacy) protocol
+		template <typename Archive> void serialize(Archive &archive);
+
 		NetworkMessagePing();
 		NetworkMessagePing(int32 pingFrequency, int64 pingTime);
 
@@ -323,13 +420,10 @@ namespace Game {
 	private:
 		Data data;
 
-	protected:
-		virtual const char * getPackedMessageFormat() const;
-		virtual unsigned int getPackedSize();
-		virtual void unpackMessage(unsigned char *buf);
-		virtual unsigned char * packMessage();
-
 	public:
+		// Field layout of the packed (non legacy) protocol
+		template <typename Archive> void serialize(Archive &archive);
+
 		NetworkMessageReady();
 		explicit NetworkMessageReady(uint32 checksum);
 
@@ -424,13 +518,10 @@ namespace Game {
 	private:
 		Data data;
 
-	protected:
-		virtual const char * getPackedMessageFormat() const;
-		virtual unsigned int getPackedSize();
-		virtual void unpackMessage(unsigned char *buf);
-		virtual unsigned char * packMessage();
-
 	public:
+		// Field layout of the packed (non legacy) protocol
+		template <typename Archive> void serialize(Archive &archive);
+
 		NetworkMessageLaunch();
 		NetworkMessageLaunch(const GameSettings *gameSettings, int8 messageType);
 
@@ -506,33 +597,24 @@ namespace Game {
 
 	private:
 		Data data;
+		// Period announced by the server to use after this frame, 0 means
+		// unchanged. Only carried by the compact encoding.
+		int32 networkFramePeriod;
 
 	protected:
-		virtual const char * getPackedMessageFormat() const {
-			return NULL;
-		}
-		virtual unsigned int getPackedSize() {
-			return 0;
-		}
-		virtual void unpackMessage(unsigned char *buf) {
-		};
-		virtual unsigned char * packMessage() {
-			return NULL;
-		}
-
-		const char * getPackedMessageFormatHeader() const;
-		unsigned int getPackedSizeHeader();
-		void unpackMessageHeader(unsigned char *buf);
-		unsigned char * packMessageHeader();
-
-		const char * getPackedMessageFormatDetail() const;
-		unsigned int getPackedSizeDetail(int count);
-		void unpackMessageDetail(unsigned char *buf, int count);
-		unsigned char * packMessageDetail(uint16 totalCommand);
+		// nmtCommandListCompact: length prefixed body of zigzag varints with
+		// each command delta coded against the previous one and faction CRCs
+		// only for players flagged in a bitmask
+		bool receiveCompact(Socket* socket);
+		void sendCompact(Socket* socket);
 
 	public:
 		explicit NetworkMessageCommandList(int32 frameCount = -1);
 
+		// Field layout of the packed header, the commands follow it in the
+		// layout of NetworkCommand::serialize()
+		template <typename Archive> void serialize(Archive &archive);
+
 		virtual size_t getDataSize() const {
 			return sizeof(Data);
 		}
@@ -556,6 +638,12 @@ namespace Game {
 		uint32 getNetworkPlayerFactionCRC(int index) const {
 			return data.header.networkPlayerFactionCRC[index];
 		}
+		int32 getNetworkFramePeriod() const {
+			return networkFramePeriod;
+		}
+		void setNetworkFramePeriod(int32 value) {
+			networkFramePeriod = value;
+		}
 		void setNetworkPlayerFactionCRC(int index, uint32 crc) {
 			data.header.networkPlayerFactionCRC[index] = crc;
 		}
@@ -565,6 +653,7 @@ namespace Game {
 		}
 
 		virtual bool receive(Socket* socket);
+		virtual bool receive(Socket* socket, NetworkMessageType type);
 		virtual void send(Socket* socket);
 	};
 #pragma pack(pop)
@@ -595,13 +684,10 @@ namespace Game {
 	private:
 		Data data;
 
-	protected:
-		virtual const char * getPackedMessageFormat() const;
-		virtual unsigned int getPackedSize();
-		virtual void unpackMessage(unsigned char *buf);
-		virtual unsigned char * packMessage();
-
 	public:
+		// Field layout of the packed (non legacy) protocol
+		template <typename Archive> void serialize(Archive &archive);
+
 		NetworkMessageText();
 		NetworkMessageText(const string &text, int teamIndex, int playerIndex,
 			const string targetLanguage);
@@ -653,13 +739,10 @@ namespace Game {
 	private:
 		//Data data;
 
-	protected:
-		virtual const char * getPackedMessageFormat() const;
-		virtual unsigned int getPackedSize();
-		virtual void unpackMessage(unsigned char *buf);
-		virtual unsigned char * packMessage();
-
 	public:
+		// Field layout of the packed (non legacy) protocol
+		template <typename Archive> void serialize(Archive &archive);
+
 		NetworkMessageQuit();
 
 		//virtual size_t getDataSize() const { return sizeof(Data); }
@@ -728,28 +811,6 @@ namespace Game {
 	private:
 		Data data;
 
-	protected:
-		virtual const char * getPackedMessageFormat() const {
-			return NULL;
-		}
-		virtual unsigned int getPackedSize() {
-			return 0;
-		}
-		virtual void unpackMessage(unsigned char *buf) {
-		};
-		virtual unsigned char * packMessage() {
-			return NULL;
-		}
-
-		const char * getPackedMessageFormatHeader() const;
-		unsigned int getPackedSizeHeader();
-		void unpackMessageHeader(unsigned char *buf);
-		unsigned char * packMessageHeader();
-
-		unsigned int getPackedSizeDetail();
-		void unpackMessageDetail(unsigned char *buf);
-		unsigned char * packMessageDetail();
-
 	public:
 		NetworkMessageSynchNetworkGameData() {
 		};
@@ -847,19 +908,6 @@ namespace Game {
 	private:
 		Data data;
 
-	protected:
-		virtual const char * getPackedMessageFormat() const {
-			return NULL;
-		}
-		virtual unsigned int getPackedSize() {
-			return 0;
-		}
-		virtual void unpackMessage(unsigned char *buf) {
-		};
-		virtual unsigned char * packMessage() {
-			return NULL;
-		}
-
 	public:
 		NetworkMessageSynchNetworkGameDataStatus() {
 		};
@@ -930,13 +978,10 @@ namespace Game {
 	private:
 		Data data;
 
-	protected:
-		virtual const char * getPackedMessageFormat() const;
-		virtual unsigned int getPackedSize();
-		virtual void unpackMessage(unsigned char *buf);
-		virtual unsigned char * packMessage();
-
 	public:
+		// Field layout of the packed (non legacy) protocol
+		template <typename Archive> void serialize(Archive &archive);
+
 		NetworkMessageSynchNetworkGameDataFileCRCCheck();
 		NetworkMessageSynchNetworkGameDataFileCRCCheck(uint32 totalFileCount, uint32 fileIndex, uint32 fileCRC, const string fileName);
 
@@ -992,13 +1037,10 @@ namespace Game {
 	private:
 		Data data;
 
-	protected:
-		virtual const char * getPackedMessageFormat() const;
-		virtual unsigned int getPackedSize();
-		virtual void unpackMessage(unsigned char *buf);
-		virtual unsigned char * packMessage();
-
 	public:
+		// Field layout of the packed (non legacy) protocol
+		template <typename Archive> void serialize(Archive &archive);
+
 		NetworkMessageSynchNetworkGameDataFileGet();
 		explicit NetworkMessageSynchNetworkGameDataFileGet(const string fileName);
 
@@ -1064,12 +1106,9 @@ namespace Game {
 		Data data;
 
 	public:
-		virtual const char * getPackedMessageFormat() const;
-		virtual unsigned int getPackedSize();
-		virtual void unpackMessage(unsigned char *buf);
-		virtual unsigned char * packMessage();
+		// Field layout of the packed (non legacy) protocol
+		template <typename Archive> void serialize(Archive &archive);
 
-	public:
 		SwitchSetupRequest();
 		SwitchSetupRequest(string selectedFactionName, int8 currentFactionIndex,
 			int8 toFactionIndex, int8 toTeam, string networkPlayerName,
@@ -1144,13 +1183,10 @@ namespace Game {
 	private:
 		Data data;
 
-	protected:
-		virtual const char * getPackedMessageFormat() const;
-		virtual unsigned int getPackedSize();
-		virtual void unpackMessage(unsigned char *buf);
-		virtual unsigned char * packMessage();
-
 	public:
+		// Field layout of the packed (non legacy) protocol
+		template <typename Archive> void serialize(Archive &archive);
+
 		explicit PlayerIndexMessage(int16 playerIndex);
 
 		virtual size_t getDataSize() const {
@@ -1217,13 +1253,10 @@ namespace Game {
 	private:
 		Data data;
 
-	protected:
-		virtual const char * getPackedMessageFormat() const;
-		virtual unsigned int getPackedSize();
-		virtual void unpackMessage(unsigned char *buf);
-		virtual unsigned char * packMessage();
-
 	public:
+		// Field layout of the packed (non legacy) protocol
+		template <typename Archive> void serialize(Archive &archive);
+
 		NetworkMessageLoadingStatus();
 		explicit NetworkMessageLoadingStatus(uint32 status);
 
@@ -1274,13 +1307,10 @@ namespace Game {
 	private:
 		Data data;
 
-	protected:
-		virtual const char * getPackedMessageFormat() const;
-		virtual unsigned int getPackedSize();
-		virtual void unpackMessage(unsigned char *buf);
-		virtual unsigned char * packMessage();
-
 	public:
+		// Field layout of the packed (non legacy) protocol
+		template <typename Archive> void serialize(Archive &archive);
+
 		NetworkMessageMarkCell();
 		NetworkMessageMarkCell(Vec2i target, int factionIndex, const string &text, int playerIndex);
 
@@ -1336,13 +1366,10 @@ namespace Game {
 	private:
 		Data data;
 
-	protected:
-		virtual const char * getPackedMessageFormat() const;
-		virtual unsigned int getPackedSize();
-		virtual void unpackMessage(unsigned char *buf);
-		virtual unsigned char * packMessage();
-
 	public:
+		// Field layout of the packed (non legacy) protocol
+		template <typename Archive> void serialize(Archive &archive);
+
 		NetworkMessageUnMarkCell();
 		NetworkMessageUnMarkCell(Vec2i target, int factionIndex);
 
@@ -1394,13 +1421,10 @@ namespace Game {
 	private:
 		Data data;
 
-	protected:
-		virtual const char * getPackedMessageFormat() const;
-		virtual unsigned int getPackedSize();
-		virtual void unpackMessage(unsigned char *buf);
-		virtual unsigned char * packMessage();
-
 	public:
+		// Field layout of the packed (non legacy) protocol
+		template <typename Archive> void serialize(Archive &archive);
+
 		NetworkMessageHighlightCell();
 		NetworkMessageHighlightCell(Vec2i target, int factionIndex);
 
@@ -1424,6 +1448,51 @@ namespace Game {
 	};
 #pragma pack(pop)
 
+	// =====================================================
+	//	class NetworkMessageGameSnapshotChunk
+	//
+	//	Part of the deflated game snapshot streamed by the
+	//	server to a client joining a game in progress
+	// =====================================================
+
+	class NetworkMessageGameSnapshotChunk : public NetworkMessage {
+	private:
+		uint32 snapshotSize;
+		uint32 uncompressedSize;
+		uint32 offset;
+		std::vector<char> chunk;
+
+	public:
+		NetworkMessageGameSnapshotChunk();
+		NetworkMessageGameSnapshotChunk(uint32 snapshotSize, uint32 uncompressedSize,
+			uint32 offset, const char *data, uint32 dataSize);
+
+		virtual size_t getDataSize() const {
+			return sizeof(uint32) * 4 + chunk.size();
+		}
+
+		virtual NetworkMessageType getNetworkMessageType() const {
+			return nmtGameSnapshotChunk;
+		}
+
+		// Size of the whole deflated snapshot
+		uint32 getSnapshotSize() const {
+			return snapshotSize;
+		}
+		uint32 getUncompressedSize() const {
+			return uncompressedSize;
+		}
+		uint32 getOffset() const {
+			return offset;
+		}
+		const std::vector<char> &getChunk() const {
+			return chunk;
+		}
+
+		virtual bool receive(Socket* socket);
+		virtual void send(Socket* socket);
+	};
+
 } //end namespace
 
 #endif
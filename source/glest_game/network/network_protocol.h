@@ -20,9 +20,169 @@
 #ifndef NETWORK_PROTOCOL_H_
 #define NETWORK_PROTOCOL_H_
 
+#include "data_types.h"
+#include "network_types.h"
+#include <cstring>
+
+using Shared::Platform::int8;
+using Shared::Platform::uint8;
+using Shared::Platform::int16;
+using Shared::Platform::uint16;
+using Shared::Platform::int32;
+using Shared::Platform::uint32;
+using Shared::Platform::int64;
+using Shared::Platform::uint64;
+
 namespace Game {
-	unsigned int pack(unsigned char *buf, const char *format, ...);
-	unsigned int unpack(unsigned char *buf, const char *format, ...);
-};
+
+	// =====================================================
+	//	Packed message archives
+	//
+	//	A message lists its wire fields once in a member
+	//	template serialize(Archive &archive) calling field()
+	//	for each value in order. Running it through the three
+	//	archives below yields the packed size, the writer and
+	//	the reader, so they can never disagree.
+	//
+	//	Integers are written big endian whatever the host byte
+	//	order with the width of their C++ type. NetworkString<S>
+	//	is a 16 bit length, always S - 1, followed by S - 1 bytes
+	// =====================================================
+
+	class NetworkPackedSize {
+	private:
+		unsigned int size;
+
+	public:
+		NetworkPackedSize() {
+			size = 0;
+		}
+		unsigned int getSize() const {
+			return size;
+		}
+
+		void field(int8) { size += 1; }
+		void field(uint8) { size += 1; }
+		void field(int16) { size += 2; }
+		void field(uint16) { size += 2; }
+		void field(int32) { size += 4; }
+		void field(uint32) { size += 4; }
+		void field(int64) { size += 8; }
+		void field(uint64) { size += 8; }
+		template<int S> void field(const NetworkString<S> &) {
+			size += sizeof(uint16) + (S - 1);
+		}
+		template<typename T> void fieldArray(const T *values, int count) {
+			for (int index = 0; index < count; ++index) {
+				field(values[index]);
+			}
+		}
+	};
+
+	class NetworkPackWriter {
+	private:
+		unsigned char *buffer;
+
+		template<typename T> void writeInteger(T value) {
+			for (int shift = (int) (sizeof(T) - 1) * 8; shift >= 0; shift -= 8) {
+				*buffer++ = static_cast<unsigned char>(static_cast<uint64>(value) >> shift);
+			}
+		}
+
+	public:
+		explicit NetworkPackWriter(unsigned char *buffer) {
+			this->buffer = buffer;
+		}
+
+		void field(int8 value) { writeInteger(value); }
+		void field(uint8 value) { writeInteger(value); }
+		void field(int16 value) { writeInteger(value); }
+		void field(uint16 value) { writeInteger(value); }
+		void field(int32 value) { writeInteger(value); }
+		void field(uint32 value) { writeInteger(value); }
+		void field(int64 value) { writeInteger(value); }
+		void field(uint64 value) { writeInteger(value); }
+		template<int S> void field(NetworkString<S> &value) {
+			writeInteger(static_cast<uint16>(S - 1));
+			memcpy(buffer, value.getBuffer(), S - 1);
+			buffer += S - 1;
+		}
+		template<typename T> void fieldArray(T *values, int count) {
+			for (int index = 0; index < count; ++index) {
+				field(values[index]);
+			}
+		}
+	};
+
+	class NetworkPackReader {
+	private:
+		const unsigned char *buffer;
+		const unsigned char *bufferEnd;
+		bool valid;
+
+		bool take(unsigned int size) {
+			if (valid == false || (unsigned int) (bufferEnd - buffer) < size) {
+				valid = false;
+				return false;
+			}
+			return true;
+		}
+		template<typename T> void readInteger(T &value) {
+			if (take(sizeof(T)) == false) {
+				return;
+			}
+			uint64 result = 0;
+			for (unsigned int index = 0; index < sizeof(T); ++index) {
+				result = (result << 8) | *buffer++;
+			}
+			value = static_cast<T>(result);
+		}
+
+	public:
+		NetworkPackReader(const unsigned char *buffer, unsigned int size) {
+			this->buffer = buffer;
+			this->bufferEnd = buffer + size;
+			this->valid = true;
+		}
+		// False once a field ran past the end of the buffer
+		bool isValid() const {
+			return valid;
+		}
+
+		void field(int8 &value) { readInteger(value); }
+		void field(uint8 &value) { readInteger(value); }
+		void field(int16 &value) { readInteger(value); }
+		void field(uint16 &value) { readInteger(value); }
+		void field(int32 &value) { readInteger(value); }
+		void field(uint32 &value) { readInteger(value); }
+		void field(int64 &value) { readInteger(value); }
+		void field(uint64 &value) { readInteger(value); }
+		template<int S> void field(NetworkString<S> &value) {
+			uint16 length = 0;
+			readInteger(length);
+			if (take(length) == false) {
+				return;
+			}
+			unsigned int count = (length < S - 1 ? length : S - 1);
+			memcpy(value.getBuffer(), buffer, count);
+			value.getBuffer()[count] = '\0';
+			buffer += length;
+		}
+		template<typename T> void fieldArray(T *values, int count) {
+			for (int index = 0; index < count; ++index) {
+				field(values[index]);
+			}
+		}
+	};
+
+	// Nested structures (e.g. NetworkCommand) provide their own serialize()
+	template<typename Archive, typename T>
+	void serializeObjects(Archive &archive, T *values, int count) {
+		for (int index = 0; index < count; ++index) {
+			values[index].serialize(archive);
+		}
+	}
+
+} //end namespace
 
 #endif /* NETWORK_PROTOCOL_H_ */
@@ -0,0 +1,541 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+#include "network_telemetry.h"
+
+#include "conversion.h"
+#include "platform_common.h"
+#include "util.h"
+#include <stdio.h>
+
+#include "leak_dumper.h"
+
+using namespace Shared::Platform;
+using namespace Shared::Util;
+using namespace Shared::PlatformCommon;
+
+namespace Game {
+
+	static const int64 ROUND_TRIP_BOUNDS_MILLIS[] = { 10, 25, 50, 100, 200, 400, 800, 1600 };
+	static const int64 UPDATE_BOUNDS_MICROS[] = { 100, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000 };
+
+	static string escapeJson(const string &value) {
+		string result;
+		for (unsigned int index = 0; index < value.size(); ++index) {
+			unsigned char c = value[index];
+			if (c == '"' || c == '\\') {
+				result += '\\';
+				result += c;
+			} else if (c < 0x20) {
+				char szBuf[8] = "";
+				snprintf(szBuf, 8, "\\u%04x", c);
+				result += szBuf;
+			} else {
+				result += c;
+			}
+		}
+		return result;
+	}
+
+	static string escapeCsv(const string &value) {
+		string result = value;
+		replaceAll(result, "\"", "\"\"");
+		return "\"" + result + "\"";
+	}
+
+	// =====================================================
+	//	class NetworkTelemetryHistogram
+	// =====================================================
+
+	NetworkTelemetryHistogram::NetworkTelemetryHistogram() {
+		reset();
+	}
+
+	NetworkTelemetryHistogram::NetworkTelemetryHistogram(const int64 *upperBounds, int boundCount) {
+		this->upperBounds.assign(upperBounds, upperBounds + boundCount);
+		reset();
+	}
+
+	void NetworkTelemetryHistogram::reset() {
+		bucketCounts.assign(upperBounds.size() + 1, 0);
+		count = 0;
+		sum = 0;
+		maxValue = 0;
+	}
+
+	void NetworkTelemetryHistogram::add(int64 value) {
+		unsigned int bucket = 0;
+		for (; bucket < upperBounds.size() && value > upperBounds[bucket]; ++bucket) {
+		}
+		bucketCounts[bucket]++;
+		count++;
+		sum += value;
+		maxValue = max(maxValue, value);
+	}
+
+	int64 NetworkTelemetryHistogram::getPercentile(double fraction) const {
+		int64 wanted = (int64) (count * fraction + 0.5);
+		int64 seen = 0;
+		for (unsigned int bucket = 0; bucket < bucketCounts.size(); ++bucket) {
+			seen += bucketCounts[bucket];
+			if (seen >= wanted && seen > 0) {
+				return (bucket < upperBounds.size() ? upperBounds[bucket] : maxValue);
+			}
+		}
+		return 0;
+	}
+
+	string NetworkTelemetryHistogram::toJson() const {
+		string result = "{\"count\":" + intToStr(count) +
+			",\"mean\":" + intToStr(getMean()) +
+			",\"max\":" + intToStr(maxValue) +
+			",\"p50\":" + intToStr(getPercentile(0.5)) +
+			",\"p95\":" + intToStr(getPercentile(0.95)) +
+			",\"buckets\":[";
+		for (unsigned int bucket = 0; bucket < bucketCounts.size(); ++bucket) {
+			if (bucket > 0) {
+				result += ",";
+			}
+			result += "{\"le\":" + (bucket < upperBounds.size() ? intToStr(upperBounds[bucket]) : string("null")) +
+				",\"count\":" + intToStr(bucketCounts[bucket]) + "}";
+		}
+		result += "]}";
+		return result;
+	}
+
+	// =====================================================
+	//	class NetworkTelemetry
+	// =====================================================
+
+	bool NetworkTelemetry::enabled = false;
+	Mutex *NetworkTelemetry::mutexTelemetry = new Mutex(CODE_AT_LINE);
+	std::map<Socket *, int> NetworkTelemetry::socketSlotMap;
+	NetworkTelemetry::SlotTelemetry NetworkTelemetry::slotTelemetryList[GameConstants::maxPlayers];
+	NetworkTelemetryHistogram NetworkTelemetry::serverUpdateMicros(UPDATE_BOUNDS_MICROS, sizeof(UPDATE_BOUNDS_MICROS) / sizeof(int64));
+	time_t NetworkTelemetry::startTime = 0;
+
+	void NetworkTelemetry::setEnabled(bool value) {
+		MutexSafeWrapper safeMutex(mutexTelemetry, CODE_AT_LINE);
+		if (value == true && enabled == false) {
+			socketSlotMap.clear();
+			for (int index = 0; index < GameConstants::maxPlayers; ++index) {
+				resetSlot(index);
+				slotTelemetryList[index].connected = false;
+			}
+			serverUpdateMicros.reset();
+			startTime = time(NULL);
+		}
+		enabled = value;
+	}
+
+	void NetworkTelemetry::resetSlot(int slotIndex) {
+		SlotTelemetry &slot = slotTelemetryList[slotIndex];
+		slot.name = "";
+		slot.ipAddress = "";
+		slot.connectedTime = time(NULL);
+		memset(slot.messageCounters, 0, sizeof(slot.messageCounters));
+		slot.sendQueueBytes = 0;
+		slot.sendQueueBytesMax = 0;
+		slot.framesBehind = 0;
+		slot.framesBehindMax = 0;
+		slot.roundTripMillis = NetworkTelemetryHistogram(ROUND_TRIP_BOUNDS_MILLIS, sizeof(ROUND_TRIP_BOUNDS_MILLIS) / sizeof(int64));
+		slot.updateMicros = NetworkTelemetryHistogram(UPDATE_BOUNDS_MICROS, sizeof(UPDATE_BOUNDS_MICROS) / sizeof(int64));
+	}
+
+	int NetworkTelemetry::getSlotIndex(Socket *socket) {
+		std::map<Socket *, int>::iterator iterFind = socketSlotMap.find(socket);
+		return (iterFind != socketSlotMap.end() ? iterFind->second : -1);
+	}
+
+	const char * NetworkTelemetry::getMessageTypeName(NetworkMessageType type) {
+		switch (type) {
+			case nmtIntroLegacy: return "IntroLegacy";
+			case nmtIntro: return "Intro";
+			case nmtPing: return "Ping";
+			case nmtReady: return "Ready";
+			case nmtLaunch: return "Launch";
+			case nmtCommandList: return "CommandList";
+			case nmtText: return "Text";
+			case nmtQuit: return "Quit";
+			case nmtSynchNetworkGameData: return "SynchNetworkGameData";
+			case nmtSynchNetworkGameDataStatus: return "SynchNetworkGameDataStatus";
+			case nmtSynchNetworkGameDataFileCRCCheck: return "SynchNetworkGameDataFileCRCCheck";
+			case nmtSynchNetworkGameDataFileGet: return "SynchNetworkGameDataFileGet";
+			case nmtBroadCastSetup: return "BroadCastSetup";
+			case nmtSwitchSetupRequest: return "SwitchSetupRequest";
+			case nmtPlayerIndexMessage: return "PlayerIndexMessage";
+			case nmtLoadingStatusMessage: return "LoadingStatusMessage";
+			case nmtMarkCell: return "MarkCell";
+			case nmtUnMarkCell: return "UnMarkCell";
+			case nmtHighlightCell: return "HighlightCell";
+			case nmtCommandListCompact: return "CommandListCompact";
+			case nmtCompressedPacket: return "CompressedPacket";
+			case nmtGameSnapshotChunk: return "GameSnapshotChunk";
+			default: return "Invalid";
+		}
+	}
+
+	void NetworkTelemetry::updateSlot(int slotIndex, Socket *socket, const string &name,
+		const string &ipAddress, int framesBehind) {
+		if (enabled == false || slotIndex < 0 || slotIndex >= GameConstants::maxPlayers) {
+			return;
+		}
+
+		MutexSafeWrapper safeMutex(mutexTelemetry, CODE_AT_LINE);
+		SlotTelemetry &slot = slotTelemetryList[slotIndex];
+		if (socket == NULL) {
+			slot.connected = false;
+			return;
+		}
+
+		if (slot.connected == false || getSlotIndex(socket) != slotIndex) {
+			resetSlot(slotIndex);
+			socketSlotMap[socket] = slotIndex;
+		}
+		slot.connected = true;
+		slot.name = name;
+		slot.ipAddress = ipAddress;
+		slot.framesBehind = framesBehind;
+		slot.framesBehindMax = max(slot.framesBehindMax, framesBehind);
+	}
+
+	void NetworkTelemetry::removeSocket(Socket *socket) {
+		if (enabled == false) {
+			return;
+		}
+		MutexSafeWrapper safeMutex(mutexTelemetry, CODE_AT_LINE);
+		int slotIndex = getSlotIndex(socket);
+		if (slotIndex >= 0) {
+			slotTelemetryList[slotIndex].connected = false;
+			socketSlotMap.erase(socket);
+		}
+	}
+
+	void NetworkTelemetry::recordSend(Socket *socket, NetworkMessageType type, int bytes, bool isNewMessage) {
+		if (enabled == false || type < 0 || type >= nmtCount) {
+			return;
+		}
+		MutexSafeWrapper safeMutex(mutexTelemetry, CODE_AT_LINE);
+		int slotIndex = getSlotIndex(socket);
+		if (slotIndex >= 0) {
+			MessageCounters &counters = slotTelemetryList[slotIndex].messageCounters[type];
+			counters.sentCount += (isNewMessage == true ? 1 : 0);
+			counters.sentBytes += bytes;
+		}
+	}
+
+	void NetworkTelemetry::recordReceive(Socket *socket, NetworkMessageType type, int bytes, bool isNewMessage) {
+		if (enabled == false || type < 0 || type >= nmtCount) {
+			return;
+		}
+		MutexSafeWrapper safeMutex(mutexTelemetry, CODE_AT_LINE);
+		int slotIndex = getSlotIndex(socket);
+		if (slotIndex >= 0) {
+			MessageCounters &counters = slotTelemetryList[slotIndex].messageCounters[type];
+			counters.receivedCount += (isNewMessage == true ? 1 : 0);
+			counters.receivedBytes += bytes;
+		}
+	}
+
+	void NetworkTelemetry::recordSendQueue(int slotIndex, int bytes) {
+		if (enabled == false || slotIndex < 0 || slotIndex >= GameConstants::maxPlayers) {
+			return;
+		}
+		MutexSafeWrapper safeMutex(mutexTelemetry, CODE_AT_LINE);
+		SlotTelemetry &slot = slotTelemetryList[slotIndex];
+		slot.sendQueueBytes = max(0, bytes);
+		slot.sendQueueBytesMax = max(slot.sendQueueBytesMax, slot.sendQueueBytes);
+	}
+
+	void NetworkTelemetry::recordRoundTrip(int slotIndex, int64 roundTripMillis) {
+		if (enabled == false || slotIndex < 0 || slotIndex >= GameConstants::maxPlayers) {
+			return;
+		}
+		MutexSafeWrapper safeMutex(mutexTelemetry, CODE_AT_LINE);
+		slotTelemetryList[slotIndex].roundTripMillis.add(roundTripMillis);
+	}
+
+	void NetworkTelemetry::recordSlotUpdate(int slotIndex, int64 micros) {
+		if (enabled == false || slotIndex < 0 || slotIndex >= GameConstants::maxPlayers) {
+			return;
+		}
+		MutexSafeWrapper safeMutex(mutexTelemetry, CODE_AT_LINE);
+		slotTelemetryList[slotIndex].updateMicros.add(micros);
+	}
+
+	void NetworkTelemetry::recordServerUpdate(int64 micros) {
+		if (enabled == false) {
+			return;
+		}
+		MutexSafeWrapper safeMutex(mutexTelemetry, CODE_AT_LINE);
+		serverUpdateMicros.add(micros);
+	}
+
+	string NetworkTelemetry::toJson() {
+		MutexSafeWrapper safeMutex(mutexTelemetry, CODE_AT_LINE);
+		time_t now = time(NULL);
+
+		string result = "{\"time\":" + intToStr((int64) now) +
+			",\"uptimeSeconds\":" + intToStr((int64) difftime(now, startTime)) +
+			",\"serverUpdateMicros\":" + serverUpdateMicros.toJson() +
+			",\"slots\":[";
+
+		bool firstSlot = true;
+		for (int index = 0; index < GameConstants::maxPlayers; ++index) {
+			const SlotTelemetry &slot = slotTelemetryList[index];
+			if (slot.connected == false) {
+				continue;
+			}
+			if (firstSlot == false) {
+				result += ",";
+			}
+			firstSlot = false;
+
+			result += "{\"slot\":" + intToStr(index) +
+				",\"name\":\"" + escapeJson(slot.name) + "\"" +
+				",\"ip\":\"" + escapeJson(slot.ipAddress) + "\"" +
+				",\"connectedSeconds\":" + intToStr((int64) difftime(now, slot.connectedTime)) +
+				",\"framesBehind\":" + intToStr(slot.framesBehind) +
+				",\"framesBehindMax\":" + intToStr(slot.framesBehindMax) +
+				",\"sendQueueBytes\":" + intToStr(slot.sendQueueBytes) +
+				",\"sendQueueBytesMax\":" + intToStr(slot.sendQueueBytesMax) +
+				",\"roundTripMillis\":" + slot.roundTripMillis.toJson() +
+				",\"updateMicros\":" + slot.updateMicros.toJson() +
+				",\"messages\":{";
+
+			bool firstType = true;
+			for (int type = nmtInvalid + 1; type < nmtCount; ++type) {
+				const MessageCounters &counters = slot.messageCounters[type];
+				if (counters.sentCount == 0 && counters.sentBytes == 0 &&
+					counters.receivedCount == 0 && counters.receivedBytes == 0) {
+					continue;
+				}
+				if (firstType == false) {
+					result += ",";
+				}
+				firstType = false;
+
+				result += "\"" + string(getMessageTypeName(static_cast<NetworkMessageType>(type))) + "\":{" +
+					"\"sentCount\":" + intToStr(counters.sentCount) +
+					",\"sentBytes\":" + intToStr(counters.sentBytes) +
+					",\"receivedCount\":" + intToStr(counters.receivedCount) +
+					",\"receivedBytes\":" + intToStr(counters.receivedBytes) + "}";
+			}
+			result += "}}";
+		}
+		result += "]}\n";
+		return result;
+	}
+
+	string NetworkTelemetry::getCsvHeader() {
+		return "time,slot,name,ip,framesBehind,framesBehindMax,sendQueueBytes,sendQueueBytesMax,"
+			"roundTripCount,roundTripMeanMillis,roundTripP95Millis,roundTripMaxMillis,"
+			"updateCount,updateMeanMicros,updateMaxMicros,"
+			"messagesSent,bytesSent,messagesReceived,bytesReceived\n";
+	}
+
+	string NetworkTelemetry::toCsv() {
+		MutexSafeWrapper safeMutex(mutexTelemetry, CODE_AT_LINE);
+		string now = intToStr((int64) time(NULL));
+
+		string result = "";
+		for (int index = 0; index < GameConstants::maxPlayers; ++index) {
+			const SlotTelemetry &slot = slotTelemetryList[index];
+			if (slot.connected == false) {
+				continue;
+			}
+
+			MessageCounters totals;
+			memset(&totals, 0, sizeof(totals));
+			for (int type = nmtInvalid + 1; type < nmtCount; ++type) {
+				totals.sentCount += slot.messageCounters[type].sentCount;
+				totals.sentBytes += slot.messageCounters[type].sentBytes;
+				totals.receivedCount += slot.messageCounters[type].receivedCount;
+				totals.receivedBytes += slot.messageCounters[type].receivedBytes;
+			}
+
+			result += now + "," + intToStr(index) + "," + escapeCsv(slot.name) + "," + escapeCsv(slot.ipAddress) + "," +
+				intToStr(slot.framesBehind) + "," + intToStr(slot.framesBehindMax) + "," +
+				intToStr(slot.sendQueueBytes) + "," + intToStr(slot.sendQueueBytesMax) + "," +
+				intToStr(slot.roundTripMillis.getCount()) + "," + intToStr(slot.roundTripMillis.getMean()) + "," +
+				intToStr(slot.roundTripMillis.getPercentile(0.95)) + "," + intToStr(slot.roundTripMillis.getMax()) + "," +
+				intToStr(slot.updateMicros.getCount()) + "," + intToStr(slot.updateMicros.getMean()) + "," +
+				intToStr(slot.updateMicros.getMax()) + "," +
+				intToStr(totals.sentCount) + "," + intToStr(totals.sentBytes) + "," +
+				intToStr(totals.receivedCount) + "," + intToStr(totals.receivedBytes) + "\n";
+		}
+		return result;
+	}
+
+	// =====================================================
+	//	class NetworkTelemetryScopeTimer
+	// =====================================================
+
+	NetworkTelemetryScopeTimer::NetworkTelemetryScopeTimer(int slotIndex) {
+		this->slotIndex = slotIndex;
+		this->active = NetworkTelemetry::isEnabled();
+		if (this->active == true) {
+			chrono.start();
+		}
+	}
+
+	NetworkTelemetryScopeTimer::~NetworkTelemetryScopeTimer() {
+		if (active == true) {
+			if (slotIndex < 0) {
+				NetworkTelemetry::recordServerUpdate(chrono.getMicros());
+			} else {
+				NetworkTelemetry::recordSlotUpdate(slotIndex, chrono.getMicros());
+			}
+		}
+	}
+
+	// =====================================================
+	//	class NetworkTelemetryThread
+	// =====================================================
+
+	NetworkTelemetryThread::NetworkTelemetryThread(const string &filePath, int intervalSeconds, int httpPort) : BaseThread() {
+		this->filePath = filePath;
+		this->intervalSeconds = max(1, intervalSeconds);
+		this->httpPort = httpPort;
+		this->httpSocket = NULL;
+		this->wroteCsvHeader = false;
+
+		if (httpPort > 0) {
+			// Operators scrape it from the same host only
+			this->httpSocket = new ServerSocket(true);
+			try {
+				this->httpSocket->setBlock(false);
+				this->httpSocket->setBindSpecificAddress("127.0.0.1");
+				this->httpSocket->setBindPort(httpPort);
+				this->httpSocket->listen(8);
+			} catch (const exception &ex) {
+				SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Could not listen for telemetry requests on port %d [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, httpPort, ex.what());
+				delete this->httpSocket;
+				this->httpSocket = NULL;
+			}
+		}
+
+		setUniqueID("NetworkTelemetryThread");
+		NetworkTelemetry::setEnabled(true);
+	}
+
+	NetworkTelemetryThread::~NetworkTelemetryThread() {
+		NetworkTelemetry::setEnabled(false);
+
+		delete httpSocket;
+		httpSocket = NULL;
+	}
+
+	void NetworkTelemetryThread::writeFiles() {
+		if (filePath == "") {
+			return;
+		}
+
+		string json = NetworkTelemetry::toJson();
+		string jsonFile = filePath + ".json";
+		FILE *fp = fopen((jsonFile + ".tmp").c_str(), "wb");
+		if (fp != NULL) {
+			bool written = (fwrite(json.c_str(), 1, json.size(), fp) == json.size());
+			fclose(fp);
+			if (written == true) {
+				removeFile(jsonFile);
+				renameFile(jsonFile + ".tmp", jsonFile);
+			}
+		}
+
+		string csv = NetworkTelemetry::toCsv();
+		string csvFile = filePath + ".csv";
+		if (wroteCsvHeader == false && fileExists(csvFile) == false) {
+			csv = NetworkTelemetry::getCsvHeader() + csv;
+		}
+		wroteCsvHeader = true;
+		if (csv.empty() == false) {
+			fp = fopen(csvFile.c_str(), "ab");
+			if (fp != NULL) {
+				fwrite(csv.c_str(), 1, csv.size(), fp);
+				fclose(fp);
+			}
+		}
+	}
+
+	void NetworkTelemetryThread::serveHttp() {
+		for (Socket *socket = httpSocket->accept(false); socket != NULL; socket = httpSocket->accept(false)) {
+			try {
+				// Requests are a single short line, wait for it briefly
+				char request[1024] = "";
+				int requestSize = 0;
+				if (socket->hasDataToReadWithWait(200000) == true) {
+					requestSize = socket->receive(request, sizeof(request) - 1, false);
+				}
+				request[max(0, requestSize)] = '\0';
+
+				string requestLine = request;
+				string status = "200 OK";
+				string contentType = "application/json";
+				string body = "";
+				if (StartsWith(requestLine, "GET /csv") == true) {
+					contentType = "text/csv";
+					body = NetworkTelemetry::getCsvHeader() + NetworkTelemetry::toCsv();
+				} else if (StartsWith(requestLine, "GET / ") == true || StartsWith(requestLine, "GET /json") == true) {
+					body = NetworkTelemetry::toJson();
+				} else {
+					status = "404 Not Found";
+					contentType = "text/plain";
+					body = "not found\n";
+				}
+
+				string reply = "HTTP/1.0 " + status + "\r\n" +
+					"Content-Type: " + contentType + "\r\n" +
+					"Content-Length: " + intToStr((int) body.size()) + "\r\n" +
+					"Connection: close\r\n\r\n" + body;
+				socket->send(reply.c_str(), (int) reply.size());
+			} catch (const exception &ex) {
+				SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, ex.what());
+			}
+			delete socket;
+		}
+	}
+
+	void NetworkTelemetryThread::execute() {
+		RunningStatusSafeWrapper runningStatus(this);
+		ExecutingTaskSafeWrapper safeExecutingTaskMutex(this);
+
+		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] Network telemetry file [%s] every %d seconds, http port %d\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, filePath.c_str(), intervalSeconds, (httpSocket != NULL ? httpPort : 0));
+
+		time_t lastWriteTime = time(NULL);
+		for (; getQuitStatus() == false;) {
+			try {
+				if (httpSocket != NULL) {
+					serveHttp();
+				}
+				if (difftime(time(NULL), lastWriteTime) >= intervalSeconds) {
+					lastWriteTime = time(NULL);
+					writeFiles();
+				}
+			} catch (const exception &ex) {
+				SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, ex.what());
+			}
+
+			sleep(50);
+		}
+
+		writeFiles();
+	}
+
+} //end namespace
@@ -0,0 +1,185 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+#ifndef _NETWORKTELEMETRY_H_
+#define _NETWORKTELEMETRY_H_
+
+#include "socket.h"
+#include "base_thread.h"
+#include "network_message.h"
+#include "game_constants.h"
+#include <map>
+#include <vector>
+
+#include "leak_dumper.h"
+
+using Shared::Platform::ServerSocket;
+using Shared::Platform::Socket;
+using Shared::PlatformCommon::BaseThread;
+using Shared::PlatformCommon::Chrono;
+using std::map;
+using std::vector;
+
+namespace Game {
+
+	// =====================================================
+	//	class NetworkTelemetryHistogram
+	// =====================================================
+
+	class NetworkTelemetryHistogram {
+	private:
+		vector<int64> upperBounds;
+		// One more bucket than bounds, the last one is open ended
+		vector<int64> bucketCounts;
+		int64 count;
+		int64 sum;
+		int64 maxValue;
+
+	public:
+		NetworkTelemetryHistogram();
+		NetworkTelemetryHistogram(const int64 *upperBounds, int boundCount);
+
+		void add(int64 value);
+		void reset();
+
+		int64 getCount() const {
+			return count;
+		}
+		int64 getMean() const {
+			return (count > 0 ? sum / count : 0);
+		}
+		int64 getMax() const {
+			return maxValue;
+		}
+		// Upper bound of the bucket holding the given fraction of samples
+		int64 getPercentile(double fraction) const;
+
+		string toJson() const;
+	};
+
+	// =====================================================
+	//	class NetworkTelemetry
+	//
+	//	Per slot counters of the server's connections, recorded
+	//	only while a NetworkTelemetryThread is running
+	// =====================================================
+
+	class NetworkTelemetry {
+	public:
+		struct MessageCounters {
+			int64 sentCount;
+			int64 sentBytes;
+			int64 receivedCount;
+			int64 receivedBytes;
+		};
+
+		struct SlotTelemetry {
+			bool connected;
+			string name;
+			string ipAddress;
+			time_t connectedTime;
+
+			MessageCounters messageCounters[nmtCount];
+			int64 sendQueueBytes;
+			int64 sendQueueBytesMax;
+			int framesBehind;
+			int framesBehindMax;
+			NetworkTelemetryHistogram roundTripMillis;
+			NetworkTelemetryHistogram updateMicros;
+		};
+
+	private:
+		static bool enabled;
+		static Mutex *mutexTelemetry;
+		static std::map<Socket *, int> socketSlotMap;
+		static SlotTelemetry slotTelemetryList[GameConstants::maxPlayers];
+		static NetworkTelemetryHistogram serverUpdateMicros;
+		static time_t startTime;
+
+		static void resetSlot(int slotIndex);
+		static int getSlotIndex(Socket *socket);
+
+	public:
+		static void setEnabled(bool value);
+		static bool isEnabled() {
+			return enabled;
+		}
+
+		static const char * getMessageTypeName(NetworkMessageType type);
+
+		// Called once per server update for every slot, binds the socket
+		// to the slot and starts fresh counters when a new player connects
+		static void updateSlot(int slotIndex, Socket *socket, const string &name,
+			const string &ipAddress, int framesBehind);
+		static void removeSocket(Socket *socket);
+
+		static void recordSend(Socket *socket, NetworkMessageType type, int bytes, bool isNewMessage);
+		static void recordReceive(Socket *socket, NetworkMessageType type, int bytes, bool isNewMessage);
+		static void recordSendQueue(int slotIndex, int bytes);
+		static void recordRoundTrip(int slotIndex, int64 roundTripMillis);
+		static void recordSlotUpdate(int slotIndex, int64 micros);
+		static void recordServerUpdate(int64 micros);
+
+		static string toJson();
+		static string getCsvHeader();
+		static string toCsv();
+	};
+
+	// Times the enclosing scope into the slot's update histogram, or the
+	// server's when slotIndex is -1
+	class NetworkTelemetryScopeTimer {
+	private:
+		int slotIndex;
+		bool active;
+		Chrono chrono;
+
+	public:
+		explicit NetworkTelemetryScopeTimer(int slotIndex);
+		~NetworkTelemetryScopeTimer();
+	};
+
+	// =====================================================
+	//	class NetworkTelemetryThread
+	//
+	//	Periodically writes the telemetry to <file>.json (latest
+	//	snapshot) and <file>.csv (one row per slot per interval)
+	//	and answers GET /, /json and /csv on a local HTTP port
+	// =====================================================
+
+	class NetworkTelemetryThread : public BaseThread {
+	private:
+		string filePath;
+		int intervalSeconds;
+		int httpPort;
+		ServerSocket *httpSocket;
+		bool wroteCsvHeader;
+
+		void writeFiles();
+		void serveHttp();
+
+	public:
+		NetworkTelemetryThread(const string &filePath, int intervalSeconds, int httpPort);
+		virtual ~NetworkTelemetryThread();
+
+		virtual void execute();
+	};
+
+} //end namespace
+
+#endif
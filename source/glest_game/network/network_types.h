@@ -195,6 +195,23 @@ namespace Game {
 		void toEndian();
 		void fromEndian();
 
+		template <typename Archive> void serialize(Archive &archive) {
+			archive.field(networkCommandType);
+			archive.field(unitId);
+			archive.field(unitTypeId);
+			archive.field(commandTypeId);
+			archive.field(positionX);
+			archive.field(positionY);
+			archive.field(targetId);
+			archive.field(wantQueue);
+			archive.field(fromFactionIndex);
+			archive.field(unitFactionUnitCount);
+			archive.field(unitFactionIndex);
+			archive.field(commandStateType);
+			archive.field(commandStateValue);
+			archive.field(unitCommandGroupId);
+		}
+
 		XmlNode * saveGame(XmlNode *rootNode);
 		void loadGame(const XmlNode *rootNode);
 	};
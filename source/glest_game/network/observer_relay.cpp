@@ -0,0 +1,600 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+#include "observer_relay.h"
+
+#include "conversion.h"
+#include "game_util.h"
+#include "config.h"
+#include "network_interface.h"
+#include "platform_util.h"
+#include "compression_utils.h"
+#include <stdexcept>
+#include "shared_const.h"
+
+#include "leak_dumper.h"
+
+using namespace std;
+using namespace Shared;
+using namespace Shared::Util;
+
+namespace Game {
+
+	// =====================================================
+	//	class ObserverRelay
+	// =====================================================
+
+	ObserverRelay::ObserverRelay(int port, int playerIndex, int sessionKey, const string &name, uint32 hostProtocolFeatures) : BaseThread() {
+		Config &config = Config::getInstance();
+
+		this->port = port;
+		this->playerIndex = playerIndex;
+		this->sessionKey = sessionKey;
+		this->name = name;
+		this->delayMilliseconds = (int64) config.getInt("ObserverRelayDelaySeconds", "0") * 1000;
+		this->snapshotIntervalMilliseconds = (int64) max(1, config.getInt("ObserverRelaySnapshotSeconds", "60")) * 1000;
+		this->maxConnections = config.getInt("ObserverRelayMaxConnections", "256");
+		// Viewers without adaptive frame periods would miss the period
+		// changes negotiated with the host and desync
+		this->requiredProtocolFeatures = npfStreamedJoinSnapshot | (hostProtocolFeatures & npfAdaptiveFramePeriod);
+		this->sendStallMilliseconds = (int64) max(1, config.getInt("ObserverRelaySendStallSeconds", "30")) * 1000;
+
+		this->mutexRelay = new Mutex(CODE_AT_LINE);
+		this->pendingSnapshot = NULL;
+		this->lastSnapshotTime = 0;
+		this->quitTime = -1;
+
+		this->serverSocket = new ServerSocket(true);
+		try {
+			this->serverSocket->setBlock(false);
+			this->serverSocket->setBindPort(port);
+			this->serverSocket->listen(max(1, min(maxConnections, 128)));
+		} catch (...) {
+			delete this->serverSocket;
+			delete this->mutexRelay;
+			throw;
+		}
+
+		setUniqueID("ObserverRelay");
+	}
+
+	ObserverRelay::~ObserverRelay() {
+		for (unsigned int index = 0; index < connectionList.size(); ++index) {
+			delete connectionList[index].socket;
+		}
+		connectionList.clear();
+
+		for (unsigned int index = 0; index < snapshotList.size(); ++index) {
+			delete snapshotList[index];
+		}
+		snapshotList.clear();
+		delete pendingSnapshot;
+		pendingSnapshot = NULL;
+
+		delete serverSocket;
+		serverSocket = NULL;
+
+		delete mutexRelay;
+		mutexRelay = NULL;
+	}
+
+	bool ObserverRelay::isSnapshotDue(int frameCount) {
+		MutexSafeWrapper safeMutex(mutexRelay, CODE_AT_LINE);
+		if (pendingSnapshot != NULL ||
+			(lastSnapshotTime > 0 && Chrono::getCurMillis() - lastSnapshotTime < snapshotIntervalMilliseconds)) {
+			return false;
+		}
+
+		// Lists arrive in frame order and may run ahead of the game
+		for (deque<RelayCommandList>::reverse_iterator iterList = commandListList.rbegin();
+			iterList != commandListList.rend() && iterList->commandList.getFrameCount() >= frameCount; ++iterList) {
+			if (iterList->commandList.getFrameCount() == frameCount) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void ObserverRelay::addSnapshot(int frameCount, const GameSettings &gameSettings, const std::vector<char> &snapshot) {
+		RelaySnapshot *relaySnapshot = new RelaySnapshot();
+		relaySnapshot->takenTime = Chrono::getCurMillis();
+		relaySnapshot->frameCount = frameCount;
+		relaySnapshot->gameSettings = gameSettings;
+		relaySnapshot->data = snapshot;
+		relaySnapshot->uncompressedSize = (uint32) snapshot.size();
+
+		MutexSafeWrapper safeMutex(mutexRelay, CODE_AT_LINE);
+		delete pendingSnapshot;
+		pendingSnapshot = relaySnapshot;
+		lastSnapshotTime = relaySnapshot->takenTime;
+	}
+
+	void ObserverRelay::addCommandList(const NetworkMessageCommandList &commandList) {
+		MutexSafeWrapper safeMutex(mutexRelay, CODE_AT_LINE);
+		RelayCommandList relayCommandList;
+		relayCommandList.receivedTime = Chrono::getCurMillis();
+		relayCommandList.commandList = commandList;
+		commandListList.push_back(relayCommandList);
+	}
+
+	void ObserverRelay::addQuit() {
+		MutexSafeWrapper safeMutex(mutexRelay, CODE_AT_LINE);
+		if (quitTime < 0) {
+			quitTime = Chrono::getCurMillis();
+		}
+	}
+
+	void ObserverRelay::execute() {
+		RunningStatusSafeWrapper runningStatus(this);
+		ExecutingTaskSafeWrapper safeExecutingTaskMutex(this);
+
+		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] Observer relay listening on port %d, delay %lld msecs\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, port, (long long int) delayMilliseconds);
+
+		for (; getQuitStatus() == false;) {
+			try {
+				deflatePendingSnapshot();
+				acceptConnections();
+				for (unsigned int index = 0; index < connectionList.size(); ++index) {
+					updateConnection(connectionList[index]);
+				}
+				broadcastCommandLists();
+				drainConnections();
+				pruneHistory();
+			} catch (const exception &ex) {
+				SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, ex.what());
+			}
+
+			sleep(5);
+		}
+
+		// Let the viewers know the stream is over
+		for (unsigned int index = 0; index < connectionList.size(); ++index) {
+			RelayConnection &connection = connectionList[index];
+			try {
+				if (connection.status == rcsStreaming && connection.socket->isConnected() == true) {
+					NetworkMessageQuit networkMessageQuit;
+					sendMessage(connection, &networkMessageQuit);
+				}
+				// Best effort, whatever does not fit right now is dropped
+				if (connection.socket != NULL) {
+					drainSendQueue(connection);
+				}
+			} catch (const exception &ex) {
+				SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, ex.what());
+			}
+			closeConnection(connection);
+		}
+		connectionList.clear();
+
+		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] Observer relay on port %d is exiting\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, port);
+	}
+
+	void ObserverRelay::deflatePendingSnapshot() {
+		MutexSafeWrapper safeMutex(mutexRelay, CODE_AT_LINE);
+		RelaySnapshot *relaySnapshot = pendingSnapshot;
+		pendingSnapshot = NULL;
+		safeMutex.ReleaseLock();
+
+		if (relaySnapshot == NULL) {
+			return;
+		}
+		if (relaySnapshot->data.empty() == true) {
+			delete relaySnapshot;
+			return;
+		}
+
+		// Deflated once here and then sent as is to every viewer
+		std::pair<unsigned char *, unsigned long> compressionResult =
+			Shared::CompressionUtil::compressMemoryToMemory((unsigned char *) &relaySnapshot->data[0], (unsigned long) relaySnapshot->data.size());
+		relaySnapshot->data.assign((const char *) compressionResult.first, (const char *) compressionResult.first + compressionResult.second);
+		delete[] compressionResult.first;
+
+		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] relay snapshot for frame %d: %u bytes (%u deflated)\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, relaySnapshot->frameCount, relaySnapshot->uncompressedSize, (uint32) relaySnapshot->data.size());
+
+		snapshotList.push_back(relaySnapshot);
+	}
+
+	void ObserverRelay::acceptConnections() {
+		for (Socket *socket = serverSocket->accept(false); socket != NULL; socket = serverSocket->accept(false)) {
+			if ((int) connectionList.size() >= maxConnections) {
+				if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] relay is full, rejecting viewer\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
+				delete socket;
+				continue;
+			}
+			socket->setBlock(false);
+
+			RelayConnection connection;
+			connection.socket = socket;
+			connection.status = rcsAwaitingIntro;
+			connection.protocolFeatures = npfNone;
+			connection.lastSentFrame = -1;
+			connection.lastPingTime = time(NULL);
+			connection.sendQueueOffset = 0;
+			connection.lastSendProgressTime = Chrono::getCurMillis();
+
+			// The viewer takes over our observer slot so the game it loads
+			// looks the same as the one we are watching
+			NetworkMessageIntro networkMessageIntro(
+				sessionKey, GameVersionString, name, playerIndex, nmgstOk,
+				0, 0, "", 1, Config::getInstance().getString("PlayerId", ""),
+				getPlatformNameString(), NetworkInterface::getLocalProtocolFeatures());
+			sendMessage(connection, &networkMessageIntro);
+
+			connectionList.push_back(connection);
+		}
+	}
+
+	void ObserverRelay::updateConnection(RelayConnection &connection) {
+		if (connection.status == rcsClosing || connection.status == rcsClosed) {
+			return;
+		}
+		if (connection.socket->isConnected() == false) {
+			closeConnection(connection);
+			return;
+		}
+
+		try {
+			// Viewers talk like any client, only the handshake matters here
+			for (int messageCount = 0; messageCount < 16 && connection.socket->hasDataToRead() == true; ++messageCount) {
+				if (receiveNextMessage(connection) == false) {
+					closeConnection(connection);
+					return;
+				}
+			}
+
+			if (connection.status == rcsAwaitingSnapshot) {
+				sendSnapshot(connection);
+			}
+
+			time_t now = time(NULL);
+			if (difftime(now, connection.lastPingTime) >= GameConstants::networkPingInterval) {
+				NetworkMessagePing networkMessagePing(GameConstants::networkPingInterval, now);
+				sendMessage(connection, &networkMessagePing);
+				connection.lastPingTime = now;
+			}
+		} catch (const exception &ex) {
+			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] dropping viewer [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, ex.what());
+			closeConnection(connection);
+		}
+	}
+
+	bool ObserverRelay::receiveNextMessage(RelayConnection &connection) {
+		Socket *socket = connection.socket;
+		int8 messageType = nmtInvalid;
+		if (socket->getDataToRead() < (int) sizeof(messageType)) {
+			return true;
+		}
+		if (socket->receive(&messageType, sizeof(messageType), true) != (int) sizeof(messageType)) {
+			return socket->isSocketValid();
+		}
+		if (messageType == nmtCompressedPacket) {
+			messageType = NetworkMessage::receiveCompressedPacket(socket);
+		}
+
+		switch (messageType) {
+			case nmtIntro:
+			{
+				NetworkMessageIntro networkMessageIntro;
+				if (receiveMessage(connection, &networkMessageIntro, nmtIntro) == false) {
+					return false;
+				}
+				if (connection.status == rcsAwaitingIntro) {
+					connection.protocolFeatures = networkMessageIntro.getSupportedProtocolFeatures() & NetworkInterface::getLocalProtocolFeatures();
+					if ((connection.protocolFeatures & requiredProtocolFeatures) != requiredProtocolFeatures ||
+						checkVersionCompatibility(GameVersionString, networkMessageIntro.getVersionString()) == false) {
+						if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] viewer [%s] lacks protocol features 0x%X\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, networkMessageIntro.getVersionString().c_str(), requiredProtocolFeatures & ~connection.protocolFeatures);
+						return false;
+					}
+					connection.status = rcsAwaitingSnapshot;
+				}
+			}
+			break;
+
+			case nmtReady:
+			{
+				NetworkMessageReady networkMessageReady;
+				if (receiveMessage(connection, &networkMessageReady, nmtReady) == false) {
+					return false;
+				}
+				// The viewer loaded the snapshot, release it from waitUntilReady
+				if (connection.status == rcsLoading) {
+					NetworkMessageReady networkMessageReadyReply(0);
+					sendMessage(connection, &networkMessageReadyReply);
+					connection.status = rcsStreaming;
+				}
+			}
+			break;
+
+			case nmtPing:
+			{
+				NetworkMessagePing networkMessagePing;
+				return receiveMessage(connection, &networkMessagePing, nmtPing);
+			}
+
+			case nmtCommandList:
+			case nmtCommandListCompact:
+			{
+				NetworkMessageCommandList networkMessageCommandList;
+				return receiveMessage(connection, &networkMessageCommandList, static_cast<NetworkMessageType>(messageType));
+			}
+
+			case nmtText:
+			{
+				NetworkMessageText networkMessageText;
+				return receiveMessage(connection, &networkMessageText, nmtText);
+			}
+
+			case nmtLaunch:
+			case nmtBroadCastSetup:
+			{
+				NetworkMessageLaunch networkMessageLaunch;
+				return receiveMessage(connection, &networkMessageLaunch, static_cast<NetworkMessageType>(messageType));
+			}
+
+			case nmtSwitchSetupRequest:
+			{
+				SwitchSetupRequest switchSetupRequest;
+				return receiveMessage(connection, &switchSetupRequest, nmtSwitchSetupRequest);
+			}
+
+			case nmtLoadingStatusMessage:
+			{
+				NetworkMessageLoadingStatus networkMessageLoadingStatus;
+				return receiveMessage(connection, &networkMessageLoadingStatus, nmtLoadingStatusMessage);
+			}
+
+			case nmtMarkCell:
+			{
+				NetworkMessageMarkCell networkMessageMarkCell;
+				return receiveMessage(connection, &networkMessageMarkCell, nmtMarkCell);
+			}
+
+			case nmtUnMarkCell:
+			{
+				NetworkMessageUnMarkCell networkMessageUnMarkCell;
+				return receiveMessage(connection, &networkMessageUnMarkCell, nmtUnMarkCell);
+			}
+
+			case nmtHighlightCell:
+			{
+				NetworkMessageHighlightCell networkMessageHighlightCell;
+				return receiveMessage(connection, &networkMessageHighlightCell, nmtHighlightCell);
+			}
+
+			case nmtQuit:
+				return false;
+
+			default:
+				if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] unexpected message type %d from viewer\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, messageType);
+				return false;
+		}
+		return true;
+	}
+
+	bool ObserverRelay::receiveMessage(RelayConnection &connection, NetworkMessage *networkMessage, NetworkMessageType type) {
+		networkMessage->setProtocolFeatures(connection.protocolFeatures);
+		return networkMessage->receive(connection.socket, type);
+	}
+
+	void ObserverRelay::sendMessage(RelayConnection &connection, NetworkMessage *networkMessage) {
+		vector<SocketSendBuffer> bufferList;
+		networkMessage->setProtocolFeatures(connection.protocolFeatures);
+		networkMessage->setSendQueue(&bufferList);
+		try {
+			if (networkMessage->sendShared(connection.socket) == false) {
+				networkMessage->sendNegotiated(connection.socket);
+			}
+		} catch (...) {
+			networkMessage->setSendQueue(NULL);
+			throw;
+		}
+		networkMessage->setSendQueue(NULL);
+
+		if (connection.sendQueue.empty() == true) {
+			connection.lastSendProgressTime = Chrono::getCurMillis();
+		}
+		connection.sendQueue.insert(connection.sendQueue.end(), bufferList.begin(), bufferList.end());
+	}
+
+	bool ObserverRelay::drainSendQueue(RelayConnection &connection) {
+		int64 now = Chrono::getCurMillis();
+		while (connection.sendQueue.empty() == false) {
+			const SocketSendBuffer &buffer = connection.sendQueue.front();
+			int remaining = (int) (buffer->size() - connection.sendQueueOffset);
+			if (remaining > 0) {
+				int bytesSent = connection.socket->trySend(&(*buffer)[connection.sendQueueOffset], remaining);
+				if (bytesSent < 0) {
+					return false;
+				}
+				if (bytesSent == 0) {
+					break;
+				}
+				connection.lastSendProgressTime = now;
+				connection.sendQueueOffset += bytesSent;
+				if (bytesSent < remaining) {
+					break;
+				}
+			}
+			connection.sendQueue.pop_front();
+			connection.sendQueueOffset = 0;
+		}
+
+		if (connection.sendQueue.empty() == false && now - connection.lastSendProgressTime > sendStallMilliseconds) {
+			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] viewer stopped reading, %d buffers still queued\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, (int) connection.sendQueue.size());
+			return false;
+		}
+		return true;
+	}
+
+	void ObserverRelay::drainConnections() {
+		for (unsigned int index = 0; index < connectionList.size(); ++index) {
+			RelayConnection &connection = connectionList[index];
+			if (connection.status == rcsClosed) {
+				continue;
+			}
+			if (drainSendQueue(connection) == false ||
+				(connection.status == rcsClosing && connection.sendQueue.empty() == true)) {
+				closeConnection(connection);
+			}
+		}
+	}
+
+	void ObserverRelay::sendSnapshot(RelayConnection &connection) {
+		// Newest snapshot the delay allows the viewer to see
+		int64 now = Chrono::getCurMillis();
+		RelaySnapshot *relaySnapshot = NULL;
+		for (unsigned int index = 0; index < snapshotList.size(); ++index) {
+			if (snapshotList[index]->takenTime + delayMilliseconds <= now) {
+				relaySnapshot = snapshotList[index];
+			}
+		}
+		if (relaySnapshot == NULL) {
+			return;
+		}
+
+		NetworkMessageLaunch networkMessageLaunch(&relaySnapshot->gameSettings, nmtBroadCastSetup);
+		sendMessage(connection, &networkMessageLaunch);
+
+		uint32 snapshotSize = (uint32) relaySnapshot->data.size();
+		for (uint32 offset = 0; offset < snapshotSize;) {
+			uint32 chunkSize = min((uint32) maxGameSnapshotChunkSize, snapshotSize - offset);
+			NetworkMessageGameSnapshotChunk networkMessageGameSnapshotChunk(snapshotSize, relaySnapshot->uncompressedSize,
+				offset, &relaySnapshot->data[offset], chunkSize);
+			sendMessage(connection, &networkMessageGameSnapshotChunk);
+			offset += chunkSize;
+		}
+
+		NetworkMessageReady networkMessageReady(0);
+		sendMessage(connection, &networkMessageReady);
+
+		connection.lastSentFrame = relaySnapshot->frameCount;
+		connection.status = rcsLoading;
+
+		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] sent relay snapshot for frame %d to viewer\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, relaySnapshot->frameCount);
+	}
+
+	void ObserverRelay::broadcastCommandLists() {
+		int minLastSentFrame = -1;
+		bool hasStreamingConnection = false;
+		for (unsigned int index = 0; index < connectionList.size(); ++index) {
+			if (connectionList[index].status == rcsStreaming) {
+				if (hasStreamingConnection == false || connectionList[index].lastSentFrame < minLastSentFrame) {
+					minLastSentFrame = connectionList[index].lastSentFrame;
+				}
+				hasStreamingConnection = true;
+			}
+		}
+		if (hasStreamingConnection == false) {
+			return;
+		}
+
+		// Copy what the delay released so slow viewers never hold the lock
+		int64 now = Chrono::getCurMillis();
+		vector<NetworkMessageCommandList> releasedList;
+		MutexSafeWrapper safeMutex(mutexRelay, CODE_AT_LINE);
+		for (deque<RelayCommandList>::iterator iterList = commandListList.begin();
+			iterList != commandListList.end() && iterList->receivedTime + delayMilliseconds <= now; ++iterList) {
+			if (iterList->commandList.getFrameCount() > minLastSentFrame) {
+				releasedList.push_back(iterList->commandList);
+			}
+		}
+		bool quitReleased = (quitTime >= 0 && quitTime + delayMilliseconds <= now);
+		safeMutex.ReleaseLock();
+
+		for (unsigned int listIndex = 0; listIndex < releasedList.size(); ++listIndex) {
+			NetworkMessageCommandList &commandList = releasedList[listIndex];
+
+			// Serialize once for all viewers at the same point of the stream
+			commandList.beginSharedSend();
+			for (unsigned int index = 0; index < connectionList.size(); ++index) {
+				RelayConnection &connection = connectionList[index];
+				if (connection.status == rcsStreaming && connection.lastSentFrame < commandList.getFrameCount()) {
+					try {
+						sendMessage(connection, &commandList);
+						connection.lastSentFrame = commandList.getFrameCount();
+					} catch (const exception &ex) {
+						if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] dropping viewer [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, ex.what());
+						closeConnection(connection);
+					}
+				}
+			}
+			commandList.endSharedSend();
+		}
+
+		if (quitReleased == true) {
+			for (unsigned int index = 0; index < connectionList.size(); ++index) {
+				RelayConnection &connection = connectionList[index];
+				if (connection.status == rcsStreaming) {
+					try {
+						NetworkMessageQuit networkMessageQuit;
+						sendMessage(connection, &networkMessageQuit);
+						// Closed once the queue drained
+						connection.status = rcsClosing;
+					} catch (const exception &ex) {
+						SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, ex.what());
+						closeConnection(connection);
+					}
+				}
+			}
+		}
+	}
+
+	void ObserverRelay::closeConnection(RelayConnection &connection) {
+		if (connection.socket != NULL) {
+			delete connection.socket;
+			connection.socket = NULL;
+		}
+		connection.status = rcsClosed;
+	}
+
+	void ObserverRelay::pruneHistory() {
+		for (vector<RelayConnection>::iterator iterConnection = connectionList.begin();
+			iterConnection != connectionList.end();) {
+			if (iterConnection->status == rcsClosed) {
+				iterConnection = connectionList.erase(iterConnection);
+			} else {
+				++iterConnection;
+			}
+		}
+
+		// Only the newest released snapshot is still handed to new viewers
+		int64 now = Chrono::getCurMillis();
+		while (snapshotList.size() > 1 && snapshotList[1]->takenTime + delayMilliseconds <= now) {
+			delete snapshotList.front();
+			snapshotList.pop_front();
+		}
+		if (snapshotList.empty() == true) {
+			return;
+		}
+
+		// Keep every list a retained snapshot or a connected viewer still needs
+		int neededFrame = snapshotList.front()->frameCount;
+		for (unsigned int index = 0; index < connectionList.size(); ++index) {
+			if (connectionList[index].status == rcsLoading || connectionList[index].status == rcsStreaming) {
+				neededFrame = min(neededFrame, connectionList[index].lastSentFrame);
+			}
+		}
+
+		MutexSafeWrapper safeMutex(mutexRelay, CODE_AT_LINE);
+		while (commandListList.empty() == false && commandListList.front().commandList.getFrameCount() <= neededFrame) {
+			commandListList.pop_front();
+		}
+	}
+
+} //end namespace
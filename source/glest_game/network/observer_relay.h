@@ -0,0 +1,145 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+#ifndef _OBSERVERRELAY_H_
+#define _OBSERVERRELAY_H_
+
+#include "socket.h"
+#include "base_thread.h"
+#include "network_message.h"
+#include "game_settings.h"
+#include <deque>
+#include <vector>
+
+#include "leak_dumper.h"
+
+using Shared::Platform::ServerSocket;
+using Shared::Platform::Socket;
+using Shared::PlatformCommon::BaseThread;
+using std::deque;
+using std::vector;
+
+namespace Game {
+
+	// =====================================================
+	//	class ObserverRelay
+	//
+	//	Runs inside an observer's client and re-broadcasts the
+	//	command lists it gets from the host to any number of
+	//	downstream observers, held back by a configurable delay.
+	//	Viewers join from the newest periodic snapshot that is
+	//	old enough and then follow the command stream from there
+	// =====================================================
+
+	class ObserverRelay : public BaseThread {
+	private:
+		enum RelayConnectionStatus {
+			rcsAwaitingIntro,
+			rcsAwaitingSnapshot,
+			rcsLoading,
+			rcsStreaming,
+			rcsClosing,
+			rcsClosed
+		};
+
+		struct RelayConnection {
+			Socket *socket;
+			RelayConnectionStatus status;
+			uint32 protocolFeatures;
+			int lastSentFrame;
+			time_t lastPingTime;
+			// Wire bytes not written yet, drained without blocking so one slow
+			// viewer never holds up the others
+			deque<SocketSendBuffer> sendQueue;
+			size_t sendQueueOffset;
+			int64 lastSendProgressTime;
+		};
+
+		struct RelaySnapshot {
+			int64 takenTime;
+			int frameCount;
+			GameSettings gameSettings;
+			// Raw until the relay thread deflates it
+			std::vector<char> data;
+			uint32 uncompressedSize;
+		};
+
+		struct RelayCommandList {
+			int64 receivedTime;
+			NetworkMessageCommandList commandList;
+		};
+
+		ServerSocket *serverSocket;
+		int port;
+		int playerIndex;
+		int sessionKey;
+		string name;
+		int64 delayMilliseconds;
+		int64 snapshotIntervalMilliseconds;
+		int maxConnections;
+		// Features every viewer must support, those that change what the
+		// forwarded command lists carry
+		uint32 requiredProtocolFeatures;
+		int64 sendStallMilliseconds;
+
+		// Shared with the game and network threads
+		Mutex *mutexRelay;
+		RelaySnapshot *pendingSnapshot;
+		int64 lastSnapshotTime;
+		deque<RelayCommandList> commandListList;
+		int64 quitTime;
+
+		// Only touched by the relay thread
+		deque<RelaySnapshot *> snapshotList;
+		vector<RelayConnection> connectionList;
+
+		void deflatePendingSnapshot();
+		void acceptConnections();
+		void updateConnection(RelayConnection &connection);
+		bool receiveNextMessage(RelayConnection &connection);
+		bool receiveMessage(RelayConnection &connection, NetworkMessage *networkMessage, NetworkMessageType type);
+		void sendMessage(RelayConnection &connection, NetworkMessage *networkMessage);
+		void sendSnapshot(RelayConnection &connection);
+		bool drainSendQueue(RelayConnection &connection);
+		void drainConnections();
+		void broadcastCommandLists();
+		void closeConnection(RelayConnection &connection);
+		void pruneHistory();
+
+	public:
+		ObserverRelay(int port, int playerIndex, int sessionKey, const string &name, uint32 hostProtocolFeatures);
+		virtual ~ObserverRelay();
+
+		virtual void execute();
+
+		// True once the command list of keyframe frameCount was given and a
+		// new snapshot is due, the snapshot must then be taken at that frame
+		bool isSnapshotDue(int frameCount);
+		void addSnapshot(int frameCount, const GameSettings &gameSettings, const std::vector<char> &snapshot);
+		void addCommandList(const NetworkMessageCommandList &commandList);
+		void addQuit();
+
+		int getPort() const {
+			return port;
+		}
+	};
+
+} //end namespace
+
+#endif
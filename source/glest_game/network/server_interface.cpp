@@ -31,6 +31,8 @@
 #include "util.h"
 #include "game_util.h"
 #include "miniftpserver.h"
+#include "content_transfer.h"
+#include "network_telemetry.h"
 #include "map_preview.h"
 #include "stats.h"
 #include <time.h>
@@ -83,9 +85,17 @@ namespace Game {
 		gameStartTime = 0;
 		resumeGameStartTime = 0;
 		publishToMasterserverThread = NULL;
+		slotReactorThread = NULL;
+		networkSendBatchingEnabled = Config::getInstance().getBool("EnableNetworkSendBatching", "false");
+		adaptiveNetworkFramePeriodEnabled = Config::getInstance().getBool("EnableAdaptiveNetworkFramePeriod", "true");
+		minAdaptiveNetworkFramePeriod = max(1, Config::getInstance().getInt("AdaptiveNetworkFramePeriodMin", "2"));
+		maxAdaptiveNetworkFramePeriod = min(255, max(minAdaptiveNetworkFramePeriod, Config::getInstance().getInt("AdaptiveNetworkFramePeriodMax", "40")));
+		lastNetworkFramePeriodChangeTime = 0;
 		lastMasterserverHeartbeatTime = 0;
 		needToRepublishToMasterserver = false;
 		ftpServer = NULL;
+		contentTransferServer = NULL;
+		telemetryThread = NULL;
 		inBroadcastMessage = false;
 		lastGlobalLagCheckTime = 0;
 		masterserverAdminRequestLaunch = false;
@@ -234,6 +244,41 @@ namespace Game {
 				allowInternetTechtreeFileTransfers, portNumber, GameConstants::maxPlayers,
 				this, tempFilePath);
 			ftpServer->start();
+
+			if (Config::getInstance().getBool("EnableContentTransfer", "true") == true) {
+				int contentTransferPort = ContentTransferServerThread::getPortForFTPPort(portNumber, GameConstants::maxPlayers);
+				try {
+					contentTransferServer = new ContentTransferServerThread(mapsPath, tilesetsPath, techtreesPath,
+						publishEnabled, allowInternetTilesetFileTransfers,
+						allowInternetTechtreeFileTransfers, contentTransferPort,
+						Config::getInstance().getInt("ContentTransferMaxConnections", "32"));
+					contentTransferServer->start();
+				} catch (const exception &ex) {
+					SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Could not listen for content transfers on port %d [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, contentTransferPort, ex.what());
+					contentTransferServer = NULL;
+				}
+			}
+		}
+
+		// In game sockets are serviced by a single reactor thread instead of
+		// each slot thread polling its own socket
+		if (Config::getInstance().getBool("EnableNetworkReactor", "false") == true) {
+			static string mutexOwnerId = string(extractFileFromDirectoryPath(__FILE__).c_str()) + string("_") + intToStr(__LINE__);
+			slotReactorThread = new ConnectionSlotReactorThread(this);
+			slotReactorThread->setUniqueID(mutexOwnerId);
+			slotReactorThread->start();
+		}
+
+		// Operators of headless servers watch per connection counters through
+		// a periodically written file and/or a local HTTP port
+		string telemetryFile = Config::getInstance().getString("NetworkTelemetryFile", "");
+		int telemetryHttpPort = Config::getInstance().getInt("NetworkTelemetryHttpPort", "0");
+		if (telemetryFile != "" || telemetryHttpPort > 0) {
+			static string mutexOwnerId = string(extractFileFromDirectoryPath(__FILE__).c_str()) + string("_") + intToStr(__LINE__);
+			telemetryThread = new NetworkTelemetryThread(telemetryFile,
+				Config::getInstance().getInt("NetworkTelemetryIntervalSeconds", "10"), telemetryHttpPort);
+			telemetryThread->setUniqueID(mutexOwnerId);
+			telemetryThread->start();
 		}
 
 		if (publishToMasterserverThread == NULL) {
@@ -254,6 +299,9 @@ namespace Game {
 		if (ftpServer != NULL) {
 			ftpServer->setInternetEnabled(value);
 		}
+		if (contentTransferServer != NULL) {
+			contentTransferServer->setInternetEnabled(value);
+		}
 	}
 
 	void ServerInterface::shutdownMasterserverPublishThread() {
@@ -273,12 +321,38 @@ namespace Game {
 		}
 	}
 
+	void ServerInterface::shutdownSlotReactorThread() {
+		if (slotReactorThread != NULL) {
+			time_t elapsed = time(NULL);
+			slotReactorThread->signalQuit();
+			for (; slotReactorThread->canShutdown(false) == false &&
+				difftime((long int) time(NULL), elapsed) <= 15;) {
+				//sleep(150);
+			}
+			if (slotReactorThread->canShutdown(true)) {
+				delete slotReactorThread;
+			}
+			slotReactorThread = NULL;
+		}
+	}
+
+	void ServerInterface::shutdownTelemetryThread() {
+		if (telemetryThread != NULL) {
+			if (telemetryThread->shutdownAndWait() == true) {
+				delete telemetryThread;
+			}
+			telemetryThread = NULL;
+		}
+	}
+
 	ServerInterface::~ServerInterface() {
 		//printf("===> Destructor for ServerInterface\n");
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__);
 
 		masterController.clearSlaves(true);
 		exitServer = true;
+		shutdownSlotReactorThread();
+		shutdownTelemetryThread();
 		for (int index = 0; index < GameConstants::maxPlayers; ++index) {
 			if (slots[index] != NULL) {
 				MutexSafeWrapper safeMutex(slotAccessorMutexes[index], CODE_AT_LINE_X(index));
@@ -1257,9 +1331,177 @@ namespace Game {
 		}
 	}
 
+	void ServerInterface::beginSlotSendBatches() {
+		if (networkSendBatchingEnabled == false || gameHasBeenInitiated == false) {
+			return;
+		}
+		for (int index = 0; exitServer == false && index < GameConstants::maxPlayers; ++index) {
+			MutexSafeWrapper safeMutexSlot(slotAccessorMutexes[index], CODE_AT_LINE_X(index));
+			ConnectionSlot *connectionSlot = slots[index];
+			if (connectionSlot != NULL && connectionSlot->isConnected() == true) {
+				Socket *socket = connectionSlot->getSocket();
+				if (socket != NULL) {
+					socket->beginSendBatch();
+				}
+			}
+		}
+	}
+
+	void ServerInterface::flushSlotSendBatches() {
+		if (networkSendBatchingEnabled == false) {
+			return;
+		}
+		// Flush every slot, even ones that dropped since the batch began so
+		// nothing stays queued on the socket
+		for (int index = 0; index < GameConstants::maxPlayers; ++index) {
+			MutexSafeWrapper safeMutexSlot(slotAccessorMutexes[index], CODE_AT_LINE_X(index));
+			ConnectionSlot *connectionSlot = slots[index];
+			if (connectionSlot != NULL) {
+				Socket *socket = connectionSlot->getSocket();
+				if (socket != NULL && socket->isSendBatchEnabled() == true) {
+					int flushedBytes = socket->flushSendBatch();
+					if (NetworkTelemetry::isEnabled() == true) {
+						NetworkTelemetry::recordSendQueue(index, max(flushedBytes, 0));
+					}
+					// A failed flush leaves the client with a stream cut part way
+					// through a message, it can not recover from that
+					if (flushedBytes < 0) {
+						if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] send batch flush failed for slot# %d, dropping it\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, index);
+						connectionSlot->close();
+					}
+				}
+			}
+		}
+	}
+
+	void ServerInterface::updateSlotTelemetry() {
+		for (int index = 0; index < GameConstants::maxPlayers; ++index) {
+			MutexSafeWrapper safeMutexSlot(slotAccessorMutexes[index], CODE_AT_LINE_X(index));
+			ConnectionSlot *connectionSlot = slots[index];
+			Socket *socket = (connectionSlot != NULL && connectionSlot->isConnected() == true ? connectionSlot->getSocket() : NULL);
+			if (socket == NULL) {
+				NetworkTelemetry::updateSlot(index, NULL, "", "", 0);
+				continue;
+			}
+
+			int framesBehind = 0;
+			if (gameHasBeenInitiated == true) {
+				framesBehind = max(0, this->getCurrentFrameCount() - connectionSlot->getCurrentFrameCount());
+			}
+			NetworkTelemetry::updateSlot(index, socket, connectionSlot->getName(), socket->getIpAddress(), framesBehind);
+		}
+	}
+
+	void ServerInterface::sendSlotPingProbes() {
+		if (adaptiveNetworkFramePeriodEnabled == false || gameHasBeenInitiated == false) {
+			return;
+		}
+
+		const int64 PING_PROBE_INTERVAL_MILLISECONDS = 1000;
+		// A probe whose echo never came back is replaced after this long
+		const int64 PING_PROBE_TIMEOUT_MILLISECONDS = 5000;
+
+		int64 now = Chrono::getCurMillis();
+		for (int index = 0; exitServer == false && index < GameConstants::maxPlayers; ++index) {
+			MutexSafeWrapper safeMutexSlot(slotAccessorMutexes[index], CODE_AT_LINE_X(index));
+			ConnectionSlot *connectionSlot = slots[index];
+			if (connectionSlot != NULL && connectionSlot->isConnected() == true &&
+				connectionSlot->getConnectHasHandshaked() == true &&
+				(connectionSlot->getProtocolFeatures() & npfAdaptiveFramePeriod) != 0) {
+
+				int64 elapsed = now - connectionSlot->getLastPingProbeTime();
+				if ((connectionSlot->getPingProbePending() == false && elapsed >= PING_PROBE_INTERVAL_MILLISECONDS) ||
+					elapsed >= PING_PROBE_TIMEOUT_MILLISECONDS) {
+					connectionSlot->sendPingProbe();
+				}
+			}
+		}
+	}
+
+	int ServerInterface::calculateAdaptiveNetworkFramePeriod() {
+		if (adaptiveNetworkFramePeriodEnabled == false || gameHasBeenInitiated == false) {
+			return 0;
+		}
+
+		int64 worstDelayMillis = -1;
+		for (int index = 0; exitServer == false && index < GameConstants::maxPlayers; ++index) {
+			MutexSafeWrapper safeMutexSlot(slotAccessorMutexes[index], CODE_AT_LINE_X(index));
+			ConnectionSlot *connectionSlot = slots[index];
+			if (connectionSlot != NULL && connectionSlot->isConnected() == true &&
+				connectionSlot->getConnectHasHandshaked() == true) {
+				// Every client has to follow a change, or none may happen
+				if ((connectionSlot->getProtocolFeatures() & npfAdaptiveFramePeriod) == 0 ||
+					connectionSlot->getHasRoundTripSample() == false) {
+					return 0;
+				}
+				worstDelayMillis = max(worstDelayMillis, connectionSlot->getRoundTripDelayMillis());
+			}
+		}
+		if (worstDelayMillis < 0) {
+			return 0;
+		}
+
+		// Commands from the slowest client must reach us and come back
+		// before the keyframe that carries them is due
+		const int64 frameMillis = max(1, 1000 / GameConstants::updateFps);
+		int targetPeriod = (int) ((worstDelayMillis + frameMillis - 1) / frameMillis) + 1;
+		targetPeriod = max(minAdaptiveNetworkFramePeriod, min(maxAdaptiveNetworkFramePeriod, targetPeriod));
+
+		int currentPeriod = gameSettings.getNetworkFramePeriod();
+		if (targetPeriod == currentPeriod) {
+			return 0;
+		}
+
+		// Grow at once to stop stalls but only shrink once the links have
+		// stayed faster for a while, so jitter does not flip the period
+		const int64 MIN_SHRINK_INTERVAL_MILLISECONDS = 5000;
+		int64 now = Chrono::getCurMillis();
+		if (targetPeriod < currentPeriod &&
+			(currentPeriod - targetPeriod < 2 ||
+				now - lastNetworkFramePeriodChangeTime < MIN_SHRINK_INTERVAL_MILLISECONDS)) {
+			return 0;
+		}
+		lastNetworkFramePeriodChangeTime = now;
+
+		if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] worstDelayMillis = %lld, network frame period changes from %d to %d\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, (long long int) worstDelayMillis, currentPeriod, targetPeriod);
+		return targetPeriod;
+	}
+
+	void ServerInterface::applyNetworkFramePeriod(int networkFramePeriod) {
+		networkFramePeriodChange = networkFramePeriod;
+		gameSettings.setNetworkFramePeriod(networkFramePeriod);
+		for (int index = 0; index < GameConstants::maxPlayers; ++index) {
+			MutexSafeWrapper safeMutexSlot(slotAccessorMutexes[index], CODE_AT_LINE_X(index));
+			ConnectionSlot *connectionSlot = slots[index];
+			if (connectionSlot != NULL) {
+				connectionSlot->getGameSettingsPtr()->setNetworkFramePeriod(networkFramePeriod);
+			}
+		}
+	}
+
 	void ServerInterface::executeNetworkCommandsFromClients() {
 		if (gameHasBeenInitiated == true) {
+			// With the reactor only slots that actually received data
+			// can have pending commands
+			bool slotSignalled[GameConstants::maxPlayers];
+			bool checkAllSlots = (slotReactorThread == NULL ||
+				slotReactorThread->getSignalledSlotQueueOverflow(true) == true);
+			for (int index = 0; index < GameConstants::maxPlayers; ++index) {
+				slotSignalled[index] = checkAllSlots;
+			}
+			if (slotReactorThread != NULL) {
+				int slotIndex = -1;
+				while (slotReactorThread->popSignalledSlot(slotIndex) == true) {
+					if (slotIndex >= 0 && slotIndex < GameConstants::maxPlayers) {
+						slotSignalled[slotIndex] = true;
+					}
+				}
+			}
+
 			for (int index = 0; exitServer == false && index < GameConstants::maxPlayers; ++index) {
+				if (slotSignalled[index] == false) {
+					continue;
+				}
 				MutexSafeWrapper safeMutexSlot(slotAccessorMutexes[index], CODE_AT_LINE_X(index));
 				ConnectionSlot* connectionSlot = slots[index];
 				if (connectionSlot != NULL && connectionSlot->isConnected() == true) {
@@ -1469,6 +1711,13 @@ namespace Game {
 		//printf("\nServerInterface::update -- A\n");
 
 		std::vector <string> errorMsgList;
+		NetworkTelemetryScopeTimer telemetryTimer(-1);
+		if (NetworkTelemetry::isEnabled() == true) {
+			updateSlotTelemetry();
+		}
+
+		// Everything sent to a client during this update goes out in one write
+		beginSlotSendBatches();
 		try {
 			// The first thing we will do is check all clients to ensure they have
 			// properly identified themselves within the alloted time period
@@ -1642,6 +1891,7 @@ namespace Game {
 			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] error detected [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, ex.what());
 			errorMsgList.push_back(ex.what());
 		}
+		flushSlotSendBatches();
 
 		if (errorMsgList.empty() == false) {
 			for (int iErrIdx = 0; iErrIdx < (int) errorMsgList.size(); ++iErrIdx) {
@@ -1673,7 +1923,10 @@ namespace Game {
 			}
 		}
 
+		beginSlotSendBatches();
 		try {
+			sendSlotPingProbes();
+
 			// Possible cause of out of synch since we have more commands that need
 			// to be sent in this frame
 			if (requestedCommands.empty() == false) {
@@ -1716,6 +1969,14 @@ namespace Game {
 					lastBroadcastCommandsTimer.reset();
 					lastBroadcastCommandsTimer.start();
 				}
+
+				// Both sides switch right after this frame, clients once they
+				// consume it, so the keyframes stay in lockstep
+				int networkFramePeriod = calculateAdaptiveNetworkFramePeriod();
+				if (networkFramePeriod > 0) {
+					networkMessageCommandList.setNetworkFramePeriod(networkFramePeriod);
+					applyNetworkFramePeriod(networkFramePeriod);
+				}
 				broadcastMessage(&networkMessageCommandList);
 			}
 		} catch (const exception &ex) {
@@ -1723,6 +1984,7 @@ namespace Game {
 			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] error detected [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, ex.what());
 			DisplayErrorMessage(ex.what());
 		}
+		flushSlotSendBatches();
 	}
 
 	bool ServerInterface::shouldDiscardNetworkMessage(NetworkMessageType networkMessageType,
@@ -2422,6 +2684,12 @@ namespace Game {
 			delete ftpServer;
 			ftpServer = NULL;
 		}
+		if (contentTransferServer != NULL) {
+			if (contentTransferServer->shutdownAndWait() == true) {
+				delete contentTransferServer;
+			}
+			contentTransferServer = NULL;
+		}
 	}
 
 	void ServerInterface::checkListenerSlots() {
@@ -2517,6 +2785,11 @@ namespace Game {
 				safeMutexSlotBroadCastAccessor.ReleaseLock(true);
 			}
 
+			// Serialize once for the first slot and replay the bytes for the rest
+			if (networkSendBatchingEnabled == true) {
+				networkMessage->beginSharedSend();
+			}
+
 			for (int slotIndex = 0; exitServer == false && slotIndex < GameConstants::maxPlayers; ++slotIndex) {
 				MutexSafeWrapper safeMutexSlot(NULL, CODE_AT_LINE_X(slotIndex));
 				if (slotIndex != lockedSlotIndex) {
@@ -2554,6 +2827,8 @@ namespace Game {
 				}
 			}
 
+			networkMessage->endSharedSend();
+
 			safeMutexSlotBroadCastAccessor.Lock();
 
 			inBroadcastMessage = false;
@@ -2562,6 +2837,7 @@ namespace Game {
 		} catch (const exception &ex) {
 			SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, ex.what());
 			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] ERROR [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, ex.what());
+			networkMessage->endSharedSend();
 
 			MutexSafeWrapper safeMutexSlotBroadCastAccessor(inBroadcastMessageThreadAccessor, CODE_AT_LINE);
 			inBroadcastMessage = false;
@@ -2919,6 +3195,17 @@ namespace Game {
 		*gameStats = *stats;
 	}
 
+	void ServerInterface::setupTask(BaseThread *callingThread, void *userdata) {
+		CURL *handle = SystemFlags::initHTTP();
+		callingThread->setGenericData<CURL>(handle);
+	}
+
+	void ServerInterface::shutdownTask(BaseThread *callingThread, void *userdata) {
+		CURL *handle = callingThread->getGenericData<CURL>();
+		SystemFlags::cleanupHTTP(&handle);
+		callingThread->setGenericData<CURL>(NULL);
+	}
+
 	void ServerInterface::simpleTask(BaseThread *callingThread, void *userdata) {
 		MutexSafeWrapper safeMutex(masterServerThreadAccessor, CODE_AT_LINE);
 
@@ -2939,7 +3226,13 @@ namespace Game {
 
 						std::map<string, string> newPublishToServerInfo = publishToMasterserver();
 
-						CURL *handle = SystemFlags::initHTTP();
+						// The publish thread keeps its handle so the masterserver
+						// connection is reused between heartbeats
+						CURL *handle = (callingThread != NULL ? callingThread->getGenericData<CURL>() : NULL);
+						bool ownsHandle = (handle == NULL);
+						if (ownsHandle == true) {
+							handle = SystemFlags::initHTTP();
+						}
 						for (std::map<string, string>::const_iterator iterMap = newPublishToServerInfo.begin();
 							iterMap != newPublishToServerInfo.end(); ++iterMap) {
 
@@ -2954,11 +3247,6 @@ namespace Game {
 
 						if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line %d] the request is:\n%s\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, request.c_str());
 
-						if (SystemFlags::VERBOSE_MODE_ENABLED) printf("Calling masterserver [%s]...\n", request.c_str());
-
-						std::string serverInfo = SystemFlags::getHTTP(request, handle);
-						//printf("Result:\n%s\n",serverInfo .c_str());
-
 						string requestStats = Config::getInstance().getString("Masterserver");
 						if (requestStats != "") {
 							endPathWithSlash(requestStats, false);
@@ -2966,16 +3254,26 @@ namespace Game {
 						requestStats += "addGameStats.php?";
 
 						std::map<string, string> newPublishToServerInfoStats = publishToMasterserverStats();
-						if (newPublishToServerInfoStats.empty() == false) {
-							for (std::map<string, string>::const_iterator iterMap = newPublishToServerInfoStats.begin();
-								iterMap != newPublishToServerInfoStats.end(); ++iterMap) {
-
-								requestStats += iterMap->first;
-								requestStats += "=";
-								requestStats += SystemFlags::escapeURL(iterMap->second, handle);
-								requestStats += "&";
-							}
+						for (std::map<string, string>::const_iterator iterMap = newPublishToServerInfoStats.begin();
+							iterMap != newPublishToServerInfoStats.end(); ++iterMap) {
+
+							requestStats += iterMap->first;
+							requestStats += "=";
+							requestStats += SystemFlags::escapeURL(iterMap->second, handle);
+							requestStats += "&";
+						}
+
+						// Both requests are built, the masterserver round trips must
+						// not hold up launching or shutting down the server
+						safeMutex.ReleaseLock(true);
+
+						if (SystemFlags::VERBOSE_MODE_ENABLED) printf("Calling masterserver [%s]...\n", request.c_str());
 
+						std::string serverInfo = SystemFlags::getHTTP(request, handle);
+						//printf("Result:\n%s\n",serverInfo .c_str());
+
+						if (newPublishToServerInfoStats.empty() == false &&
+							(callingThread == NULL || callingThread->getQuitStatus() == false)) {
 							//printf("The Host stats request is:\n%s\n",requestStats.c_str());
 							if (SystemFlags::VERBOSE_MODE_ENABLED) printf("The Host request is:\n%s\n", requestStats.c_str());
 							if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line %d] the request is:\n%s\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, requestStats.c_str());
@@ -2987,7 +3285,10 @@ namespace Game {
 							if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line %d] the result is:\n'%s'\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, serverInfoStats.c_str());
 						}
 
-						SystemFlags::cleanupHTTP(&handle);
+						if (ownsHandle == true) {
+							SystemFlags::cleanupHTTP(&handle);
+						}
+						safeMutex.Lock();
 
 						if (SystemFlags::VERBOSE_MODE_ENABLED) printf("Done Calling masterserver\n");
 
@@ -38,6 +38,7 @@ using Shared::Platform::ServerSocket;
 namespace Shared {
 	namespace PlatformCommon {
 		class FTPServerThread;
+		class ContentTransferServerThread;
 	}
 }
 
@@ -60,6 +61,7 @@ namespace Game {
 	const int MAX_EMPTY_NETWORK_COMMAND_LIST_BROADCAST_INTERVAL_MILLISECONDS = 4000;
 
 	class Stats;
+	class NetworkTelemetryThread;
 	// =====================================================
 	//	class ServerInterface
 	// =====================================================
@@ -95,11 +97,19 @@ namespace Game {
 		time_t lastGlobalLagCheckTime;
 
 		SimpleTaskThread *publishToMasterserverThread;
+		ConnectionSlotReactorThread *slotReactorThread;
+		bool networkSendBatchingEnabled;
+		bool adaptiveNetworkFramePeriodEnabled;
+		int minAdaptiveNetworkFramePeriod;
+		int maxAdaptiveNetworkFramePeriod;
+		int64 lastNetworkFramePeriodChangeTime;
 		Mutex *masterServerThreadAccessor;
 		time_t lastMasterserverHeartbeatTime;
 		bool needToRepublishToMasterserver;
 
 		::Shared::PlatformCommon::FTPServerThread *ftpServer;
+		::Shared::PlatformCommon::ContentTransferServerThread *contentTransferServer;
+		NetworkTelemetryThread *telemetryThread;
 		bool exitServer;
 		int64 nextEventId;
 
@@ -161,6 +171,9 @@ namespace Game {
 		virtual bool getAllowInGameConnections() const {
 			return allowInGameConnections;
 		}
+		virtual bool getNetworkReactorEnabled() const {
+			return slotReactorThread != NULL;
+		}
 		void setAllowInGameConnections(bool value) {
 			allowInGameConnections = value;
 		}
@@ -283,6 +296,8 @@ namespace Game {
 		}
 
 		virtual void simpleTask(BaseThread *callingThread, void *userdata);
+		virtual void setupTask(BaseThread *callingThread, void *userdata);
+		virtual void shutdownTask(BaseThread *callingThread, void *userdata);
 		void addClientToServerIPAddress(uint32 clientIp, uint32 ServerIp);
 		virtual int isValidClientType(uint32 clientIp);
 		virtual int isClientAllowedToGetFile(uint32 clientIp, const char *username, const char *filename);
@@ -332,6 +347,16 @@ namespace Game {
 		void dispatchPendingHighlightCellMessages(std::vector <string> &errorMsgList);
 
 		void shutdownMasterserverPublishThread();
+		void shutdownSlotReactorThread();
+		void shutdownTelemetryThread();
+		void updateSlotTelemetry();
+
+		void beginSlotSendBatches();
+		void flushSlotSendBatches();
+
+		void sendSlotPingProbes();
+		int calculateAdaptiveNetworkFramePeriod();
+		void applyNetworkFramePeriod(int networkFramePeriod);
 
 
 	};
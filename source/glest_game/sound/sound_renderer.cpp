@@ -22,6 +22,7 @@
 #include "core_data.h"
 #include "config.h"
 #include "sound_interface.h"
+#include "sound_cache.h"
 #include "factory_repository.h"
 #include "util.h"
 #include "leak_dumper.h"
@@ -282,6 +283,13 @@ namespace Game {
 		fxVolume = config.getInt("SoundVolumeFx") / 100.f;
 		musicVolume = config.getInt("SoundVolumeMusic") / 100.f;
 		ambientVolume = config.getInt("SoundVolumeAmbient") / 100.f;
+
+		// Decoded sounds no unit type references any more are kept up to this
+		SoundCache::setMaxUnusedBytes((uint64) config.getInt("SoundCacheUnusedMB", "32") * 1024 * 1024);
+	}
+
+	string SoundRenderer::getSoundCacheStats() const {
+		return SoundCache::getStats();
 	}
 
 } //end namespace
@@ -95,6 +95,7 @@ namespace Game {
 		//misc
 		void stopAllSounds(int64 fadeOff = 0);
 		void loadConfig();
+		string getSoundCacheStats() const;
 
 		bool wasInitOk() const;
 
@@ -894,6 +894,7 @@ namespace Game {
 	void Unit::setType(const UnitType * newType) {
 		this->faction->notifyUnitTypeChange(this, newType);
 		this->type = newType;
+		newType->loadAssets();
 	}
 
 	void Unit::setAlive(bool value) {
@@ -2115,6 +2116,15 @@ namespace Game {
 			throw game_runtime_error("command->getCommandType() == NULL");
 		}
 
+		// Have the models ready before the produced unit shows up
+		const UnitType *producedType = command->getUnitType();
+		if (producedType == NULL) {
+			producedType = dynamic_cast<const UnitType *>(command->getCommandType()->getProduced());
+		}
+		if (producedType != NULL) {
+			producedType->loadAssets();
+		}
+
 		const int command_priority = command->getPriority();
 
 		if (SystemFlags::
@@ -70,7 +70,7 @@ namespace Game {
 		string currentPath = dir;
 		endPathWithSlash(currentPath);
 		if (image) {
-			image->load(imageNode->getAttribute("path")->
+			Renderer::getInstance().loadTexture2DAsync(rsGame, image, imageNode->getAttribute("path")->
 				getRestrictedValue(currentPath));
 		}
 		loadedFileList[imageNode->getAttribute("path")->
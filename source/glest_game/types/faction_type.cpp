@@ -28,6 +28,7 @@
 #include "platform_util.h"
 #include "game_util.h"
 #include "conversion.h"
+#include "xml_preloader.h"
 #include "leak_dumper.h"
 
 using namespace Shared::Util;
@@ -204,6 +205,35 @@ namespace Game {
 				SDL_PumpEvents();
 			}
 
+			// a3) read and parse the unit and upgrade files in parallel, the
+			// loading below stays serial and takes the parsed trees in order
+			XmlPreloader xmlPreloader;
+			xmlPreloader.setCache(techTree->getXmlCache());
+			std::map < string, string > mapUnitTagReplacementValues;
+			mapUnitTagReplacementValues["$COMMONDATAPATH"] =
+				techTreePath + "/commondata/";
+			mapUnitTagReplacementValues =
+				Properties::getTagReplacementValues(&mapUnitTagReplacementValues);
+			for (int i = 0; i < (int) unitTypes.size(); ++i) {
+				string unitPath = currentPath + "units/" + unitTypes[i].getName();
+				endPathWithSlash(unitPath);
+				xmlPreloader.add(unitPath + unitTypes[i].getName() + ".xml",
+					mapUnitTagReplacementValues);
+			}
+			std::map < string, string > mapUpgradeTagReplacementValues;
+			mapUpgradeTagReplacementValues["$COMMONDATAPATH"] =
+				techTree->getPath() + "/commondata/";
+			mapUpgradeTagReplacementValues =
+				Properties::getTagReplacementValues(&mapUpgradeTagReplacementValues);
+			for (int i = 0; i < (int) upgradeTypes.size(); ++i) {
+				string upgradePath =
+					currentPath + "upgrades/" + upgradeTypes[i].getName();
+				endPathWithSlash(upgradePath);
+				xmlPreloader.add(upgradePath + upgradeTypes[i].getName() + ".xml",
+					mapUpgradeTagReplacementValues);
+			}
+			xmlPreloader.loadAll();
+
 			// b1) load units
 			try {
 				Logger & logger = Logger::getInstance();
@@ -214,7 +244,7 @@ namespace Game {
 					try {
 						unitTypes[i].loadUnit(i, str, techTree, techTreePath, this,
 							checksum, techtreeChecksum, loadedFileList,
-							validationMode);
+							validationMode, &xmlPreloader);
 						logger.setProgress(progressBaseValue +
 							(int) ((((double) i +
 								1.0) /
@@ -262,7 +292,7 @@ namespace Game {
 					try {
 						upgradeTypes[i].load(str, techTree, this, checksum,
 							techtreeChecksum, loadedFileList,
-							validationMode);
+							validationMode, &xmlPreloader);
 					} catch (game_runtime_error & ex) {
 						if (validationMode == false) {
 							throw;
@@ -419,7 +449,7 @@ namespace Game {
 						healthbarTexture =
 							Renderer::getInstance().newTexture2D(rsGame);
 						if (healthbarTexture) {
-							healthbarTexture->load(healthbarNode->
+							Renderer::getInstance().loadTexture2DAsync(rsGame, healthbarTexture, healthbarNode->
 								getChild("borderTexture")->
 								getAttribute("path")->
 								getRestrictedValue(currentPath));
@@ -443,7 +473,7 @@ namespace Game {
 						healthbarBackgroundTexture =
 							Renderer::getInstance().newTexture2D(rsGame);
 						if (healthbarBackgroundTexture) {
-							healthbarBackgroundTexture->load(healthbarNode->
+							Renderer::getInstance().loadTexture2DAsync(rsGame, healthbarBackgroundTexture, healthbarNode->
 								getChild
 								("backgroundTexture")->
 								getAttribute("path")->
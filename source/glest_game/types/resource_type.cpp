@@ -111,7 +111,7 @@ namespace Game {
 			const XmlNode *imageNode = resourceNode->getChild("image");
 			image = renderer.newTexture2D(rsGame);
 			if (image) {
-				image->load(imageNode->getAttribute("path")->
+				renderer.loadTexture2DAsync(rsGame, image, imageNode->getAttribute("path")->
 					getRestrictedValue(currentPath));
 			}
 			loadedFileList[imageNode->getAttribute("path")->
@@ -31,6 +31,7 @@
 #include "projectile_type.h"
 #include "tech_tree.h"
 #include "faction_type.h"
+#include "config.h"
 #include "leak_dumper.h"
 
 using namespace Shared::Util;
@@ -541,6 +542,12 @@ namespace Game {
 		}
 
 		if (sn->hasChild("animation") == true) {
+			// Deferred models are loaded once a unit of this type exists or
+			// starts being produced, see UnitType::loadAssets. Validation
+			// needs every file the models reference
+			bool deferModelLoading =
+				Config::getInstance().getBool("DeferUnitModelLoading", "true") == true
+				&& tt->getIsValidationModeEnabled() == false;
 			//string path= sn->getChild("animation")->getAttribute("path")->getRestrictedValue(currentPath);
 			vector < XmlNode * >animationList = sn->getChildList("animation");
 			for (unsigned int i = 0; i < animationList.size(); ++i) {
@@ -548,10 +555,13 @@ namespace Game {
 					animationList[i]->getAttribute("path")->
 					getRestrictedValue(currentPath);
 				if (fileExists(path) == true) {
-					Model *animation =
-						Renderer::getInstance().newModel(rsGame, path, false,
-							&loadedFileList,
-							&parentLoader);
+					Model *animation = NULL;
+					if (deferModelLoading == false) {
+						animation =
+							Renderer::getInstance().newModel(rsGame, path, false,
+								&loadedFileList,
+								&parentLoader);
+					}
 					loadedFileList[path].
 						push_back(make_pair
 						(parentLoader,
@@ -559,6 +569,7 @@ namespace Game {
 							getRestrictedValue()));
 
 					animations.push_back(animation);
+					animationPaths.push_back(path);
 					//printf("**FOUND ANIMATION [%s]\n",path.c_str());
 
 					AnimationAttributes animationAttributeList;
@@ -876,9 +887,23 @@ namespace Game {
 		}
 
 		//printf("!!RETURN ANIMATION [%d / %d]\n",modelIndex,animations.size()-1);
+		if (animations[modelIndex] == NULL) {
+			animations[modelIndex] =
+				Renderer::getInstance().newModel(rsGame,
+					animationPaths[modelIndex]);
+		}
 		return animations[modelIndex];
 	}
 
+	void SkillType::loadAnimations() const {
+		for (unsigned int i = 0; i < animations.size(); ++i) {
+			if (animations[i] == NULL) {
+				animations[i] =
+					Renderer::getInstance().newModel(rsGame, animationPaths[i]);
+			}
+		}
+	}
+
 	string SkillType::skillClassToStr(SkillClass skillClass) {
 		switch (skillClass) {
 			case scStop:
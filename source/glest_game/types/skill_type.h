@@ -202,7 +202,9 @@ namespace Game {
 
 
 		int animationRandomCycleMaxcount;
-		vector < Model * >animations;
+		// With DeferUnitModelLoading the models stay NULL until first used
+		mutable vector < Model * >animations;
+		vector < string >animationPaths;
 		vector < AnimationAttributes > animationAttributes;
 
 		SkillSoundList skillSoundList;
@@ -247,6 +249,7 @@ namespace Game {
 		int getAnimationCount() const {
 			return (int) animations.size();
 		}
+		void loadAnimations() const;
 
 		//get
 		const string & getName() const {
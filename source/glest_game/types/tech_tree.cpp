@@ -30,6 +30,7 @@
 #include "game_util.h"
 #include "window.h"
 #include "common_scoped_ptr.h"
+#include "tech_tree_cache.h"
 #include "leak_dumper.h"
 
 using namespace Shared::Util;
@@ -55,6 +56,7 @@ namespace Game {
 		translatedTechFactionNames.clear();
 		languageUsedForCache = "";
 		isValidationModeEnabled = false;
+		xmlCache = NULL;
 	}
 
 	string TechTree::getNameUntranslated() const {
@@ -406,6 +408,15 @@ namespace Game {
 		sleep(0);
 		//SDL_PumpEvents();
 
+		// Parsed unit and upgrade files come from the binary cache while
+		// their files are unchanged, see XmlPreloader
+		auto_ptr < TechTreeCache > xmlCacheOwner(TechTreeCache::isEnabled() == true ?
+			new TechTreeCache() : NULL);
+		if (xmlCacheOwner.get() != NULL) {
+			xmlCacheOwner->open(treePath);
+		}
+		xmlCache = xmlCacheOwner.get();
+
 		//load factions
 		try {
 			factionTypes.resize(factions.size());
@@ -439,7 +450,13 @@ namespace Game {
 				Window::handleEvent();
 				SDL_PumpEvents();
 			}
+
+			xmlCache = NULL;
+			if (xmlCacheOwner.get() != NULL) {
+				xmlCacheOwner->save();
+			}
 		} catch (game_runtime_error & ex) {
+			xmlCache = NULL;
 			SystemFlags::OutputDebug(SystemFlags::debugError,
 				"In [%s::%s Line: %d] Error [%s]\n",
 				extractFileFromDirectoryPath(__FILE__).
@@ -450,6 +467,7 @@ namespace Game {
 				ex.what(), !ex.wantStackTrace()
 				|| isValidationModeEnabled);
 		} catch (const exception & e) {
+			xmlCache = NULL;
 			SystemFlags::OutputDebug(SystemFlags::debugError,
 				"In [%s::%s Line: %d] Error [%s]\n",
 				extractFileFromDirectoryPath(__FILE__).
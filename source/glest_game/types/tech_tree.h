@@ -33,6 +33,9 @@
 #include "leak_dumper.h"
 
 namespace Game {
+
+	class TechTreeCache;
+
 	// =====================================================
 	//      class TechTree
 	//
@@ -65,6 +68,8 @@ namespace Game {
 		std::map < string, std::map < string,
 			string > >translatedTechFactionNames;
 		bool isValidationModeEnabled;
+		// Only set while the factions load
+		TechTreeCache *xmlCache;
 
 	public:
 		Checksum loadTech(const string & techName,
@@ -88,6 +93,12 @@ namespace Game {
 		Checksum *getChecksumValue() {
 			return &checksumValue;
 		}
+		TechTreeCache *getXmlCache() const {
+			return xmlCache;
+		}
+		bool getIsValidationModeEnabled() const {
+			return isValidationModeEnabled;
+		}
 
 		//get
 		int getResourceTypeCount() const {
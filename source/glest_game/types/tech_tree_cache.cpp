@@ -0,0 +1,311 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+
+#include "tech_tree_cache.h"
+
+#include "checksum.h"
+#include "config.h"
+#include "conversion.h"
+#include "platform_common.h"
+#include "platform_util.h"
+#include "util.h"
+#include "virtual_file_system.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "leak_dumper.h"
+
+using namespace Shared::Util;
+using namespace Shared::Platform;
+using namespace Shared::PlatformCommon;
+
+namespace Game {
+
+	// File layout, all numbers little endian uint32 (64 bit values as
+	// low and high half):
+	//   magic, version, tech tree path size and path, entry count, then
+	//   per entry the path size, path, file modification time, file size,
+	//   data size and the binary xml of the file
+	static const char techTreeCacheMagic[4] = { 'Z', 'G', 'T', 'C' };
+	static const char techTreeCacheVersion = 2;
+
+	static void writeTechTreeCacheUInt32(vector<char> &buffer, uint32 value) {
+		for (int i = 0; i < 4; ++i) {
+			buffer.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+		}
+	}
+
+	static void writeTechTreeCacheInt64(vector<char> &buffer, int64 value) {
+		writeTechTreeCacheUInt32(buffer, (uint32) ((uint64) value & 0xFFFFFFFF));
+		writeTechTreeCacheUInt32(buffer, (uint32) ((uint64) value >> 32));
+	}
+
+	static void writeTechTreeCacheString(vector<char> &buffer, const string &value) {
+		writeTechTreeCacheUInt32(buffer, (uint32) value.size());
+		buffer.insert(buffer.end(), value.begin(), value.end());
+	}
+
+	static uint32 readTechTreeCacheUInt32(const vector<char> &buffer, size_t &offset) {
+		if (buffer.size() - offset < 4) {
+			throw game_runtime_error("Error reading tech tree cache, truncated data");
+		}
+		const unsigned char *data = reinterpret_cast<const unsigned char *>(&buffer[offset]);
+		offset += 4;
+		return (uint32) data[0] | ((uint32) data[1] << 8) | ((uint32) data[2] << 16) | ((uint32) data[3] << 24);
+	}
+
+	static int64 readTechTreeCacheInt64(const vector<char> &buffer, size_t &offset) {
+		uint64 low = readTechTreeCacheUInt32(buffer, offset);
+		uint64 high = readTechTreeCacheUInt32(buffer, offset);
+		return (int64) (low | (high << 32));
+	}
+
+	static void readTechTreeCacheBytes(const vector<char> &buffer, size_t &offset, uint32 size, const char *&data) {
+		if (buffer.size() - offset < size) {
+			throw game_runtime_error("Error reading tech tree cache, truncated data");
+		}
+		data = (size > 0 ? &buffer[offset] : NULL);
+		offset += size;
+	}
+
+	// =====================================================
+	//	class TechTreeCache
+	// =====================================================
+
+	TechTreeCache::TechTreeCache() {
+		mutexEntries = new Mutex(CODE_AT_LINE);
+		changed = false;
+	}
+
+	TechTreeCache::~TechTreeCache() {
+		delete mutexEntries;
+		mutexEntries = NULL;
+	}
+
+	bool TechTreeCache::isEnabled() {
+		return Config::getInstance().getBool("TechTreeCache", "true") == true &&
+			getCRCCacheFilePath() != "";
+	}
+
+	void TechTreeCache::open(const string &techTreePath) {
+		this->techTreePath = techTreePath;
+		endPathWithSlash(this->techTreePath);
+
+		Checksum pathChecksum;
+		pathChecksum.addString(this->techTreePath);
+		cacheFile = getCRCCacheFilePath() + "techtree_" + lastDir(this->techTreePath) +
+			"_" + uIntToStr(pathChecksum.getSum()) + ".cache";
+
+		MutexSafeWrapper safeMutex(mutexEntries, CODE_AT_LINE);
+		entryList.clear();
+		changed = false;
+		safeMutex.ReleaseLock();
+
+		Chrono chrono;
+		chrono.start();
+		bool valid = false;
+		try {
+			valid = readFile();
+		} catch (const exception &ex) {
+			SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error reading [%s]: %s\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, cacheFile.c_str(), ex.what());
+		}
+		if (valid == false) {
+			// Broken, everything parsed from now on replaces it
+			safeMutex.Lock();
+			entryList.clear();
+			changed = true;
+			safeMutex.ReleaseLock();
+		}
+
+		if (SystemFlags::VERBOSE_MODE_ENABLED) printf("Tech tree cache [%s] valid = %d with %d files in %lld msecs\n", cacheFile.c_str(), valid, (int) entryList.size(), (long long int) chrono.getMillis());
+	}
+
+	bool TechTreeCache::readFile() {
+#ifdef WIN32
+		FILE *file = _wfopen(utf8_decode(cacheFile).c_str(), L"rb");
+#else
+		FILE *file = fopen(cacheFile.c_str(), "rb");
+#endif
+		if (file == NULL) {
+			return false;
+		}
+		vector<char> buffer;
+		if (fseek(file, 0, SEEK_END) == 0) {
+			long size = ftell(file);
+			if (size > 0) {
+				buffer.resize(size);
+				fseek(file, 0, SEEK_SET);
+				if (fread(&buffer[0], size, 1, file) != 1) {
+					buffer.clear();
+				}
+			}
+		}
+		fclose(file);
+
+		if (buffer.size() < sizeof(techTreeCacheMagic) + 1 ||
+			memcmp(&buffer[0], techTreeCacheMagic, sizeof(techTreeCacheMagic)) != 0 ||
+			buffer[sizeof(techTreeCacheMagic)] != techTreeCacheVersion) {
+			return false;
+		}
+		size_t offset = sizeof(techTreeCacheMagic) + 1;
+		const char *data = NULL;
+		uint32 size = readTechTreeCacheUInt32(buffer, offset);
+		readTechTreeCacheBytes(buffer, offset, size, data);
+		if (string(data != NULL ? data : "", size) != techTreePath) {
+			return false;
+		}
+
+		std::map<string, Entry> readList;
+		int staleCount = 0;
+		uint32 entryCount = readTechTreeCacheUInt32(buffer, offset);
+		for (uint32 i = 0; i < entryCount; ++i) {
+			size = readTechTreeCacheUInt32(buffer, offset);
+			readTechTreeCacheBytes(buffer, offset, size, data);
+			string path(data != NULL ? data : "", size);
+
+			int64 modificationTime = readTechTreeCacheInt64(buffer, offset);
+			int64 fileSize = readTechTreeCacheInt64(buffer, offset);
+			size = readTechTreeCacheUInt32(buffer, offset);
+			readTechTreeCacheBytes(buffer, offset, size, data);
+
+			// Edited or removed since it was cached
+			int64 currentModificationTime = 0;
+			int64 currentFileSize = 0;
+			if (getFileStamp(path, currentModificationTime, currentFileSize) == false ||
+				currentModificationTime != modificationTime || currentFileSize != fileSize) {
+				staleCount++;
+				continue;
+			}
+
+			Entry &entry = readList[path];
+			entry.modificationTime = modificationTime;
+			entry.fileSize = fileSize;
+			entry.data.assign(data, data + size);
+		}
+
+		MutexSafeWrapper safeMutex(mutexEntries, CODE_AT_LINE);
+		entryList.swap(readList);
+		if (staleCount > 0) {
+			changed = true;
+		}
+		return true;
+	}
+
+	bool TechTreeCache::getFileStamp(const string &path, int64 &modificationTime, int64 &fileSize) {
+#ifdef WIN32
+#if defined(__MINGW32__)
+		struct _stat stbuf;
+#else
+		struct _stat64i32 stbuf;
+#endif
+		int statResult = _wstat(utf8_decode(path).c_str(), &stbuf);
+#else
+		struct stat stbuf;
+		int statResult = stat(path.c_str(), &stbuf);
+#endif
+		if (statResult == 0) {
+			modificationTime = (int64) stbuf.st_mtime;
+			fileSize = (int64) stbuf.st_size;
+			return true;
+		}
+
+		// A file inside a mounted zip changes only with its archive
+		uint64 archiveSize = 0;
+		if (VirtualFileSystem::getArchiveStamp(path, modificationTime, archiveSize) == false) {
+			return false;
+		}
+		fileSize = (int64) archiveSize;
+		return true;
+	}
+
+	void TechTreeCache::save() {
+		MutexSafeWrapper safeMutex(mutexEntries, CODE_AT_LINE);
+		if (changed == false || cacheFile == "") {
+			return;
+		}
+
+		vector<char> buffer;
+		buffer.insert(buffer.end(), techTreeCacheMagic, techTreeCacheMagic + sizeof(techTreeCacheMagic));
+		buffer.push_back(techTreeCacheVersion);
+		writeTechTreeCacheString(buffer, techTreePath);
+		writeTechTreeCacheUInt32(buffer, (uint32) entryList.size());
+		for (std::map<string, Entry>::const_iterator iterMap = entryList.begin();
+			iterMap != entryList.end(); ++iterMap) {
+			writeTechTreeCacheString(buffer, iterMap->first);
+			writeTechTreeCacheInt64(buffer, iterMap->second.modificationTime);
+			writeTechTreeCacheInt64(buffer, iterMap->second.fileSize);
+			writeTechTreeCacheUInt32(buffer, (uint32) iterMap->second.data.size());
+			buffer.insert(buffer.end(), iterMap->second.data.begin(), iterMap->second.data.end());
+		}
+		changed = false;
+		safeMutex.ReleaseLock();
+
+		string tempFile = cacheFile + ".tmp";
+#ifdef WIN32
+		FILE *file = _wfopen(utf8_decode(tempFile).c_str(), L"wb");
+#else
+		FILE *file = fopen(tempFile.c_str(), "wb");
+#endif
+		if (file == NULL) {
+			SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Can not open file: [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, tempFile.c_str());
+			return;
+		}
+		bool written = (fwrite(&buffer[0], buffer.size(), 1, file) == 1);
+		fclose(file);
+		if (written == true) {
+			removeFile(cacheFile);
+			written = renameFile(tempFile, cacheFile);
+		}
+		if (written == false) {
+			SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error writing [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, cacheFile.c_str());
+			removeFile(tempFile);
+		}
+	}
+
+	bool TechTreeCache::isCacheable(const string &path) const {
+		return techTreePath != "" && StartsWith(path, techTreePath) == true;
+	}
+
+	const vector<char> * TechTreeCache::find(const string &path) {
+		MutexSafeWrapper safeMutex(mutexEntries, CODE_AT_LINE);
+		std::map<string, Entry>::const_iterator iterFind = entryList.find(path);
+		return (iterFind != entryList.end() ? &iterFind->second.data : NULL);
+	}
+
+	const vector<char> * TechTreeCache::add(const string &path, const vector<char> &buffer) {
+		// Stamped before taking the lock, a file without a stamp is never
+		// matched on the next open
+		Entry entry;
+		entry.modificationTime = -1;
+		entry.fileSize = -1;
+		getFileStamp(path, entry.modificationTime, entry.fileSize);
+
+		MutexSafeWrapper safeMutex(mutexEntries, CODE_AT_LINE);
+		std::pair<std::map<string, Entry>::iterator, bool> inserted =
+			entryList.insert(std::make_pair(path, entry));
+		if (inserted.second == true) {
+			inserted.first->second.data = buffer;
+			changed = true;
+		}
+		return &inserted.first->second.data;
+	}
+
+} //end namespace
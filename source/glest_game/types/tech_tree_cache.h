@@ -0,0 +1,88 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+
+#ifndef _TECHTREECACHE_H_
+#define _TECHTREECACHE_H_
+
+#include "data_types.h"
+#include "thread.h"
+#include <map>
+#include <string>
+#include <vector>
+#include "leak_dumper.h"
+
+using std::map;
+using std::string;
+using std::vector;
+using Shared::Platform::uint32;
+using Shared::Platform::int64;
+using Shared::Platform::Mutex;
+
+namespace Game {
+
+	// =====================================================
+	//	class TechTreeCache
+	//
+	//	Binary image of the parsed xml files of one tech tree,
+	//	kept in the user cache folder. Each entry remembers the
+	//	modification time and size of its file and is dropped on
+	//	open once they differ, so edited files get parsed again.
+	//	Files inside a mounted zip carry the stamp of the zip
+	// =====================================================
+
+	class TechTreeCache {
+	private:
+		struct Entry {
+			int64 modificationTime;
+			int64 fileSize;
+			vector<char> data;
+		};
+
+		string techTreePath;
+		string cacheFile;
+
+		Mutex *mutexEntries;
+		std::map<string, Entry> entryList;
+		bool changed;
+
+		bool readFile();
+		static bool getFileStamp(const string &path, int64 &modificationTime, int64 &fileSize);
+
+	public:
+		TechTreeCache();
+		~TechTreeCache();
+
+		static bool isEnabled();
+
+		void open(const string &techTreePath);
+		void save();
+
+		// Only files inside the tech tree folder are cached
+		bool isCacheable(const string &path) const;
+
+		// Returns the binary xml stored for the path or NULL. Entries are
+		// never changed once added so the data stays valid without the lock
+		const vector<char> * find(const string &path);
+		const vector<char> * add(const string &path, const vector<char> &buffer);
+	};
+
+} //end namespace
+
+#endif
@@ -37,6 +37,7 @@
 #include "unit_particle_type.h"
 #include "faction.h"
 #include "common_scoped_ptr.h"
+#include "xml_preloader.h"
 #include "leak_dumper.h"
 
 using namespace Shared::Xml;
@@ -201,7 +202,8 @@ namespace Game {
 		const FactionType * factionType,
 		Checksum * checksum, Checksum * techtreeChecksum,
 		std::map < string, vector < pair < string,
-		string > > >&loadedFileList, bool validationMode) {
+		string > > >&loadedFileList, bool validationMode,
+		XmlPreloader * xmlPreloader) {
 
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugSystem).
 			enabled)
@@ -232,16 +234,21 @@ namespace Game {
 			techtreeChecksum->addFile(path);
 
 			XmlTree xmlTree;
-			std::map < string, string > mapExtraTagReplacementValues;
-			mapExtraTagReplacementValues["$COMMONDATAPATH"] =
-				techTreePath + "/commondata/";
-			xmlTree.load(path,
-				Properties::
-				getTagReplacementValues
-				(&mapExtraTagReplacementValues));
+			auto_ptr < XmlTree > preloadedXmlTree(xmlPreloader != NULL ?
+				xmlPreloader->take(path) : NULL);
+			if (preloadedXmlTree.get() == NULL) {
+				std::map < string, string > mapExtraTagReplacementValues;
+				mapExtraTagReplacementValues["$COMMONDATAPATH"] =
+					techTreePath + "/commondata/";
+				xmlTree.load(path,
+					Properties::
+					getTagReplacementValues
+					(&mapExtraTagReplacementValues));
+			}
 			loadedFileList[path].push_back(make_pair(dir, dir));
 
-			const XmlNode *unitNode = xmlTree.getRootNode();
+			const XmlNode *unitNode = (preloadedXmlTree.get() != NULL ?
+				preloadedXmlTree->getRootNode() : xmlTree.getRootNode());
 			if (unitNode->hasChild("link")) {
 				XmlNode* node = unitNode->getChild("link");
 
@@ -914,7 +921,7 @@ namespace Game {
 			const XmlNode *imageNode = parametersNode->getChild("image");
 			image = Renderer::getInstance().newTexture2D(rsGame);
 			if (image) {
-				image->load(imageNode->getAttribute("path")->
+				Renderer::getInstance().loadTexture2DAsync(rsGame, image, imageNode->getAttribute("path")->
 					getRestrictedValue(currentPath));
 			}
 			loadedFileList[imageNode->getAttribute("path")->
@@ -929,7 +936,7 @@ namespace Game {
 				parametersNode->getChild("image-cancel");
 			cancelImage = Renderer::getInstance().newTexture2D(rsGame);
 			if (cancelImage) {
-				cancelImage->load(imageCancelNode->getAttribute("path")->
+				Renderer::getInstance().loadTexture2DAsync(rsGame, cancelImage, imageCancelNode->getAttribute("path")->
 					getRestrictedValue(currentPath));
 			}
 			loadedFileList[imageCancelNode->getAttribute("path")->
@@ -947,7 +954,7 @@ namespace Game {
 			if (meetingPoint) {
 				meetingPointImage = Renderer::getInstance().newTexture2D(rsGame);
 				if (meetingPointImage) {
-					meetingPointImage->load(meetingPointNode->
+					Renderer::getInstance().loadTexture2DAsync(rsGame, meetingPointImage, meetingPointNode->
 						getAttribute("image-path")->
 						getRestrictedValue(currentPath));
 				}
@@ -1202,6 +1209,12 @@ namespace Game {
 		return firstCommandTypeOfClass[commandClass];
 	}
 
+	void UnitType::loadAssets() const {
+		for (int i = 0; i < (int) skillTypes.size(); ++i) {
+			skillTypes[i]->loadAnimations();
+		}
+	}
+
 	const SkillType *UnitType::getFirstStOfClass(SkillClass skillClass) const {
 		if (firstSkillTypeOfClass[skillClass] == NULL) {
 			if (skillClass == SkillClass::scAttack)
@@ -47,6 +47,7 @@ namespace Game {
 	class TechTree;
 	class FactionType;
 	class Faction;
+	class XmlPreloader;
 
 
 	// ===============================
@@ -282,7 +283,10 @@ namespace Game {
 			const FactionType * factionType, Checksum * checksum,
 			Checksum * techtreeChecksum,
 			std::map < string, vector < pair < string,
-			string > > >&loadedFileList, bool validationMode = false);
+			string > > >&loadedFileList, bool validationMode = false,
+			XmlPreloader * xmlPreloader = NULL);
+		// Loads the skill models left out by DeferUnitModelLoading
+		void loadAssets() const;
 
 		virtual string getName(bool translatedValue = false) const;
 
@@ -34,6 +34,8 @@
 #include "renderer.h"
 #include "game_util.h"
 #include "faction.h"
+#include "xml_preloader.h"
+#include "common_scoped_ptr.h"
 #include "leak_dumper.h"
 
 using namespace Shared::Util;
@@ -1039,7 +1041,8 @@ namespace Game {
 		const FactionType * factionType,
 		Checksum * checksum, Checksum * techtreeChecksum,
 		std::map < string, vector < pair < string,
-		string > > >&loadedFileList, bool validationMode) {
+		string > > >&loadedFileList, bool validationMode,
+		XmlPreloader * xmlPreloader) {
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugSystem).
 			enabled)
 			SystemFlags::OutputDebug(SystemFlags::debugSystem,
@@ -1063,15 +1066,20 @@ namespace Game {
 			techtreeChecksum->addFile(path);
 
 			XmlTree xmlTree;
-			std::map < string, string > mapExtraTagReplacementValues;
-			mapExtraTagReplacementValues["$COMMONDATAPATH"] =
-				techTree->getPath() + "/commondata/";
-			xmlTree.load(path,
-				Properties::
-				getTagReplacementValues
-				(&mapExtraTagReplacementValues));
+			auto_ptr < XmlTree > preloadedXmlTree(xmlPreloader != NULL ?
+				xmlPreloader->take(path) : NULL);
+			if (preloadedXmlTree.get() == NULL) {
+				std::map < string, string > mapExtraTagReplacementValues;
+				mapExtraTagReplacementValues["$COMMONDATAPATH"] =
+					techTree->getPath() + "/commondata/";
+				xmlTree.load(path,
+					Properties::
+					getTagReplacementValues
+					(&mapExtraTagReplacementValues));
+			}
 			loadedFileList[path].push_back(make_pair(currentPath, currentPath));
-			const XmlNode *upgradeNode = xmlTree.getRootNode();
+			const XmlNode *upgradeNode = (preloadedXmlTree.get() != NULL ?
+				preloadedXmlTree->getRootNode() : xmlTree.getRootNode());
 
 			//image
 			image = NULL;           // Not used for upgrade types
@@ -54,6 +54,7 @@ namespace Game {
 	class MoveSkillType;
 	class ProduceSkillType;
 	class Faction;
+	class XmlPreloader;
 
 	/**
 		* Groups all information used for upgrades. Attack boosts also use this class for modifying stats.
@@ -407,12 +408,15 @@ namespace Game {
 		* as the `techtreeChecksum`).
 		* @param techtreeChecksum Cumulative checksum for the techtree. The path of loaded upgrades
 		* is added to this checksum.
+		* @param xmlPreloader If not NULL and it holds the parsed upgrade file, that tree is used
+		* instead of reading the file again.
 		*/
 		void load(const string & dir, const TechTree * techTree,
 			const FactionType * factionType, Checksum * checksum,
 			Checksum * techtreeChecksum,
 			std::map < string, vector < pair < string,
-			string > > >&loadedFileList, bool validationMode = false);
+			string > > >&loadedFileList, bool validationMode = false,
+			XmlPreloader * xmlPreloader = NULL);
 
 		/**
 		* Obtains the upgrade name.
@@ -0,0 +1,173 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+
+#include "xml_preloader.h"
+
+#include "config.h"
+#include "tech_tree_cache.h"
+#include "platform_util.h"
+#include "util.h"
+#include "leak_dumper.h"
+
+using namespace Shared::Platform;
+using namespace Shared::PlatformCommon;
+using namespace Shared::Util;
+
+namespace Game {
+
+	// =====================================================
+	//	class XmlPreloader
+	// =====================================================
+
+	XmlPreloader::XmlPreloader() {
+		cache = NULL;
+		mutexJobs = new Mutex(CODE_AT_LINE);
+		nextJob = 0;
+		finishedThreadCount = 0;
+	}
+
+	XmlPreloader::~XmlPreloader() {
+		for (unsigned int i = 0; i < jobList.size(); ++i) {
+			delete jobList[i].xmlTree;
+		}
+		jobList.clear();
+
+		delete mutexJobs;
+		mutexJobs = NULL;
+	}
+
+	void XmlPreloader::add(const string &path, const std::map<string, string> &mapTagReplacementValues) {
+		Job job;
+		job.path = path;
+		job.mapTagReplacementValues = mapTagReplacementValues;
+		job.xmlTree = NULL;
+		jobList.push_back(job);
+	}
+
+	int XmlPreloader::getThreadCount() {
+		// 0 means one thread per cpu, 1 loads everything on the calling thread
+		int threadCount = Config::getInstance().getInt("TechTreeLoadThreads", "0");
+		if (threadCount <= 0) {
+			threadCount = SDL_GetCPUCount();
+		}
+		return max(threadCount, 1);
+	}
+
+	bool XmlPreloader::runNextJob() {
+		MutexSafeWrapper safeMutex(mutexJobs, CODE_AT_LINE);
+		if (nextJob >= jobList.size()) {
+			return false;
+		}
+		Job &job = jobList[nextJob++];
+		safeMutex.ReleaseLock();
+
+		// Each tree skips the recursion check, it is shared by all threads
+		// and the files of one batch never include each other
+		XmlTree *xmlTree = new XmlTree();
+		try {
+			if (cache != NULL && cache->isCacheable(job.path) == true) {
+				const vector<char> *binary = cache->find(job.path);
+				if (binary == NULL) {
+					vector<char> buffer;
+					XmlTree::parseFileToBinary(job.path, buffer);
+					binary = cache->add(job.path, buffer);
+				}
+				xmlTree->loadFromBinary(&(*binary)[0], binary->size(), job.mapTagReplacementValues, true);
+			} else {
+				xmlTree->load(job.path, job.mapTagReplacementValues, false, true);
+			}
+		} catch (const exception &ex) {
+			if (SystemFlags::getSystemSettingType(SystemFlags::debugSystem).enabled) SystemFlags::OutputDebug(SystemFlags::debugSystem, "In [%s::%s Line: %d] Error preloading [%s]: %s\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, job.path.c_str(), ex.what());
+			delete xmlTree;
+			xmlTree = NULL;
+		}
+
+		safeMutex.Lock();
+		job.xmlTree = xmlTree;
+		return true;
+	}
+
+	void XmlPreloader::loadAll() {
+		if (jobList.empty() == true) {
+			return;
+		}
+
+		Chrono chrono;
+		chrono.start();
+
+		int threadCount = min(getThreadCount(), (int) jobList.size());
+		vector<XmlPreloaderThread *> threadList;
+		for (int i = 1; i < threadCount; ++i) {
+			XmlPreloaderThread *thread = new XmlPreloaderThread(this);
+			thread->start();
+			threadList.push_back(thread);
+		}
+
+		// The calling thread works through the list too
+		for (; runNextJob() == true;) {
+		}
+
+		for (bool done = threadList.empty(); done == false;) {
+			MutexSafeWrapper safeMutex(mutexJobs, CODE_AT_LINE);
+			done = (finishedThreadCount == (int) threadList.size());
+			safeMutex.ReleaseLock();
+			if (done == false) {
+				sleep(1);
+			}
+		}
+		for (unsigned int i = 0; i < threadList.size(); ++i) {
+			if (threadList[i]->shutdownAndWait() == true) {
+				delete threadList[i];
+			}
+		}
+
+		if (SystemFlags::VERBOSE_MODE_ENABLED) printf("Preloaded %d xml files on %d threads in %lld msecs\n", (int) jobList.size(), threadCount, (long long int) chrono.getMillis());
+	}
+
+	XmlTree * XmlPreloader::take(const string &path) {
+		for (unsigned int i = 0; i < jobList.size(); ++i) {
+			if (jobList[i].path == path) {
+				XmlTree *xmlTree = jobList[i].xmlTree;
+				jobList[i].xmlTree = NULL;
+				return xmlTree;
+			}
+		}
+		return NULL;
+	}
+
+	// =====================================================
+	//	class XmlPreloaderThread
+	// =====================================================
+
+	XmlPreloaderThread::XmlPreloaderThread(XmlPreloader *preloader) : BaseThread() {
+		this->preloader = preloader;
+		setUniqueID("XmlPreloaderThread");
+	}
+
+	void XmlPreloaderThread::execute() {
+		RunningStatusSafeWrapper runningStatus(this);
+		for (; getQuitStatus() == false && preloader->runNextJob() == true;) {
+		}
+
+		MutexSafeWrapper safeMutex(preloader->mutexJobs, CODE_AT_LINE);
+		preloader->finishedThreadCount++;
+	}
+
+} //end namespace
@@ -0,0 +1,103 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+
+#ifndef _XMLPRELOADER_H_
+#define _XMLPRELOADER_H_
+
+#include "xml_parser.h"
+#include "base_thread.h"
+#include <map>
+#include <vector>
+#include "leak_dumper.h"
+
+using std::map;
+using std::vector;
+using Shared::Xml::XmlTree;
+using Shared::PlatformCommon::BaseThread;
+using Shared::Platform::Mutex;
+
+namespace Game {
+
+	class XmlPreloaderThread;
+	class TechTreeCache;
+
+	// =====================================================
+	//	class XmlPreloader
+	//
+	//	Reads and parses a batch of xml files on worker threads.
+	//	Only the file I/O and parsing run in parallel, the callers
+	//	take the finished trees and do the actual loading serially
+	//	so the result does not depend on the thread count
+	// =====================================================
+
+	class XmlPreloader {
+	private:
+		struct Job {
+			string path;
+			std::map<string, string> mapTagReplacementValues;
+			XmlTree *xmlTree;
+		};
+
+		TechTreeCache *cache;
+		Mutex *mutexJobs;
+		vector<Job> jobList;
+		unsigned int nextJob;
+		int finishedThreadCount;
+
+		bool runNextJob();
+
+		friend class XmlPreloaderThread;
+
+	public:
+		XmlPreloader();
+		~XmlPreloader();
+
+		// Files the cache covers are read from it, or parsed and added to it
+		void setCache(TechTreeCache *cache) {
+			this->cache = cache;
+		}
+		void add(const string &path, const std::map<string, string> &mapTagReplacementValues);
+
+		// Returns once every file was parsed or failed
+		void loadAll();
+
+		// The caller owns the returned tree. NULL when the file was never
+		// added or failed to parse, loading it directly then reports the error
+		XmlTree * take(const string &path);
+
+		static int getThreadCount();
+	};
+
+	// =====================================================
+	//	class XmlPreloaderThread
+	// =====================================================
+
+	class XmlPreloaderThread : public BaseThread {
+	private:
+		XmlPreloader *preloader;
+
+	public:
+		explicit XmlPreloaderThread(XmlPreloader *preloader);
+		virtual void execute();
+	};
+
+} //end namespace
+
+#endif
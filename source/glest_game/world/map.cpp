@@ -35,6 +35,8 @@
 #include "map_preview.h"
 #include "world.h"
 #include "byte_order.h"
+#include "virtual_file_system.h"
+#include "parallel_rows.h"
 #include "leak_dumper.h"
 
 using namespace Shared::Graphics;
@@ -400,23 +402,32 @@ namespace Game {
 		}
 	}
 
+	// Reads one whole plane of the map file, the single byte fields need no
+	// byte swapping and the wider ones are swapped by the caller
+	static void readMapPlane(VirtualFile &f, void *dest, size_t bytes, int line) {
+		size_t readBytes = f.read(dest, bytes);
+		if (readBytes != bytes) {
+			char szBuf[8096] = "";
+			snprintf(szBuf, 8096, "read returned wrong size = " SIZE_T_SPECIFIER " of " SIZE_T_SPECIFIER " on line: %d.", readBytes, bytes, line);
+			throw game_runtime_error(szBuf);
+		}
+	}
+
 	Checksum Map::load(const string &path, TechTree *techTree, Tileset *tileset) {
 		Checksum mapChecksum;
 		try {
-#ifdef WIN32
-			FILE *f = _wfopen(utf8_decode(path).c_str(), L"rb");
-#else
-			FILE *f = fopen(path.c_str(), "rb");
-#endif
-			if (f != NULL) {
+			// The whole file is mapped (or read once), every plane below is
+			// then copied out with a single read instead of one per cell
+			VirtualFile f;
+			if (f.open(path) == true) {
 				mapFile = path;
 
 				mapChecksum.addFile(path);
 				checksumValue.addFile(path);
 				//read header
 				MapFileHeader header;
-				size_t readBytes = fread(&header, sizeof(MapFileHeader), 1, f);
-				if (readBytes != 1) {
+				size_t readBytes = f.read(&header, sizeof(MapFileHeader));
+				if (readBytes != sizeof(MapFileHeader)) {
 					throw game_runtime_error("Invalid map header detected for file: " + path);
 				}
 				fromEndianMapFileHeader(header);
@@ -465,25 +476,15 @@ namespace Game {
 
 				//start locations
 				startLocations = new Vec2i[maxPlayers];
-				for (int i = 0; i < hardMaxPlayers; ++i) {
-					int x = 0, y = 0;
-					readBytes = fread(&x, sizeof(int32), 1, f);
-					if (readBytes != 1) {
-						char szBuf[8096] = "";
-						snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " on line: %d.", readBytes, __LINE__);
-						throw game_runtime_error(szBuf);
+				if (hardMaxPlayers > 0) {
+					vector<int32> locations(hardMaxPlayers * 2);
+					readMapPlane(f, &locations[0], locations.size() * sizeof(int32), __LINE__);
+					for (int i = 0; i < hardMaxPlayers; ++i) {
+						int x = ::Shared::PlatformByteOrder::fromCommonEndian(locations[i * 2]);
+						int y = ::Shared::PlatformByteOrder::fromCommonEndian(locations[i * 2 + 1]);
+
+						startLocations[i] = Vec2i(x, y)*cellScale;
 					}
-					x = ::Shared::PlatformByteOrder::fromCommonEndian(x);
-
-					readBytes = fread(&y, sizeof(int32), 1, f);
-					if (readBytes != 1) {
-						char szBuf[8096] = "";
-						snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " on line: %d.", readBytes, __LINE__);
-						throw game_runtime_error(szBuf);
-					}
-					y = ::Shared::PlatformByteOrder::fromCommonEndian(y);
-
-					startLocations[i] = Vec2i(x, y)*cellScale;
 				}
 
 				//cells
@@ -491,50 +492,31 @@ namespace Game {
 				surfaceCells = new SurfaceCell[getSurfaceCellArraySize()];
 
 				//read heightmap
+				vector<float32> altitudes(surfaceSize);
+				readMapPlane(f, &altitudes[0], altitudes.size() * sizeof(float32), __LINE__);
 				for (int j = 0; j < surfaceH; ++j) {
+					const float32 *altitudeRow = &altitudes[j * surfaceW];
+					SurfaceCell *sc = &surfaceCells[j * surfaceW];
 					for (int i = 0; i < surfaceW; ++i) {
-						float32 alt = 0;
-						readBytes = fread(&alt, sizeof(float32), 1, f);
-						if (readBytes != 1) {
-							char szBuf[8096] = "";
-							snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " on line: %d.", readBytes, __LINE__);
-							throw game_runtime_error(szBuf);
-						}
-						alt = ::Shared::PlatformByteOrder::fromCommonEndian(alt);
-
-						SurfaceCell *sc = getSurfaceCell(i, j);
-						sc->setVertex(Vec3f(i*mapScale, alt / heightFactor, j*mapScale));
+						float32 alt = ::Shared::PlatformByteOrder::fromCommonEndian(altitudeRow[i]);
+						sc[i].setVertex(Vec3f(i*mapScale, alt / heightFactor, j*mapScale));
 					}
 				}
 
 				//read surfaces
-				for (int j = 0; j < surfaceH; ++j) {
-					for (int i = 0; i < surfaceW; ++i) {
-						int8 surf = 0;
-						readBytes = fread(&surf, sizeof(int8), 1, f);
-						if (readBytes != 1) {
-							char szBuf[8096] = "";
-							snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " on line: %d.", readBytes, __LINE__);
-							throw game_runtime_error(szBuf);
-						}
-						surf = ::Shared::PlatformByteOrder::fromCommonEndian(surf);
-
-						getSurfaceCell(i, j)->setSurfaceType(surf - 1);
-					}
+				vector<int8> surfaces(surfaceSize);
+				readMapPlane(f, &surfaces[0], surfaces.size() * sizeof(int8), __LINE__);
+				for (int i = 0; i < surfaceSize; ++i) {
+					surfaceCells[i].setSurfaceType(surfaces[i] - 1);
 				}
 
 				//read objects and resources
+				vector<int8> objects(surfaceSize);
+				readMapPlane(f, &objects[0], objects.size() * sizeof(int8), __LINE__);
 				for (int j = 0; j < h; j += cellScale) {
 					for (int i = 0; i < w; i += cellScale) {
 
-						int8 objNumber = 0;
-						readBytes = fread(&objNumber, sizeof(int8), 1, f);
-						if (readBytes != 1) {
-							char szBuf[8096] = "";
-							snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " on line: %d.", readBytes, __LINE__);
-							throw game_runtime_error(szBuf);
-						}
-						objNumber = ::Shared::PlatformByteOrder::fromCommonEndian(objNumber);
+						int8 objNumber = objects[(j / cellScale) * surfaceW + (i / cellScale)];
 
 						SurfaceCell *sc = getSurfaceCell(toSurfCoords(Vec2i(i, j)));
 						if (objNumber <= 0) {
@@ -556,7 +538,6 @@ namespace Game {
 						}
 					}
 				}
-				if (f) fclose(f);
 			} else {
 				throw game_runtime_error("Can't open file");
 			}
@@ -1586,11 +1567,11 @@ namespace Game {
 
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugPerformance).enabled && chrono.getMillis() > 0) SystemFlags::OutputDebug(SystemFlags::debugPerformance, "In [%s::%s Line: %d] took msecs: %lld\n", __FILE__, __FUNCTION__, __LINE__, chrono.getMillis());
 
-		computeNormals();
+		computeNormals(false);
 
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugPerformance).enabled && chrono.getMillis() > 0) SystemFlags::OutputDebug(SystemFlags::debugPerformance, "In [%s::%s Line: %d] took msecs: %lld\n", __FILE__, __FUNCTION__, __LINE__, chrono.getMillis());
 
-		computeInterpolatedHeights();
+		computeInterpolatedHeights(false);
 
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugPerformance).enabled && chrono.getMillis() > 0) SystemFlags::OutputDebug(SystemFlags::debugPerformance, "In [%s::%s Line: %d] took msecs: %lld\n", __FILE__, __FUNCTION__, __LINE__, chrono.getMillis());
 	}
@@ -1616,104 +1597,235 @@ namespace Game {
 		}
 	}
 
-	//compute normals
-	void Map::computeNormals() {
-		//compute center normals
-		for (int i = 1; i < surfaceW - 1; ++i) {
-			for (int j = 1; j < surfaceH - 1; ++j) {
-				getSurfaceCell(i, j)->setNormal(
-					getSurfaceCell(i, j)->getVertex().normal(getSurfaceCell(i, j - 1)->getVertex(),
-						getSurfaceCell(i + 1, j)->getVertex(),
-						getSurfaceCell(i, j + 1)->getVertex(),
-						getSurfaceCell(i - 1, j)->getVertex()));
+	// Row kernels for the terrain passes. Each row only writes its own
+	// cells and reads data no other row writes, so they can run in any
+	// order and on any number of threads
+
+	class NormalsKernel : public RowKernel {
+	private:
+		SurfaceCell *surfaceCells;
+		int surfaceW;
+
+	public:
+		NormalsKernel(SurfaceCell *surfaceCells, int surfaceW) {
+			this->surfaceCells = surfaceCells;
+			this->surfaceW = surfaceW;
+		}
+
+		// Rows are offset by one, the border rows keep their normals
+		virtual void processRows(int firstRow, int lastRow) {
+			for (int j = firstRow + 1; j < lastRow + 1; ++j) {
+				SurfaceCell *row = &surfaceCells[j * surfaceW];
+				const SurfaceCell *rowUp = row - surfaceW;
+				const SurfaceCell *rowDown = row + surfaceW;
+				for (int i = 1; i < surfaceW - 1; ++i) {
+					row[i].setNormal(row[i].getVertex().normal(rowUp[i].getVertex(),
+						row[i + 1].getVertex(),
+						rowDown[i].getVertex(),
+						row[i - 1].getVertex()));
+				}
 			}
 		}
-	}
+	};
 
-	void Map::computeInterpolatedHeights() {
+	class InterpolatedHeightsKernel : public RowKernel {
+	private:
+		Cell *cells;
+		const SurfaceCell *surfaceCells;
+		int surfaceW;
+		int surfaceH;
 
-		for (int i = 0; i < w; ++i) {
-			for (int j = 0; j < h; ++j) {
-				getCell(i, j)->setHeight(getSurfaceCell(toSurfCoords(Vec2i(i, j)))->getHeight());
+	public:
+		InterpolatedHeightsKernel(Cell *cells, const SurfaceCell *surfaceCells, int surfaceW, int surfaceH) {
+			this->cells = cells;
+			this->surfaceCells = surfaceCells;
+			this->surfaceW = surfaceW;
+			this->surfaceH = surfaceH;
+		}
+
+		// One row per surface row, covering the cellScale cell rows under it
+		virtual void processRows(int firstRow, int lastRow) {
+			const int cellScale = Map::cellScale;
+			const int w = surfaceW * cellScale;
+			for (int j = firstRow; j < lastRow; ++j) {
+				const SurfaceCell *row = &surfaceCells[j * surfaceW];
+				bool interpolate = (j >= 1 && j < surfaceH - 1);
+				const SurfaceCell *rowDown = (interpolate == true ? row + surfaceW : row);
+
+				for (int l = 0; l < cellScale; ++l) {
+					Cell *cellRow = &cells[(j * cellScale + l) * w];
+					for (int x = 0; x < w; ++x) {
+						cellRow[x].setHeight(row[x / cellScale].getHeight());
+					}
+					if (interpolate == false) {
+						continue;
+					}
+
+					for (int i = 1; i < surfaceW - 1; ++i) {
+						Cell *cell = &cellRow[i * cellScale];
+						for (int k = 0; k < cellScale; ++k) {
+							if (k == 0 && l == 0) {
+								cell[k].setHeight(row[i].getHeight());
+							} else if (k != 0 && l == 0) {
+								cell[k].setHeight((
+									row[i].getHeight() +
+									row[i + 1].getHeight()) / 2.f);
+							} else if (l != 0 && k == 0) {
+								cell[k].setHeight((
+									row[i].getHeight() +
+									rowDown[i].getHeight()) / 2.f);
+							} else {
+								cell[k].setHeight((
+									row[i].getHeight() +
+									rowDown[i].getHeight() +
+									row[i + 1].getHeight() +
+									rowDown[i + 1].getHeight()) / 4.f);
+							}
+						}
+					}
+				}
 			}
 		}
+	};
 
-		for (int i = 1; i < surfaceW - 1; ++i) {
-			for (int j = 1; j < surfaceH - 1; ++j) {
-				for (int k = 0; k < cellScale; ++k) {
-					for (int l = 0; l < cellScale; ++l) {
-						if (k == 0 && l == 0) {
-							getCell(i*cellScale, j*cellScale)->setHeight(getSurfaceCell(i, j)->getHeight());
-						} else if (k != 0 && l == 0) {
-							getCell(i*cellScale + k, j*cellScale)->setHeight((
-								getSurfaceCell(i, j)->getHeight() +
-								getSurfaceCell(i + 1, j)->getHeight()) / 2.f);
-						} else if (l != 0 && k == 0) {
-							getCell(i*cellScale, j*cellScale + l)->setHeight((
-								getSurfaceCell(i, j)->getHeight() +
-								getSurfaceCell(i, j + 1)->getHeight()) / 2.f);
-						} else {
-							getCell(i*cellScale + k, j*cellScale + l)->setHeight((
-								getSurfaceCell(i, j)->getHeight() +
-								getSurfaceCell(i, j + 1)->getHeight() +
-								getSurfaceCell(i + 1, j)->getHeight() +
-								getSurfaceCell(i + 1, j + 1)->getHeight()) / 4.f);
+	class SmoothSurfaceKernel : public RowKernel {
+	private:
+		const float *oldHeights;
+		float *newHeights;
+		// Number of neighbours too far up or down to be smoothed with
+		int8 *cliffCounts;
+		int surfaceW;
+		float cliffLevel;
+
+	public:
+		SmoothSurfaceKernel(const float *oldHeights, float *newHeights, int8 *cliffCounts, int surfaceW, float cliffLevel) {
+			this->oldHeights = oldHeights;
+			this->newHeights = newHeights;
+			this->cliffCounts = cliffCounts;
+			this->surfaceW = surfaceW;
+			this->cliffLevel = cliffLevel;
+		}
+
+		// Rows are offset by one, the border rows are not smoothed
+		virtual void processRows(int firstRow, int lastRow) {
+			for (int j = firstRow + 1; j < lastRow + 1; ++j) {
+				for (int i = 1; i < surfaceW - 1; ++i) {
+					float height = 0.f;
+					float numUsedToSmooth = 0.f;
+					int8 cliffCount = 0;
+					for (int k = -1; k <= 1; ++k) {
+						for (int l = -1; l <= 1; ++l) {
+#ifdef USE_STREFLOP
+							if (cliffLevel <= 0.1f || cliffLevel > streflop::fabs(static_cast<streflop::Simple>(oldHeights[(j) * surfaceW + (i)]
+								- oldHeights[(j + k) * surfaceW + (i + l)]))) {
+#else
+							if (cliffLevel <= 0.1f || cliffLevel > fabs(oldHeights[(j) * surfaceW + (i)]
+								- oldHeights[(j + k) * surfaceW + (i + l)])) {
+#endif
+								height += oldHeights[(j + k) * surfaceW + (i + l)];
+								numUsedToSmooth++;
+							} else {
+								cliffCount++;
+							}
 						}
 					}
+
+					newHeights[j * surfaceW + i] = height / numUsedToSmooth;
+					cliffCounts[j * surfaceW + i] = cliffCount;
 				}
 			}
 		}
+	};
+
+	class NearSubmergedKernel : public RowKernel {
+	private:
+		Map *map;
+
+	public:
+		explicit NearSubmergedKernel(Map *map) {
+			this->map = map;
+		}
+
+		virtual void processRows(int firstRow, int lastRow) {
+			for (int j = firstRow; j < lastRow; ++j) {
+				for (int i = 0; i < map->getSurfaceW() - 1; ++i) {
+					bool anySubmerged = false;
+					for (int k = -1; k <= 2; ++k) {
+						for (int l = -1; l <= 2; ++l) {
+							Vec2i pos = Vec2i(i + k, j + l);
+							if (map->isInsideSurface(pos) && map->isInsideSurface(Map::toSurfCoords(pos))) {
+								if (map->getSubmerged(map->getSurfaceCell(pos)))
+									anySubmerged = true;
+							}
+						}
+					}
+					map->getSurfaceCell(i, j)->setNearSubmerged(anySubmerged);
+				}
+			}
+		}
+	};
+
+	//compute normals
+	void Map::computeNormals(bool threaded) {
+		//compute center normals
+		NormalsKernel kernel(surfaceCells, surfaceW);
+		if (threaded == true) {
+			ParallelRows::run(&kernel, surfaceH - 2);
+		} else if (surfaceH > 2) {
+			kernel.processRows(0, surfaceH - 2);
+		}
+	}
+
+	void Map::computeInterpolatedHeights(bool threaded) {
+		InterpolatedHeightsKernel kernel(cells, surfaceCells, surfaceW, surfaceH);
+		if (threaded == true) {
+			ParallelRows::run(&kernel, surfaceH);
+		} else {
+			kernel.processRows(0, surfaceH);
+		}
 	}
 
 	void Map::smoothSurface(Tileset *tileset) {
-		float *oldHeights = new float[getSurfaceCellArraySize()];
-		//int arraySize=getSurfaceCellArraySize();
+		vector<float> oldHeights(getSurfaceCellArraySize());
+		vector<float> newHeights(getSurfaceCellArraySize());
+		vector<int8> cliffCounts(getSurfaceCellArraySize());
 
 		for (int i = 0; i < getSurfaceCellArraySize(); ++i) {
 			oldHeights[i] = surfaceCells[i].getHeight();
 		}
 
+		// The heights are computed on worker threads. Cliff objects are
+		// created afterwards in the original order, objects take color
+		// picking ids in the order they are created
+		SmoothSurfaceKernel kernel(&oldHeights[0], &newHeights[0], &cliffCounts[0], surfaceW, cliffLevel);
+		ParallelRows::run(&kernel, surfaceH - 2);
+
 		for (int i = 1; i < surfaceW - 1; ++i) {
 			for (int j = 1; j < surfaceH - 1; ++j) {
-				float height = 0.f;
-				float numUsedToSmooth = 0.f;
-				for (int k = -1; k <= 1; ++k) {
-					for (int l = -1; l <= 1; ++l) {
-#ifdef USE_STREFLOP
-						if (cliffLevel <= 0.1f || cliffLevel > streflop::fabs(static_cast<streflop::Simple>(oldHeights[(j) * surfaceW + (i)]
-							- oldHeights[(j + k) * surfaceW + (i + l)]))) {
-#else
-						if (cliffLevel <= 0.1f || cliffLevel > fabs(oldHeights[(j) * surfaceW + (i)]
-							- oldHeights[(j + k) * surfaceW + (i + l)])) {
-#endif
-							height += oldHeights[(j + k) * surfaceW + (i + l)];
-							numUsedToSmooth++;
-						} else {
-							// we have something which should not be smoothed!
-							// This is a cliff and must be textured -> set cliff texture
-							getSurfaceCell(i, j)->setSurfaceType(5);
-							//set invisible blocking object and replace resource objects
-							//and non blocking objects with invisible blocker too
-							Object *formerObject =
-								getSurfaceCell(i, j)->getObject();
-							if (formerObject != NULL) {
-								if (formerObject->getWalkable()
-									|| formerObject->getResource() != NULL) {
-									delete formerObject;
-									formerObject = NULL;
-								}
-							}
-							if (formerObject == NULL) {
-								Object *o = new Object(tileset->getObjectType(9),
-									getSurfaceCell(i, j)->getVertex(),
-									Vec2i(i, j));
-								getSurfaceCell(i, j)->setObject(o);
-							}
-						}
+				for (int cliff = 0; cliff < cliffCounts[j * surfaceW + i]; ++cliff) {
+					// we have something which should not be smoothed!
+					// This is a cliff and must be textured -> set cliff texture
+					getSurfaceCell(i, j)->setSurfaceType(5);
+					//set invisible blocking object and replace resource objects
+					//and non blocking objects with invisible blocker too
+					Object *formerObject =
+						getSurfaceCell(i, j)->getObject();
+					if (formerObject != NULL) {
+						if (formerObject->getWalkable()
+							|| formerObject->getResource() != NULL) {
+							delete formerObject;
+							formerObject = NULL;
 						}
 					}
+					if (formerObject == NULL) {
+						Object *o = new Object(tileset->getObjectType(9),
+							getSurfaceCell(i, j)->getVertex(),
+							Vec2i(i, j));
+						getSurfaceCell(i, j)->setObject(o);
+					}
+				}
 
-				height /= numUsedToSmooth;
+				float height = newHeights[j * surfaceW + i];
 				if (maxMapHeight < height) {
 					maxMapHeight = height;
 				}
@@ -1723,28 +1835,13 @@ namespace Game {
 				if (object != NULL) {
 					object->setHeight(height);
 				}
-				}
 			}
-		delete[] oldHeights;
 		}
+	}
 
 	void Map::computeNearSubmerged() {
-
-		for (int i = 0; i < surfaceW - 1; ++i) {
-			for (int j = 0; j < surfaceH - 1; ++j) {
-				bool anySubmerged = false;
-				for (int k = -1; k <= 2; ++k) {
-					for (int l = -1; l <= 2; ++l) {
-						Vec2i pos = Vec2i(i + k, j + l);
-						if (isInsideSurface(pos) && isInsideSurface(toSurfCoords(pos))) {
-							if (getSubmerged(getSurfaceCell(pos)))
-								anySubmerged = true;
-						}
-					}
-				}
-				getSurfaceCell(i, j)->setNearSubmerged(anySubmerged);
-			}
-		}
+		NearSubmergedKernel kernel(this);
+		ParallelRows::run(&kernel, surfaceH - 1);
 	}
 
 	void Map::computeCellColors() {
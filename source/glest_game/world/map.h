@@ -460,8 +460,10 @@ namespace Game {
 
 		void prepareTerrain(const Unit *unit);
 		void flatternTerrain(const Unit *unit);
-		void computeNormals();
-		void computeInterpolatedHeights();
+		// Runs on worker threads unless threaded is false, used in game
+		// where only a few cells change
+		void computeNormals(bool threaded = true);
+		void computeInterpolatedHeights(bool threaded = true);
 
 		//static
 		inline static Vec2i toSurfCoords(const Vec2i &unitPos) {
@@ -0,0 +1,152 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+#include "parallel_rows.h"
+
+#include "math_wrapper.h"
+#include "config.h"
+#include "platform_util.h"
+#include "util.h"
+#include "leak_dumper.h"
+
+using namespace Shared::Platform;
+using namespace Shared::PlatformCommon;
+using namespace Shared::Util;
+
+namespace Game {
+
+	// =====================================================
+	//	class ParallelRows
+	// =====================================================
+
+	const int ParallelRows::rowsPerJob = 8;
+
+	ParallelRows::ParallelRows(RowKernel *kernel, int rowCount) {
+		this->kernel = kernel;
+		this->rowCount = rowCount;
+		mutexRows = new Mutex(CODE_AT_LINE);
+		nextRow = 0;
+		finishedThreadCount = 0;
+	}
+
+	ParallelRows::~ParallelRows() {
+		delete mutexRows;
+		mutexRows = NULL;
+	}
+
+	int ParallelRows::getThreadCount() {
+		// 0 means one thread per cpu, 1 runs everything on the calling thread
+		int threadCount = Config::getInstance().getInt("MapLoadThreads", "0");
+		if (threadCount <= 0) {
+			threadCount = SDL_GetCPUCount();
+		}
+		return max(threadCount, 1);
+	}
+
+	bool ParallelRows::runNextJob() {
+		MutexSafeWrapper safeMutex(mutexRows, CODE_AT_LINE);
+		if (nextRow >= rowCount || errorText.empty() == false) {
+			return false;
+		}
+		int firstRow = nextRow;
+		int lastRow = min(firstRow + rowsPerJob, rowCount);
+		nextRow = lastRow;
+		safeMutex.ReleaseLock();
+
+		try {
+			kernel->processRows(firstRow, lastRow);
+		} catch (const exception &ex) {
+			safeMutex.Lock();
+			if (errorText.empty() == true) {
+				errorText = ex.what();
+			}
+			return false;
+		}
+		return true;
+	}
+
+	void ParallelRows::runAll() {
+		int threadCount = min(getThreadCount(), (rowCount + rowsPerJob - 1) / rowsPerJob);
+		vector<ParallelRowsThread *> threadList;
+		for (int i = 1; i < threadCount; ++i) {
+			ParallelRowsThread *thread = new ParallelRowsThread(this);
+			thread->start();
+			threadList.push_back(thread);
+		}
+
+		// The calling thread works through the rows too
+		for (; runNextJob() == true;) {
+		}
+
+		for (bool done = threadList.empty(); done == false;) {
+			MutexSafeWrapper safeMutex(mutexRows, CODE_AT_LINE);
+			done = (finishedThreadCount == (int) threadList.size());
+			safeMutex.ReleaseLock();
+			if (done == false) {
+				sleep(1);
+			}
+		}
+		for (unsigned int i = 0; i < threadList.size(); ++i) {
+			if (threadList[i]->shutdownAndWait() == true) {
+				delete threadList[i];
+			}
+		}
+
+		if (errorText.empty() == false) {
+			throw game_runtime_error(errorText);
+		}
+	}
+
+	void ParallelRows::run(RowKernel *kernel, int rowCount) {
+		if (rowCount <= 0) {
+			return;
+		}
+		if (rowCount <= rowsPerJob || getThreadCount() <= 1) {
+			kernel->processRows(0, rowCount);
+			return;
+		}
+
+		ParallelRows rows(kernel, rowCount);
+		rows.runAll();
+	}
+
+	// =====================================================
+	//	class ParallelRowsThread
+	// =====================================================
+
+	ParallelRowsThread::ParallelRowsThread(ParallelRows *rows) : BaseThread() {
+		this->rows = rows;
+		setUniqueID("ParallelRowsThread");
+	}
+
+	void ParallelRowsThread::execute() {
+		RunningStatusSafeWrapper runningStatus(this);
+#ifdef USE_STREFLOP
+		// Same float mode as the main thread so every row comes out
+		// bit identical no matter which thread computed it
+		streflop_init<streflop::Simple>();
+#endif
+		for (; getQuitStatus() == false && rows->runNextJob() == true;) {
+		}
+
+		MutexSafeWrapper safeMutex(rows->mutexRows, CODE_AT_LINE);
+		rows->finishedThreadCount++;
+	}
+
+} //end namespace
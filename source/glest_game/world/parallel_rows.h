@@ -0,0 +1,99 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+#ifndef _PARALLELROWS_H_
+#define _PARALLELROWS_H_
+
+#include "base_thread.h"
+#include <string>
+#include "leak_dumper.h"
+
+using std::string;
+using Shared::PlatformCommon::BaseThread;
+using Shared::Platform::Mutex;
+
+namespace Game {
+
+	class ParallelRowsThread;
+
+	// =====================================================
+	//	class RowKernel
+	//
+	//	Work split into independent rows, every row must only
+	//	write data no other row touches
+	// =====================================================
+
+	class RowKernel {
+	public:
+		virtual ~RowKernel() {
+		}
+		// Rows [firstRow, lastRow), may run on several threads at once
+		virtual void processRows(int firstRow, int lastRow) = 0;
+	};
+
+	// =====================================================
+	//	class ParallelRows
+	//
+	//	Runs a RowKernel over bands of rows on worker threads
+	//	and returns when all rows are done. Rows are independent
+	//	so the result does not depend on the thread count
+	// =====================================================
+
+	class ParallelRows {
+	private:
+		static const int rowsPerJob;
+
+		RowKernel *kernel;
+		Mutex *mutexRows;
+		int rowCount;
+		int nextRow;
+		int finishedThreadCount;
+		string errorText;
+
+		ParallelRows(RowKernel *kernel, int rowCount);
+		~ParallelRows();
+
+		bool runNextJob();
+		void runAll();
+
+		friend class ParallelRowsThread;
+
+	public:
+		// Errors thrown by the kernel are rethrown on the calling thread
+		static void run(RowKernel *kernel, int rowCount);
+
+		static int getThreadCount();
+	};
+
+	// =====================================================
+	//	class ParallelRowsThread
+	// =====================================================
+
+	class ParallelRowsThread : public BaseThread {
+	private:
+		ParallelRows *rows;
+
+	public:
+		explicit ParallelRowsThread(ParallelRows *rows);
+		virtual void execute();
+	};
+
+} //end namespace
+
+#endif
@@ -21,10 +21,12 @@
 
 #include <stdexcept>
 #include <algorithm>
+#include <functional>
 
 #include "renderer.h"
 #include "util.h"
 #include "math_util.h"
+#include "parallel_rows.h"
 #include "leak_dumper.h"
 
 using namespace std;
@@ -65,6 +67,53 @@ namespace Game {
 			this->rightUp == si.getRightUp();
 	}
 
+	bool SurfaceInfo::operator<(const SurfaceInfo &si) const {
+		std::less<const Pixmap2D *> less;
+		if (this->center != si.getCenter()) {
+			return less(this->center, si.getCenter());
+		}
+		if (this->leftDown != si.getLeftDown()) {
+			return less(this->leftDown, si.getLeftDown());
+		}
+		if (this->leftUp != si.getLeftUp()) {
+			return less(this->leftUp, si.getLeftUp());
+		}
+		if (this->rightDown != si.getRightDown()) {
+			return less(this->rightDown, si.getRightDown());
+		}
+		return less(this->rightUp, si.getRightUp());
+	}
+
+	// =====================================================
+	//	class SurfaceFillKernel
+	//
+	//	One row per pending surface, each only writes the
+	//	pixmap of its own texture
+	// =====================================================
+
+	class SurfaceFillKernel : public RowKernel {
+	private:
+		const SurfaceInfo **infos;
+		Texture2D **textures;
+
+	public:
+		SurfaceFillKernel(const SurfaceInfo **infos, Texture2D **textures) {
+			this->infos = infos;
+			this->textures = textures;
+		}
+
+		virtual void processRows(int firstRow, int lastRow) {
+			for (int i = firstRow; i < lastRow; ++i) {
+				const SurfaceInfo *si = infos[i];
+				if (si->getCenter() != NULL) {
+					textures[i]->getPixmap()->copy(si->getCenter());
+				} else {
+					textures[i]->getPixmap()->splat(si->getLeftUp(), si->getRightUp(), si->getLeftDown(), si->getRightDown());
+				}
+			}
+		}
+	};
+
 	// ===============================
 	// 	class SurfaceAtlas
 	// ===============================
@@ -89,7 +138,7 @@ namespace Game {
 		}
 
 		//add info
-		SurfaceInfos::iterator it = find(surfaceInfos.begin(), surfaceInfos.end(), *si);
+		SurfaceInfos::iterator it = surfaceInfos.find(*si);
 		if (it == surfaceInfos.end()) {
 			//add new texture
 			Texture2D *t = Renderer::getInstance().newTexture2D(rsGame);
@@ -103,17 +152,12 @@ namespace Game {
 
 			si->setCoord(Vec2f(0.f, 0.f));
 			si->setTexture(t);
-			surfaceInfos.push_back(*si);
+			surfaceInfos.insert(*si);
 
-			//copy texture to pixmap
-			if (si->getCenter() != NULL) {
-				if (t) {
-					t->getPixmap()->copy(si->getCenter());
-				}
-			} else {
-				if (t) {
-					t->getPixmap()->splat(si->getLeftUp(), si->getRightUp(), si->getLeftDown(), si->getRightDown());
-				}
+			//copy texture to pixmap, done later for all new textures at once
+			if (t) {
+				PendingSurface pending = { *si, t };
+				pendingSurfaces.push_back(pending);
 			}
 		} else {
 			si->setCoord(it->getCoord());
@@ -121,6 +165,23 @@ namespace Game {
 		}
 	}
 
+	void SurfaceAtlas::fillPendingSurfaces() {
+		if (pendingSurfaces.empty() == true) {
+			return;
+		}
+
+		vector<const SurfaceInfo *> infos;
+		vector<Texture2D *> textures;
+		for (unsigned int i = 0; i < pendingSurfaces.size(); ++i) {
+			infos.push_back(&pendingSurfaces[i].info);
+			textures.push_back(pendingSurfaces[i].texture);
+		}
+
+		SurfaceFillKernel kernel(&infos[0], &textures[0]);
+		ParallelRows::run(&kernel, (int) pendingSurfaces.size());
+		pendingSurfaces.clear();
+	}
+
 	float SurfaceAtlas::getCoordStep() const {
 		return 1.f;
 	}
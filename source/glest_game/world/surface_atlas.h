@@ -57,6 +57,7 @@ namespace Game {
 		explicit SurfaceInfo(const Pixmap2D *center);
 		SurfaceInfo(const Pixmap2D *lu, const Pixmap2D *ru, const Pixmap2D *ld, const Pixmap2D *rd);
 		bool operator==(const SurfaceInfo &si) const;
+		bool operator<(const SurfaceInfo &si) const;
 
 		inline const Pixmap2D *getCenter() const {
 			return center;
@@ -96,16 +97,27 @@ namespace Game {
 
 	class SurfaceAtlas {
 	private:
-		typedef vector<SurfaceInfo> SurfaceInfos;
+		typedef set<SurfaceInfo> SurfaceInfos;
+
+		// A new texture whose pixels still have to be copied or splatted
+		struct PendingSurface {
+			SurfaceInfo info;
+			Texture2D *texture;
+		};
 
 	private:
 		SurfaceInfos surfaceInfos;
+		vector<PendingSurface> pendingSurfaces;
 		int surfaceSize;
 
 	public:
 		SurfaceAtlas();
 
+		// Creates the texture right away but leaves its pixels for
+		// fillPendingSurfaces, which must be called before rendering
 		void addSurface(SurfaceInfo *si);
+		// Copies and splats the pixels of all new textures on worker threads
+		void fillPendingSurfaces();
 		float getCoordStep() const;
 
 	private:
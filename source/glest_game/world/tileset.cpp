@@ -560,4 +560,8 @@ namespace Game {
 		}
 	}
 
+	void Tileset::finishSurfTex() {
+		surfaceAtlas.fillPendingSurfaces();
+	}
+
 } //end namespace
@@ -264,6 +264,8 @@ namespace Game {
 		//surface textures
 		const Pixmap2D *getSurfPixmap(int type, int var) const;
 		void addSurfTex(int leftUp, int rightUp, int leftDown, int rightDown, Vec2f &coord, const Texture2D *&texture, int mapX, int mapY);
+		// Fills the pixels of the textures created by addSurfTex
+		void finishSurfTex();
 
 		//sounds
 		AmbientSounds *getAmbientSounds() {
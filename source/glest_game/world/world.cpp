@@ -2018,6 +2018,9 @@ namespace Game {
 				sc00->setSurfaceTexture(texture);
 			}
 		}
+		// The random variations are picked serially above so the result
+		// stays the same, the texture pixels are splatted in parallel here
+		tileset.finishSurfTex();
 		if (SystemFlags::getSystemSettingType(SystemFlags::debugSystem).enabled) SystemFlags::OutputDebug(SystemFlags::debugSystem, "In [%s::%s Line: %d]\n", __FILE__, __FUNCTION__, __LINE__);
 	}
 
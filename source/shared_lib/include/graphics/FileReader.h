@@ -30,17 +30,19 @@
 #include <typeinfo>
 #include <vector>
 #include "conversion.h"
+#include "virtual_file_system.h"
 #include "leak_dumper.h"
 
 using std::map;
 using std::string;
 using std::vector;
-using std::ifstream;
+using std::istream;
 using std::ios;
 using std::runtime_error;
 using namespace Shared::Util;
 
 using Shared::PlatformCommon::extractExtension;
+using Shared::PlatformCommon::VirtualFileStream;
 
 #define AS_STRING(...) #__VA_ARGS__
 
@@ -105,7 +107,7 @@ namespace Shared {
 
 		/**Gives a better estimation of whether the specified file
 		 * can be read or not depending on the file content*/
-		virtual bool canRead(ifstream& file) const;
+		virtual bool canRead(istream& file) const;
 
 		virtual void cleanupExtensions();
 
@@ -129,7 +131,7 @@ namespace Shared {
 		 * Default implementation generates an object using T()
 		 * is thrown
 		 */
-		virtual T* read(ifstream& file, const string& path) const {
+		virtual T* read(istream& file, const string& path) const {
 			T* obj = new T();
 			T* ret = read(file, path, obj);
 			if (obj != ret) {
@@ -144,7 +146,7 @@ namespace Shared {
 		 * If it failes, either <code>null</code> is returned or an exception
 		 * is thrown
 		 */
-		virtual T* read(ifstream& file, const string& path, T* former) const = 0;
+		virtual T* read(istream& file, const string& path, T* former) const = 0;
 
 		virtual ~FileReader() {
 			cleanupExtensions();
@@ -154,12 +156,7 @@ namespace Shared {
 	template <typename T>
 	static inline T* readFromFileReaders(vector<FileReader<T> const *>* readers, const string& filepath) {
 		//try to assign file
-#if defined(WIN32) && !defined(__MINGW32__)
-		FILE *fp = _wfopen(utf8_decode(filepath).c_str(), L"rb");
-		ifstream file(fp);
-#else
-		ifstream file(filepath.c_str(), ios::in | ios::binary);
-#endif
+		VirtualFileStream file(filepath);
 		if (!file.is_open()) {
 			throw game_runtime_error("[#1] Could not open file " + filepath);
 		}
@@ -181,16 +178,10 @@ namespace Shared {
 			}
 			if (ret != NULL) {
 				file.close();
-#if defined(WIN32) && !defined(__MINGW32__)
-				if (fp) fclose(fp);
-#endif
 				return ret;
 			}
 			}
 		file.close();
-#if defined(WIN32) && !defined(__MINGW32__)
-		if (fp) fclose(fp);
-#endif
 
 		return NULL;
 		}
@@ -198,21 +189,9 @@ namespace Shared {
 	template <typename T>
 	static inline T* readFromFileReaders(vector<FileReader<T> const *>* readers, const string& filepath, T* object) {
 		//try to assign file
-#if defined(WIN32) && !defined(__MINGW32__)
-		wstring wstr = utf8_decode(filepath);
-		FILE *fp = _wfopen(wstr.c_str(), L"rb");
-		int fileErrno = errno;
-		ifstream file(fp);
-#else
-		ifstream file(filepath.c_str(), ios::in | ios::binary);
-#endif
+		VirtualFileStream file(filepath);
 		if (!file.is_open()) {
-#if defined(WIN32) && !defined(__MINGW32__)
-			DWORD error = GetLastError();
-			throw game_runtime_error("[#2] Could not open file, result: " + intToStr(error) + " - " + intToStr(fileErrno) + " [" + filepath + "]");
-#else
 			throw game_runtime_error("[#2] Could not open file [" + filepath + "]");
-#endif
 		}
 		for (typename vector<FileReader<T> const *>::const_iterator i = readers->begin(); i != readers->end(); ++i) {
 			T* ret = NULL;
@@ -232,16 +211,10 @@ namespace Shared {
 			}
 			if (ret != NULL) {
 				file.close();
-#if defined(WIN32) && !defined(__MINGW32__)
-				if (fp) fclose(fp);
-#endif
 				return ret;
 			}
 			}
 		file.close();
-#if defined(WIN32) && !defined(__MINGW32__)
-		if (fp) fclose(fp);
-#endif
 		return NULL;
 		}
 
@@ -252,7 +225,9 @@ namespace Shared {
 	template <typename T>
 	T* FileReader<T>::readPath(const string& filepath) {
 		const string& extension = extractExtension(filepath);
-		vector<FileReader<T> const * >* possibleReaders = (getFileReadersMap())[extension];
+		// find() rather than [], textures are decoded on several threads
+		typename map<string, vector<FileReader<T> const * >* >::const_iterator iterFind = getFileReadersMap().find(extension);
+		vector<FileReader<T> const * >* possibleReaders = (iterFind != getFileReadersMap().end() ? iterFind->second : NULL);
 		if (possibleReaders != NULL) {
 			//Search in these possible readers
 			T* ret = readFromFileReaders(possibleReaders, filepath);
@@ -275,7 +250,8 @@ namespace Shared {
 	template <typename T>
 	T* FileReader<T>::readPath(const string& filepath, T* object) {
 		const string& extension = extractExtension(filepath);
-		vector<FileReader<T> const * >* possibleReaders = (getFileReadersMap())[extension];
+		typename map<string, vector<FileReader<T> const * >* >::const_iterator iterFind = getFileReadersMap().find(extension);
+		vector<FileReader<T> const * >* possibleReaders = (iterFind != getFileReadersMap().end() ? iterFind->second : NULL);
 		if (possibleReaders != NULL) {
 			//Search in these possible readers
 			T* ret = readFromFileReaders(possibleReaders, filepath, object);
@@ -340,7 +316,7 @@ namespace Shared {
 	/**Gives a better estimation of whether the specified file
 	 * can be read or not depending on the file content*/
 	template <typename T>
-	bool FileReader<T>::canRead(ifstream& file) const {
+	bool FileReader<T>::canRead(istream& file) const {
 		try {
 			T* wouldRead = read(file, "unknown file");
 			bool ret = (wouldRead != NULL);
@@ -365,20 +341,12 @@ namespace Shared {
 	 */
 	template <typename T>
 	T* FileReader<T>::read(const string& filepath) const {
-#if defined(WIN32) && !defined(__MINGW32__)
-		FILE *fp = _wfopen(utf8_decode(filepath).c_str(), L"rb");
-		ifstream file(fp);
-#else
-		ifstream file(filepath.c_str(), ios::in | ios::binary);
-#endif
+		VirtualFileStream file(filepath);
 		if (!file.is_open()) {
 			throw game_runtime_error("[#3] Could not open file " + filepath);
 		}
 		T* ret = read(file, filepath);
 		file.close();
-#if defined(WIN32) && !defined(__MINGW32__)
-		if (fp) fclose(fp);
-#endif
 
 		return ret;
 	}
@@ -390,20 +358,12 @@ namespace Shared {
 	 */
 	template <typename T>
 	T* FileReader<T>::read(const string& filepath, T* object) const {
-#if defined(WIN32) && !defined(__MINGW32__)
-		FILE *fp = _wfopen(utf8_decode(filepath).c_str(), L"rb");
-		ifstream file(fp);
-#else
-		ifstream file(filepath.c_str(), ios::in | ios::binary);
-#endif
+		VirtualFileStream file(filepath);
 		if (!file.is_open()) {
 			throw game_runtime_error("[#4] Could not open file " + filepath);
 		}
 		T* ret = read(file, filepath, object);
 		file.close();
-#if defined(WIN32) && !defined(__MINGW32__)
-		if (fp) fclose(fp);
-#endif
 
 		return ret;
 	}
@@ -35,7 +35,7 @@ namespace Shared {
 		public:
 			JPGReader();
 
-			Pixmap2D* read(ifstream& in, const string& path, Pixmap2D* ret) const;
+			Pixmap2D* read(istream& in, const string& path, Pixmap2D* ret) const;
 		};
 
 
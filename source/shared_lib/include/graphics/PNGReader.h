@@ -35,14 +35,14 @@ namespace Shared {
 		public:
 			PNGReader();
 
-			Pixmap2D* read(ifstream& in, const string& path, Pixmap2D* ret) const;
+			Pixmap2D* read(istream& in, const string& path, Pixmap2D* ret) const;
 		};
 
 		class PNGReader3D : FileReader<Pixmap3D> {
 		public:
 			PNGReader3D();
 
-			Pixmap3D* read(ifstream& in, const string& path, Pixmap3D* ret) const;
+			Pixmap3D* read(istream& in, const string& path, Pixmap3D* ret) const;
 		};
 
 	}
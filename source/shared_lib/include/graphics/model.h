@@ -30,11 +30,13 @@
 #include <memory>
 #include "common_scoped_ptr.h"
 #include "byte_order.h"
+#include "virtual_file_system.h"
 #include "leak_dumper.h"
 
 using std::string;
 using std::map;
 using std::pair;
+using Shared::PlatformCommon::VirtualFile;
 
 namespace Shared {
 	namespace Graphics {
@@ -45,6 +47,39 @@ namespace Shared {
 		class InterpolationData;
 		class TextureManager;
 
+		// =====================================================
+		//	class G3dFileReader
+		//
+		//	Maps a whole g3d file into memory so the loaders copy
+		//	the headers and frame arrays straight out of it instead
+		//	of going through stdio for every array
+		// =====================================================
+
+		class G3dFileReader {
+		private:
+			// Loose file or entry of a mounted data archive
+			VirtualFile file;
+			const char *data;
+			size_t size;
+			size_t offset;
+
+		private:
+			G3dFileReader(G3dFileReader&);
+			void operator =(G3dFileReader&);
+
+		public:
+			G3dFileReader();
+			~G3dFileReader();
+
+			bool open(const string &path);
+			void close();
+
+			// Same contract as fread, returns the number of whole items copied
+			size_t read(void *dest, size_t itemSize, size_t itemCount);
+			// Same contract as fseek with SEEK_CUR
+			int seek(long delta);
+		};
+
 		// =====================================================
 		//	class Mesh
 		//
@@ -215,11 +250,11 @@ namespace Shared {
 				string sourceLoader = "", string modelFile = "");
 
 			//load
-			void loadV2(int meshIndex, const string &dir, FILE *f, TextureManager *textureManager,
+			void loadV2(int meshIndex, const string &dir, G3dFileReader *f, TextureManager *textureManager,
 				bool deletePixMapAfterLoad, std::map<string, vector<pair<string, string> > > *loadedFileList = NULL, string sourceLoader = "", string modelFile = "");
-			void loadV3(int meshIndex, const string &dir, FILE *f, TextureManager *textureManager,
+			void loadV3(int meshIndex, const string &dir, G3dFileReader *f, TextureManager *textureManager,
 				bool deletePixMapAfterLoad, std::map<string, vector<pair<string, string> > > *loadedFileList = NULL, string sourceLoader = "", string modelFile = "");
-			void load(int meshIndex, const string &dir, FILE *f, TextureManager *textureManager, bool deletePixMapAfterLoad, std::map<string, vector<pair<string, string> > > *loadedFileList = NULL, string sourceLoader = "", string modelFile = "");
+			void load(int meshIndex, const string &dir, G3dFileReader *f, TextureManager *textureManager, bool deletePixMapAfterLoad, std::map<string, vector<pair<string, string> > > *loadedFileList = NULL, string sourceLoader = "", string modelFile = "");
 			void save(int meshIndex, const string &dir, FILE *f, TextureManager *textureManager,
 				string convertTextureToFormat, std::map<string, int> &textureDeleteList,
 				bool keepsmallest, string modelFile);
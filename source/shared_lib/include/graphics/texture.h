@@ -34,6 +34,7 @@ namespace Shared {
 	namespace Graphics {
 
 		class TextureParams;
+		class TextureDecodeJob;
 
 
 		// =====================================================
@@ -181,29 +182,90 @@ namespace Shared {
 		protected:
 			Pixmap2D pixmap;
 
+			// Set while a TextureDecoder thread fills the pixmap
+			mutable TextureDecodeJob *decodeJob;
+			// Pixels of an async load are kept until the first init
+			bool awaitingUpload;
+			bool deletePixelsOnUpload;
+
+			// Only evictable textures are tracked by TextureResidency
+			bool evictable;
+			bool evicted;
+			mutable uint32 lastUsedFrame;
+			static uint32 currentFrame;
+
+			void finishDecode() const;
+			void waitForDecode() const {
+				if (decodeJob != NULL) {
+					finishDecode();
+				}
+			}
+			void uploadFinished();
+
+			friend class TextureDecoder;
+
 		public:
+			Texture2D();
+			virtual ~Texture2D();
+
 			void load(const string &path);
+			// Decodes on a TextureDecoder thread when those are enabled,
+			// anything touching the pixmap waits for it
+			void loadAsync(const string &path);
+			bool isDecodePending() const;
+
+			void markUsed() const {
+				lastUsedFrame = currentFrame;
+			}
+			uint32 getLastUsedFrame() const {
+				return lastUsedFrame;
+			}
+			static uint32 getCurrentFrame() {
+				return currentFrame;
+			}
+			static void nextFrame() {
+				currentFrame++;
+			}
+			bool getEvictable() const {
+				return evictable;
+			}
+			void setEvictable(bool value) {
+				evictable = value;
+			}
+			bool getEvicted() const {
+				return evicted;
+			}
+			// Drops the GL texture and the pixels, the path is kept so
+			// reload() can decode the file again
+			void evict();
+			void reload();
 
 			Pixmap2D *getPixmap() {
+				waitForDecode();
 				return &pixmap;
 			}
 			const Pixmap2D *getPixmapConst() const {
+				waitForDecode();
 				return &pixmap;
 			}
 			virtual string getPath() const;
 			virtual void deletePixels();
 			virtual std::size_t getPixelByteCount() const {
+				waitForDecode();
 				return pixmap.getPixelByteCount();
 			}
 
 			virtual int getTextureWidth() const {
+				waitForDecode();
 				return pixmap.getW();
 			}
 			virtual int getTextureHeight() const {
+				waitForDecode();
 				return pixmap.getH();
 			}
 
 			virtual uint32 getCRC() {
+				waitForDecode();
 				return pixmap.getCRC()->getSum();
 			}
 
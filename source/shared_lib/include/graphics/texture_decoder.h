@@ -0,0 +1,100 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+
+#ifndef _SHARED_GRAPHICS_TEXTUREDECODER_H_
+#define _SHARED_GRAPHICS_TEXTUREDECODER_H_
+
+#include "base_thread.h"
+#include <deque>
+#include <vector>
+#include "leak_dumper.h"
+
+using std::deque;
+using std::vector;
+using Shared::PlatformCommon::BaseThread;
+using Shared::Platform::Mutex;
+using Shared::Platform::Semaphore;
+
+namespace Shared {
+	namespace Graphics {
+
+		class Texture2D;
+		class TextureDecodeThread;
+
+		// =====================================================
+		//	class TextureDecoder
+		//
+		//	Pool of threads that decode image files into the pixmaps
+		//	of Texture2D::loadAsync. Only the decoding runs there, the
+		//	GL upload stays with the thread owning the context
+		// =====================================================
+
+		class TextureDecodeJob {
+		public:
+			Texture2D *texture;
+			string path;
+			bool started;
+			bool done;
+			string error;
+		};
+
+		class TextureDecoder {
+		private:
+			static Mutex *mutexJobs;
+			static Semaphore *semJobs;
+			static deque<TextureDecodeJob *> jobList;
+			static vector<TextureDecodeThread *> threadList;
+			static int threadCount;
+
+			static void decode(TextureDecodeJob *job);
+			static bool runNextJob();
+
+			friend class TextureDecodeThread;
+
+		public:
+			// Less than zero decodes on the calling thread, 0 starts one
+			// thread per cpu but the main one
+			static void setThreadCount(int value);
+			static bool isEnabled() {
+				return threadCount > 0;
+			}
+			static void shutdown();
+
+			static TextureDecodeJob * add(Texture2D *texture, const string &path);
+			static bool isDone(TextureDecodeJob *job);
+			// Decodes the job on the calling thread if no thread took it yet,
+			// deletes it and throws when decoding failed
+			static void wait(TextureDecodeJob *job);
+		};
+
+		// =====================================================
+		//	class TextureDecodeThread
+		// =====================================================
+
+		class TextureDecodeThread : public BaseThread {
+		public:
+			TextureDecodeThread();
+			virtual void execute();
+		};
+
+	}
+} //end namespace
+
+#endif
@@ -39,10 +39,15 @@ namespace Shared {
 
 		protected:
 			TextureContainer textures;
+			// Loaded with loadTexture2DAsync and not uploaded yet
+			vector<Texture2D *> pendingUploads;
+			vector<Texture2D *> evictableTextures;
 
 			Texture::Filter textureFilter;
 			int maxAnisotropy;
 
+			void removeTrackedTexture(Texture *texture);
+
 		public:
 			TextureManager();
 			~TextureManager();
@@ -56,6 +61,16 @@ namespace Shared {
 			void endLastTexture(bool mustExistInList = false);
 			void reinitTextures();
 
+			// Uploads the texture once a TextureDecoder thread decoded it,
+			// right away when those are disabled. Evictable textures must
+			// only ever hold the file's pixels, TextureResidency may drop
+			// and reload them
+			void loadTexture2DAsync(Texture2D *texture, const string &path, bool evictable = false);
+			void reloadTexture(Texture2D *texture);
+			// Uploads decoded textures until maxMillis are spent (all of them
+			// when negative), returns how many are still waiting
+			int initDecodedTextures(int64 maxMillis);
+
 			Texture::Filter getTextureFilter() const {
 				return textureFilter;
 			}
@@ -72,6 +87,9 @@ namespace Shared {
 			const TextureContainer &getTextures() const {
 				return textures;
 			}
+			const vector<Texture2D *> &getEvictableTextures() const {
+				return evictableTextures;
+			}
 		};
 	}
 } //end namespace
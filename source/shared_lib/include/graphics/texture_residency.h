@@ -0,0 +1,93 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+
+#ifndef _SHARED_GRAPHICS_TEXTURERESIDENCY_H_
+#define _SHARED_GRAPHICS_TEXTURERESIDENCY_H_
+
+#include <vector>
+#include <string>
+#include "data_types.h"
+#include "leak_dumper.h"
+
+using std::vector;
+using std::string;
+using Shared::Platform::int64;
+using Shared::Platform::uint32;
+
+namespace Shared {
+	namespace Graphics {
+
+		class TextureManager;
+
+		// =====================================================
+		//	class TextureResidency
+		//
+		//	Keeps the evictable textures of a set of managers within a
+		//	memory budget. Textures not drawn for a while are evicted
+		//	least recently used first and decoded again the frame
+		//	after they are drawn while evicted
+		// =====================================================
+
+		class TextureResidency {
+		private:
+			vector<TextureManager *> managers;
+			std::size_t budgetBytes;
+			uint32 minIdleFrames;
+			std::size_t residentBytes;
+
+			int64 hitCount;
+			int64 missCount;
+			int64 evictionCount;
+
+		public:
+			TextureResidency();
+
+			void addManager(TextureManager *manager);
+			// 0 means no budget, nothing is ever evicted
+			void setBudget(std::size_t bytes) {
+				budgetBytes = bytes;
+			}
+			// Textures drawn within this many frames are never evicted
+			void setMinIdleFrames(uint32 frames) {
+				minIdleFrames = frames;
+			}
+
+			// Once per frame on the GL thread, after rendering
+			void update();
+
+			std::size_t getResidentBytes() const {
+				return residentBytes;
+			}
+			int64 getHitCount() const {
+				return hitCount;
+			}
+			int64 getMissCount() const {
+				return missCount;
+			}
+			int64 getEvictionCount() const {
+				return evictionCount;
+			}
+			string getStats() const;
+		};
+
+	}
+} //end namespace
+
+#endif
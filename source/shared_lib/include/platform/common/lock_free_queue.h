@@ -0,0 +1,130 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+#ifndef _SHARED_PLATFORMCOMMON_LOCKFREEQUEUE_H_
+#define _SHARED_PLATFORMCOMMON_LOCKFREEQUEUE_H_
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include "leak_dumper.h"
+
+namespace Shared {
+	namespace PlatformCommon {
+
+		// =====================================================
+		//	class LockFreeQueue
+		//
+		//	Bounded single producer / single consumer ring buffer.
+		//	Exactly one thread may call push() and exactly one
+		//	(other) thread may call pop(); neither ever blocks.
+		// =====================================================
+
+		template <typename T>
+		class LockFreeQueue {
+		private:
+			std::vector<T> buffer;
+			size_t capacityMask;
+			std::atomic<size_t> head;
+			std::atomic<size_t> tail;
+
+			LockFreeQueue(const LockFreeQueue &);
+			LockFreeQueue & operator=(const LockFreeQueue &);
+
+		public:
+			// capacity is rounded up to the next power of two
+			explicit LockFreeQueue(size_t capacity = 1024) : head(0), tail(0) {
+				size_t size = 2;
+				while (size < capacity) {
+					size <<= 1;
+				}
+				buffer.resize(size);
+				capacityMask = size - 1;
+			}
+
+			// Producer side, returns false if the queue is full
+			bool push(const T &item) {
+				const size_t currentTail = tail.load(std::memory_order_relaxed);
+				if (currentTail - head.load(std::memory_order_acquire) > capacityMask) {
+					return false;
+				}
+				buffer[currentTail & capacityMask] = item;
+				tail.store(currentTail + 1, std::memory_order_release);
+				return true;
+			}
+
+			// Consumer side, returns false if the queue is empty
+			bool pop(T &item) {
+				const size_t currentHead = head.load(std::memory_order_relaxed);
+				if (currentHead == tail.load(std::memory_order_acquire)) {
+					return false;
+				}
+				item = buffer[currentHead & capacityMask];
+				head.store(currentHead + 1, std::memory_order_release);
+				return true;
+			}
+
+			// Producer side, copies as many items as fit and returns that count
+			size_t write(const T *items, size_t count) {
+				const size_t currentTail = tail.load(std::memory_order_relaxed);
+				const size_t freeCount = capacity() - (currentTail - head.load(std::memory_order_acquire));
+				if (count > freeCount) {
+					count = freeCount;
+				}
+				for (size_t i = 0; i < count; ++i) {
+					buffer[(currentTail + i) & capacityMask] = items[i];
+				}
+				tail.store(currentTail + count, std::memory_order_release);
+				return count;
+			}
+
+			// Consumer side, copies up to count items and returns how many it got
+			size_t read(T *items, size_t count) {
+				const size_t currentHead = head.load(std::memory_order_relaxed);
+				const size_t usedCount = tail.load(std::memory_order_acquire) - currentHead;
+				if (count > usedCount) {
+					count = usedCount;
+				}
+				for (size_t i = 0; i < count; ++i) {
+					items[i] = buffer[(currentHead + i) & capacityMask];
+				}
+				head.store(currentHead + count, std::memory_order_release);
+				return count;
+			}
+
+			// Consumer side, drops everything queued so far
+			void discard() {
+				head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+			}
+
+			bool empty() const {
+				return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+			}
+			size_t size() const {
+				return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+			}
+			size_t capacity() const {
+				return capacityMask + 1;
+			}
+		};
+
+	}
+} //end namespace
+
+#endif
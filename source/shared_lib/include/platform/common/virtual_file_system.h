@@ -0,0 +1,246 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+
+#ifndef _SHARED_PLATFORMCOMMON_VIRTUALFILESYSTEM_H_
+#define _SHARED_PLATFORMCOMMON_VIRTUALFILESYSTEM_H_
+
+#include "thread.h"
+#include "data_types.h"
+#include <istream>
+#include <streambuf>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "leak_dumper.h"
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+using Shared::Platform::Mutex;
+using Shared::Platform::int64;
+using Shared::Platform::uint64;
+
+namespace Shared {
+	namespace PlatformCommon {
+
+		// =====================================================
+		//	class VirtualFileSystem
+		//
+		//	Read only path index over zip archives and loose data
+		//	folders. A zip named <name>.zip inside a mounted folder
+		//	shows its files under <folder>/<name>/ as if extracted
+		//	there. Lookups that miss the index go to the disk
+		// =====================================================
+
+		class VirtualFileSystem {
+		public:
+			struct Entry {
+				// -1 for loose files
+				int archiveIndex;
+				uint64 localHeaderOffset;
+				uint64 compressedSize;
+				uint64 size;
+				bool compressed;
+			};
+
+			struct Archive {
+				string path;
+				const char *data;
+				uint64 size;
+				void *mapping;
+				// Holds the archive when it could not be mapped
+				vector<char> buffer;
+				// Stamp of the file when it was mapped, an unchanged archive
+				// is kept mapped across refreshes
+				int64 modificationTime;
+				// Open files pointing into it, a retired archive is unmapped
+				// once the last one is closed
+				int useCount;
+				bool retired;
+			};
+
+		private:
+			struct Mount {
+				string folder;
+				bool indexLooseFiles;
+			};
+
+			struct Index {
+				vector<Archive *> archiveList;
+				map<string, Entry> fileIndex;
+				map<string, set<string> > folderIndex;
+				set<string> archivedFolders;
+			};
+
+			static Mutex *mutexIndex;
+			// Held while an index is built, refreshes never overlap
+			static Mutex *mutexRefresh;
+			static vector<Mount> mountList;
+			static Index currentIndex;
+			static vector<Archive *> retiredArchiveList;
+
+			static void addEntry(Index &index, const string &path, const string &mountFolder, const Entry &entry);
+			static bool getFileStamp(const string &path, int64 &modificationTime, uint64 &size);
+			static Archive * mapArchive(const string &archivePath, int64 modificationTime);
+			static bool indexArchive(Index &index, Archive *archive, const string &mountPath);
+			static void unmapArchive(Archive *archive);
+			static void mountArchives(Index &index, const string &folder, map<string, Archive *> &reusableArchives);
+			static void indexFolder(Index &index, const string &folder);
+
+		public:
+			// Mounts the zip archives directly inside folder and, if asked,
+			// indexes the loose files below it. Loose files win over
+			// archived ones of the same path
+			static void mount(const string &folder, bool indexLooseFiles);
+			// Rebuilds the index of every mount after content on disk changed.
+			// The new index is built aside and swapped in, archives that did
+			// not change stay mapped
+			static void refresh();
+
+			static string normalizePath(const string &path);
+
+			static bool hasFile(const string &path);
+			static bool hasFolder(const string &path);
+			static bool isArchived(const string &path);
+			// Modification time and size of the archive holding path, for
+			// telling whether an archived file changed
+			static bool getArchiveStamp(const string &path, int64 &modificationTime, uint64 &size);
+			// An archive handed out stays mapped until releaseArchive
+			static bool findEntry(const string &path, Entry &entry, const Archive **archive);
+			static void releaseArchive(const Archive *archive);
+
+			// Adds the archived names in the folder of pattern matching its
+			// last part, glob style with * and ?
+			static void findArchived(const string &pattern, vector<string> &results);
+			// Adds the full paths of archived files below folder
+			static void findArchivedRecursively(const string &folder, const string &filterFileExt,
+				bool includeFolders, vector<string> &results);
+
+			static string getStats();
+		};
+
+		// =====================================================
+		//	class VirtualFile
+		//
+		//	One file opened through the VirtualFileSystem. Loose
+		//	files are mapped and stored archive entries point into
+		//	the mapped archive, both without copying. Compressed
+		//	entries are inflated as they are read
+		// =====================================================
+
+		class VirtualFile {
+		private:
+			struct InflateState;
+
+			bool opened;
+			string path;
+			const VirtualFileSystem::Archive *archive;
+			const char *data;
+			uint64 size;
+			uint64 position;
+			void *mapping;
+			vector<char> buffer;
+
+			const char *compressedData;
+			uint64 compressedSize;
+			InflateState *inflateState;
+			uint64 inflatePosition;
+
+			VirtualFile(const VirtualFile &);
+			void operator =(const VirtualFile &);
+
+			bool openLoose(const string &path);
+			bool startInflate();
+			size_t inflateTo(char *dest, size_t bytes);
+
+		public:
+			VirtualFile();
+			~VirtualFile();
+
+			bool open(const string &path);
+			void close();
+
+			bool isOpen() const {
+				return opened;
+			}
+			uint64 getSize() const {
+				return size;
+			}
+			// The whole contents, inflated into memory first for compressed
+			// archive entries. NULL for an empty file
+			const char * getData();
+			// Only when the contents are addressable without inflating
+			const char * getDirectData() const {
+				return data;
+			}
+
+			size_t read(void *dest, size_t bytes);
+			bool seek(uint64 offset);
+			uint64 tell() const {
+				return position;
+			}
+		};
+
+		// =====================================================
+		//	class VirtualFileStream
+		//
+		//	std::istream over a VirtualFile for the loaders that
+		//	parse streams
+		// =====================================================
+
+		class VirtualFileStreamBuf : public std::streambuf {
+		private:
+			VirtualFile *file;
+			vector<char> chunk;
+
+		protected:
+			virtual int_type underflow();
+			virtual pos_type seekoff(off_type offset, std::ios_base::seekdir dir,
+				std::ios_base::openmode which = std::ios_base::in);
+			virtual pos_type seekpos(pos_type position,
+				std::ios_base::openmode which = std::ios_base::in);
+
+		public:
+			VirtualFileStreamBuf();
+			void attach(VirtualFile *file);
+		};
+
+		class VirtualFileStream : public std::istream {
+		private:
+			VirtualFile file;
+			VirtualFileStreamBuf streamBuf;
+
+		public:
+			VirtualFileStream();
+			explicit VirtualFileStream(const string &path);
+
+			void open(const string &path);
+			void close();
+			bool is_open() const {
+				return file.isOpen();
+			}
+		};
+
+	}
+} //end namespace
+
+#endif
@@ -0,0 +1,210 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+#ifndef _SHARED_PLATFORMCOMMON_CONTENTTRANSFER_H_
+#define _SHARED_PLATFORMCOMMON_CONTENTTRANSFER_H_
+
+#ifdef WIN32
+#include <winsock2.h>
+#include <winsock.h>
+#endif
+
+#include "base_thread.h"
+#include <vector>
+#include <string>
+#include <map>
+#include <deque>
+#include "data_types.h"
+#include "socket.h"
+
+#include "leak_dumper.h"
+
+using namespace std;
+using Shared::Platform::Socket;
+using Shared::Platform::ServerSocket;
+using Shared::Platform::SocketSendBuffer;
+
+namespace Shared {
+	namespace PlatformCommon {
+
+		enum ContentTransferType {
+			ctt_Map = 0,
+			ctt_Tileset = 1,
+			ctt_Techtree = 2
+		};
+
+		// =====================================================
+		//	class ContentManifest
+		//
+		//	Lists the files of one map, tileset or tech tree and
+		//	splits each into fixed size chunks named by their hash
+		// =====================================================
+
+		class ContentManifest {
+		public:
+			struct Chunk {
+				uint64 hash;
+				uint32 size;
+			};
+
+			struct File {
+				// Relative to the content root, always uses '/'
+				string path;
+				uint64 size;
+				vector<Chunk> chunkList;
+			};
+
+			static const uint32 chunkSize = 256 * 1024;
+
+			vector<File> fileList;
+
+			static uint64 hashData(const void *data, size_t size);
+			static string getChunkName(const Chunk &chunk);
+
+			bool addFile(const string &fullPath, const string &relativePath);
+			uint64 getTotalSize() const;
+
+			void saveToBuffer(vector<char> &buffer) const;
+			bool loadFromBuffer(const vector<char> &buffer);
+		};
+
+		// =====================================================
+		//	class ContentTransferServerThread
+		//
+		//	Serves manifests and chunks of the content the lobby
+		//	offers over FTP, next to the FTP server
+		// =====================================================
+
+		class ContentTransferServerThread : public BaseThread {
+		protected:
+			struct ChunkLocation {
+				string fullPath;
+				uint64 offset;
+			};
+
+			// Replies wait here until the socket takes them, so a client
+			// that reads slowly never holds up the others
+			struct Connection {
+				Socket *socket;
+				time_t lastActivity;
+				std::deque<SocketSendBuffer> sendQueue;
+				size_t sendQueueOffset;
+				int64 lastSendProgressTime;
+			};
+
+			std::pair<string, string> mapsPath;
+			std::pair<string, string> tilesetsPath;
+			std::pair<string, string> techtreesPath;
+
+			int portNumber;
+			int maxConnections;
+			ServerSocket *serverSocket;
+
+			Mutex *mutexSettings;
+			bool internetEnabled;
+			bool allowInternetTilesetFileTransfers;
+			bool allowInternetTechtreeFileTransfers;
+
+			// Only touched by the server thread
+			vector<Connection> connectionList;
+			std::map<string, vector<char> > manifestCache;
+			std::map<string, ChunkLocation> chunkLocations;
+
+			bool isTransferAllowed(ContentTransferType type);
+			bool buildManifest(ContentTransferType type, const string &name, vector<char> &buffer);
+			bool readChunk(uint64 hash, uint32 size, vector<char> &buffer);
+			bool serviceConnection(Connection &connection);
+			bool drainSendQueue(Connection &connection);
+			void sendReply(Connection &connection, uint8 status, const vector<char> &payload);
+
+		public:
+			ContentTransferServerThread(std::pair<string, string> mapsPath,
+				std::pair<string, string> tilesetsPath, std::pair<string, string> techtreesPath,
+				bool internetEnabledFlag,
+				bool allowInternetTilesetFileTransfers, bool allowInternetTechtreeFileTransfers,
+				int portNumber, int maxConnections);
+			virtual ~ContentTransferServerThread();
+			virtual void execute();
+
+			void setInternetEnabled(bool value);
+
+			// The engine listens just past the FTP passive port range
+			static int getPortForFTPPort(int ftpPortNumber, int maxPlayers) {
+				return ftpPortNumber + maxPlayers + 1;
+			}
+		};
+
+		// =====================================================
+		//	class ContentTransferClient
+		//
+		//	Fetches the chunks of one item the local copy lacks over
+		//	several connections at once. Verified chunks are kept in
+		//	a store on disk so an interrupted transfer picks up where
+		//	it stopped
+		// =====================================================
+
+		class ContentTransferProgressInterface {
+		public:
+			virtual ~ContentTransferProgressInterface() {
+			}
+			// Return false to abort the transfer
+			virtual bool ContentTransfer_Progress(const string &itemName, const string &currentFilename,
+				uint64 totalBytes, uint64 receivedBytes) = 0;
+		};
+
+		class ContentTransferClient {
+		protected:
+			struct LocalChunk {
+				string fullPath;
+				uint64 offset;
+			};
+
+			struct Connection {
+				Socket *socket;
+				int pendingChunk;
+			};
+
+			string serverUrl;
+			int portNumber;
+			int connectionCount;
+			string chunkStorePath;
+			ContentTransferProgressInterface *pCBObject;
+
+			Socket * connectSocket();
+			bool requestManifest(ContentTransferType type, const string &name, ContentManifest &manifest, string &error);
+			bool sendChunkRequest(Socket *socket, const ContentManifest::Chunk &chunk);
+			bool receiveReply(Socket *socket, uint8 &status, vector<char> &payload);
+			bool fetchChunks(const string &itemName, const vector<ContentManifest::Chunk> &missingList,
+				uint64 totalBytes, uint64 receivedBytes, string &error);
+			bool assembleFile(const ContentManifest::File &file, const string &destRoot,
+				const std::map<string, LocalChunk> &localChunks);
+
+		public:
+			ContentTransferClient(string serverUrl, int portNumber, int connectionCount,
+				string chunkStorePath, ContentTransferProgressInterface *pCBObject);
+
+			// destRoot receives the manifest paths, for tilesets and tech
+			// trees those start with the item folder
+			bool getContent(ContentTransferType type, const string &name, const string &destRoot, string &error);
+		};
+
+	}
+} //end namespace
+
+#endif
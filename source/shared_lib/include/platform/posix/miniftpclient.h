@@ -24,6 +24,7 @@
 #include <vector>
 #include <string>
 #include "platform_common.h"
+#include "content_transfer.h"
 #include "leak_dumper.h"
 
 using namespace std;
@@ -73,7 +74,7 @@ namespace Shared {
 				void *userdata) = 0;
 		};
 
-		class FTPClientThread : public BaseThread, public ShellCommandOutputCallbackInterface {
+		class FTPClientThread : public BaseThread, public ShellCommandOutputCallbackInterface, public ContentTransferProgressInterface {
 		protected:
 			int portNumber;
 			string serverUrl;
@@ -84,6 +85,12 @@ namespace Shared {
 			std::pair<string, string> scenariosPath;
 			string tempFilesPath;
 
+			// Chunked transfers are tried first when the host offers them
+			int contentTransferPort;
+			int contentTransferConnections;
+			string contentTransferItemName;
+			FTP_Client_CallbackType contentTransferType;
+
 			Mutex mutexMapFileList;
 			vector<pair<string, string> > mapFileList;
 
@@ -132,6 +139,11 @@ namespace Shared {
 				string remotePath, string destFileSaveAs, string ftpUser,
 				string ftpUserPassword, vector <string> *wantDirListOnly = NULL);
 
+			pair<FTP_Client_ResultType, string> getContentFromServer(FTP_Client_CallbackType downloadType,
+				const string &name, const string &destRoot);
+			virtual bool ContentTransfer_Progress(const string &itemName, const string &currentFilename,
+				uint64 totalBytes, uint64 receivedBytes);
+
 			string shellCommandCallbackUserData;
 			virtual void * getShellCommandOutput_UserData(string cmd);
 			virtual void ShellCommandOutput_CallbackEvent(string cmd, char *output, void *userdata);
@@ -160,6 +172,8 @@ namespace Shared {
 			void addFileToRequests(string fileName, string URL = "");
 			void addTempFileToRequests(string fileName, string URL = "");
 
+			void setContentTransferPort(int portNumber, int connectionCount);
+
 			FTPClientCallbackInterface * getCallBackObject();
 			void setCallBackObject(FTPClientCallbackInterface *value);
 
@@ -51,6 +51,7 @@ typedef int PLATFORM_SOCKET;
 #include <fcntl.h>
 #include <map>
 #include <vector>
+#include <memory>
 #include "base_thread.h"
 #include "simple_threads.h"
 #include "data_types.h"
@@ -128,6 +129,32 @@ namespace Shared {
 			string getString() const;
 		};
 
+		// Immutable serialized payload which may be queued on many sockets
+		// at once without copying
+		typedef std::shared_ptr<const std::vector<char> > SocketSendBuffer;
+
+		// Simulated link conditions for outgoing data, used to reproduce lag
+		// handling on localhost. TCP never drops bytes so loss shows up as a
+		// retransmit delay on the affected send.
+		class SocketLinkConditions {
+		public:
+			int latencyMilliseconds;
+			int jitterMilliseconds;
+			int bandwidthKbps;
+			int lossPercent;
+
+			SocketLinkConditions() {
+				latencyMilliseconds = 0;
+				jitterMilliseconds = 0;
+				bandwidthKbps = 0;
+				lossPercent = 0;
+			}
+			bool isEnabled() const {
+				return (latencyMilliseconds > 0 || jitterMilliseconds > 0 ||
+					bandwidthKbps > 0 || lossPercent > 0);
+			}
+		};
+
 		// =====================================================
 		//	class Socket
 		// =====================================================
@@ -166,6 +193,18 @@ namespace Shared {
 			bool isSocketBlocking;
 			time_t lastSocketError;
 
+			Mutex *sendBatchAccessor;
+			bool sendBatchEnabled;
+			std::vector<SocketSendBuffer> sendBatchList;
+
+			std::vector<char> unreadBuffer;
+			size_t unreadOffset;
+
+			static SocketLinkConditions defaultLinkConditions;
+
+			friend class SocketLinkSimulator;
+			int sendNow(const void *data, int dataSize);
+
 			static string host_name;
 			static std::vector<string> intfTypes;
 
@@ -193,6 +232,14 @@ namespace Shared {
 			}
 			static std::vector<std::string> getLocalIPAddressList();
 
+			// Conditions simulated on every socket
+			static void setDefaultLinkConditions(const SocketLinkConditions &value) {
+				defaultLinkConditions = value;
+			}
+			SocketLinkConditions getLinkConditions() const {
+				return defaultLinkConditions;
+			}
+
 			// Int lookup is socket fd while bool result is whether or not that socket was signalled for reading
 			static bool hasDataToRead(std::map<PLATFORM_SOCKET, bool> &socketTriggeredList);
 			static bool hasDataToRead(PLATFORM_SOCKET socket);
@@ -209,7 +256,23 @@ namespace Shared {
 
 			int getDataToRead(bool wantImmediateReply = false);
 			int send(const void *data, int dataSize);
+			// Writes what fits into the send buffer right now without waiting,
+			// returns 0 when it is full and -1 (disconnected) on errors
+			int trySend(const void *data, int dataSize);
+
+			// While a send batch is open sendBuffer() only queues the payload,
+			// flushSendBatch() then writes everything queued with one gathered
+			// write (writev where available) and closes the batch. A flush that
+			// can not write everything disconnects the socket and returns -1
+			void beginSendBatch();
+			bool isSendBatchEnabled();
+			int sendBuffer(const SocketSendBuffer &buffer);
+			int flushSendBatch();
 			int receive(void *data, int dataSize, bool tryReceiveUntilDataSizeMet);
+			// Queues bytes which receive() hands out before reading the socket,
+			// used to feed unwrapped (e.g. decompressed) payloads back in
+			void unreadData(const void *data, int dataSize);
+			bool hasUnreadData();
 			int peek(void *data, int dataSize, bool mustGetData = true, int *pLastSocketError = NULL);
 
 			void setBlock(bool block);
@@ -240,6 +303,81 @@ namespace Shared {
 			static void getLocalIPAddressListForPlatform(std::vector<std::string> &ipList);
 		};
 
+		// =====================================================
+		//	class SocketReactor
+		//
+		//	Keeps a persistent set of sockets registered with the
+		//	kernel (edge triggered epoll on linux, select elsewhere)
+		//	so callers do not have to rebuild fd sets on each poll.
+		//	Each socket carries an int key which is returned when
+		//	the socket is signalled.
+		// =====================================================
+		class SocketReactor {
+		protected:
+			PLATFORM_SOCKET reactorHandle;
+			Mutex *mutexSocketList;
+			std::map<PLATFORM_SOCKET, int> socketList;
+
+		public:
+			SocketReactor();
+			virtual ~SocketReactor();
+
+			static bool isEdgeTriggered();
+
+			bool addSocket(PLATFORM_SOCKET socket, int key);
+			void removeSocket(PLATFORM_SOCKET socket);
+			bool hasSocket(PLATFORM_SOCKET socket);
+			int getSocketCount();
+
+			// Fills triggeredKeyList with the keys of all signalled sockets
+			// and returns the count, or -1 on error
+			int wait(std::vector<int> &triggeredKeyList, int waitMilliseconds);
+		};
+
+		// =====================================================
+		//	class SocketLinkSimulator
+		//
+		//	Holds outgoing data of sockets with link conditions
+		//	and writes it once its simulated arrival time passes.
+		//	Per socket ordering is preserved like a TCP stream.
+		// =====================================================
+		class SocketLinkSimulator : public BaseThread {
+		protected:
+			class SimulatedPacket {
+			public:
+				Socket *socket;
+				std::vector<char> data;
+			};
+
+			static Mutex mutexInstance;
+			static SocketLinkSimulator *instance;
+
+			Mutex *mutexPacketList;
+			// Held while due packets are written, discardSocket waits on it
+			// so a socket is never written after it was destroyed
+			Mutex *mutexSend;
+			std::multimap<int64, SimulatedPacket> packetList;
+			std::map<Socket *, int64> lastDueTimeList;
+			std::map<Socket *, int64> linkBusyUntilList;
+			uint32 randomState;
+
+			int nextRandom(int maxValue);
+			void sendDuePackets(bool sendAll);
+
+		public:
+			SocketLinkSimulator();
+			virtual ~SocketLinkSimulator();
+
+			static SocketLinkSimulator * getInstance();
+			static void removeSocket(Socket *socket);
+			static void shutdown();
+
+			int queue(Socket *socket, const SocketLinkConditions &conditions, const void *data, int dataSize);
+			void discardSocket(Socket *socket);
+
+			virtual void execute();
+		};
+
 		class SafeSocketBlockToggleWrapper {
 		protected:
 			Socket *socket;
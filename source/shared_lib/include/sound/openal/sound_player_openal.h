@@ -21,6 +21,8 @@
 #define _SHARED_SOUND_SOUNDPLAYEROPENAL_H_
 
 #include "sound_player.h"
+#include "sound_cache.h"
+#include "sound_stream_decoder.h"
 #include "platform_util.h"
 #include "platform_common.h"
 #include <SDL.h>
@@ -32,6 +34,7 @@
 #include <AL/al.h>
 #endif
 #include <vector>
+#include <map>
 #include "leak_dumper.h"
 
 using std::vector;
@@ -51,7 +54,7 @@ namespace Shared {
 
 			protected:
 				friend class SoundPlayerOpenAL;
-				ALenum getFormat(Sound* sound);
+				static ALenum getFormat(Sound* sound);
 
 				ALuint source;
 			};
@@ -61,11 +64,12 @@ namespace Shared {
 				StaticSoundSource();
 				virtual ~StaticSoundSource();
 
-				void play(StaticSound* sound);
+				// The buffer belongs to the player and is shared by every
+				// source playing the same samples
+				void play(StaticSound* sound, ALuint buffer);
 
 			protected:
 				friend class SoundPlayerOpenAL;
-				bool bufferAllocated;
 				ALuint buffer;
 			};
 
@@ -86,11 +90,20 @@ namespace Shared {
 				static const size_t STREAMFRAGMENTSIZE
 					= STREAMBUFFERSIZE / STREAMFRAGMENTS;
 
+				// The decoder reads ahead by this much
+				static const size_t STREAMDECODESIZE = STREAMBUFFERSIZE / 2;
+				static const size_t STREAMDECODECHUNKSIZE = 64 * 1024;
+
 				bool fillBufferAndQueue(ALuint buffer);
 
 				StrSound* sound;
 				ALuint buffers[STREAMFRAGMENTS];
+				vector<ALuint> freeBuffers;
+				vector<int8> fragment;
 				ALenum format;
+				uint32 samplesPerSecond;
+				bool started;
+				StreamDecodeBuffer decodeBuffer;
 
 				enum FadeState { NoFading, FadingOn, FadingOff };
 				FadeState fadeState;
@@ -104,7 +117,7 @@ namespace Shared {
 			///	SoundPlayer implementation using SDL_mixer
 			// ==============================================================
 
-			class SoundPlayerOpenAL : public SoundPlayer {
+			class SoundPlayerOpenAL : public SoundPlayer, public SoundCacheListener {
 			public:
 				SoundPlayerOpenAL();
 				virtual ~SoundPlayerOpenAL();
@@ -116,6 +129,8 @@ namespace Shared {
 				virtual void stopAllSounds(int64 fadeOff=0);
 				virtual void updateStreams();	//updates str buffers if needed
 
+				virtual void SoundCache_SamplesFreed(const int8 *samples);
+
 			private:
 				friend class SoundSource;
 				friend class StaticSoundSource;
@@ -125,6 +140,8 @@ namespace Shared {
 
 				StaticSoundSource* findStaticSoundSource();
 				StreamSoundSource* findStreamSoundSource();
+				ALuint getStaticBuffer(StaticSound *staticSound);
+				void deleteStaticBuffers();
 				void checkAlcError(string message);
 				static void checkAlError(string message);
 
@@ -136,6 +153,11 @@ namespace Shared {
 				typedef std::vector<StreamSoundSource*> StreamSoundSources;
 				StreamSoundSources streamSources;
 
+				// One AL buffer per cached sample data, guarded by
+				// mutexStaticSources with the static sources
+				Mutex *mutexStaticSources;
+				std::map<const int8 *, ALuint> staticBuffers;
+
 				SoundPlayerParams params;
 			};
 		}
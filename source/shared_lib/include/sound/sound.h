@@ -121,6 +121,7 @@ namespace Shared {
 
 		class StaticSound : public Sound {
 		private:
+			// Shared with every StaticSound of the same file, see SoundCache
 			int8 * samples;
 
 		public:
@@ -0,0 +1,97 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+
+#ifndef _SHARED_SOUND_SOUNDCACHE_H_
+#define _SHARED_SOUND_SOUNDCACHE_H_
+
+#include "sound.h"
+#include "thread.h"
+#include <map>
+#include <vector>
+#include "leak_dumper.h"
+
+using std::map;
+using std::vector;
+using Shared::Platform::Mutex;
+
+namespace Shared {
+	namespace Sound {
+
+		class SoundCacheListener {
+		public:
+			virtual ~SoundCacheListener() {
+			}
+			// Called before the samples are deleted
+			virtual void SoundCache_SamplesFreed(const int8 *samples) = 0;
+		};
+
+		// =====================================================
+		//	class SoundCache
+		//
+		//	Decoded samples of static sounds, shared by every
+		//	StaticSound loaded from the same file. Samples nobody
+		//	references any more are kept until they exceed the
+		//	unused limit, the least recently released go first
+		// =====================================================
+
+		class SoundCache {
+		private:
+			struct Entry {
+				int8 *samples;
+				SoundInfo info;
+				int refCount;
+				uint64 lastReleased;
+			};
+
+			static Mutex *mutexCache;
+			static Mutex *mutexListeners;
+			static map<string, Entry> entryList;
+			static vector<SoundCacheListener *> listenerList;
+			static uint64 maxUnusedBytes;
+			static uint64 unusedBytes;
+			static uint64 totalBytes;
+			static uint64 releaseCount;
+			static int64 hitCount;
+			static int64 missCount;
+			static int64 evictionCount;
+
+			static int8 * decode(const string &path, SoundInfo *info);
+			static void trim(uint64 maxBytes, vector<int8 *> &freeList);
+			static void freeSamples(const vector<int8 *> &freeList);
+
+		public:
+			// Returns the shared samples of the file, decoding it on a miss.
+			// Every acquire needs a matching release
+			static int8 * acquire(const string &path, SoundInfo *info);
+			static void release(const string &path);
+
+			static void setMaxUnusedBytes(uint64 value);
+			static void clearUnused();
+
+			static void addListener(SoundCacheListener *listener);
+			static void removeListener(SoundCacheListener *listener);
+
+			static string getStats();
+		};
+
+	}
+} //end namespace
+
+#endif
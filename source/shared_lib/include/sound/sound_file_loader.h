@@ -24,12 +24,12 @@
 #include <fstream>
 #include "data_types.h"
 #include "factory.h"
+#include "virtual_file_system.h"
 #include "leak_dumper.h"
 
 struct OggVorbis_File;
 
 using std::string;
-using std::ifstream;
 
 namespace Shared {
 	namespace Sound {
@@ -37,6 +37,8 @@ namespace Shared {
 		using Platform::uint32;
 		using Platform::int8;
 		using Util::MultiFactory;
+		using PlatformCommon::VirtualFile;
+		using PlatformCommon::VirtualFileStream;
 
 		class SoundInfo;
 
@@ -72,7 +74,7 @@ namespace Shared {
 			uint32 dataOffset;
 			uint32 dataSize;
 			uint32 bytesPerSecond;
-			ifstream f;
+			VirtualFileStream f;
 
 		public:
 			virtual void open(const string &path, SoundInfo *soundInfo);
@@ -93,7 +95,7 @@ namespace Shared {
 		class OggSoundFileLoader : public SoundFileLoader {
 		private:
 			OggVorbis_File *vf;
-			FILE *f;
+			VirtualFile f;
 			string fileName;
 
 		public:
@@ -0,0 +1,124 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+
+#ifndef _SHARED_SOUND_SOUNDSTREAMDECODER_H_
+#define _SHARED_SOUND_SOUNDSTREAMDECODER_H_
+
+#include "sound.h"
+#include "base_thread.h"
+#include "lock_free_queue.h"
+#include <atomic>
+#include <vector>
+#include "leak_dumper.h"
+
+using std::vector;
+using Shared::PlatformCommon::BaseThread;
+using Shared::PlatformCommon::LockFreeQueue;
+using Shared::Platform::Mutex;
+using Shared::Platform::Semaphore;
+
+namespace Shared {
+	namespace Sound {
+
+		class StreamDecodeThread;
+
+		// =====================================================
+		//	class StreamDecodeBuffer
+		//
+		//	Read ahead of one playing StrSound. The decode thread
+		//	fills the ring and moves on to the next sound of the
+		//	chain at the end of each file, the player drains it
+		// =====================================================
+
+		class StreamDecodeBuffer {
+		private:
+			// Only touched by the decode thread while registered
+			StrSound *sound;
+			vector<int8> chunk;
+			LockFreeQueue<int8> ring;
+			// The sound decoded last, published for the player
+			std::atomic<StrSound *> currentSound;
+
+			friend class StreamDecoder;
+			bool decodeChunk();
+
+		public:
+			StreamDecodeBuffer(size_t capacity, size_t chunkSize);
+
+			// Only while not registered with the StreamDecoder
+			void reset(StrSound *sound);
+
+			// The sound of the chain the decoder has moved on to
+			StrSound * getCurrentSound() const {
+				return currentSound.load();
+			}
+
+			size_t available() const {
+				return ring.size();
+			}
+			size_t read(int8 *samples, size_t size) {
+				return ring.read(samples, size);
+			}
+		};
+
+		// =====================================================
+		//	class StreamDecoder
+		//
+		//	Decodes the registered stream buffers on one background
+		//	thread, started with the first buffer
+		// =====================================================
+
+		class StreamDecoder {
+		private:
+			static Mutex *mutexBuffers;
+			static Semaphore *semWork;
+			static vector<StreamDecodeBuffer *> bufferList;
+			static StreamDecodeThread *thread;
+
+			friend class StreamDecodeThread;
+
+		public:
+			static void add(StreamDecodeBuffer *buffer);
+			// Waits for the chunk being decoded into the buffer, if any
+			static void remove(StreamDecodeBuffer *buffer);
+			static void shutdown();
+
+			// Decodes one chunk into every buffer with room for it, returns
+			// false if none had. The thread calls this, it may be called
+			// directly when no thread is wanted
+			static bool decodeChunks();
+			// Tells the thread that buffers were drained
+			static void wakeUp();
+		};
+
+		// =====================================================
+		//	class StreamDecodeThread
+		// =====================================================
+
+		class StreamDecodeThread : public BaseThread {
+		public:
+			StreamDecodeThread();
+			virtual void execute();
+		};
+
+	}
+} //end namespace
+
+#endif
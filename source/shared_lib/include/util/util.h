@@ -193,6 +193,11 @@ namespace Shared {
 
 			static size_t httpWriteMemoryCallback(void *ptr, size_t size, size_t nmemb, void *data);
 			static std::string getHTTP(std::string URL, CURL *handle = NULL, int timeOut = -1, CURLcode *savedResult = NULL);
+			// Conditional GET, sends the etag as If-None-Match and replaces it with
+			// the one the server returns. notModified is set on a 304 reply, the
+			// returned body is empty then
+			static std::string getHTTPIfChanged(std::string URL, std::string &etag, bool &notModified,
+				CURL *handle = NULL, int timeOut = -1, CURLcode *savedResult = NULL);
 			static std::string escapeURL(std::string URL, CURL *handle = NULL);
 
 			static CURL *initHTTP();
@@ -162,6 +162,22 @@ namespace Shared {
 			void load(const string &path, const std::map<string, string> &mapTagReplacementValues, bool noValidation = false, bool skipStackCheck = false, bool skipStackTrace = false);
 			void save(const string &path);
 
+			// Compact binary form of the tree for in memory hand over, a lot
+			// smaller and faster to read back than the XML text
+			void saveToBinary(std::vector<char> &buffer) const;
+			void loadFromBinary(const char *data, size_t dataSize, const std::map<string, string> &mapTagReplacementValues, bool applyTagsToText = false);
+
+			// Parses an xml file straight into the binary form without applying
+			// any tag replacements. Loading that with applyTagsToText gives the
+			// same tree as load() would
+			static void parseFileToBinary(const string &path, std::vector<char> &buffer);
+
+			// Chunked binary file for saved games, written and read back one
+			// chunk at a time. compressionLevel 0 stores the chunks as is
+			void saveToChunkedBinaryFile(const string &path, int compressionLevel) const;
+			void loadFromChunkedBinaryFile(const string &path, const std::map<string, string> &mapTagReplacementValues);
+			static bool isChunkedBinaryFile(const string &path);
+
 			XmlNode *getRootNode() const {
 				return rootNode;
 			}
@@ -172,6 +188,8 @@ namespace Shared {
 		// =====================================================
 
 		class XmlNode {
+			friend class XmlTree;
+
 		private:
 			string name;
 			string text;
@@ -245,7 +263,6 @@ namespace Shared {
 			string name;
 			bool skipRestrictionCheck;
 			bool usesCommondata;
-			std::map<string, string> mapTagReplacementValues;
 
 		private:
 			XmlAttribute(XmlAttribute&);
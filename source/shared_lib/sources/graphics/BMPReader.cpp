@@ -80,10 +80,10 @@ namespace Shared {
 		}
 
 		/**Reads a Pixmap2D-object
-		  *This function reads a Pixmap2D-object from the given ifstream utilising the already existing Pixmap2D* ret.
+		  *This function reads a Pixmap2D-object from the given istream utilising the already existing Pixmap2D* ret.
 		  *Path is used for printing error messages
 		  *@return <code>NULL</code> if the Pixmap2D could not be read, else the pixmap*/
-		Pixmap2D* BMPReader::read(ifstream& in, const string& path, Pixmap2D* ret) const {
+		Pixmap2D* BMPReader::read(istream& in, const string& path, Pixmap2D* ret) const {
 			if (GlobalStaticFlags::getIsNonGraphicalModeEnabled() == true) {
 				throw game_runtime_error("Loading graphics in headless server mode not allowed!");
 			}
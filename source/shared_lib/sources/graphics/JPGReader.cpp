@@ -79,7 +79,7 @@ namespace Shared {
 		JPGReader::JPGReader() : FileReader<Pixmap2D>(getExtensions()) {
 		}
 
-		Pixmap2D* JPGReader::read(ifstream& is, const string& path, Pixmap2D* ret) const {
+		Pixmap2D* JPGReader::read(istream& is, const string& path, Pixmap2D* ret) const {
 			if (GlobalStaticFlags::getIsNonGraphicalModeEnabled() == true) {
 				throw game_runtime_error("Loading graphics in headless server mode not allowed!");
 			}
@@ -38,7 +38,7 @@ namespace Shared {
 		// =====================================================
 
 		static void user_read_data(png_structp read_ptr, png_bytep data, png_size_t length) {
-			ifstream& is = *((ifstream*) png_get_io_ptr(read_ptr));
+			istream& is = *((istream*) png_get_io_ptr(read_ptr));
 			is.read((char*) data, (std::streamsize)length);
 			static bool bigEndianSystem = Shared::PlatformByteOrder::isBigEndian();
 			if (bigEndianSystem == true) {
@@ -72,7 +72,7 @@ namespace Shared {
 		PNGReader::PNGReader() : FileReader<Pixmap2D>(getExtensionsPng()) {
 		}
 
-		Pixmap2D* PNGReader::read(ifstream& is, const string& path, Pixmap2D* ret) const {
+		Pixmap2D* PNGReader::read(istream& is, const string& path, Pixmap2D* ret) const {
 			if (GlobalStaticFlags::getIsNonGraphicalModeEnabled() == true) {
 				throw game_runtime_error("Loading graphics in headless server mode not allowed!");
 			}
@@ -225,7 +225,7 @@ namespace Shared {
 		PNGReader3D::PNGReader3D() : FileReader<Pixmap3D>(getExtensionsPng()) {
 		}
 
-		Pixmap3D* PNGReader3D::read(ifstream& is, const string& path, Pixmap3D* ret) const {
+		Pixmap3D* PNGReader3D::read(istream& is, const string& path, Pixmap3D* ret) const {
 			//Read file
 			is.seekg(0, ios::end);
 			//size_t length = is.tellg();
@@ -75,7 +75,7 @@ namespace Shared {
 		TGAReader3D::TGAReader3D() : FileReader<Pixmap3D>(getExtensionStrings()) {
 		}
 
-		Pixmap3D* TGAReader3D::read(ifstream& in, const string& path, Pixmap3D* ret) const {
+		Pixmap3D* TGAReader3D::read(istream& in, const string& path, Pixmap3D* ret) const {
 			//printf("In [%s] line: %d\n",__FILE__,__LINE__);
 		//	try {
 			if (GlobalStaticFlags::getIsNonGraphicalModeEnabled() == true) {
@@ -222,7 +222,7 @@ namespace Shared {
 		TGAReader::TGAReader() : FileReader<Pixmap2D>(getExtensionStrings()) {
 		}
 
-		Pixmap2D* TGAReader::read(ifstream& in, const string& path, Pixmap2D* ret) const {
+		Pixmap2D* TGAReader::read(istream& in, const string& path, Pixmap2D* ret) const {
 			//printf("In [%s] line: %d\n",__FILE__,__LINE__);
 			//try {
 				//read header
@@ -305,6 +305,11 @@ namespace Shared {
 					}
 					
 					//texture state
+					for (int i = 0; i < MESH_TEXTURE_COUNT; ++i) {
+						if (mesh->getTexture(i) != NULL) {
+							mesh->getTexture(i)->markUsed();
+						}
+					}
 					const Texture2DGl *texture = static_cast<const Texture2DGl*>(mesh->getTexture(0));
 					if (texture != NULL && renderTextures) {
 						if (lastTexture != texture->getHandle()) {
@@ -769,6 +769,7 @@ namespace Shared {
 			}
 
 			void Texture2DGl::init(Filter filter, int maxAnisotropy) {
+				waitForDecode();
 				assertGl();
 
 				if (inited == false) {
@@ -944,6 +945,7 @@ namespace Shared {
 					}
 					inited = true;
 					OutputTextureDebugInfo(format, pixmap.getComponents(), getPath(), pixmap.getPixelByteCount(), GL_TEXTURE_2D);
+					uploadFinished();
 				}
 
 				assertGl();
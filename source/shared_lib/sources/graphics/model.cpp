@@ -46,6 +46,59 @@ namespace Shared {
 
 		using namespace Util;
 
+		// =====================================================
+		//	class G3dFileReader
+		// =====================================================
+
+		G3dFileReader::G3dFileReader() {
+			data = NULL;
+			size = 0;
+			offset = 0;
+		}
+
+		G3dFileReader::~G3dFileReader() {
+			close();
+		}
+
+		bool G3dFileReader::open(const string &path) {
+			close();
+
+			if (file.open(path) == false) {
+				return false;
+			}
+			// Stored and loose files are handed out without a copy, only
+			// deflated archive entries get inflated into memory here
+			data = file.getData();
+			size = (data != NULL ? (size_t) file.getSize() : 0);
+			return true;
+		}
+
+		void G3dFileReader::close() {
+			file.close();
+			data = NULL;
+			size = 0;
+			offset = 0;
+		}
+
+		int G3dFileReader::seek(long delta) {
+			// Like fseek with SEEK_CUR, moving past the end is allowed
+			if (delta < 0 && (size_t) (-delta) > offset) {
+				return -1;
+			}
+			offset = (size_t) ((long) offset + delta);
+			return 0;
+		}
+
+		size_t G3dFileReader::read(void *dest, size_t itemSize, size_t itemCount) {
+			if (itemSize == 0 || data == NULL) {
+				return 0;
+			}
+			size_t count = (offset < size ? min(itemCount, (size - offset) / itemSize) : 0);
+			memcpy(dest, data + offset, count * itemSize);
+			offset += count * itemSize;
+			return count;
+		}
+
 		// Utils methods for endianness conversion
 		void toEndianFileHeader(FileHeader &header) {
 			static bool bigEndianSystem = Shared::PlatformByteOrder::isBigEndian();
@@ -412,13 +465,13 @@ namespace Shared {
 			return result;
 		}
 
-		void Mesh::loadV2(int meshIndex, const string &dir, FILE *f, TextureManager *textureManager,
+		void Mesh::loadV2(int meshIndex, const string &dir, G3dFileReader *f, TextureManager *textureManager,
 			bool deletePixMapAfterLoad, std::map<string, vector<pair<string, string> > > *loadedFileList,
 			string sourceLoader, string modelFile) {
 			this->textureManager = textureManager;
 			//read header
 			MeshHeaderV2 meshHeader;
-			size_t readBytes = fread(&meshHeader, sizeof(MeshHeaderV2), 1, f);
+			size_t readBytes = f->read(&meshHeader, sizeof(MeshHeaderV2), 1);
 			if (readBytes != 1) {
 				char szBuf[8096] = "";
 				snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " on line: %d.", readBytes, __LINE__);
@@ -498,7 +551,7 @@ namespace Shared {
 			}
 
 			//read data
-			readBytes = fread(vertices, sizeof(Vec3f)*frameCount*vertexCount, 1, f);
+			readBytes = f->read(vertices, sizeof(Vec3f)*frameCount*vertexCount, 1);
 			if (readBytes != 1 && (frameCount * vertexCount) != 0) {
 				char szBuf[8096] = "";
 				snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " [%u][%u] on line: %d.", readBytes, frameCount, vertexCount, __LINE__);
@@ -506,7 +559,7 @@ namespace Shared {
 			}
 			fromEndianVecArray<Vec3f>(vertices, frameCount*vertexCount);
 
-			readBytes = fread(normals, sizeof(Vec3f)*frameCount*vertexCount, 1, f);
+			readBytes = f->read(normals, sizeof(Vec3f)*frameCount*vertexCount, 1);
 			if (readBytes != 1 && (frameCount * vertexCount) != 0) {
 				char szBuf[8096] = "";
 				snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " [%u][%u] on line: %d.", readBytes, frameCount, vertexCount, __LINE__);
@@ -515,7 +568,7 @@ namespace Shared {
 			fromEndianVecArray<Vec3f>(normals, frameCount*vertexCount);
 
 			if ((textureFlags & mtDiffuse) == mtDiffuse) {
-				readBytes = fread(texCoords, sizeof(Vec2f)*vertexCount, 1, f);
+				readBytes = f->read(texCoords, sizeof(Vec2f)*vertexCount, 1);
 				if (readBytes != 1 && vertexCount != 0) {
 					char szBuf[8096] = "";
 					snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " [%u][%u] on line: %d.", readBytes, frameCount, vertexCount, __LINE__);
@@ -523,7 +576,7 @@ namespace Shared {
 				}
 				fromEndianVecArray<Vec2f>(texCoords, vertexCount);
 			}
-			readBytes = fread(&diffuseColor, sizeof(Vec3f), 1, f);
+			readBytes = f->read(&diffuseColor, sizeof(Vec3f), 1);
 			if (readBytes != 1) {
 				char szBuf[8096] = "";
 				snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " on line: %d.", readBytes, __LINE__);
@@ -531,7 +584,7 @@ namespace Shared {
 			}
 			fromEndianVecArray<Vec3f>(&diffuseColor, 1);
 
-			readBytes = fread(&opacity, sizeof(float32), 1, f);
+			readBytes = f->read(&opacity, sizeof(float32), 1);
 			if (readBytes != 1) {
 				char szBuf[8096] = "";
 				snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " on line: %d.", readBytes, __LINE__);
@@ -539,13 +592,13 @@ namespace Shared {
 			}
 			opacity = Shared::PlatformByteOrder::fromCommonEndian(opacity);
 
-			int seek_result = fseek(f, sizeof(Vec4f)*(meshHeader.colorFrameCount - 1), SEEK_CUR);
+			int seek_result = f->seek((long) (sizeof(Vec4f)*(meshHeader.colorFrameCount - 1)));
 			if (seek_result != 0) {
 				char szBuf[8096] = "";
 				snprintf(szBuf, 8096, "fseek returned failure = %d [%u] on line: %d.", seek_result, indexCount, __LINE__);
 				throw game_runtime_error(szBuf);
 			}
-			readBytes = fread(indices, sizeof(uint32)*indexCount, 1, f);
+			readBytes = f->read(indices, sizeof(uint32)*indexCount, 1);
 			if (readBytes != 1 && indexCount != 0) {
 				char szBuf[8096] = "";
 				snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " [%u] on line: %d.", readBytes, indexCount, __LINE__);
@@ -554,7 +607,7 @@ namespace Shared {
 			Shared::PlatformByteOrder::fromEndianTypeArray<uint32>(indices, indexCount);
 		}
 
-		void Mesh::loadV3(int meshIndex, const string &dir, FILE *f,
+		void Mesh::loadV3(int meshIndex, const string &dir, G3dFileReader *f,
 			TextureManager *textureManager, bool deletePixMapAfterLoad,
 			std::map<string, vector<pair<string, string> > > *loadedFileList,
 			string sourceLoader, string modelFile) {
@@ -562,7 +615,7 @@ namespace Shared {
 
 			//read header
 			MeshHeaderV3 meshHeader;
-			size_t readBytes = fread(&meshHeader, sizeof(MeshHeaderV3), 1, f);
+			size_t readBytes = f->read(&meshHeader, sizeof(MeshHeaderV3), 1);
 			if (readBytes != 1) {
 				char szBuf[8096] = "";
 				snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " on line: %d.", readBytes, __LINE__);
@@ -639,7 +692,7 @@ namespace Shared {
 			}
 
 			//read data
-			readBytes = fread(vertices, sizeof(Vec3f)*frameCount*vertexCount, 1, f);
+			readBytes = f->read(vertices, sizeof(Vec3f)*frameCount*vertexCount, 1);
 			if (readBytes != 1 && (frameCount * vertexCount) != 0) {
 				char szBuf[8096] = "";
 				snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " [%u][%u] on line: %d.", readBytes, frameCount, vertexCount, __LINE__);
@@ -647,7 +700,7 @@ namespace Shared {
 			}
 			fromEndianVecArray<Vec3f>(vertices, frameCount*vertexCount);
 
-			readBytes = fread(normals, sizeof(Vec3f)*frameCount*vertexCount, 1, f);
+			readBytes = f->read(normals, sizeof(Vec3f)*frameCount*vertexCount, 1);
 			if (readBytes != 1 && (frameCount * vertexCount) != 0) {
 				char szBuf[8096] = "";
 				snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " [%u][%u] on line: %d.", readBytes, frameCount, vertexCount, __LINE__);
@@ -657,7 +710,7 @@ namespace Shared {
 
 			if ((textureFlags & mtDiffuse) == mtDiffuse) {
 				for (unsigned int i = 0; i < meshHeader.texCoordFrameCount; ++i) {
-					readBytes = fread(texCoords, sizeof(Vec2f)*vertexCount, 1, f);
+					readBytes = f->read(texCoords, sizeof(Vec2f)*vertexCount, 1);
 					if (readBytes != 1 && vertexCount != 0) {
 						char szBuf[8096] = "";
 						snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " [%u][%u] on line: %d.", readBytes, frameCount, vertexCount, __LINE__);
@@ -666,7 +719,7 @@ namespace Shared {
 					fromEndianVecArray<Vec2f>(texCoords, vertexCount);
 				}
 			}
-			readBytes = fread(&diffuseColor, sizeof(Vec3f), 1, f);
+			readBytes = f->read(&diffuseColor, sizeof(Vec3f), 1);
 			if (readBytes != 1) {
 				char szBuf[8096] = "";
 				snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " on line: %d.", readBytes, __LINE__);
@@ -674,7 +727,7 @@ namespace Shared {
 			}
 			fromEndianVecArray<Vec3f>(&diffuseColor, 1);
 
-			readBytes = fread(&opacity, sizeof(float32), 1, f);
+			readBytes = f->read(&opacity, sizeof(float32), 1);
 			if (readBytes != 1) {
 				char szBuf[8096] = "";
 				snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " on line: %d.", readBytes, __LINE__);
@@ -682,14 +735,14 @@ namespace Shared {
 			}
 			opacity = Shared::PlatformByteOrder::fromCommonEndian(opacity);
 
-			int seek_result = fseek(f, sizeof(Vec4f)*(meshHeader.colorFrameCount - 1), SEEK_CUR);
+			int seek_result = f->seek((long) (sizeof(Vec4f)*(meshHeader.colorFrameCount - 1)));
 			if (seek_result != 0) {
 				char szBuf[8096] = "";
 				snprintf(szBuf, 8096, "fseek returned failure = %d [%u] on line: %d.", seek_result, indexCount, __LINE__);
 				throw game_runtime_error(szBuf);
 			}
 
-			readBytes = fread(indices, sizeof(uint32)*indexCount, 1, f);
+			readBytes = f->read(indices, sizeof(uint32)*indexCount, 1);
 			if (readBytes != 1 && indexCount != 0) {
 				char szBuf[8096] = "";
 				snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " [%u] on line: %d.", readBytes, indexCount, __LINE__);
@@ -727,7 +780,7 @@ namespace Shared {
 					if (textureChannelCount != -1) {
 						texture->getPixmap()->init(textureChannelCount);
 					}
-					texture->load(textureFile);
+					textureManager->loadTexture2DAsync(texture, textureFile, true);
 					if (loadedFileList) {
 						(*loadedFileList)[textureFile].push_back(make_pair(sourceLoader, sourceLoader));
 					}
@@ -735,7 +788,6 @@ namespace Shared {
 					//if(SystemFlags::VERBOSE_MODE_ENABLED) printf("In [%s] texture loaded [%s]\n",__FUNCTION__,textureFile.c_str());
 
 					textureOwned = true;
-					texture->init(textureManager->getTextureFilter(), textureManager->getMaxAnisotropy());
 					if (deletePixMapAfterLoad == true) {
 						texture->deletePixels();
 					}
@@ -750,14 +802,14 @@ namespace Shared {
 			return texture;
 		}
 
-		void Mesh::load(int meshIndex, const string &dir, FILE *f, TextureManager *textureManager,
+		void Mesh::load(int meshIndex, const string &dir, G3dFileReader *f, TextureManager *textureManager,
 			bool deletePixMapAfterLoad, std::map<string, vector<pair<string, string> > > *loadedFileList,
 			string sourceLoader, string modelFile) {
 			this->textureManager = textureManager;
 
 			//read header
 			MeshHeader meshHeader;
-			size_t readBytes = fread(&meshHeader, sizeof(MeshHeader), 1, f);
+			size_t readBytes = f->read(&meshHeader, sizeof(MeshHeader), 1);
 			if (readBytes != 1) {
 				char szBuf[8096] = "";
 				snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " on line: %d.", readBytes, __LINE__);
@@ -803,7 +855,7 @@ namespace Shared {
 				if (meshHeader.textures & flag) {
 					uint8 cMapPath[mapPathSize + 1];
 					memset(&cMapPath[0], 0, mapPathSize + 1);
-					readBytes = fread(cMapPath, mapPathSize, 1, f);
+					readBytes = f->read(cMapPath, mapPathSize, 1);
 					cMapPath[mapPathSize] = 0;
 					if (readBytes != 1 && mapPathSize != 0) {
 						char szBuf[8096] = "";
@@ -833,7 +885,7 @@ namespace Shared {
 			}
 
 			//read data
-			readBytes = fread(vertices, sizeof(Vec3f)*frameCount*vertexCount, 1, f);
+			readBytes = f->read(vertices, sizeof(Vec3f)*frameCount*vertexCount, 1);
 			if (readBytes != 1 && (frameCount * vertexCount) != 0) {
 				char szBuf[8096] = "";
 				snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " [%u][%u] on line: %d.", readBytes, frameCount, vertexCount, __LINE__);
@@ -841,7 +893,7 @@ namespace Shared {
 			}
 			fromEndianVecArray<Vec3f>(vertices, frameCount*vertexCount);
 
-			readBytes = fread(normals, sizeof(Vec3f)*frameCount*vertexCount, 1, f);
+			readBytes = f->read(normals, sizeof(Vec3f)*frameCount*vertexCount, 1);
 			if (readBytes != 1 && (frameCount * vertexCount) != 0) {
 				char szBuf[8096] = "";
 				snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " [%u][%u] on line: %d.", readBytes, frameCount, vertexCount, __LINE__);
@@ -850,7 +902,7 @@ namespace Shared {
 			fromEndianVecArray<Vec3f>(normals, frameCount*vertexCount);
 
 			if (meshHeader.textures != 0) {
-				readBytes = fread(texCoords, sizeof(Vec2f)*vertexCount, 1, f);
+				readBytes = f->read(texCoords, sizeof(Vec2f)*vertexCount, 1);
 				if (readBytes != 1 && vertexCount != 0) {
 					char szBuf[8096] = "";
 					snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " [%u][%u] on line: %d.", readBytes, frameCount, vertexCount, __LINE__);
@@ -858,7 +910,7 @@ namespace Shared {
 				}
 				fromEndianVecArray<Vec2f>(texCoords, vertexCount);
 			}
-			readBytes = fread(indices, sizeof(uint32)*indexCount, 1, f);
+			readBytes = f->read(indices, sizeof(uint32)*indexCount, 1);
 			if (readBytes != 1 && indexCount != 0) {
 				char szBuf[8096] = "";
 				snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " [%u] on line: %d.", readBytes, indexCount, __LINE__);
@@ -1176,12 +1228,8 @@ namespace Shared {
 			string sourceLoader) {
 
 			try {
-#ifdef WIN32
-				FILE *f = _wfopen(utf8_decode(path).c_str(), L"rb");
-#else
-				FILE *f = fopen(path.c_str(), "rb");
-#endif
-				if (f == NULL) {
+				G3dFileReader f;
+				if (f.open(path) == false) {
 					printf("In [%s::%s] cannot load file = [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, path.c_str());
 					throw game_runtime_error("Error opening g3d model file [" + path + "]", true);
 				}
@@ -1194,9 +1242,8 @@ namespace Shared {
 
 				//file header
 				FileHeader fileHeader;
-				size_t readBytes = fread(&fileHeader, sizeof(FileHeader), 1, f);
+				size_t readBytes = f.read(&fileHeader, sizeof(FileHeader), 1);
 				if (readBytes != 1) {
-					fclose(f);
 					char szBuf[8096] = "";
 					snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " on line: %d.", readBytes, __LINE__);
 					throw game_runtime_error(szBuf);
@@ -1208,8 +1255,6 @@ namespace Shared {
 				memcpy(&fileId[0], reinterpret_cast<char*>(fileHeader.id), 3);
 
 				if (strncmp(fileId, "G3D", 3) != 0) {
-					fclose(f);
-					f = NULL;
 					printf("In [%s::%s] file = [%s] fileheader.id = [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, path.c_str(), fileId);
 					throw game_runtime_error("Not a valid G3D model", true);
 				}
@@ -1221,7 +1266,7 @@ namespace Shared {
 				if (fileHeader.version == 4) {
 					//model header
 					ModelHeader modelHeader;
-					readBytes = fread(&modelHeader, sizeof(ModelHeader), 1, f);
+					readBytes = f.read(&modelHeader, sizeof(ModelHeader), 1);
 					if (readBytes != 1) {
 						char szBuf[8096] = "";
 						snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " on line: %d.", readBytes, __LINE__);
@@ -1247,14 +1292,14 @@ namespace Shared {
 					}
 
 					for (uint32 i = 0; i < meshCount; ++i) {
-						meshes[i].load(i, dir, f, textureManager, deletePixMapAfterLoad,
+						meshes[i].load(i, dir, &f, textureManager, deletePixMapAfterLoad,
 							loadedFileList, sourceLoader, path);
 						meshes[i].buildInterpolationData();
 					}
 				}
 				//version 3
 				else if (fileHeader.version == 3) {
-					readBytes = fread(&meshCount, sizeof(meshCount), 1, f);
+					readBytes = f.read(&meshCount, sizeof(meshCount), 1);
 					if (readBytes != 1 && meshCount != 0) {
 						char szBuf[8096] = "";
 						snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " [%u] on line: %d.", readBytes, meshCount, __LINE__);
@@ -1273,14 +1318,14 @@ namespace Shared {
 					}
 
 					for (uint32 i = 0; i < meshCount; ++i) {
-						meshes[i].loadV3(i, dir, f, textureManager, deletePixMapAfterLoad,
+						meshes[i].loadV3(i, dir, &f, textureManager, deletePixMapAfterLoad,
 							loadedFileList, sourceLoader, path);
 						meshes[i].buildInterpolationData();
 					}
 				}
 				//version 2
 				else if (fileHeader.version == 2) {
-					readBytes = fread(&meshCount, sizeof(meshCount), 1, f);
+					readBytes = f.read(&meshCount, sizeof(meshCount), 1);
 					if (readBytes != 1 && meshCount != 0) {
 						char szBuf[8096] = "";
 						snprintf(szBuf, 8096, "fread returned wrong size = " SIZE_T_SPECIFIER " [%u] on line: %d.", readBytes, meshCount, __LINE__);
@@ -1300,7 +1345,7 @@ namespace Shared {
 					}
 
 					for (uint32 i = 0; i < meshCount; ++i) {
-						meshes[i].loadV2(i, dir, f, textureManager, deletePixMapAfterLoad,
+						meshes[i].loadV2(i, dir, &f, textureManager, deletePixMapAfterLoad,
 							loadedFileList, sourceLoader, path);
 						meshes[i].buildInterpolationData();
 					}
@@ -1308,7 +1353,7 @@ namespace Shared {
 					throw game_runtime_error("Invalid model version: " + intToStr(fileHeader.version));
 				}
 
-				fclose(f);
+				f.close();
 
 				autoJoinMeshFrames();
 			} catch (game_runtime_error& ex) {
@@ -18,6 +18,7 @@
 // along with this program. If not, see <https://www.gnu.org/licenses/>
 
 #include "texture.h"
+#include "texture_decoder.h"
 #include "util.h"
 #include <SDL.h>
 #include "platform_util.h"
@@ -94,7 +95,27 @@ namespace Shared {
 		//	class Texture2D
 		// =====================================================
 
+		uint32 Texture2D::currentFrame = 0;
+
+		Texture2D::Texture2D() : Texture() {
+			decodeJob = NULL;
+			awaitingUpload = false;
+			deletePixelsOnUpload = false;
+			evictable = false;
+			evicted = false;
+			lastUsedFrame = 0;
+		}
+
+		Texture2D::~Texture2D() {
+			try {
+				waitForDecode();
+			} catch (const exception &ex) {
+				SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, ex.what());
+			}
+		}
+
 		std::pair<SDL_Surface*, unsigned char*> Texture2D::CreateSDLSurface(bool newPixelData) const {
+			waitForDecode();
 			std::pair<SDL_Surface*, unsigned char*> result;
 			result.first = NULL;
 			result.second = NULL;
@@ -227,6 +248,7 @@ namespace Shared {
 		}
 
 		void Texture2D::load(const string &path) {
+			waitForDecode();
 			this->path = path;
 			if (SystemFlags::getSystemSettingType(SystemFlags::debugSystem).enabled) SystemFlags::OutputDebug(SystemFlags::debugSystem, "In [%s::%s Line: %d] this->path = [%s]\n", __FILE__, __FUNCTION__, __LINE__, this->path.c_str());
 
@@ -237,11 +259,68 @@ namespace Shared {
 			this->path = path;
 		}
 
+		void Texture2D::loadAsync(const string &path) {
+			if (TextureDecoder::isEnabled() == false) {
+				load(path);
+				return;
+			}
+
+			waitForDecode();
+			this->path = path;
+			if (pixmap.getComponents() == -1) {
+				pixmap.init(defaultComponents);
+			}
+			awaitingUpload = (inited == false);
+			decodeJob = TextureDecoder::add(this, path);
+		}
+
+		bool Texture2D::isDecodePending() const {
+			return (decodeJob != NULL && TextureDecoder::isDone(decodeJob) == false);
+		}
+
+		void Texture2D::evict() {
+			waitForDecode();
+			end(true);
+			pixmap.deletePixels();
+			awaitingUpload = false;
+			deletePixelsOnUpload = false;
+			evicted = true;
+		}
+
+		void Texture2D::reload() {
+			evicted = false;
+			end(false);
+			loadAsync(path);
+		}
+
+		void Texture2D::finishDecode() const {
+			TextureDecodeJob *job = decodeJob;
+			decodeJob = NULL;
+			TextureDecoder::wait(job);
+		}
+
+		void Texture2D::uploadFinished() {
+			awaitingUpload = false;
+			if (deletePixelsOnUpload == true) {
+				deletePixelsOnUpload = false;
+				deletePixels();
+			}
+		}
+
 		string Texture2D::getPath() const {
+			// The worker thread is still writing the pixmap's path
+			if (decodeJob != NULL) {
+				return path;
+			}
 			return (pixmap.getPath() != "" ? pixmap.getPath() : path);
 		}
 
 		void Texture2D::deletePixels() {
+			if (awaitingUpload == true) {
+				deletePixelsOnUpload = true;
+				return;
+			}
+			waitForDecode();
 			//printf("+++> Texture2D pixmap deletion for [%s]\n",getPath().c_str());
 			pixmap.deletePixels();
 		}
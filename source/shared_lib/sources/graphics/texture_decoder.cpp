@@ -0,0 +1,174 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+
+#include "texture_decoder.h"
+
+#include <SDL.h>
+#include "texture.h"
+#include "platform_util.h"
+#include "util.h"
+#include "leak_dumper.h"
+
+using namespace Shared::Util;
+using namespace Shared::Platform;
+using namespace Shared::PlatformCommon;
+
+namespace Shared {
+	namespace Graphics {
+
+		// =====================================================
+		//	class TextureDecoder
+		// =====================================================
+
+		Mutex *TextureDecoder::mutexJobs = new Mutex(CODE_AT_LINE);
+		Semaphore *TextureDecoder::semJobs = new Semaphore();
+		deque<TextureDecodeJob *> TextureDecoder::jobList;
+		vector<TextureDecodeThread *> TextureDecoder::threadList;
+		int TextureDecoder::threadCount = 0;
+
+		void TextureDecoder::setThreadCount(int value) {
+			shutdown();
+			if (value == 0) {
+				value = max(SDL_GetCPUCount() - 1, 1);
+			}
+			threadCount = max(value, 0);
+		}
+
+		void TextureDecoder::shutdown() {
+			MutexSafeWrapper safeMutex(mutexJobs, CODE_AT_LINE);
+			vector<TextureDecodeThread *> stopList = threadList;
+			threadList.clear();
+			safeMutex.ReleaseLock();
+
+			for (unsigned int i = 0; i < stopList.size(); ++i) {
+				stopList[i]->signalQuit();
+				semJobs->signal();
+			}
+			// Queued jobs stay queued, waiting for them decodes them
+			for (unsigned int i = 0; i < stopList.size(); ++i) {
+				if (stopList[i]->shutdownAndWait() == true) {
+					delete stopList[i];
+				}
+			}
+		}
+
+		TextureDecodeJob * TextureDecoder::add(Texture2D *texture, const string &path) {
+			TextureDecodeJob *job = new TextureDecodeJob();
+			job->texture = texture;
+			job->path = path;
+			job->started = false;
+			job->done = false;
+
+			MutexSafeWrapper safeMutex(mutexJobs, CODE_AT_LINE);
+			jobList.push_back(job);
+			if (threadList.empty() == true) {
+				for (int i = 0; i < threadCount; ++i) {
+					TextureDecodeThread *thread = new TextureDecodeThread();
+					thread->start();
+					threadList.push_back(thread);
+				}
+			}
+			safeMutex.ReleaseLock();
+
+			semJobs->signal();
+			return job;
+		}
+
+		void TextureDecoder::decode(TextureDecodeJob *job) {
+			string error;
+			try {
+				job->texture->pixmap.load(job->path);
+			} catch (const exception &ex) {
+				error = ex.what();
+				SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error decoding [%s]: %s\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, job->path.c_str(), ex.what());
+			}
+
+			MutexSafeWrapper safeMutex(mutexJobs, CODE_AT_LINE);
+			job->error = error;
+			job->done = true;
+		}
+
+		bool TextureDecoder::runNextJob() {
+			MutexSafeWrapper safeMutex(mutexJobs, CODE_AT_LINE);
+			if (jobList.empty() == true) {
+				return false;
+			}
+			TextureDecodeJob *job = jobList.front();
+			jobList.pop_front();
+			job->started = true;
+			safeMutex.ReleaseLock();
+
+			decode(job);
+			return true;
+		}
+
+		bool TextureDecoder::isDone(TextureDecodeJob *job) {
+			MutexSafeWrapper safeMutex(mutexJobs, CODE_AT_LINE);
+			return job->done;
+		}
+
+		void TextureDecoder::wait(TextureDecodeJob *job) {
+			MutexSafeWrapper safeMutex(mutexJobs, CODE_AT_LINE);
+			if (job->started == false) {
+				for (deque<TextureDecodeJob *>::iterator iterJob = jobList.begin(); iterJob != jobList.end(); ++iterJob) {
+					if (*iterJob == job) {
+						jobList.erase(iterJob);
+						break;
+					}
+				}
+				job->started = true;
+				safeMutex.ReleaseLock();
+
+				decode(job);
+				safeMutex.Lock();
+			}
+			for (; job->done == false;) {
+				safeMutex.ReleaseLock();
+				sleep(1);
+				safeMutex.Lock();
+			}
+			string error = job->error;
+			safeMutex.ReleaseLock();
+
+			delete job;
+			if (error != "") {
+				throw game_runtime_error(error);
+			}
+		}
+
+		// =====================================================
+		//	class TextureDecodeThread
+		// =====================================================
+
+		TextureDecodeThread::TextureDecodeThread() : BaseThread() {
+			setUniqueID("TextureDecodeThread");
+		}
+
+		void TextureDecodeThread::execute() {
+			RunningStatusSafeWrapper runningStatus(this);
+			for (; getQuitStatus() == false;) {
+				if (TextureDecoder::runNextJob() == false) {
+					TextureDecoder::semJobs->waitTillSignalled(250);
+				}
+			}
+		}
+
+	}
+} //end namespace
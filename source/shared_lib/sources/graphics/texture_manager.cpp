@@ -24,6 +24,7 @@
 
 #include "graphics_interface.h"
 #include "graphics_factory.h"
+#include "texture_decoder.h"
 
 #include "util.h"
 #include "platform_util.h"
@@ -61,6 +62,7 @@ namespace Shared {
 
 		void TextureManager::endTexture(Texture *texture, bool mustExistInList) {
 			if (texture != NULL) {
+				removeTrackedTexture(texture);
 				bool found = false;
 				for (unsigned int idx = 0; idx < textures.size(); idx++) {
 					Texture *curTexture = textures[idx];
@@ -85,6 +87,7 @@ namespace Shared {
 				int index = (int) textures.size() - 1;
 				Texture *curTexture = textures[index];
 				textures.erase(textures.begin() + index);
+				removeTrackedTexture(curTexture);
 
 				curTexture->end();
 				delete curTexture;
@@ -100,6 +103,10 @@ namespace Shared {
 				if (texture == NULL) {
 					throw std::runtime_error("texture == NULL during init");
 				}
+				Texture2D *texture2D = dynamic_cast<Texture2D *>(texture);
+				if (texture2D != NULL && texture2D->getEvicted() == true) {
+					continue;
+				}
 				if (forceInit == true) {
 					texture->reseInitState();
 				}
@@ -108,9 +115,12 @@ namespace Shared {
 				}
 				texture->init(textureFilter, maxAnisotropy);
 			}
+			pendingUploads.clear();
 		}
 
 		void TextureManager::end() {
+			pendingUploads.clear();
+			evictableTextures.clear();
 			for (unsigned int i = 0; i < textures.size(); ++i) {
 				if (textures[i] != NULL) {
 					textures[i]->end();
@@ -128,6 +138,71 @@ namespace Shared {
 			this->maxAnisotropy = maxAnisotropy;
 		}
 
+		void TextureManager::removeTrackedTexture(Texture *texture) {
+			for (unsigned int i = 0; i < pendingUploads.size(); ++i) {
+				if (pendingUploads[i] == texture) {
+					pendingUploads.erase(pendingUploads.begin() + i);
+					break;
+				}
+			}
+			for (unsigned int i = 0; i < evictableTextures.size(); ++i) {
+				if (evictableTextures[i] == texture) {
+					evictableTextures.erase(evictableTextures.begin() + i);
+					break;
+				}
+			}
+		}
+
+		void TextureManager::loadTexture2DAsync(Texture2D *texture, const string &path, bool evictable) {
+			texture->loadAsync(path);
+			if (texture->isDecodePending() == true) {
+				pendingUploads.push_back(texture);
+			} else {
+				texture->init(textureFilter, maxAnisotropy);
+			}
+			if (evictable == true && texture->getEvictable() == false) {
+				texture->setEvictable(true);
+				texture->markUsed();
+				evictableTextures.push_back(texture);
+			}
+		}
+
+		void TextureManager::reloadTexture(Texture2D *texture) {
+			// Nothing reads the pixels of an evictable texture once it is
+			// uploaded, so the reloaded copy does not keep them either
+			texture->reload();
+			if (texture->isDecodePending() == true) {
+				pendingUploads.push_back(texture);
+			} else {
+				texture->init(textureFilter, maxAnisotropy);
+			}
+			texture->deletePixels();
+		}
+
+		int TextureManager::initDecodedTextures(int64 maxMillis) {
+			Chrono chrono;
+			chrono.start();
+			for (unsigned int i = 0; i < pendingUploads.size() && (maxMillis < 0 || chrono.getMillis() < maxMillis);) {
+				Texture2D *texture = pendingUploads[i];
+				if (texture->isDecodePending() == true) {
+					++i;
+					continue;
+				}
+				pendingUploads.erase(pendingUploads.begin() + i);
+
+				// A decode error comes out of init, reported like a failed
+				// synchronous load
+				string path = texture->getPath();
+				try {
+					texture->init(textureFilter, maxAnisotropy);
+				} catch (const exception &ex) {
+					SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error loading texture [%s]: %s\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, path.c_str(), ex.what());
+					throw game_runtime_error("Error loading texture [" + path + "]: " + ex.what());
+				}
+			}
+			return (int) pendingUploads.size();
+		}
+
 		Texture *TextureManager::getTexture(const string &path) {
 			for (unsigned int i = 0; i < textures.size(); ++i) {
 				if (textures[i]->getPath() == path) {
@@ -0,0 +1,110 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+
+#include "texture_residency.h"
+
+#include <algorithm>
+#include "texture_manager.h"
+#include "conversion.h"
+#include "util.h"
+#include "platform_util.h"
+#include "leak_dumper.h"
+
+using namespace Shared::Util;
+using namespace Shared::Platform;
+
+namespace Shared {
+	namespace Graphics {
+
+		// =====================================================
+		//	class TextureResidency
+		// =====================================================
+
+		static bool compareLastUsedFrame(const Texture2D *a, const Texture2D *b) {
+			return a->getLastUsedFrame() < b->getLastUsedFrame();
+		}
+
+		TextureResidency::TextureResidency() {
+			budgetBytes = 0;
+			minIdleFrames = 300;
+			residentBytes = 0;
+			hitCount = 0;
+			missCount = 0;
+			evictionCount = 0;
+		}
+
+		void TextureResidency::addManager(TextureManager *manager) {
+			managers.push_back(manager);
+		}
+
+		void TextureResidency::update() {
+			uint32 frame = Texture2D::getCurrentFrame();
+			Texture2D::nextFrame();
+
+			residentBytes = 0;
+			vector<Texture2D *> idleList;
+			for (unsigned int i = 0; i < managers.size(); ++i) {
+				TextureManager *manager = managers[i];
+				// reloadTexture does not change the list, eviction happens below
+				const vector<Texture2D *> &textures = manager->getEvictableTextures();
+				for (unsigned int j = 0; j < textures.size(); ++j) {
+					Texture2D *texture = textures[j];
+					bool drawn = (texture->getLastUsedFrame() == frame);
+					if (texture->getEvicted() == true) {
+						if (drawn == true) {
+							missCount++;
+							manager->reloadTexture(texture);
+						}
+						continue;
+					}
+					if (drawn == true) {
+						hitCount++;
+					}
+					if (texture->getInited() == true) {
+						residentBytes += texture->getPixelByteCount();
+						if (frame - texture->getLastUsedFrame() >= minIdleFrames) {
+							idleList.push_back(texture);
+						}
+					}
+				}
+			}
+
+			if (budgetBytes == 0 || residentBytes <= budgetBytes) {
+				return;
+			}
+			std::sort(idleList.begin(), idleList.end(), compareLastUsedFrame);
+			for (unsigned int i = 0; i < idleList.size() && residentBytes > budgetBytes; ++i) {
+				Texture2D *texture = idleList[i];
+				residentBytes -= texture->getPixelByteCount();
+				texture->evict();
+				evictionCount++;
+			}
+		}
+
+		string TextureResidency::getStats() const {
+			char szBuf[8096] = "";
+			snprintf(szBuf, 8096, "resident KB: %s budget KB: %s hits: %lld misses: %lld evictions: %lld",
+				formatNumber(residentBytes / 1000).c_str(), formatNumber(budgetBytes / 1000).c_str(),
+				(long long int) hitCount, (long long int) missCount, (long long int) evictionCount);
+			return szBuf;
+		}
+
+	}
+} //end namespace
@@ -24,6 +24,7 @@
 
 #include "platform_common.h"
 #include "cache_manager.h"
+#include "virtual_file_system.h"
 
 #ifdef WIN32
 
@@ -408,6 +409,8 @@ namespace Shared {
 
 				globfree(&globbuf);
 
+				VirtualFileSystem::findArchived(mypath, results);
+
 				if (results.empty() == true && errorOnNotFound == true) {
 					throw game_runtime_error("No files found in: " + mypath);
 				}
@@ -421,6 +424,10 @@ namespace Shared {
 		}
 
 		bool isdir(const char *path) {
+			if (VirtualFileSystem::hasFolder(path) == true) {
+				return true;
+			}
+
 			string friendly_path = path;
 
 #ifdef WIN32
@@ -458,6 +465,7 @@ namespace Shared {
 
 		bool fileExists(const string &path) {
 			if (path.size() == 0) return false;
+			if (VirtualFileSystem::hasFile(path) == true) return true;
 
 #ifdef WIN32
 			wstring wstr = utf8_decode(path);
@@ -1317,6 +1325,12 @@ namespace Shared {
 			if (SystemFlags::getSystemSettingType(SystemFlags::debugSystem).enabled) SystemFlags::OutputDebug(SystemFlags::debugSystem, "In [%s::%s] scanning [%s]\n", __FILE__, __FUNCTION__, path.c_str());
 
 			if (topLevelCaller == true) {
+				// Archived content has no folders on disk for glob to descend into
+				size_t folderEnd = mypath.find_last_of('/');
+				if (folderEnd != string::npos) {
+					VirtualFileSystem::findArchivedRecursively(mypath.substr(0, folderEnd + 1), filterFileExt, includeFolders, resultFiles);
+				}
+
 				if (SystemFlags::getSystemSettingType(SystemFlags::debugSystem).enabled) SystemFlags::OutputDebug(SystemFlags::debugSystem, "In [%s::%s Line: %d] EXITING TOP LEVEL RECURSION\n", __FILE__, __FUNCTION__, __LINE__);
 			}
 
@@ -0,0 +1,1014 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+
+#include "virtual_file_system.h"
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#if !defined(WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#include <windows.h>
+#endif
+
+#include "platform_common.h"
+#include "platform_util.h"
+#include "conversion.h"
+#include "util.h"
+
+#ifdef HAVE_ZLIB
+	#include <zlib.h>
+#else
+	#include "miniz/miniz.h"
+#endif
+#include "leak_dumper.h"
+
+using namespace Shared::Util;
+using namespace Shared::Platform;
+
+namespace Shared {
+	namespace PlatformCommon {
+
+		static const uint32 zipLocalHeaderSignature = 0x04034b50;
+		static const uint32 zipCentralHeaderSignature = 0x02014b50;
+		static const uint32 zipEndOfCentralDirSignature = 0x06054b50;
+		static const size_t zipLocalHeaderSize = 30;
+		static const size_t zipCentralHeaderSize = 46;
+		static const size_t zipEndOfCentralDirSize = 22;
+
+		static uint16 readLittleEndian16(const char *data) {
+			const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+			return (uint16) (bytes[0] | (bytes[1] << 8));
+		}
+
+		static uint32 readLittleEndian32(const char *data) {
+			const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+			return (uint32) bytes[0] | ((uint32) bytes[1] << 8) |
+				((uint32) bytes[2] << 16) | ((uint32) bytes[3] << 24);
+		}
+
+		static string getParentPath(const string &path) {
+			size_t pos = path.find_last_of('/');
+			if (pos == string::npos) {
+				return "";
+			}
+			return (pos == 0 ? "/" : path.substr(0, pos));
+		}
+
+		static string joinPath(const string &folder, const string &name) {
+			if (folder.empty() == true) {
+				return name;
+			}
+			return (folder == "/" ? folder + name : folder + "/" + name);
+		}
+
+		// Glob style match of a single path part, * does not match a
+		// leading dot unless allowHidden is set
+		static bool matchWildcard(const char *pattern, const char *name, bool allowHidden) {
+			if (*name == '.' && *pattern != '.' && allowHidden == false) {
+				return false;
+			}
+			const char *starPattern = NULL;
+			const char *starName = NULL;
+			while (*name != 0) {
+				if (*pattern == '*') {
+					starPattern = ++pattern;
+					starName = name;
+				} else if (*pattern == '?' || *pattern == *name) {
+					++pattern;
+					++name;
+				} else if (starPattern != NULL) {
+					pattern = starPattern;
+					name = ++starName;
+				} else {
+					return false;
+				}
+			}
+			while (*pattern == '*') {
+				++pattern;
+			}
+			return (*pattern == 0);
+		}
+
+		// =====================================================
+		//	class VirtualFileSystem
+		// =====================================================
+
+		Mutex *VirtualFileSystem::mutexIndex = new Mutex(CODE_AT_LINE);
+		Mutex *VirtualFileSystem::mutexRefresh = new Mutex(CODE_AT_LINE);
+		vector<VirtualFileSystem::Mount> VirtualFileSystem::mountList;
+		VirtualFileSystem::Index VirtualFileSystem::currentIndex;
+		vector<VirtualFileSystem::Archive *> VirtualFileSystem::retiredArchiveList;
+
+		string VirtualFileSystem::normalizePath(const string &path) {
+			vector<string> partList;
+			bool absolute = (path.empty() == false && (path[0] == '/' || path[0] == '\\'));
+
+			size_t start = 0;
+			for (size_t i = 0; i <= path.size(); ++i) {
+				if (i == path.size() || path[i] == '/' || path[i] == '\\') {
+					string part = path.substr(start, i - start);
+					start = i + 1;
+
+					if (part.empty() == true || part == ".") {
+						continue;
+					}
+					if (part == ".." && partList.empty() == false && partList.back() != "..") {
+						partList.pop_back();
+						continue;
+					}
+					partList.push_back(part);
+				}
+			}
+
+			string result = (absolute == true ? "/" : "");
+			for (size_t i = 0; i < partList.size(); ++i) {
+				if (i > 0) {
+					result += "/";
+				}
+				result += partList[i];
+			}
+#ifdef WIN32
+			result = toLower(result);
+#endif
+			return result;
+		}
+
+		// The first entry added for a path wins
+		void VirtualFileSystem::addEntry(Index &index, const string &path, const string &mountFolder, const Entry &entry) {
+			string key = normalizePath(path);
+			if (index.fileIndex.find(key) != index.fileIndex.end()) {
+				return;
+			}
+			index.fileIndex[key] = entry;
+
+			// Link every folder up to the mounted one to its parent
+			for (string child = key; child != mountFolder && child.empty() == false && child != "/";) {
+				string parent = getParentPath(child);
+				if (entry.archiveIndex >= 0 && child != key) {
+					index.archivedFolders.insert(child);
+				}
+				index.folderIndex[parent].insert(child.substr(parent == "/" ? 1 : (parent.empty() == true ? 0 : parent.size() + 1)));
+				child = parent;
+			}
+		}
+
+#ifdef WIN32
+		// Maps the whole file read only, NULL when it is empty or can not
+		// be mapped. The view keeps the file open, UnmapViewOfFile ends it
+		static void * mapWin32File(const string &path, uint64 &size) {
+			HANDLE file = CreateFileW(utf8_decode(path).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+				OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+			if (file == INVALID_HANDLE_VALUE) {
+				return NULL;
+			}
+			void *mapped = NULL;
+			LARGE_INTEGER fileSize;
+			if (GetFileSizeEx(file, &fileSize) != 0 && fileSize.QuadPart > 0) {
+				HANDLE fileMapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+				if (fileMapping != NULL) {
+					mapped = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+					CloseHandle(fileMapping);
+					if (mapped != NULL) {
+						size = (uint64) fileSize.QuadPart;
+					}
+				}
+			}
+			CloseHandle(file);
+			return mapped;
+		}
+#endif
+
+		bool VirtualFileSystem::getFileStamp(const string &path, int64 &modificationTime, uint64 &size) {
+#ifdef WIN32
+#if defined(__MINGW32__)
+			struct _stat fileStat;
+#else
+			struct _stat64i32 fileStat;
+#endif
+			if (_wstat(utf8_decode(path).c_str(), &fileStat) == -1) {
+				return false;
+			}
+#else
+			struct stat fileStat;
+			if (stat(path.c_str(), &fileStat) == -1) {
+				return false;
+			}
+#endif
+			modificationTime = (int64) fileStat.st_mtime;
+			size = (uint64) fileStat.st_size;
+			return true;
+		}
+
+		VirtualFileSystem::Archive * VirtualFileSystem::mapArchive(const string &archivePath, int64 modificationTime) {
+			Archive *archive = new Archive();
+			archive->path = archivePath;
+			archive->data = NULL;
+			archive->size = 0;
+			archive->mapping = NULL;
+			archive->modificationTime = modificationTime;
+			archive->useCount = 0;
+			archive->retired = false;
+
+#if !defined(WIN32)
+			int fd = ::open(archivePath.c_str(), O_RDONLY);
+			if (fd >= 0) {
+				struct stat fileStat;
+				if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+					void *mapped = mmap(NULL, (size_t) fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+					if (mapped != MAP_FAILED) {
+						// Let the kernel read the archive ahead in large sequential
+						// chunks instead of faulting in each entry
+						madvise(mapped, (size_t) fileStat.st_size, MADV_WILLNEED);
+						archive->mapping = mapped;
+						archive->data = static_cast<const char *>(mapped);
+						archive->size = (uint64) fileStat.st_size;
+					}
+				}
+				::close(fd);
+			}
+#else
+			archive->mapping = mapWin32File(archivePath, archive->size);
+			archive->data = static_cast<const char *>(archive->mapping);
+#endif
+			if (archive->mapping == NULL) {
+#ifdef WIN32
+				FILE *file = _wfopen(utf8_decode(archivePath).c_str(), L"rb");
+#else
+				FILE *file = fopen(archivePath.c_str(), "rb");
+#endif
+				if (file != NULL) {
+					if (fseek(file, 0, SEEK_END) == 0) {
+						long fileSize = ftell(file);
+						if (fileSize > 0) {
+							archive->buffer.resize(fileSize);
+							fseek(file, 0, SEEK_SET);
+							if (fread(&archive->buffer[0], fileSize, 1, file) != 1) {
+								archive->buffer.clear();
+							}
+						}
+					}
+					fclose(file);
+				}
+				archive->data = (archive->buffer.empty() == false ? &archive->buffer[0] : NULL);
+				archive->size = archive->buffer.size();
+			}
+
+			return archive;
+		}
+
+		bool VirtualFileSystem::indexArchive(Index &index, Archive *archive, const string &mountPath) {
+			// The end of central directory record sits at the end, followed
+			// only by the archive comment
+			const char *endRecord = NULL;
+			if (archive->size >= zipEndOfCentralDirSize) {
+				uint64 lowest = (archive->size > zipEndOfCentralDirSize + 0xFFFF ? archive->size - zipEndOfCentralDirSize - 0xFFFF : 0);
+				for (uint64 pos = archive->size - zipEndOfCentralDirSize + 1; pos-- > lowest;) {
+					if (readLittleEndian32(archive->data + pos) == zipEndOfCentralDirSignature) {
+						endRecord = archive->data + pos;
+						break;
+					}
+				}
+			}
+
+			uint32 entryCount = 0;
+			uint32 directorySize = 0;
+			uint32 directoryOffset = 0;
+			if (endRecord != NULL) {
+				entryCount = readLittleEndian16(endRecord + 10);
+				directorySize = readLittleEndian32(endRecord + 12);
+				directoryOffset = readLittleEndian32(endRecord + 16);
+			}
+			if (endRecord == NULL || entryCount == 0xFFFF || directoryOffset == 0xFFFFFFFF ||
+				(uint64) directoryOffset + directorySize > archive->size) {
+				SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Not a supported zip archive [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, archive->path.c_str());
+				return false;
+			}
+
+			// Read the names first, archives made by zipping the folder
+			// itself repeat its name in front of every entry
+			vector<string> nameList;
+			vector<Entry> entryList;
+			const char *entryData = archive->data + directoryOffset;
+			const char *directoryEnd = entryData + directorySize;
+			for (uint32 i = 0; i < entryCount; ++i) {
+				if (entryData + zipCentralHeaderSize > directoryEnd ||
+					readLittleEndian32(entryData) != zipCentralHeaderSignature) {
+					SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Corrupt central directory in [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, archive->path.c_str());
+					break;
+				}
+				uint16 flags = readLittleEndian16(entryData + 8);
+				uint16 method = readLittleEndian16(entryData + 10);
+				uint16 nameLength = readLittleEndian16(entryData + 28);
+				uint16 extraLength = readLittleEndian16(entryData + 30);
+				uint16 commentLength = readLittleEndian16(entryData + 32);
+				if (entryData + zipCentralHeaderSize + nameLength > directoryEnd) {
+					break;
+				}
+
+				string name(entryData + zipCentralHeaderSize, nameLength);
+				if (name.empty() == false && name[name.size() - 1] != '/') {
+					if ((flags & 0x1) != 0 || (method != 0 && method != 8)) {
+						SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Skipping encrypted or unsupported entry [%s] in [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, name.c_str(), archive->path.c_str());
+					} else {
+						Entry entry;
+						entry.archiveIndex = (int) index.archiveList.size();
+						entry.compressed = (method == 8);
+						entry.compressedSize = readLittleEndian32(entryData + 20);
+						entry.size = readLittleEndian32(entryData + 24);
+						entry.localHeaderOffset = readLittleEndian32(entryData + 42);
+						nameList.push_back(name);
+						entryList.push_back(entry);
+					}
+				}
+				entryData += zipCentralHeaderSize + nameLength + extraLength + commentLength;
+			}
+
+			string rootFolder = extractFileFromDirectoryPath(mountPath) + "/";
+			bool stripRootFolder = (nameList.empty() == false);
+			for (size_t i = 0; i < nameList.size() && stripRootFolder == true; ++i) {
+				stripRootFolder = StartsWith(nameList[i], rootFolder);
+			}
+
+			string mountFolder = getParentPath(normalizePath(mountPath));
+			index.archiveList.push_back(archive);
+			for (size_t i = 0; i < nameList.size(); ++i) {
+				string name = (stripRootFolder == true ? nameList[i].substr(rootFolder.size()) : nameList[i]);
+				addEntry(index, mountPath + "/" + name, mountFolder, entryList[i]);
+			}
+
+			if (SystemFlags::VERBOSE_MODE_ENABLED) printf("Mounted [%s] at [%s] with %d files\n", archive->path.c_str(), mountPath.c_str(), (int) nameList.size());
+			return true;
+		}
+
+		void VirtualFileSystem::unmapArchive(Archive *archive) {
+			if (archive->mapping != NULL) {
+#if !defined(WIN32)
+				munmap(archive->mapping, (size_t) archive->size);
+#else
+				UnmapViewOfFile(archive->mapping);
+#endif
+			}
+			delete archive;
+		}
+
+		void VirtualFileSystem::indexFolder(Index &index, const string &folder) {
+			string searchPath = folder;
+			endPathWithSlash(searchPath);
+			vector<string> fileList = getFolderTreeContentsListRecursively(searchPath + "*", "", false);
+
+			string mountFolder = normalizePath(folder);
+			Entry entry;
+			entry.archiveIndex = -1;
+			entry.localHeaderOffset = 0;
+			entry.compressedSize = 0;
+			entry.size = 0;
+			entry.compressed = false;
+
+			for (size_t i = 0; i < fileList.size(); ++i) {
+				// The listing also reports what the live index has archived,
+				// only files that really are on disk are loose
+				int64 modificationTime = 0;
+				uint64 size = 0;
+				if (isArchived(fileList[i]) == true && getFileStamp(fileList[i], modificationTime, size) == false) {
+					continue;
+				}
+				addEntry(index, fileList[i], mountFolder, entry);
+			}
+		}
+
+		void VirtualFileSystem::mountArchives(Index &index, const string &folder, map<string, Archive *> &reusableArchives) {
+			string searchPath = folder;
+			endPathWithSlash(searchPath);
+
+			vector<string> archiveNames;
+			findAll(searchPath + "*.zip", archiveNames, false, false);
+			for (size_t i = 0; i < archiveNames.size(); ++i) {
+				string archivePath = searchPath + archiveNames[i];
+				int64 modificationTime = 0;
+				uint64 size = 0;
+				if (getFileStamp(archivePath, modificationTime, size) == false) {
+					continue;
+				}
+
+				// Only archives that changed on disk are mapped again
+				Archive *archive = NULL;
+				bool reused = false;
+				map<string, Archive *>::iterator iterFind = reusableArchives.find(archivePath);
+				if (iterFind != reusableArchives.end() &&
+					iterFind->second->modificationTime == modificationTime && iterFind->second->size == size) {
+					archive = iterFind->second;
+					reusableArchives.erase(iterFind);
+					reused = true;
+				} else {
+					archive = mapArchive(archivePath, modificationTime);
+				}
+
+				if (indexArchive(index, archive, searchPath + cutLastExt(archiveNames[i])) == false) {
+					// A reused one may be in use, refresh retires it
+					if (reused == true) {
+						reusableArchives[archivePath] = archive;
+					} else {
+						unmapArchive(archive);
+					}
+				}
+			}
+		}
+
+		void VirtualFileSystem::mount(const string &folder, bool indexLooseFiles) {
+			Mount mount;
+			mount.folder = folder;
+			mount.indexLooseFiles = indexLooseFiles;
+
+			MutexSafeWrapper safeMutex(mutexIndex, CODE_AT_LINE);
+			mountList.push_back(mount);
+			safeMutex.ReleaseLock();
+
+			refresh();
+		}
+
+		void VirtualFileSystem::refresh() {
+			MutexSafeWrapper safeMutexRefresh(mutexRefresh, CODE_AT_LINE);
+
+			MutexSafeWrapper safeMutex(mutexIndex, CODE_AT_LINE);
+			vector<Mount> remountList = mountList;
+			map<string, Archive *> reusableArchives;
+			for (size_t i = 0; i < currentIndex.archiveList.size(); ++i) {
+				reusableArchives[currentIndex.archiveList[i]->path] = currentIndex.archiveList[i];
+			}
+			safeMutex.ReleaseLock();
+
+			// Built aside while lookups keep using the current index. Loose
+			// files first, they win over archived ones
+			Index index;
+			for (size_t i = 0; i < remountList.size(); ++i) {
+				if (remountList[i].indexLooseFiles == true) {
+					indexFolder(index, remountList[i].folder);
+				}
+			}
+			for (size_t i = 0; i < remountList.size(); ++i) {
+				mountArchives(index, remountList[i].folder, reusableArchives);
+			}
+
+			safeMutex.Lock();
+			std::swap(currentIndex, index);
+			// What was not reused is gone or changed, files opened earlier
+			// may still point into it
+			for (map<string, Archive *>::iterator iterMap = reusableArchives.begin();
+				iterMap != reusableArchives.end(); ++iterMap) {
+				Archive *archive = iterMap->second;
+				if (archive->useCount > 0) {
+					archive->retired = true;
+					retiredArchiveList.push_back(archive);
+				} else {
+					unmapArchive(archive);
+				}
+			}
+			safeMutex.ReleaseLock();
+
+			if (SystemFlags::VERBOSE_MODE_ENABLED) printf("Virtual file system refreshed, %s\n", getStats().c_str());
+		}
+
+		bool VirtualFileSystem::hasFile(const string &path) {
+			MutexSafeWrapper safeMutex(mutexIndex, CODE_AT_LINE);
+			if (currentIndex.fileIndex.empty() == true) {
+				return false;
+			}
+			return (currentIndex.fileIndex.find(normalizePath(path)) != currentIndex.fileIndex.end());
+		}
+
+		bool VirtualFileSystem::hasFolder(const string &path) {
+			MutexSafeWrapper safeMutex(mutexIndex, CODE_AT_LINE);
+			if (currentIndex.folderIndex.empty() == true) {
+				return false;
+			}
+			return (currentIndex.folderIndex.find(normalizePath(path)) != currentIndex.folderIndex.end());
+		}
+
+		bool VirtualFileSystem::isArchived(const string &path) {
+			MutexSafeWrapper safeMutex(mutexIndex, CODE_AT_LINE);
+			if (currentIndex.archiveList.empty() == true) {
+				return false;
+			}
+			map<string, Entry>::const_iterator iterFind = currentIndex.fileIndex.find(normalizePath(path));
+			return (iterFind != currentIndex.fileIndex.end() && iterFind->second.archiveIndex >= 0);
+		}
+
+		bool VirtualFileSystem::getArchiveStamp(const string &path, int64 &modificationTime, uint64 &size) {
+			MutexSafeWrapper safeMutex(mutexIndex, CODE_AT_LINE);
+			if (currentIndex.archiveList.empty() == true) {
+				return false;
+			}
+			map<string, Entry>::const_iterator iterFind = currentIndex.fileIndex.find(normalizePath(path));
+			if (iterFind == currentIndex.fileIndex.end() || iterFind->second.archiveIndex < 0) {
+				return false;
+			}
+			const Archive *archive = currentIndex.archiveList[iterFind->second.archiveIndex];
+			modificationTime = archive->modificationTime;
+			size = archive->size;
+			return true;
+		}
+
+		bool VirtualFileSystem::findEntry(const string &path, Entry &entry, const Archive **archive) {
+			*archive = NULL;
+
+			MutexSafeWrapper safeMutex(mutexIndex, CODE_AT_LINE);
+			if (currentIndex.fileIndex.empty() == true) {
+				return false;
+			}
+			map<string, Entry>::const_iterator iterFind = currentIndex.fileIndex.find(normalizePath(path));
+			if (iterFind == currentIndex.fileIndex.end()) {
+				return false;
+			}
+			entry = iterFind->second;
+			if (entry.archiveIndex >= 0) {
+				Archive *foundArchive = currentIndex.archiveList[entry.archiveIndex];
+				foundArchive->useCount++;
+				*archive = foundArchive;
+			}
+			return true;
+		}
+
+		void VirtualFileSystem::releaseArchive(const Archive *archive) {
+			if (archive == NULL) {
+				return;
+			}
+			MutexSafeWrapper safeMutex(mutexIndex, CODE_AT_LINE);
+			Archive *releasedArchive = const_cast<Archive *>(archive);
+			releasedArchive->useCount--;
+			if (releasedArchive->retired == true && releasedArchive->useCount <= 0) {
+				retiredArchiveList.erase(std::remove(retiredArchiveList.begin(), retiredArchiveList.end(), releasedArchive), retiredArchiveList.end());
+				unmapArchive(releasedArchive);
+			}
+		}
+
+		void VirtualFileSystem::findArchived(const string &pattern, vector<string> &results) {
+			MutexSafeWrapper safeMutex(mutexIndex, CODE_AT_LINE);
+			if (currentIndex.archiveList.empty() == true) {
+				return;
+			}
+
+			size_t pos = pattern.find_last_of("/\\");
+			string folder = (pos == string::npos ? "" : pattern.substr(0, pos + 1));
+			string namePattern = (pos == string::npos ? pattern : pattern.substr(pos + 1));
+			bool allowHidden = false;
+			if (EndsWith(namePattern, "{,.}*") == true) {
+				namePattern = namePattern.substr(0, namePattern.size() - 5) + "*";
+				allowHidden = true;
+			}
+
+			string folderKey = normalizePath(folder);
+			map<string, set<string> >::const_iterator iterFolder = currentIndex.folderIndex.find(folderKey);
+			if (iterFolder == currentIndex.folderIndex.end()) {
+				return;
+			}
+			for (set<string>::const_iterator iterChild = iterFolder->second.begin();
+				iterChild != iterFolder->second.end(); ++iterChild) {
+				const string &name = *iterChild;
+				if (matchWildcard(namePattern.c_str(), name.c_str(), allowHidden) == false) {
+					continue;
+				}
+
+				string childKey = joinPath(folderKey, name);
+				map<string, Entry>::const_iterator iterFile = currentIndex.fileIndex.find(childKey);
+				bool archived = (iterFile != currentIndex.fileIndex.end() ?
+					iterFile->second.archiveIndex >= 0 : currentIndex.archivedFolders.find(childKey) != currentIndex.archivedFolders.end());
+				if (archived == true && std::find(results.begin(), results.end(), name) == results.end()) {
+					results.push_back(name);
+				}
+			}
+		}
+
+		void VirtualFileSystem::findArchivedRecursively(const string &folder, const string &filterFileExt,
+			bool includeFolders, vector<string> &results) {
+			MutexSafeWrapper safeMutex(mutexIndex, CODE_AT_LINE);
+			if (currentIndex.archiveList.empty() == true) {
+				return;
+			}
+
+			set<string> knownResults(results.begin(), results.end());
+			string prefix = folder;
+			endPathWithSlash(prefix);
+
+			// Depth first walk keeping both the index key and the caller's
+			// spelling of every folder
+			vector<std::pair<string, string> > pendingFolders;
+			pendingFolders.push_back(std::make_pair(normalizePath(folder), prefix));
+			while (pendingFolders.empty() == false) {
+				std::pair<string, string> current = pendingFolders.back();
+				pendingFolders.pop_back();
+
+				map<string, set<string> >::const_iterator iterFolder = currentIndex.folderIndex.find(current.first);
+				if (iterFolder == currentIndex.folderIndex.end()) {
+					continue;
+				}
+				for (set<string>::const_iterator iterChild = iterFolder->second.begin();
+					iterChild != iterFolder->second.end(); ++iterChild) {
+					string childKey = joinPath(current.first, *iterChild);
+					string childPath = current.second + *iterChild;
+
+					map<string, Entry>::const_iterator iterFile = currentIndex.fileIndex.find(childKey);
+					if (iterFile != currentIndex.fileIndex.end()) {
+						if (iterFile->second.archiveIndex >= 0 &&
+							(filterFileExt == "" || EndsWith(childPath, filterFileExt) == true) &&
+							knownResults.insert(childPath).second == true) {
+							results.push_back(childPath);
+						}
+					} else {
+						if (includeFolders == true && currentIndex.archivedFolders.find(childKey) != currentIndex.archivedFolders.end() &&
+							knownResults.insert(childPath).second == true) {
+							results.push_back(childPath);
+						}
+						pendingFolders.push_back(std::make_pair(childKey, childPath + "/"));
+					}
+				}
+			}
+		}
+
+		string VirtualFileSystem::getStats() {
+			MutexSafeWrapper safeMutex(mutexIndex, CODE_AT_LINE);
+			char szBuf[8096] = "";
+			snprintf(szBuf, 8096, "mounts: %d archives: %d (%d retired) files: %d folders: %d",
+				(int) mountList.size(), (int) currentIndex.archiveList.size(), (int) retiredArchiveList.size(),
+				(int) currentIndex.fileIndex.size(), (int) currentIndex.folderIndex.size());
+			return szBuf;
+		}
+
+		// =====================================================
+		//	class VirtualFile
+		// =====================================================
+
+		struct VirtualFile::InflateState {
+			z_stream stream;
+		};
+
+		VirtualFile::VirtualFile() {
+			opened = false;
+			archive = NULL;
+			data = NULL;
+			size = 0;
+			position = 0;
+			mapping = NULL;
+			compressedData = NULL;
+			compressedSize = 0;
+			inflateState = NULL;
+			inflatePosition = 0;
+		}
+
+		VirtualFile::~VirtualFile() {
+			close();
+		}
+
+		bool VirtualFile::open(const string &path) {
+			close();
+			this->path = path;
+
+			VirtualFileSystem::Entry entry;
+			if (VirtualFileSystem::findEntry(path, entry, &archive) == false || archive == NULL) {
+				return openLoose(path);
+			}
+
+			// The local header repeats the name and may carry its own extra
+			// field, only it tells where the data starts
+			uint64 headerOffset = entry.localHeaderOffset;
+			if (headerOffset + zipLocalHeaderSize > archive->size ||
+				readLittleEndian32(archive->data + headerOffset) != zipLocalHeaderSignature) {
+				SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Bad local header for [%s] in [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, path.c_str(), archive->path.c_str());
+				return false;
+			}
+			uint64 dataOffset = headerOffset + zipLocalHeaderSize +
+				readLittleEndian16(archive->data + headerOffset + 26) +
+				readLittleEndian16(archive->data + headerOffset + 28);
+			uint64 storedSize = (entry.compressed == true ? entry.compressedSize : entry.size);
+			if (dataOffset + storedSize > archive->size) {
+				SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Truncated entry [%s] in [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, path.c_str(), archive->path.c_str());
+				return false;
+			}
+
+			size = entry.size;
+			if (entry.compressed == false) {
+				data = (size > 0 ? archive->data + dataOffset : NULL);
+			} else {
+				compressedData = archive->data + dataOffset;
+				compressedSize = entry.compressedSize;
+				if (startInflate() == false) {
+					close();
+					return false;
+				}
+			}
+			opened = true;
+			return true;
+		}
+
+		bool VirtualFile::openLoose(const string &path) {
+#if !defined(WIN32)
+			int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0) {
+				return false;
+			}
+			struct stat fileStat;
+			if (fstat(fd, &fileStat) == 0) {
+				if (S_ISDIR(fileStat.st_mode)) {
+					::close(fd);
+					return false;
+				}
+				if (fileStat.st_size > 0) {
+					void *mapped = mmap(NULL, (size_t) fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+					if (mapped != MAP_FAILED) {
+						mapping = mapped;
+						data = static_cast<const char *>(mapped);
+						size = (uint64) fileStat.st_size;
+					}
+				}
+			}
+			::close(fd);
+#else
+			mapping = mapWin32File(path, size);
+			data = static_cast<const char *>(mapping);
+#endif
+			if (mapping != NULL) {
+				opened = true;
+				return true;
+			}
+
+#ifdef WIN32
+			FILE *file = _wfopen(utf8_decode(path).c_str(), L"rb");
+#else
+			FILE *file = fopen(path.c_str(), "rb");
+#endif
+			if (file == NULL) {
+				return false;
+			}
+			if (fseek(file, 0, SEEK_END) == 0) {
+				long fileSize = ftell(file);
+				if (fileSize > 0) {
+					buffer.resize(fileSize);
+					fseek(file, 0, SEEK_SET);
+					if (fread(&buffer[0], fileSize, 1, file) != 1) {
+						buffer.clear();
+					}
+				}
+			}
+			fclose(file);
+
+			data = (buffer.empty() == false ? &buffer[0] : NULL);
+			size = buffer.size();
+			opened = true;
+			return true;
+		}
+
+		void VirtualFile::close() {
+			if (mapping != NULL) {
+#if !defined(WIN32)
+				munmap(mapping, (size_t) size);
+#else
+				UnmapViewOfFile(mapping);
+#endif
+			}
+			if (inflateState != NULL) {
+				inflateEnd(&inflateState->stream);
+				delete inflateState;
+				inflateState = NULL;
+			}
+			mapping = NULL;
+			// Only now may a retired archive be unmapped
+			VirtualFileSystem::releaseArchive(archive);
+			archive = NULL;
+			buffer.clear();
+			opened = false;
+			data = NULL;
+			size = 0;
+			position = 0;
+			compressedData = NULL;
+			compressedSize = 0;
+			inflatePosition = 0;
+		}
+
+		bool VirtualFile::startInflate() {
+			if (inflateState != NULL) {
+				inflateEnd(&inflateState->stream);
+			} else {
+				inflateState = new InflateState();
+			}
+			memset(&inflateState->stream, 0, sizeof(inflateState->stream));
+			inflateState->stream.next_in = (unsigned char *) compressedData;
+			inflateState->stream.avail_in = (unsigned int) compressedSize;
+			inflatePosition = 0;
+
+			// Zip entries are raw deflate streams without the zlib header
+			if (inflateInit2(&inflateState->stream, -MAX_WBITS) != Z_OK) {
+				SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] inflateInit2 failed for [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, path.c_str());
+				delete inflateState;
+				inflateState = NULL;
+				return false;
+			}
+			return true;
+		}
+
+		// Inflates up to bytes more into dest, or drops them when dest is NULL
+		size_t VirtualFile::inflateTo(char *dest, size_t bytes) {
+			if (inflateState == NULL) {
+				return 0;
+			}
+
+			char discardBuffer[16384];
+			size_t done = 0;
+			while (done < bytes && inflatePosition < size) {
+				char *out = (dest != NULL ? dest + done : discardBuffer);
+				size_t wanted = bytes - done;
+				if (dest == NULL && wanted > sizeof(discardBuffer)) {
+					wanted = sizeof(discardBuffer);
+				}
+
+				inflateState->stream.next_out = (unsigned char *) out;
+				inflateState->stream.avail_out = (unsigned int) wanted;
+				int result = inflate(&inflateState->stream, Z_NO_FLUSH);
+
+				size_t produced = wanted - inflateState->stream.avail_out;
+				done += produced;
+				inflatePosition += produced;
+				if (result == Z_STREAM_END) {
+					break;
+				}
+				if (result != Z_OK) {
+					SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] inflate failed with %d for [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, result, path.c_str());
+					break;
+				}
+			}
+			return done;
+		}
+
+		const char * VirtualFile::getData() {
+			if (data != NULL || size == 0 || compressedData == NULL) {
+				return data;
+			}
+
+			buffer.resize((size_t) size);
+			if (startInflate() == false || inflateTo(&buffer[0], (size_t) size) != size) {
+				buffer.clear();
+				return NULL;
+			}
+			inflateEnd(&inflateState->stream);
+			delete inflateState;
+			inflateState = NULL;
+
+			data = &buffer[0];
+			return data;
+		}
+
+		size_t VirtualFile::read(void *dest, size_t bytes) {
+			if (opened == false || position >= size) {
+				return 0;
+			}
+			if (bytes > size - position) {
+				bytes = (size_t) (size - position);
+			}
+
+			if (data != NULL) {
+				memcpy(dest, data + position, bytes);
+				position += bytes;
+				return bytes;
+			}
+
+			// Reading backwards means inflating again from the start
+			if (position < inflatePosition && startInflate() == false) {
+				return 0;
+			}
+			if (position > inflatePosition) {
+				inflateTo(NULL, (size_t) (position - inflatePosition));
+				if (position != inflatePosition) {
+					return 0;
+				}
+			}
+			size_t result = inflateTo(static_cast<char *>(dest), bytes);
+			position += result;
+			return result;
+		}
+
+		bool VirtualFile::seek(uint64 offset) {
+			if (opened == false || offset > size) {
+				return false;
+			}
+			// Compressed entries catch up lazily on the next read
+			position = offset;
+			return true;
+		}
+
+		// =====================================================
+		//	class VirtualFileStream
+		// =====================================================
+
+		VirtualFileStreamBuf::VirtualFileStreamBuf() {
+			file = NULL;
+		}
+
+		void VirtualFileStreamBuf::attach(VirtualFile *file) {
+			this->file = file;
+			chunk.clear();
+
+			const char *data = (file != NULL ? file->getDirectData() : NULL);
+			if (data != NULL) {
+				char *begin = const_cast<char *>(data);
+				setg(begin, begin, begin + file->getSize());
+			} else {
+				setg(NULL, NULL, NULL);
+			}
+		}
+
+		VirtualFileStreamBuf::int_type VirtualFileStreamBuf::underflow() {
+			if (gptr() < egptr()) {
+				return traits_type::to_int_type(*gptr());
+			}
+			if (file == NULL || file->getDirectData() != NULL) {
+				return traits_type::eof();
+			}
+
+			chunk.resize(16384);
+			size_t bytesRead = file->read(&chunk[0], chunk.size());
+			if (bytesRead == 0) {
+				return traits_type::eof();
+			}
+			setg(&chunk[0], &chunk[0], &chunk[0] + bytesRead);
+			return traits_type::to_int_type(*gptr());
+		}
+
+		VirtualFileStreamBuf::pos_type VirtualFileStreamBuf::seekoff(off_type offset, std::ios_base::seekdir dir,
+			std::ios_base::openmode which) {
+			if (file == NULL) {
+				return pos_type(off_type(-1));
+			}
+
+			off_type current = (file->getDirectData() != NULL ?
+				gptr() - eback() : (off_type) file->tell() - (egptr() - gptr()));
+			off_type base = 0;
+			if (dir == std::ios_base::cur) {
+				base = current;
+			} else if (dir == std::ios_base::end) {
+				base = (off_type) file->getSize();
+			}
+			return seekpos(pos_type(base + offset), which);
+		}
+
+		VirtualFileStreamBuf::pos_type VirtualFileStreamBuf::seekpos(pos_type position,
+			std::ios_base::openmode which) {
+			off_type target = off_type(position);
+			if (file == NULL || target < 0 || (uint64) target > file->getSize()) {
+				return pos_type(off_type(-1));
+			}
+
+			if (file->getDirectData() != NULL) {
+				setg(eback(), eback() + target, egptr());
+			} else {
+				file->seek((uint64) target);
+				setg(NULL, NULL, NULL);
+			}
+			return position;
+		}
+
+		VirtualFileStream::VirtualFileStream() : std::istream(NULL) {
+			rdbuf(&streamBuf);
+		}
+
+		VirtualFileStream::VirtualFileStream(const string &path) : std::istream(NULL) {
+			rdbuf(&streamBuf);
+			open(path);
+		}
+
+		void VirtualFileStream::open(const string &path) {
+			if (file.open(path) == true) {
+				streamBuf.attach(&file);
+				clear();
+			} else {
+				streamBuf.attach(NULL);
+				setstate(std::ios_base::failbit);
+			}
+		}
+
+		void VirtualFileStream::close() {
+			streamBuf.attach(NULL);
+			file.close();
+		}
+
+	}
+} //end namespace
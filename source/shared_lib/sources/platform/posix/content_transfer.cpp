@@ -0,0 +1,974 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+#include "content_transfer.h"
+#include "util.h"
+#include "platform_common.h"
+#include "platform_util.h"
+#include "conversion.h"
+#include "byte_order.h"
+
+#include <algorithm>
+#include <set>
+#include <cstdio>
+
+using namespace Shared::Util;
+using namespace Shared::PlatformCommon;
+using namespace Shared::PlatformByteOrder;
+using Shared::Platform::ClientSocket;
+using Shared::Platform::Ip;
+
+namespace Shared {
+	namespace PlatformCommon {
+
+		// Wire format, all integers in common endian:
+		//   request  uint8 type, then
+		//            ctrt_Manifest: uint8 contentType, uint16 nameLength, name
+		//            ctrt_Chunk:    uint64 hash, uint32 size
+		//   reply    uint8 status, uint32 payloadLength, payload
+		enum ContentTransferRequestType {
+			ctrt_Manifest = 1,
+			ctrt_Chunk = 2
+		};
+
+		enum ContentTransferReplyStatus {
+			ctrs_Ok = 0,
+			ctrs_NotFound = 1,
+			ctrs_Denied = 2,
+			ctrs_BadRequest = 3
+		};
+
+		static const uint32 maxManifestSize = 16 * 1024 * 1024;
+		static const int CONTENT_TRANSFER_IDLE_SECONDS = 60;
+		static const int CONTENT_TRANSFER_STALL_SECONDS = 30;
+		// Requests read from one connection while its replies are still queued
+		static const unsigned int CONTENT_TRANSFER_MAX_QUEUED_REPLIES = 4;
+		static const int CONTENT_TRANSFER_MAX_RECONNECTS = 8;
+
+		static const char *MAP_FILE_EXTENSIONS[] = { ".zgm", ".gbm", ".mgm" };
+
+		template<class T> static void appendValue(vector<char> &buffer, T value) {
+			value = toCommonEndian(value);
+			const char *data = reinterpret_cast<const char *>(&value);
+			buffer.insert(buffer.end(), data, data + sizeof(T));
+		}
+
+		template<class T> static bool readValue(const vector<char> &buffer, size_t &offset, T &value) {
+			if (offset + sizeof(T) > buffer.size()) {
+				return false;
+			}
+			memcpy(&value, &buffer[offset], sizeof(T));
+			value = fromCommonEndian(value);
+			offset += sizeof(T);
+			return true;
+		}
+
+		static FILE * openContentFile(const string &path, bool forWriting) {
+#ifdef WIN32
+			return _wfopen(utf8_decode(path).c_str(), (forWriting ? L"wb" : L"rb"));
+#else
+			return fopen(path.c_str(), (forWriting ? "wb" : "rb"));
+#endif
+		}
+
+		static bool writeContentFile(const string &path, const vector<char> &data) {
+			FILE *fp = openContentFile(path, true);
+			if (fp == NULL) {
+				return false;
+			}
+			bool result = (data.empty() == true || fwrite(&data[0], 1, data.size(), fp) == data.size());
+			if (fclose(fp) != 0) {
+				result = false;
+			}
+			return result;
+		}
+
+		static bool receiveValue(Socket *socket, void *data, int dataSize) {
+			return socket->receive(data, dataSize, true) == dataSize;
+		}
+
+		// A received path may only point below the content root
+		static bool isSafeContentPath(const string &path) {
+			if (path.empty() == true || path[0] == '/' ||
+				path.find('\\') != string::npos || path.find(':') != string::npos) {
+				return false;
+			}
+			vector<string> tokens;
+			Tokenize(path, tokens, "/");
+			for (unsigned int index = 0; index < tokens.size(); ++index) {
+				if (tokens[index] == "" || tokens[index] == "." || tokens[index] == "..") {
+					return false;
+				}
+			}
+			return tokens.empty() == false;
+		}
+
+		static bool isSafeContentName(const string &name) {
+			return name.empty() == false && name.find("..") == string::npos &&
+				name.find('/') == string::npos && name.find('\\') == string::npos;
+		}
+
+		// =====================================================
+		//	class ContentManifest
+		// =====================================================
+
+		uint64 ContentManifest::hashData(const void *data, size_t size) {
+			// 64 bit FNV-1a
+			uint64 hash = 14695981039346656037ULL;
+			const unsigned char *bytes = static_cast<const unsigned char *>(data);
+			for (size_t index = 0; index < size; ++index) {
+				hash ^= bytes[index];
+				hash *= 1099511628211ULL;
+			}
+			return hash;
+		}
+
+		string ContentManifest::getChunkName(const Chunk &chunk) {
+			char szBuf[64] = "";
+			snprintf(szBuf, 64, "%016llx_%u", (unsigned long long) chunk.hash, chunk.size);
+			return szBuf;
+		}
+
+		bool ContentManifest::addFile(const string &fullPath, const string &relativePath) {
+			FILE *fp = openContentFile(fullPath, false);
+			if (fp == NULL) {
+				return false;
+			}
+
+			File file;
+			file.path = relativePath;
+			file.size = 0;
+
+			vector<char> buffer(chunkSize);
+			for (size_t bytesRead = fread(&buffer[0], 1, chunkSize, fp); bytesRead > 0;
+				bytesRead = fread(&buffer[0], 1, chunkSize, fp)) {
+				Chunk chunk;
+				chunk.hash = hashData(&buffer[0], bytesRead);
+				chunk.size = (uint32) bytesRead;
+				file.chunkList.push_back(chunk);
+				file.size += bytesRead;
+			}
+			bool readError = (ferror(fp) != 0);
+			fclose(fp);
+
+			if (readError == true) {
+				return false;
+			}
+			fileList.push_back(file);
+			return true;
+		}
+
+		uint64 ContentManifest::getTotalSize() const {
+			uint64 result = 0;
+			for (unsigned int index = 0; index < fileList.size(); ++index) {
+				result += fileList[index].size;
+			}
+			return result;
+		}
+
+		void ContentManifest::saveToBuffer(vector<char> &buffer) const {
+			buffer.clear();
+			appendValue<uint32>(buffer, (uint32) fileList.size());
+			for (unsigned int index = 0; index < fileList.size(); ++index) {
+				const File &file = fileList[index];
+				appendValue<uint16>(buffer, (uint16) file.path.size());
+				buffer.insert(buffer.end(), file.path.begin(), file.path.end());
+				appendValue<uint64>(buffer, file.size);
+				appendValue<uint32>(buffer, (uint32) file.chunkList.size());
+				for (unsigned int chunkIndex = 0; chunkIndex < file.chunkList.size(); ++chunkIndex) {
+					appendValue<uint64>(buffer, file.chunkList[chunkIndex].hash);
+					appendValue<uint32>(buffer, file.chunkList[chunkIndex].size);
+				}
+			}
+		}
+
+		bool ContentManifest::loadFromBuffer(const vector<char> &buffer) {
+			fileList.clear();
+
+			size_t offset = 0;
+			uint32 fileCount = 0;
+			if (readValue(buffer, offset, fileCount) == false) {
+				return false;
+			}
+			for (uint32 index = 0; index < fileCount; ++index) {
+				File file;
+				uint16 pathLength = 0;
+				if (readValue(buffer, offset, pathLength) == false ||
+					offset + pathLength > buffer.size()) {
+					return false;
+				}
+				file.path.assign(&buffer[0] + offset, pathLength);
+				offset += pathLength;
+
+				uint32 chunkCount = 0;
+				if (readValue(buffer, offset, file.size) == false ||
+					readValue(buffer, offset, chunkCount) == false ||
+					offset + (uint64) chunkCount * (sizeof(uint64) + sizeof(uint32)) > buffer.size()) {
+					return false;
+				}
+
+				uint64 chunkTotal = 0;
+				for (uint32 chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex) {
+					Chunk chunk;
+					readValue(buffer, offset, chunk.hash);
+					readValue(buffer, offset, chunk.size);
+					if (chunk.size == 0 || chunk.size > chunkSize) {
+						return false;
+					}
+					chunkTotal += chunk.size;
+					file.chunkList.push_back(chunk);
+				}
+				if (chunkTotal != file.size) {
+					return false;
+				}
+				fileList.push_back(file);
+			}
+			return true;
+		}
+
+		// =====================================================
+		//	class ContentTransferServerThread
+		// =====================================================
+
+		ContentTransferServerThread::ContentTransferServerThread(std::pair<string, string> mapsPath,
+			std::pair<string, string> tilesetsPath, std::pair<string, string> techtreesPath,
+			bool internetEnabledFlag,
+			bool allowInternetTilesetFileTransfers, bool allowInternetTechtreeFileTransfers,
+			int portNumber, int maxConnections) : BaseThread() {
+
+			uniqueID = "ContentTransferServerThread";
+			this->mapsPath = mapsPath;
+			this->tilesetsPath = tilesetsPath;
+			this->techtreesPath = techtreesPath;
+			this->internetEnabled = internetEnabledFlag;
+			this->allowInternetTilesetFileTransfers = allowInternetTilesetFileTransfers;
+			this->allowInternetTechtreeFileTransfers = allowInternetTechtreeFileTransfers;
+			this->portNumber = portNumber;
+			this->maxConnections = maxConnections;
+			this->mutexSettings = new Mutex(CODE_AT_LINE);
+
+			this->serverSocket = new ServerSocket(true);
+			try {
+				this->serverSocket->setBlock(false);
+				this->serverSocket->setBindPort(portNumber);
+				this->serverSocket->listen(max(1, maxConnections));
+			} catch (...) {
+				delete this->serverSocket;
+				delete this->mutexSettings;
+				throw;
+			}
+
+			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line %d] Using content transfer port #: %d\n", __FILE__, __FUNCTION__, __LINE__, portNumber);
+		}
+
+		ContentTransferServerThread::~ContentTransferServerThread() {
+			for (unsigned int index = 0; index < connectionList.size(); ++index) {
+				delete connectionList[index].socket;
+			}
+			connectionList.clear();
+
+			delete serverSocket;
+			serverSocket = NULL;
+
+			delete mutexSettings;
+			mutexSettings = NULL;
+		}
+
+		void ContentTransferServerThread::setInternetEnabled(bool value) {
+			MutexSafeWrapper safeMutex(mutexSettings, CODE_AT_LINE);
+			this->internetEnabled = value;
+		}
+
+		// Same rule the FTP server applies to its tileset and techtree users
+		bool ContentTransferServerThread::isTransferAllowed(ContentTransferType type) {
+			MutexSafeWrapper safeMutex(mutexSettings, CODE_AT_LINE);
+			if (internetEnabled == false) {
+				return true;
+			}
+			switch (type) {
+				case ctt_Tileset:
+					return allowInternetTilesetFileTransfers;
+				case ctt_Techtree:
+					return allowInternetTechtreeFileTransfers;
+				default:
+					return true;
+			}
+		}
+
+		bool ContentTransferServerThread::buildManifest(ContentTransferType type, const string &name, vector<char> &buffer) {
+			string cacheKey = intToStr(type) + ":" + name;
+			std::map<string, vector<char> >::iterator iterFind = manifestCache.find(cacheKey);
+			if (iterFind != manifestCache.end()) {
+				buffer = iterFind->second;
+				return true;
+			}
+
+			ContentManifest manifest;
+			vector<string> rootList;
+			if (type == ctt_Map) {
+				rootList.push_back(mapsPath.second);
+				rootList.push_back(mapsPath.first);
+			} else if (type == ctt_Tileset) {
+				rootList.push_back(tilesetsPath.second);
+				rootList.push_back(tilesetsPath.first);
+			} else {
+				rootList.push_back(techtreesPath.second);
+				rootList.push_back(techtreesPath.first);
+			}
+
+			// The user folder wins, like on the FTP side
+			bool found = false;
+			for (unsigned int rootIndex = 0; rootIndex < rootList.size() && found == false; ++rootIndex) {
+				string root = rootList[rootIndex];
+				if (root == "") {
+					continue;
+				}
+				endPathWithSlash(root);
+
+				if (type == ctt_Map) {
+					for (unsigned int extIndex = 0; extIndex < 3 && found == false; ++extIndex) {
+						string fileName = name + MAP_FILE_EXTENSIONS[extIndex];
+						if (fileExists(root + fileName) == true) {
+							found = manifest.addFile(root + fileName, fileName);
+						}
+					}
+				} else if (isdir((root + name).c_str()) == true) {
+					string folder = root + name;
+					endPathWithSlash(folder);
+					vector<string> fileList = getFolderTreeContentsListRecursively(folder + "*", "", false);
+					std::sort(fileList.begin(), fileList.end());
+
+					found = true;
+					for (unsigned int fileIndex = 0; fileIndex < fileList.size() && found == true; ++fileIndex) {
+						string relativePath = fileList[fileIndex].substr(root.size());
+						replaceAll(relativePath, "\\", "/");
+						found = manifest.addFile(fileList[fileIndex], relativePath);
+					}
+				}
+
+				if (found == true) {
+					for (unsigned int fileIndex = 0; fileIndex < manifest.fileList.size(); ++fileIndex) {
+						const ContentManifest::File &file = manifest.fileList[fileIndex];
+						uint64 offset = 0;
+						for (unsigned int chunkIndex = 0; chunkIndex < file.chunkList.size(); ++chunkIndex) {
+							ChunkLocation location;
+							location.fullPath = root + file.path;
+							location.offset = offset;
+							chunkLocations[ContentManifest::getChunkName(file.chunkList[chunkIndex])] = location;
+							offset += file.chunkList[chunkIndex].size;
+						}
+					}
+				} else {
+					manifest.fileList.clear();
+				}
+			}
+
+			if (found == false) {
+				return false;
+			}
+
+			manifest.saveToBuffer(buffer);
+			manifestCache[cacheKey] = buffer;
+			return true;
+		}
+
+		bool ContentTransferServerThread::readChunk(uint64 hash, uint32 size, vector<char> &buffer) {
+			ContentManifest::Chunk chunk;
+			chunk.hash = hash;
+			chunk.size = size;
+
+			// Only chunks of a manifest handed out before are served
+			std::map<string, ChunkLocation>::iterator iterFind = chunkLocations.find(ContentManifest::getChunkName(chunk));
+			if (iterFind == chunkLocations.end() || size == 0 || size > ContentManifest::chunkSize) {
+				return false;
+			}
+
+			bool result = false;
+			FILE *fp = openContentFile(iterFind->second.fullPath, false);
+			if (fp != NULL) {
+				buffer.resize(size);
+				result = (fseek(fp, (long) iterFind->second.offset, SEEK_SET) == 0 &&
+					fread(&buffer[0], 1, size, fp) == size &&
+					ContentManifest::hashData(&buffer[0], size) == hash);
+				fclose(fp);
+			}
+
+			if (result == false) {
+				// The file changed on disk, index it again on the next request
+				manifestCache.clear();
+				chunkLocations.erase(iterFind);
+			}
+			return result;
+		}
+
+		void ContentTransferServerThread::sendReply(Connection &connection, uint8 status, const vector<char> &payload) {
+			std::vector<char> *reply = new std::vector<char>();
+			reply->reserve(sizeof(uint8) + sizeof(uint32) + payload.size());
+			appendValue<uint8>(*reply, status);
+			appendValue<uint32>(*reply, (uint32) payload.size());
+			reply->insert(reply->end(), payload.begin(), payload.end());
+
+			if (connection.sendQueue.empty() == true) {
+				connection.lastSendProgressTime = Chrono::getCurMillis();
+			}
+			connection.sendQueue.push_back(SocketSendBuffer(reply));
+		}
+
+		bool ContentTransferServerThread::drainSendQueue(Connection &connection) {
+			int64 now = Chrono::getCurMillis();
+			while (connection.sendQueue.empty() == false) {
+				const SocketSendBuffer &buffer = connection.sendQueue.front();
+				int remaining = (int) (buffer->size() - connection.sendQueueOffset);
+				if (remaining > 0) {
+					int bytesSent = connection.socket->trySend(&(*buffer)[connection.sendQueueOffset], remaining);
+					if (bytesSent < 0) {
+						return false;
+					}
+					if (bytesSent == 0) {
+						break;
+					}
+					connection.lastSendProgressTime = now;
+					connection.lastActivity = time(NULL);
+					connection.sendQueueOffset += bytesSent;
+					if (bytesSent < remaining) {
+						break;
+					}
+				}
+				connection.sendQueue.pop_front();
+				connection.sendQueueOffset = 0;
+			}
+
+			if (connection.sendQueue.empty() == false && now - connection.lastSendProgressTime > CONTENT_TRANSFER_STALL_SECONDS * 1000) {
+				if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] client stopped reading, %d replies still queued\n", __FILE__, __FUNCTION__, __LINE__, (int) connection.sendQueue.size());
+				return false;
+			}
+			return true;
+		}
+
+		bool ContentTransferServerThread::serviceConnection(Connection &connection) {
+			Socket *socket = connection.socket;
+			for (int requestCount = 0; requestCount < 16 &&
+				connection.sendQueue.size() < CONTENT_TRANSFER_MAX_QUEUED_REPLIES &&
+				socket->hasDataToRead() == true; ++requestCount) {
+				connection.lastActivity = time(NULL);
+
+				uint8 requestType = 0;
+				if (receiveValue(socket, &requestType, sizeof(requestType)) == false) {
+					return false;
+				}
+
+				vector<char> payload;
+				if (requestType == ctrt_Manifest) {
+					uint8 contentType = 0;
+					uint16 nameLength = 0;
+					if (receiveValue(socket, &contentType, sizeof(contentType)) == false ||
+						receiveValue(socket, &nameLength, sizeof(nameLength)) == false) {
+						return false;
+					}
+					nameLength = fromCommonEndian(nameLength);
+
+					string name(nameLength, '\0');
+					if (nameLength > 0 && receiveValue(socket, &name[0], nameLength) == false) {
+						return false;
+					}
+
+					if (contentType > ctt_Techtree || isSafeContentName(name) == false) {
+						sendReply(connection, ctrs_BadRequest, payload);
+					} else if (isTransferAllowed(static_cast<ContentTransferType>(contentType)) == false) {
+						sendReply(connection, ctrs_Denied, payload);
+					} else if (buildManifest(static_cast<ContentTransferType>(contentType), name, payload) == false) {
+						sendReply(connection, ctrs_NotFound, payload);
+					} else {
+						sendReply(connection, ctrs_Ok, payload);
+					}
+				} else if (requestType == ctrt_Chunk) {
+					uint64 hash = 0;
+					uint32 size = 0;
+					if (receiveValue(socket, &hash, sizeof(hash)) == false ||
+						receiveValue(socket, &size, sizeof(size)) == false) {
+						return false;
+					}
+					hash = fromCommonEndian(hash);
+					size = fromCommonEndian(size);
+
+					if (readChunk(hash, size, payload) == false) {
+						payload.clear();
+						sendReply(connection, ctrs_NotFound, payload);
+					} else {
+						sendReply(connection, ctrs_Ok, payload);
+					}
+				} else {
+					return false;
+				}
+
+				if (socket->isConnected() == false) {
+					return false;
+				}
+			}
+
+			if (drainSendQueue(connection) == false) {
+				return false;
+			}
+			return connection.sendQueue.empty() == false ||
+				difftime(time(NULL), connection.lastActivity) < CONTENT_TRANSFER_IDLE_SECONDS;
+		}
+
+		void ContentTransferServerThread::execute() {
+			RunningStatusSafeWrapper runningStatus(this);
+			ExecutingTaskSafeWrapper safeExecutingTaskMutex(this);
+
+			if (SystemFlags::VERBOSE_MODE_ENABLED) printf("===> Content transfer server thread is running on port %d\n", portNumber);
+			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "Content transfer server thread is running on port %d\n", portNumber);
+
+			for (; getQuitStatus() == false;) {
+				try {
+					for (Socket *socket = serverSocket->accept(false); socket != NULL; socket = serverSocket->accept(false)) {
+						if ((int) connectionList.size() >= maxConnections) {
+							delete socket;
+							continue;
+						}
+						socket->setBlock(false);
+
+						Connection connection;
+						connection.socket = socket;
+						connection.lastActivity = time(NULL);
+						connection.sendQueueOffset = 0;
+						connection.lastSendProgressTime = 0;
+						connectionList.push_back(connection);
+					}
+
+					for (int index = (int) connectionList.size() - 1; index >= 0; --index) {
+						bool keepConnection = false;
+						try {
+							keepConnection = serviceConnection(connectionList[index]);
+						} catch (const exception &ex) {
+							SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error [%s]\n", __FILE__, __FUNCTION__, __LINE__, ex.what());
+						}
+
+						if (keepConnection == false) {
+							delete connectionList[index].socket;
+							connectionList.erase(connectionList.begin() + index);
+						}
+					}
+				} catch (const exception &ex) {
+					SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error [%s]\n", __FILE__, __FUNCTION__, __LINE__, ex.what());
+				}
+
+				sleep(connectionList.empty() == true ? 50 : 1);
+			}
+
+			if (SystemFlags::VERBOSE_MODE_ENABLED) printf("===> Content transfer server thread is exiting\n");
+			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "Content transfer server thread is exiting\n");
+		}
+
+		// =====================================================
+		//	class ContentTransferClient
+		// =====================================================
+
+		ContentTransferClient::ContentTransferClient(string serverUrl, int portNumber, int connectionCount,
+			string chunkStorePath, ContentTransferProgressInterface *pCBObject) {
+			this->serverUrl = serverUrl;
+			this->portNumber = portNumber;
+			this->connectionCount = max(1, connectionCount);
+			this->chunkStorePath = chunkStorePath;
+			endPathWithSlash(this->chunkStorePath);
+			this->pCBObject = pCBObject;
+		}
+
+		Socket * ContentTransferClient::connectSocket() {
+			ClientSocket *socket = new ClientSocket();
+			try {
+				socket->connect(Ip(serverUrl), portNumber);
+			} catch (const exception &ex) {
+				if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] Error [%s]\n", __FILE__, __FUNCTION__, __LINE__, ex.what());
+			}
+			if (socket->isConnected() == false) {
+				delete socket;
+				return NULL;
+			}
+			socket->setBlock(false);
+			return socket;
+		}
+
+		bool ContentTransferClient::receiveReply(Socket *socket, uint8 &status, vector<char> &payload) {
+			uint32 payloadLength = 0;
+			if (receiveValue(socket, &status, sizeof(status)) == false ||
+				receiveValue(socket, &payloadLength, sizeof(payloadLength)) == false) {
+				return false;
+			}
+			payloadLength = fromCommonEndian(payloadLength);
+			if (payloadLength > maxManifestSize) {
+				return false;
+			}
+
+			payload.resize(payloadLength);
+			return payloadLength == 0 || receiveValue(socket, &payload[0], (int) payloadLength);
+		}
+
+		bool ContentTransferClient::sendChunkRequest(Socket *socket, const ContentManifest::Chunk &chunk) {
+			vector<char> request;
+			appendValue<uint8>(request, ctrt_Chunk);
+			appendValue<uint64>(request, chunk.hash);
+			appendValue<uint32>(request, chunk.size);
+			return socket->send(&request[0], (int) request.size()) == (int) request.size();
+		}
+
+		bool ContentTransferClient::requestManifest(ContentTransferType type, const string &name, ContentManifest &manifest, string &error) {
+			Socket *socket = connectSocket();
+			if (socket == NULL) {
+				error = "could not connect to content transfer port";
+				return false;
+			}
+
+			vector<char> request;
+			appendValue<uint8>(request, ctrt_Manifest);
+			appendValue<uint8>(request, (uint8) type);
+			appendValue<uint16>(request, (uint16) name.size());
+			request.insert(request.end(), name.begin(), name.end());
+
+			uint8 status = ctrs_BadRequest;
+			vector<char> payload;
+			bool result = (socket->send(&request[0], (int) request.size()) == (int) request.size() &&
+				socket->hasDataToReadWithWait(CONTENT_TRANSFER_STALL_SECONDS * 1000000) == true &&
+				receiveReply(socket, status, payload) == true);
+			delete socket;
+
+			if (result == false) {
+				error = "no manifest received";
+				return false;
+			} else if (status != ctrs_Ok) {
+				error = (status == ctrs_Denied ? "transfer denied by host" : "host does not have the requested content");
+				return false;
+			} else if (manifest.loadFromBuffer(payload) == false) {
+				error = "invalid manifest";
+				return false;
+			}
+
+			// Never write outside of the item being requested
+			for (unsigned int index = 0; index < manifest.fileList.size(); ++index) {
+				const string &path = manifest.fileList[index].path;
+				bool validPath = isSafeContentPath(path);
+				if (validPath == true && type == ctt_Map) {
+					validPath = (path.find('/') == string::npos && StartsWith(path, name + ".") == true);
+				} else if (validPath == true) {
+					validPath = StartsWith(path, name + "/");
+				}
+				if (validPath == false) {
+					error = "invalid path in manifest [" + path + "]";
+					return false;
+				}
+			}
+			return manifest.fileList.empty() == false;
+		}
+
+		bool ContentTransferClient::fetchChunks(const string &itemName, const vector<ContentManifest::Chunk> &missingList,
+			uint64 totalBytes, uint64 receivedBytes, string &error) {
+
+			vector<Connection> connectionList;
+			vector<int> queueList;
+			for (int index = (int) missingList.size() - 1; index >= 0; --index) {
+				queueList.push_back(index);
+			}
+
+			unsigned int completedCount = 0;
+			int reconnectCount = 0;
+			time_t lastProgressTime = time(NULL);
+			bool result = true;
+
+			for (; completedCount < missingList.size();) {
+				// Keep enough connections open for the work left
+				for (; (int) connectionList.size() < connectionCount &&
+					connectionList.size() < missingList.size() - completedCount &&
+					reconnectCount <= CONTENT_TRANSFER_MAX_RECONNECTS;) {
+					Socket *socket = connectSocket();
+					if (socket == NULL) {
+						++reconnectCount;
+						break;
+					}
+					Connection connection;
+					connection.socket = socket;
+					connection.pendingChunk = -1;
+					connectionList.push_back(connection);
+				}
+
+				if (connectionList.empty() == true) {
+					error = "lost connection to content transfer port";
+					result = false;
+					break;
+				}
+
+				for (int index = (int) connectionList.size() - 1; index >= 0; --index) {
+					Connection &connection = connectionList[index];
+					bool dropConnection = false;
+
+					if (connection.pendingChunk < 0 && queueList.empty() == false) {
+						connection.pendingChunk = queueList.back();
+						queueList.pop_back();
+						dropConnection = (sendChunkRequest(connection.socket, missingList[connection.pendingChunk]) == false);
+					} else if (connection.pendingChunk >= 0 &&
+						connection.socket->hasDataToReadWithWait(10000) == true) {
+						const ContentManifest::Chunk &chunk = missingList[connection.pendingChunk];
+
+						uint8 status = ctrs_BadRequest;
+						vector<char> payload;
+						if (receiveReply(connection.socket, status, payload) == false) {
+							dropConnection = true;
+						} else if (status != ctrs_Ok) {
+							error = "host no longer has chunk " + ContentManifest::getChunkName(chunk);
+							result = false;
+						} else if (payload.size() != chunk.size ||
+							ContentManifest::hashData(&payload[0], payload.size()) != chunk.hash) {
+							dropConnection = true;
+						} else {
+							// Land the chunk under its final name only once it is complete
+							string chunkFile = chunkStorePath + ContentManifest::getChunkName(chunk);
+							if (writeContentFile(chunkFile + ".part", payload) == false ||
+								renameFile(chunkFile + ".part", chunkFile) == false) {
+								error = "could not write chunk store [" + chunkFile + "]";
+								result = false;
+							}
+
+							connection.pendingChunk = -1;
+							++completedCount;
+							receivedBytes += chunk.size;
+							lastProgressTime = time(NULL);
+
+							if (pCBObject != NULL &&
+								pCBObject->ContentTransfer_Progress(itemName, itemName, totalBytes, receivedBytes) == false) {
+								error = "aborted";
+								result = false;
+							}
+						}
+					}
+
+					if (dropConnection == true) {
+						if (connection.pendingChunk >= 0) {
+							queueList.push_back(connection.pendingChunk);
+						}
+						delete connection.socket;
+						connectionList.erase(connectionList.begin() + index);
+						++reconnectCount;
+					}
+					if (result == false) {
+						break;
+					}
+				}
+
+				if (result == false) {
+					break;
+				}
+				if (difftime(time(NULL), lastProgressTime) > CONTENT_TRANSFER_STALL_SECONDS) {
+					error = "content transfer stalled";
+					result = false;
+					break;
+				}
+			}
+
+			for (unsigned int index = 0; index < connectionList.size(); ++index) {
+				delete connectionList[index].socket;
+			}
+			return result;
+		}
+
+		bool ContentTransferClient::assembleFile(const ContentManifest::File &file, const string &destRoot,
+			const std::map<string, LocalChunk> &localChunks) {
+
+			string destFile = destRoot + file.path + ".tmp";
+			createDirectoryPaths(extractDirectoryPathFromFile(destFile));
+
+			FILE *fpOut = openContentFile(destFile, true);
+			if (fpOut == NULL) {
+				return false;
+			}
+
+			bool result = true;
+			vector<char> buffer;
+			for (unsigned int index = 0; index < file.chunkList.size() && result == true; ++index) {
+				const ContentManifest::Chunk &chunk = file.chunkList[index];
+				std::map<string, LocalChunk>::const_iterator iterFind = localChunks.find(ContentManifest::getChunkName(chunk));
+				if (iterFind == localChunks.end()) {
+					result = false;
+					break;
+				}
+
+				FILE *fpIn = openContentFile(iterFind->second.fullPath, false);
+				if (fpIn == NULL) {
+					result = false;
+					break;
+				}
+				buffer.resize(chunk.size);
+				result = (fseek(fpIn, (long) iterFind->second.offset, SEEK_SET) == 0 &&
+					fread(&buffer[0], 1, chunk.size, fpIn) == chunk.size &&
+					fwrite(&buffer[0], 1, chunk.size, fpOut) == chunk.size);
+				fclose(fpIn);
+			}
+
+			if (fclose(fpOut) != 0) {
+				result = false;
+			}
+			if (result == false) {
+				removeFile(destFile);
+			}
+			return result;
+		}
+
+		bool ContentTransferClient::getContent(ContentTransferType type, const string &name, const string &destRootPath, string &error) {
+			string destRoot = destRootPath;
+			if (destRoot == "" || isSafeContentName(name) == false) {
+				error = "no destination for content";
+				return false;
+			}
+			endPathWithSlash(destRoot);
+			createDirectoryPaths(chunkStorePath);
+
+			ContentManifest manifest;
+			if (requestManifest(type, name, manifest, error) == false) {
+				return false;
+			}
+
+			// Index every chunk we can already produce locally, either from
+			// the current copy of a file or from an earlier interrupted run
+			std::map<string, LocalChunk> localChunks;
+			vector<char> buffer(ContentManifest::chunkSize);
+			for (unsigned int index = 0; index < manifest.fileList.size(); ++index) {
+				string fullPath = destRoot + manifest.fileList[index].path;
+				FILE *fp = (fileExists(fullPath) == true ? openContentFile(fullPath, false) : NULL);
+				if (fp == NULL) {
+					continue;
+				}
+				uint64 offset = 0;
+				for (size_t bytesRead = fread(&buffer[0], 1, buffer.size(), fp); bytesRead > 0;
+					bytesRead = fread(&buffer[0], 1, buffer.size(), fp)) {
+					ContentManifest::Chunk chunk;
+					chunk.hash = ContentManifest::hashData(&buffer[0], bytesRead);
+					chunk.size = (uint32) bytesRead;
+
+					LocalChunk localChunk;
+					localChunk.fullPath = fullPath;
+					localChunk.offset = offset;
+					localChunks.insert(make_pair(ContentManifest::getChunkName(chunk), localChunk));
+					offset += bytesRead;
+				}
+				fclose(fp);
+			}
+
+			uint64 totalBytes = 0;
+			uint64 receivedBytes = 0;
+			vector<ContentManifest::Chunk> missingList;
+			std::set<string> seenChunks;
+			for (unsigned int index = 0; index < manifest.fileList.size(); ++index) {
+				const vector<ContentManifest::Chunk> &chunkList = manifest.fileList[index].chunkList;
+				for (unsigned int chunkIndex = 0; chunkIndex < chunkList.size(); ++chunkIndex) {
+					const ContentManifest::Chunk &chunk = chunkList[chunkIndex];
+					string chunkName = ContentManifest::getChunkName(chunk);
+					if (seenChunks.insert(chunkName).second == false) {
+						continue;
+					}
+					totalBytes += chunk.size;
+
+					if (localChunks.find(chunkName) != localChunks.end()) {
+						receivedBytes += chunk.size;
+						continue;
+					}
+
+					string chunkFile = chunkStorePath + chunkName;
+					FILE *fp = (fileExists(chunkFile) == true ? openContentFile(chunkFile, false) : NULL);
+					bool haveChunk = false;
+					if (fp != NULL) {
+						haveChunk = (fread(&buffer[0], 1, chunk.size, fp) == chunk.size &&
+							ContentManifest::hashData(&buffer[0], chunk.size) == chunk.hash);
+						fclose(fp);
+					}
+					if (haveChunk == true) {
+						receivedBytes += chunk.size;
+					} else {
+						missingList.push_back(chunk);
+					}
+				}
+			}
+
+			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] [%s] has %d files, " I64U_SPECIFIER " of " I64U_SPECIFIER " bytes present, fetching %d chunks\n", __FILE__, __FUNCTION__, __LINE__, name.c_str(), (int) manifest.fileList.size(), receivedBytes, totalBytes, (int) missingList.size());
+
+			if (pCBObject != NULL &&
+				pCBObject->ContentTransfer_Progress(name, name, totalBytes, receivedBytes) == false) {
+				error = "aborted";
+				return false;
+			}
+			if (missingList.empty() == false &&
+				fetchChunks(name, missingList, totalBytes, receivedBytes, error) == false) {
+				return false;
+			}
+
+			for (std::set<string>::iterator iterChunk = seenChunks.begin(); iterChunk != seenChunks.end(); ++iterChunk) {
+				if (localChunks.find(*iterChunk) == localChunks.end()) {
+					LocalChunk localChunk;
+					localChunk.fullPath = chunkStorePath + *iterChunk;
+					localChunk.offset = 0;
+					localChunks[*iterChunk] = localChunk;
+				}
+			}
+
+			// Write every file aside first since chunks may come from the
+			// current copy of another file in the same item
+			bool result = true;
+			for (unsigned int index = 0; index < manifest.fileList.size() && result == true; ++index) {
+				result = assembleFile(manifest.fileList[index], destRoot, localChunks);
+			}
+			if (result == false) {
+				for (unsigned int index = 0; index < manifest.fileList.size(); ++index) {
+					removeFile(destRoot + manifest.fileList[index].path + ".tmp");
+				}
+				error = "could not assemble content";
+				return false;
+			}
+
+			std::set<string> manifestPaths;
+			for (unsigned int index = 0; index < manifest.fileList.size(); ++index) {
+				string destFile = destRoot + manifest.fileList[index].path;
+				manifestPaths.insert(destFile);
+				removeFile(destFile);
+				renameFile(destFile + ".tmp", destFile);
+			}
+
+			// Files the host does not have would change the item's checksum
+			if (type != ctt_Map) {
+				string folder = destRoot + name;
+				endPathWithSlash(folder);
+				vector<string> fileList = getFolderTreeContentsListRecursively(folder + "*", "", false);
+				for (unsigned int index = 0; index < fileList.size(); ++index) {
+					string path = fileList[index];
+					replaceAll(path, "\\", "/");
+					if (manifestPaths.find(path) == manifestPaths.end() &&
+						manifestPaths.find(fileList[index]) == manifestPaths.end()) {
+						removeFile(fileList[index]);
+					}
+				}
+			}
+
+			for (std::set<string>::iterator iterChunk = seenChunks.begin(); iterChunk != seenChunks.end(); ++iterChunk) {
+				string chunkFile = chunkStorePath + *iterChunk;
+				if (fileExists(chunkFile) == true) {
+					removeFile(chunkFile);
+				}
+			}
+			return true;
+		}
+
+	}
+} //end namespace
@@ -265,6 +265,9 @@ namespace Shared {
 			this->fileArchiveExtractCommandParameters = fileArchiveExtractCommandParameters;
 			this->fileArchiveExtractCommandSuccessResult = fileArchiveExtractCommandSuccessResult;
 			this->tempFilesPath = tempFilesPath;
+			this->contentTransferPort = 0;
+			this->contentTransferConnections = 1;
+			this->contentTransferType = ftp_cct_File;
 
 			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line %d] Using FTP port #: %d, serverUrl [%s]\n", __FILE__, __FUNCTION__, __LINE__, portNumber, serverUrl.c_str());
 		}
@@ -284,6 +287,72 @@ namespace Shared {
 		}
 
 
+		void FTPClientThread::setContentTransferPort(int portNumber, int connectionCount) {
+			this->contentTransferPort = portNumber;
+			this->contentTransferConnections = connectionCount;
+		}
+
+		pair<FTP_Client_ResultType, string> FTPClientThread::getContentFromServer(FTP_Client_CallbackType downloadType,
+			const string &name, const string &destRoot) {
+			pair<FTP_Client_ResultType, string> result = make_pair(ftp_crt_FAIL, "");
+			if (this->contentTransferPort <= 0 || this->getQuitStatus() == true) {
+				return result;
+			}
+
+			ContentTransferType type = ctt_Map;
+			if (downloadType == ftp_cct_Tileset) {
+				type = ctt_Tileset;
+			} else if (downloadType == ftp_cct_Techtree) {
+				type = ctt_Techtree;
+			}
+
+			this->contentTransferItemName = name;
+			this->contentTransferType = downloadType;
+
+			string chunkStorePath = this->tempFilesPath;
+			endPathWithSlash(chunkStorePath);
+			chunkStorePath += "content_chunks/";
+
+			ContentTransferClient client(this->serverUrl, this->contentTransferPort,
+				this->contentTransferConnections, chunkStorePath, this);
+			string error = "";
+			if (client.getContent(type, name, destRoot, error) == true) {
+				result.first = ftp_crt_SUCCESS;
+			} else {
+				result.second = error;
+				if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] chunked transfer of [%s] failed [%s], falling back to FTP\n", __FILE__, __FUNCTION__, __LINE__, name.c_str(), error.c_str());
+			}
+
+			return result;
+		}
+
+		bool FTPClientThread::ContentTransfer_Progress(const string &itemName, const string &currentFilename,
+			uint64 totalBytes, uint64 receivedBytes) {
+			if (this->getQuitStatus() == true) {
+				return false;
+			}
+
+			FTPClientCallbackInterface::FtpProgressStats stats;
+			stats.download_total = (double) totalBytes;
+			stats.download_now = (double) receivedBytes;
+			stats.upload_total = 0;
+			stats.upload_now = 0;
+			stats.currentFilename = currentFilename;
+			stats.downloadType = this->contentTransferType;
+
+			static string mutexOwnerId = string(__FILE__) + string("_") + intToStr(__LINE__);
+			MutexSafeWrapper safeMutex(this->getProgressMutex(), mutexOwnerId);
+			this->getProgressMutex()->setOwnerId(mutexOwnerId);
+			if (this->pCBObject != NULL) {
+				this->pCBObject->FTPClient_CallbackEvent(
+					this->contentTransferItemName,
+					ftp_cct_DownloadProgress,
+					make_pair(ftp_crt_SUCCESS, ""),
+					&stats);
+			}
+			return true;
+		}
+
 		pair<FTP_Client_ResultType, string> FTPClientThread::getMapFromServer(pair<string, string> mapFileName, string ftpUser, string ftpUserPassword) {
 			pair<FTP_Client_ResultType, string> result = make_pair(ftp_crt_FAIL, "");
 
@@ -376,29 +445,34 @@ namespace Shared {
 
 		void FTPClientThread::getMapFromServer(pair<string, string> mapFileName) {
 			pair<FTP_Client_ResultType, string> result = make_pair(ftp_crt_FAIL, "");
-			if (mapFileName.second != "") {
-				result = getMapFromServer(mapFileName, "", "");
-			} else {
-				pair<string, string> findMapFileName = mapFileName;
-				findMapFileName.first += +".zgm";
+			if (mapFileName.second == "") {
+				result = getContentFromServer(ftp_cct_Map, mapFileName.first, this->mapsPath.second);
+			}
+			if (result.first != ftp_crt_SUCCESS && this->getQuitStatus() == false) {
+				if (mapFileName.second != "") {
+					result = getMapFromServer(mapFileName, "", "");
+				} else {
+					pair<string, string> findMapFileName = mapFileName;
+					findMapFileName.first += +".zgm";
 
-				result = getMapFromServer(findMapFileName, FTP_MAPS_CUSTOM_USERNAME, FTP_COMMON_PASSWORD);
-				if (result.first == ftp_crt_FAIL && this->getQuitStatus() == false) {
-					findMapFileName = mapFileName;
-					findMapFileName.first += +".gbm";
 					result = getMapFromServer(findMapFileName, FTP_MAPS_CUSTOM_USERNAME, FTP_COMMON_PASSWORD);
 					if (result.first == ftp_crt_FAIL && this->getQuitStatus() == false) {
-							findMapFileName = mapFileName;
-							findMapFileName.first += +".zgm";
-							result = getMapFromServer(findMapFileName, FTP_MAPS_USERNAME, FTP_COMMON_PASSWORD);
+						findMapFileName = mapFileName;
+						findMapFileName.first += +".gbm";
+						result = getMapFromServer(findMapFileName, FTP_MAPS_CUSTOM_USERNAME, FTP_COMMON_PASSWORD);
 						if (result.first == ftp_crt_FAIL && this->getQuitStatus() == false) {
-							findMapFileName = mapFileName;
-							findMapFileName.first += +".mgm";
-							result = getMapFromServer(findMapFileName, FTP_MAPS_USERNAME, FTP_COMMON_PASSWORD);
+								findMapFileName = mapFileName;
+								findMapFileName.first += +".zgm";
+								result = getMapFromServer(findMapFileName, FTP_MAPS_USERNAME, FTP_COMMON_PASSWORD);
 							if (result.first == ftp_crt_FAIL && this->getQuitStatus() == false) {
 								findMapFileName = mapFileName;
-								findMapFileName.first += +".gbm";
+								findMapFileName.first += +".mgm";
 								result = getMapFromServer(findMapFileName, FTP_MAPS_USERNAME, FTP_COMMON_PASSWORD);
+								if (result.first == ftp_crt_FAIL && this->getQuitStatus() == false) {
+									findMapFileName = mapFileName;
+									findMapFileName.first += +".gbm";
+									result = getMapFromServer(findMapFileName, FTP_MAPS_USERNAME, FTP_COMMON_PASSWORD);
+								}
 							}
 						}
 					}
@@ -483,7 +557,10 @@ namespace Shared {
 				this->fileArchiveExtractCommandSuccessResult);
 
 			pair<FTP_Client_ResultType, string> result = make_pair(ftp_crt_FAIL, "");
-			if (findArchive == true) {
+			if (tileSetName.second == "") {
+				result = getContentFromServer(ftp_cct_Tileset, tileSetName.first, this->tilesetsPath.second);
+			}
+			if (findArchive == true && result.first != ftp_crt_SUCCESS && this->getQuitStatus() == false) {
 				if (tileSetName.second != "") {
 					//result = getTilesetFromServer(tileSetName, "", "", "", findArchive);
 					result = getTilesetFromServer(tileSetName, "", "", "", true);
@@ -665,7 +742,10 @@ namespace Shared {
 			bool findArchive = executeShellCommand(
 				this->fileArchiveExtractCommand,
 				this->fileArchiveExtractCommandSuccessResult);
-			if (findArchive == true) {
+			if (techtreeName.second == "") {
+				result = getContentFromServer(ftp_cct_Techtree, techtreeName.first, this->techtreesPath.second);
+			}
+			if (findArchive == true && result.first != ftp_crt_SUCCESS && this->getQuitStatus() == false) {
 				if (techtreeName.second != "") {
 					result = getTechtreeFromServer(techtreeName, "", "");
 				} else {
@@ -60,6 +60,11 @@
 #include <netinet/in.h>
 #include <net/if.h>
 #include <netinet/tcp.h>
+#include <sys/uio.h>
+#endif
+
+#ifdef __linux__
+#include <sys/epoll.h>
 #endif
 
 
@@ -80,6 +85,9 @@ namespace Shared {
 	namespace Platform {
 
 		bool Socket::disableNagle = false;
+		SocketLinkConditions Socket::defaultLinkConditions;
+		Mutex SocketLinkSimulator::mutexInstance;
+		SocketLinkSimulator *SocketLinkSimulator::instance = NULL;
 		int Socket::DEFAULT_SOCKET_SENDBUF_SIZE = -1;
 		int Socket::DEFAULT_SOCKET_RECVBUF_SIZE = -1;
 		string Socket::host_name = "";
@@ -857,6 +865,9 @@ namespace Shared {
 			dataSynchAccessorRead = new Mutex(CODE_AT_LINE);
 			dataSynchAccessorWrite = new Mutex(CODE_AT_LINE);
 			inSocketDestructorSynchAccessor = new Mutex(CODE_AT_LINE);
+			sendBatchAccessor = new Mutex(CODE_AT_LINE);
+			sendBatchEnabled = false;
+			unreadOffset = 0;
 			lastSocketError = 0;
 
 			MutexSafeWrapper safeMutexSocketDestructorFlag(inSocketDestructorSynchAccessor, CODE_AT_LINE);
@@ -880,6 +891,9 @@ namespace Shared {
 			dataSynchAccessorRead = new Mutex(CODE_AT_LINE);
 			dataSynchAccessorWrite = new Mutex(CODE_AT_LINE);
 			inSocketDestructorSynchAccessor = new Mutex(CODE_AT_LINE);
+			sendBatchAccessor = new Mutex(CODE_AT_LINE);
+			sendBatchEnabled = false;
+			unreadOffset = 0;
 			lastSocketError = 0;
 			lastDebugEvent = 0;
 			lastThreadedPing = 0;
@@ -1003,6 +1017,7 @@ namespace Shared {
 			//safeMutexSocketDestructorFlag.ReleaseLock();
 
 			disconnectSocket();
+			SocketLinkSimulator::removeSocket(this);
 
 			// Allow other callers with a lock on the mutexes to let them go
 			for (time_t elapsed = time(NULL);
@@ -1023,6 +1038,8 @@ namespace Shared {
 			dataSynchAccessorRead = NULL;
 			delete dataSynchAccessorWrite;
 			dataSynchAccessorWrite = NULL;
+			delete sendBatchAccessor;
+			sendBatchAccessor = NULL;
 			delete inSocketDestructorSynchAccessor;
 			inSocketDestructorSynchAccessor = NULL;
 		}
@@ -1116,6 +1133,9 @@ namespace Shared {
 
 		bool Socket::hasDataToRead() {
 			MutexSafeWrapper safeMutex(dataSynchAccessorRead, CODE_AT_LINE);
+			if (unreadOffset < unreadBuffer.size()) {
+				return true;
+			}
 			return Socket::hasDataToRead(sock);
 		}
 
@@ -1154,6 +1174,9 @@ namespace Shared {
 
 		bool Socket::hasDataToReadWithWait(int waitMicroseconds) {
 			MutexSafeWrapper safeMutex(dataSynchAccessorRead, CODE_AT_LINE);
+			if (unreadOffset < unreadBuffer.size()) {
+				return true;
+			}
 			return Socket::hasDataToReadWithWait(sock, waitMicroseconds);
 		}
 
@@ -1198,6 +1221,26 @@ namespace Shared {
 		int Socket::getDataToRead(bool wantImmediateReply) {
 			unsigned long size = 0;
 
+			// Bytes pushed back by unreadData are ready right away, only add
+			// what the socket holds now without waiting for more
+			MutexSafeWrapper safeMutexUnread(dataSynchAccessorRead, CODE_AT_LINE);
+			size_t unreadCount = (unreadOffset < unreadBuffer.size() ? unreadBuffer.size() - unreadOffset : 0);
+			safeMutexUnread.ReleaseLock();
+			if (unreadCount > 0) {
+				if (isSocketValid() == true) {
+#ifndef WIN32
+					if (ioctl(sock, FIONREAD, &size) < 0) {
+						size = 0;
+					}
+#else
+					if (ioctlsocket(sock, FIONREAD, &size) < 0) {
+						size = 0;
+					}
+#endif
+				}
+				return static_cast<int>(unreadCount + size);
+			}
+
 			//fd_set rfds;
 			//struct timeval tv;
 			//int retval;
@@ -1256,6 +1299,40 @@ namespace Shared {
 		}
 
 		int Socket::send(const void *data, int dataSize) {
+			SocketLinkConditions conditions = getLinkConditions();
+			if (conditions.isEnabled() == true && isSocketValid() == true) {
+				return SocketLinkSimulator::getInstance()->queue(this, conditions, data, dataSize);
+			}
+			return sendNow(data, dataSize);
+		}
+
+		int Socket::trySend(const void *data, int dataSize) {
+			if (isSocketValid() == false) {
+				return -1;
+			}
+
+			MutexSafeWrapper safeMutex(dataSynchAccessorWrite, CODE_AT_LINE);
+			errno = 0;
+#ifdef __APPLE__
+			int bytesSent = (int)::send(sock, (const char *) data, dataSize, SO_NOSIGPIPE);
+#else
+			int bytesSent = (int)::send(sock, (const char *) data, dataSize, MSG_NOSIGNAL | MSG_DONTWAIT);
+#endif
+			int lastSocketError = getLastSocketError();
+			safeMutex.ReleaseLock();
+
+			if (bytesSent < 0) {
+				if (lastSocketError == PLATFORM_SOCKET_TRY_AGAIN) {
+					return 0;
+				}
+				if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] ERROR WRITING SOCKET DATA, err = %d error = %s dataSize = %d\n", __FILE__, __FUNCTION__, __LINE__, bytesSent, getLastSocketErrorFormattedText(&lastSocketError).c_str(), dataSize);
+				disconnectSocket();
+				return -1;
+			}
+			return bytesSent;
+		}
+
+		int Socket::sendNow(const void *data, int dataSize) {
 			const int MAX_SEND_WAIT_SECONDS = 3;
 
 			int bytesSent = 0;
@@ -1427,7 +1504,183 @@ namespace Shared {
 			return static_cast<int>(bytesSent);
 		}
 
+		void Socket::beginSendBatch() {
+			MutexSafeWrapper safeMutex(sendBatchAccessor, CODE_AT_LINE);
+			sendBatchEnabled = true;
+		}
+
+		bool Socket::isSendBatchEnabled() {
+			MutexSafeWrapper safeMutex(sendBatchAccessor, CODE_AT_LINE);
+			return sendBatchEnabled;
+		}
+
+		int Socket::sendBuffer(const SocketSendBuffer &buffer) {
+			if (buffer.get() == NULL || buffer->empty() == true) {
+				return 0;
+			}
+
+			MutexSafeWrapper safeMutex(sendBatchAccessor, CODE_AT_LINE);
+			if (sendBatchEnabled == true) {
+				sendBatchList.push_back(buffer);
+				return (int) buffer->size();
+			}
+			safeMutex.ReleaseLock();
+
+			return send(&(*buffer)[0], (int) buffer->size());
+		}
+
+		int Socket::flushSendBatch() {
+			const int MAX_SEND_WAIT_SECONDS = 3;
+
+			std::vector<SocketSendBuffer> flushList;
+			MutexSafeWrapper safeMutexBatch(sendBatchAccessor, CODE_AT_LINE);
+			sendBatchEnabled = false;
+			flushList.swap(sendBatchList);
+			safeMutexBatch.ReleaseLock();
+
+			if (flushList.empty() == true) {
+				return 0;
+			}
+
+			int totalSize = 0;
+			for (unsigned int index = 0; index < flushList.size(); ++index) {
+				totalSize += (int) flushList[index]->size();
+			}
+
+			// Simulated links delay every buffer on its own so skip the gathered write
+#ifndef WIN32
+			if (getLinkConditions().isEnabled() == false) {
+				const unsigned int MAX_IOVEC_COUNT = 64;
+
+				int totalBytesSent = 0;
+				unsigned int bufferIndex = 0;
+				size_t bufferOffset = 0;
+				time_t tStartTimer = time(NULL);
+
+				MutexSafeWrapper safeMutex(dataSynchAccessorWrite, CODE_AT_LINE);
+				while (bufferIndex < flushList.size() && isSocketValid() == true) {
+					struct iovec iov[MAX_IOVEC_COUNT];
+					unsigned int iovCount = 0;
+					for (unsigned int index = bufferIndex;
+						index < flushList.size() && iovCount < MAX_IOVEC_COUNT; ++index) {
+						const std::vector<char> &buffer = *flushList[index];
+						size_t offset = (index == bufferIndex ? bufferOffset : 0);
+						iov[iovCount].iov_base = (void *) (&buffer[0] + offset);
+						iov[iovCount].iov_len = buffer.size() - offset;
+						iovCount++;
+					}
+
+					struct msghdr msg;
+					memset(&msg, 0, sizeof(msg));
+					msg.msg_iov = iov;
+					msg.msg_iovlen = iovCount;
+
+#ifdef __APPLE__
+					ssize_t bytesSent = ::sendmsg(sock, &msg, 0);
+#else
+					ssize_t bytesSent = ::sendmsg(sock, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+#endif
+					if (bytesSent < 0) {
+						int lastSocketError = getLastSocketError();
+						if (lastSocketError == PLATFORM_SOCKET_TRY_AGAIN || lastSocketError == PLATFORM_SOCKET_INTERRUPTED) {
+							if (difftime((long int) time(NULL), tStartTimer) > MAX_SEND_WAIT_SECONDS) {
+								break;
+							}
+							struct timeval timeVal;
+							timeVal.tv_sec = 1;
+							timeVal.tv_usec = 0;
+							isWritable(&timeVal);
+							continue;
+						}
+
+						if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] ERROR WRITING SOCKET DATA, error = %s totalSize = %d\n", __FILE__, __FUNCTION__, __LINE__, getLastSocketErrorFormattedText(&lastSocketError).c_str(), totalSize);
+						safeMutex.ReleaseLock();
+						disconnectSocket();
+						return -1;
+					}
+
+					// Advance past everything the kernel accepted, which may end
+					// part way through a buffer
+					totalBytesSent += (int) bytesSent;
+					size_t remaining = (size_t) bytesSent;
+					while (remaining > 0 && bufferIndex < flushList.size()) {
+						size_t available = flushList[bufferIndex]->size() - bufferOffset;
+						if (remaining >= available) {
+							remaining -= available;
+							bufferIndex++;
+							bufferOffset = 0;
+						} else {
+							bufferOffset += remaining;
+							remaining = 0;
+						}
+					}
+				}
+				safeMutex.ReleaseLock();
+
+				// sendBuffer already reported every queued message as sent, the
+				// peer would be left with a stream cut part way through one
+				if (totalBytesSent != totalSize) {
+					if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] ERROR partial batch send, totalBytesSent = %d totalSize = %d\n", __FILE__, __FUNCTION__, __LINE__, totalBytesSent, totalSize);
+					disconnectSocket();
+					return -1;
+				}
+				return totalBytesSent;
+			}
+#endif
+
+			int totalBytesSent = 0;
+			for (unsigned int index = 0; index < flushList.size(); ++index) {
+				const std::vector<char> &buffer = *flushList[index];
+				int bytesSent = send(&buffer[0], (int) buffer.size());
+				if (bytesSent != (int) buffer.size()) {
+					if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] ERROR partial batch send, bytesSent = %d size = %d\n", __FILE__, __FUNCTION__, __LINE__, bytesSent, (int) buffer.size());
+					disconnectSocket();
+					return -1;
+				}
+				totalBytesSent += bytesSent;
+			}
+			return totalBytesSent;
+		}
+
+		void Socket::unreadData(const void *data, int dataSize) {
+			if (data == NULL || dataSize <= 0) {
+				return;
+			}
+			MutexSafeWrapper safeMutex(dataSynchAccessorRead, CODE_AT_LINE);
+			if (unreadOffset >= unreadBuffer.size()) {
+				unreadBuffer.clear();
+				unreadOffset = 0;
+			}
+			const char *dataBuffer = (const char *) data;
+			unreadBuffer.insert(unreadBuffer.begin() + unreadOffset, dataBuffer, dataBuffer + dataSize);
+		}
+
+		bool Socket::hasUnreadData() {
+			MutexSafeWrapper safeMutex(dataSynchAccessorRead, CODE_AT_LINE);
+			return (unreadOffset < unreadBuffer.size());
+		}
+
 		int Socket::receive(void *data, int dataSize, bool tryReceiveUntilDataSizeMet) {
+			// Hand out any unread bytes first
+			MutexSafeWrapper safeMutexUnread(dataSynchAccessorRead, CODE_AT_LINE);
+			if (unreadOffset < unreadBuffer.size() && dataSize > 0) {
+				int unreadCount = std::min<int>(dataSize, (int) (unreadBuffer.size() - unreadOffset));
+				memcpy(data, &unreadBuffer[unreadOffset], unreadCount);
+				unreadOffset += unreadCount;
+				if (unreadOffset >= unreadBuffer.size()) {
+					unreadBuffer.clear();
+					unreadOffset = 0;
+				}
+				safeMutexUnread.ReleaseLock();
+
+				if (unreadCount == dataSize || tryReceiveUntilDataSizeMet == false) {
+					return unreadCount;
+				}
+				int bytesRemaining = receive(reinterpret_cast<char *>(data) + unreadCount, dataSize - unreadCount, tryReceiveUntilDataSizeMet);
+				return (bytesRemaining > 0 ? unreadCount + bytesRemaining : unreadCount);
+			}
+			safeMutexUnread.ReleaseLock();
+
 			ssize_t bytesReceived = 0;
 
 			if (isSocketValid() == true) {
@@ -1519,6 +1772,156 @@ namespace Shared {
 			return static_cast<int>(bytesReceived);
 		}
 
+		// =====================================================
+		//	class SocketReactor
+		// =====================================================
+
+		SocketReactor::SocketReactor() {
+			mutexSocketList = new Mutex(CODE_AT_LINE);
+#ifdef __linux__
+			reactorHandle = epoll_create1(EPOLL_CLOEXEC);
+			if (reactorHandle < 0) {
+				SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] epoll_create1 failed, error = %s\n", __FILE__, __FUNCTION__, __LINE__, Socket::getLastSocketErrorFormattedText().c_str());
+				throw game_runtime_error("epoll_create1 failed, error = " + Socket::getLastSocketErrorFormattedText());
+			}
+#else
+			reactorHandle = INVALID_SOCKET;
+#endif
+		}
+
+		SocketReactor::~SocketReactor() {
+#ifdef __linux__
+			if (reactorHandle >= 0) {
+				::close(reactorHandle);
+				reactorHandle = -1;
+			}
+#endif
+			delete mutexSocketList;
+			mutexSocketList = NULL;
+		}
+
+		bool SocketReactor::isEdgeTriggered() {
+#ifdef __linux__
+			return true;
+#else
+			return false;
+#endif
+		}
+
+		bool SocketReactor::addSocket(PLATFORM_SOCKET socket, int key) {
+			if (Socket::isSocketValid(&socket) == false) {
+				return false;
+			}
+			MutexSafeWrapper safeMutex(mutexSocketList, CODE_AT_LINE);
+#ifdef __linux__
+			struct epoll_event event;
+			memset(&event, 0, sizeof(event));
+			event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+			event.data.u64 = ((uint64) (uint32) key << 32) | (uint32) socket;
+
+			// A closed socket is silently dropped by the kernel, so a re-used
+			// descriptor may still be in our list but unknown to epoll
+			int result = -1;
+			if (socketList.find(socket) != socketList.end()) {
+				result = epoll_ctl(reactorHandle, EPOLL_CTL_MOD, socket, &event);
+			}
+			if (result != 0) {
+				result = epoll_ctl(reactorHandle, EPOLL_CTL_ADD, socket, &event);
+			}
+			if (result != 0) {
+				if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line: %d] epoll_ctl failed for socket = %d, error = %s\n", __FILE__, __FUNCTION__, __LINE__, socket, Socket::getLastSocketErrorFormattedText().c_str());
+				return false;
+			}
+#endif
+			socketList[socket] = key;
+			return true;
+		}
+
+		void SocketReactor::removeSocket(PLATFORM_SOCKET socket) {
+			MutexSafeWrapper safeMutex(mutexSocketList, CODE_AT_LINE);
+			std::map<PLATFORM_SOCKET, int>::iterator iterFind = socketList.find(socket);
+			if (iterFind != socketList.end()) {
+#ifdef __linux__
+				// Fails harmlessly with EBADF / ENOENT if the socket was already closed
+				struct epoll_event event;
+				memset(&event, 0, sizeof(event));
+				epoll_ctl(reactorHandle, EPOLL_CTL_DEL, socket, &event);
+#endif
+				socketList.erase(iterFind);
+			}
+		}
+
+		bool SocketReactor::hasSocket(PLATFORM_SOCKET socket) {
+			MutexSafeWrapper safeMutex(mutexSocketList, CODE_AT_LINE);
+			return (socketList.find(socket) != socketList.end());
+		}
+
+		int SocketReactor::getSocketCount() {
+			MutexSafeWrapper safeMutex(mutexSocketList, CODE_AT_LINE);
+			return (int) socketList.size();
+		}
+
+		int SocketReactor::wait(std::vector<int> &triggeredKeyList, int waitMilliseconds) {
+			triggeredKeyList.clear();
+
+#ifdef __linux__
+			const int MAX_REACTOR_EVENTS = 64;
+			struct epoll_event events[MAX_REACTOR_EVENTS];
+
+			int retval = epoll_wait(reactorHandle, events, MAX_REACTOR_EVENTS, waitMilliseconds);
+			if (retval < 0) {
+				if (Socket::getLastSocketError() == PLATFORM_SOCKET_INTERRUPTED) {
+					return 0;
+				}
+				if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s] Line: %d, ERROR epoll_wait retval = %d error = %s\n", __FILE__, __FUNCTION__, __LINE__, retval, Socket::getLastSocketErrorFormattedText().c_str());
+				return -1;
+			}
+			for (int index = 0; index < retval; ++index) {
+				triggeredKeyList.push_back((int) (events[index].data.u64 >> 32));
+			}
+			return retval;
+#else
+			fd_set rfds;
+			FD_ZERO(&rfds);
+
+			PLATFORM_SOCKET imaxsocket = 0;
+			std::map<PLATFORM_SOCKET, int> socketListCopy;
+			MutexSafeWrapper safeMutex(mutexSocketList, CODE_AT_LINE);
+			socketListCopy = socketList;
+			safeMutex.ReleaseLock();
+
+			for (std::map<PLATFORM_SOCKET, int>::iterator iterMap = socketListCopy.begin();
+				iterMap != socketListCopy.end(); ++iterMap) {
+				PLATFORM_SOCKET socket = iterMap->first;
+				if (Socket::isSocketValid(&socket) == true) {
+					FD_SET(socket, &rfds);
+					imaxsocket = max(socket, imaxsocket);
+				}
+			}
+			if (imaxsocket == 0) {
+				sleep(waitMilliseconds);
+				return 0;
+			}
+
+			struct timeval tv;
+			tv.tv_sec = waitMilliseconds / 1000;
+			tv.tv_usec = (waitMilliseconds % 1000) * 1000;
+
+			int retval = select((int) imaxsocket + 1, &rfds, NULL, NULL, &tv);
+			if (retval < 0) {
+				if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s] Line: %d, ERROR SELECTING SOCKET DATA retval = %d error = %s\n", __FILE__, __FUNCTION__, __LINE__, retval, Socket::getLastSocketErrorFormattedText().c_str());
+				return -1;
+			}
+			for (std::map<PLATFORM_SOCKET, int>::iterator iterMap = socketListCopy.begin();
+				retval > 0 && iterMap != socketListCopy.end(); ++iterMap) {
+				if (FD_ISSET(iterMap->first, &rfds)) {
+					triggeredKeyList.push_back(iterMap->second);
+				}
+			}
+			return (int) triggeredKeyList.size();
+#endif
+		}
+
 		SafeSocketBlockToggleWrapper::SafeSocketBlockToggleWrapper(Socket *socket, bool toggle) {
 			this->socket = socket;
 
@@ -1922,6 +2325,153 @@ namespace Shared {
 			throw game_runtime_error(msg);
 		}
 
+		// =====================================================
+		//	class SocketLinkSimulator
+		// =====================================================
+
+		SocketLinkSimulator::SocketLinkSimulator() : BaseThread() {
+			mutexPacketList = new Mutex(CODE_AT_LINE);
+			mutexSend = new Mutex(CODE_AT_LINE);
+			randomState = (uint32) time(NULL);
+			setUniqueID("SocketLinkSimulator");
+		}
+
+		SocketLinkSimulator::~SocketLinkSimulator() {
+			delete mutexPacketList;
+			mutexPacketList = NULL;
+			delete mutexSend;
+			mutexSend = NULL;
+		}
+
+		SocketLinkSimulator * SocketLinkSimulator::getInstance() {
+			MutexSafeWrapper safeMutex(&mutexInstance, CODE_AT_LINE);
+			if (instance == NULL) {
+				instance = new SocketLinkSimulator();
+				instance->start();
+			}
+			return instance;
+		}
+
+		void SocketLinkSimulator::removeSocket(Socket *socket) {
+			MutexSafeWrapper safeMutex(&mutexInstance, CODE_AT_LINE);
+			if (instance != NULL) {
+				instance->discardSocket(socket);
+			}
+		}
+
+		void SocketLinkSimulator::shutdown() {
+			MutexSafeWrapper safeMutex(&mutexInstance, CODE_AT_LINE);
+			if (instance != NULL) {
+				instance->signalQuit();
+				if (instance->shutdownAndWait() == true) {
+					delete instance;
+				}
+				instance = NULL;
+			}
+		}
+
+		int SocketLinkSimulator::nextRandom(int maxValue) {
+			// Small LCG, the simulation only needs a cheap uniform spread
+			randomState = randomState * 1664525u + 1013904223u;
+			return (maxValue > 0 ? (int) ((randomState >> 8) % (uint32) (maxValue + 1)) : 0);
+		}
+
+		int SocketLinkSimulator::queue(Socket *socket, const SocketLinkConditions &conditions, const void *data, int dataSize) {
+			if (data == NULL || dataSize <= 0) {
+				return 0;
+			}
+
+			MutexSafeWrapper safeMutex(mutexPacketList, CODE_AT_LINE);
+			int64 now = Chrono::getCurMillis();
+
+			// Bandwidth: data leaves the link one packet after the other
+			int64 sendTime = max(now, linkBusyUntilList[socket]);
+			if (conditions.bandwidthKbps > 0) {
+				sendTime += ((int64) dataSize * 8) / conditions.bandwidthKbps;
+			}
+			linkBusyUntilList[socket] = sendTime;
+
+			int64 dueTime = sendTime + conditions.latencyMilliseconds;
+			if (conditions.jitterMilliseconds > 0) {
+				dueTime += nextRandom(conditions.jitterMilliseconds * 2) - conditions.jitterMilliseconds;
+			}
+			if (conditions.lossPercent > 0 && nextRandom(99) < conditions.lossPercent) {
+				dueTime += max(200, conditions.latencyMilliseconds * 2);
+			}
+
+			// A stream never reorders so nothing may overtake earlier data
+			int64 &lastDueTime = lastDueTimeList[socket];
+			dueTime = max(dueTime, lastDueTime);
+			lastDueTime = dueTime;
+
+			SimulatedPacket packet;
+			packet.socket = socket;
+			packet.data.assign((const char *) data, (const char *) data + dataSize);
+			packetList.insert(std::make_pair(dueTime, packet));
+
+			return dataSize;
+		}
+
+		void SocketLinkSimulator::discardSocket(Socket *socket) {
+			MutexSafeWrapper safeMutexSend(mutexSend, CODE_AT_LINE);
+			MutexSafeWrapper safeMutex(mutexPacketList, CODE_AT_LINE);
+			for (std::multimap<int64, SimulatedPacket>::iterator iterMap = packetList.begin();
+				iterMap != packetList.end();) {
+				if (iterMap->second.socket == socket) {
+					packetList.erase(iterMap++);
+				} else {
+					++iterMap;
+				}
+			}
+			lastDueTimeList.erase(socket);
+			linkBusyUntilList.erase(socket);
+		}
+
+		void SocketLinkSimulator::sendDuePackets(bool sendAll) {
+			MutexSafeWrapper safeMutexSend(mutexSend, CODE_AT_LINE);
+
+			// Taken off the list under the lock and written without it, so
+			// queue() never waits on a blocking send
+			vector<SimulatedPacket> dueList;
+			MutexSafeWrapper safeMutex(mutexPacketList, CODE_AT_LINE);
+			int64 now = Chrono::getCurMillis();
+			while (packetList.empty() == false && (sendAll == true || packetList.begin()->first <= now)) {
+				dueList.push_back(SimulatedPacket());
+				dueList.back().socket = packetList.begin()->second.socket;
+				dueList.back().data.swap(packetList.begin()->second.data);
+				packetList.erase(packetList.begin());
+			}
+			safeMutex.ReleaseLock();
+
+			for (unsigned int index = 0; index < dueList.size(); ++index) {
+				SimulatedPacket &packet = dueList[index];
+				if (packet.socket->isSocketValid() == true) {
+					packet.socket->sendNow(&packet.data[0], (int) packet.data.size());
+				}
+			}
+		}
+
+		void SocketLinkSimulator::execute() {
+			RunningStatusSafeWrapper runningStatus(this);
+			ExecutingTaskSafeWrapper safeExecutingTaskMutex(this);
+
+			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "Socket link simulator thread is running\n");
+
+			for (; getQuitStatus() == false;) {
+				sendDuePackets(false);
+				sleep(1);
+			}
+
+			// Deliver whatever is still in flight rather than cutting streams short
+			sendDuePackets(true);
+
+			MutexSafeWrapper safeMutex(mutexPacketList, CODE_AT_LINE);
+			lastDueTimeList.clear();
+			linkBusyUntilList.clear();
+
+			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "Socket link simulator thread is exiting\n");
+		}
+
 		// ===============================================
 		//	class ClientSocket
 		// ===============================================
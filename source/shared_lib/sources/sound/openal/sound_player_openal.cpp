@@ -140,38 +140,19 @@ namespace Shared {
 			//---------------------------------------------------------------------------
 
 			StaticSoundSource::StaticSoundSource() {
-				bufferAllocated = false;
 				buffer = 0;
 			}
 
 			StaticSoundSource::~StaticSoundSource() {
-				if (bufferAllocated) {
-					stop();
-					alDeleteBuffers(1, &buffer);
-				}
 			}
 
-			void StaticSoundSource::play(StaticSound* sound) {
-				if (SystemFlags::getSystemSettingType(SystemFlags::debugSound).enabled) SystemFlags::OutputDebug(SystemFlags::debugSound, "In [%s::%s Line: %d]\n", __FILE__, __FUNCTION__, __LINE__);
+			void StaticSoundSource::play(StaticSound* sound, ALuint buffer) {
+				if (SystemFlags::getSystemSettingType(SystemFlags::debugSound).enabled) SystemFlags::OutputDebug(SystemFlags::debugSound, "In [%s::%s Line: %d] filename [%s] buffer = %u\n", __FILE__, __FUNCTION__, __LINE__, sound->getFileName().c_str(), buffer);
 
-				if (bufferAllocated) {
+				if (this->buffer != 0) {
 					stop();
-					alDeleteBuffers(1, &buffer);
-					SoundPlayerOpenAL::checkAlError(string(__FILE__) + string(" ") + string(__FUNCTION__) + string(" ") + intToStr(__LINE__));
 				}
-				ALenum format = getFormat(sound);
-
-				alGenBuffers(1, &buffer);
-				SoundPlayerOpenAL::checkAlError("Couldn't create audio buffer: ");
-
-				if (SystemFlags::getSystemSettingType(SystemFlags::debugSound).enabled) SystemFlags::OutputDebug(SystemFlags::debugSound, "In [%s::%s Line: %d] filename [%s] format = %d, sound->getSamples() = %d, sound->getInfo()->getSize() = %d, sound->getInfo()->getSamplesPerSecond() = %d\n", __FILE__, __FUNCTION__, __LINE__, sound->getFileName().c_str(), format, sound->getSamples(), sound->getInfo()->getSize(), sound->getInfo()->getSamplesPerSecond());
-
-				bufferAllocated = true;
-				alBufferData(buffer, format, sound->getSamples(),
-					static_cast<ALsizei> (sound->getInfo()->getSize()),
-					static_cast<ALsizei> (sound->getInfo()->getSamplesPerSecond()));
-
-				SoundPlayerOpenAL::checkAlError(string(__FILE__) + string(" ") + string(__FUNCTION__) + string(" ") + intToStr(__LINE__));
+				this->buffer = buffer;
 
 				alSourcei(source, AL_BUFFER, buffer);
 				SoundPlayerOpenAL::checkAlError(string(__FILE__) + string(" ") + string(__FUNCTION__) + string(" ") + intToStr(__LINE__));
@@ -182,13 +163,17 @@ namespace Shared {
 				SoundPlayerOpenAL::checkAlError(string(__FILE__) + string(" ") + string(__FUNCTION__) + string(" ") + intToStr(__LINE__));
 			}
 
-			StreamSoundSource::StreamSoundSource() {
+			StreamSoundSource::StreamSoundSource() :
+				fragment(STREAMFRAGMENTSIZE), decodeBuffer(STREAMDECODESIZE, STREAMDECODECHUNKSIZE) {
 				sound = 0;
 				fadeState = NoFading;
 				format = 0;
+				samplesPerSecond = 0;
+				started = false;
 				fade = 0;
 				alGenBuffers(STREAMFRAGMENTS, buffers);
 				SoundPlayerOpenAL::checkAlError(string(__FILE__) + string(" ") + string(__FUNCTION__) + string(" ") + intToStr(__LINE__));
+				freeBuffers.assign(buffers, buffers + STREAMFRAGMENTS);
 			}
 
 			StreamSoundSource::~StreamSoundSource() {
@@ -198,8 +183,13 @@ namespace Shared {
 			}
 
 			void StreamSoundSource::stop() {
+				StreamDecoder::remove(&decodeBuffer);
+				decodeBuffer.reset(NULL);
+
 				sound = 0;
+				started = false;
 				SoundSource::stop();
+				freeBuffers.assign(buffers, buffers + STREAMFRAGMENTS);
 			}
 
 			void StreamSoundSource::stop(int64 fadeoff) {
@@ -215,12 +205,15 @@ namespace Shared {
 			void StreamSoundSource::play(StrSound* sound, int64 fadeon) {
 				stop();
 
+				format = getFormat(sound);
+				samplesPerSecond = sound->getInfo()->getSamplesPerSecond();
 				this->sound = sound;
 
-				format = getFormat(sound);
-				for (size_t i = 0; i < STREAMFRAGMENTS; ++i) {
-					fillBufferAndQueue(buffers[i]);
-				}
+				// The decoder fills the first fragments, update() starts the
+				// source once they are queued
+				decodeBuffer.reset(sound);
+				StreamDecoder::add(&decodeBuffer);
+
 				if (fadeon > 0) {
 					alSourcef(source, AL_GAIN, 0);
 					SoundPlayerOpenAL::checkAlError(string(__FILE__) + string(" ") + string(__FUNCTION__) + string(" ") + intToStr(__LINE__));
@@ -233,8 +226,6 @@ namespace Shared {
 					alSourcef(source, AL_GAIN, sound->getVolume());
 					SoundPlayerOpenAL::checkAlError(string(__FILE__) + string(" ") + string(__FUNCTION__) + string(" ") + intToStr(__LINE__));
 				}
-				alSourcePlay(source);
-				SoundPlayerOpenAL::checkAlError(string(__FILE__) + string(" ") + string(__FUNCTION__) + string(" ") + intToStr(__LINE__));
 			}
 
 			void StreamSoundSource::update() {
@@ -242,6 +233,14 @@ namespace Shared {
 					return;
 				}
 
+				// Follow the decoder along the chain so volume changes and
+				// stop() calls reach the sound that is playing now
+				StrSound *current = decodeBuffer.getCurrentSound();
+				if (current != NULL && current != sound) {
+					current->setVolume(sound->getVolume());
+					sound = current;
+				}
+
 				if (fadeState == NoFading) {
 					alSourcef(source, AL_GAIN, sound->getVolume());
 					SoundPlayerOpenAL::checkAlError(string(__FILE__) + string(" ") + string(__FUNCTION__) + string(" ") + intToStr(__LINE__));
@@ -256,18 +255,37 @@ namespace Shared {
 					ALuint buffer;
 					alSourceUnqueueBuffers(source, 1, &buffer);
 					SoundPlayerOpenAL::checkAlError(string(__FILE__) + string(" ") + string(__FUNCTION__) + string(" ") + intToStr(__LINE__));
+					freeBuffers.push_back(buffer);
+				}
 
-					if (!fillBufferAndQueue(buffer))
+				bool drained = false;
+				while (freeBuffers.empty() == false && decodeBuffer.available() >= STREAMFRAGMENTSIZE) {
+					if (!fillBufferAndQueue(freeBuffers.back()))
 						break;
+					freeBuffers.pop_back();
+					drained = true;
+				}
+				if (drained == true) {
+					StreamDecoder::wakeUp();
 				}
 
-				// we might have to restart the source if we had a buffer underrun
+				// start the source once the decoder delivered, and restart it
+				// if we had a buffer underrun
 				if (!playing()) {
-					if (SystemFlags::getSystemSettingType(SystemFlags::debugSound).enabled) SystemFlags::OutputDebug(SystemFlags::debugSound, "In [%s::%s %d] Restarting audio source because of buffer underrun.\n", __FILE__, __FUNCTION__, __LINE__);
-
-					std::cerr << "Restarting audio source because of buffer underrun.\n";
-					alSourcePlay(source);
+					ALint queued = 0;
+					alGetSourcei(source, AL_BUFFERS_QUEUED, &queued);
 					SoundPlayerOpenAL::checkAlError(string(__FILE__) + string(" ") + string(__FUNCTION__) + string(" ") + intToStr(__LINE__));
+
+					if (queued > 0) {
+						if (started == true) {
+							if (SystemFlags::getSystemSettingType(SystemFlags::debugSound).enabled) SystemFlags::OutputDebug(SystemFlags::debugSound, "In [%s::%s %d] Restarting audio source because of buffer underrun.\n", __FILE__, __FUNCTION__, __LINE__);
+
+							std::cerr << "Restarting audio source because of buffer underrun.\n";
+						}
+						started = true;
+						alSourcePlay(source);
+						SoundPlayerOpenAL::checkAlError(string(__FILE__) + string(" ") + string(__FUNCTION__) + string(" ") + intToStr(__LINE__));
+					}
 				}
 
 				// handle fading
@@ -299,24 +317,12 @@ namespace Shared {
 			}
 
 			bool StreamSoundSource::fillBufferAndQueue(ALuint buffer) {
-				// fill buffer
-				int8* bufferdata = new int8[STREAMFRAGMENTSIZE];
-				uint32 bytesread = 0;
-				do {
-					bytesread += sound->read(bufferdata + bytesread, STREAMFRAGMENTSIZE - bytesread);
-					if (bytesread < STREAMFRAGMENTSIZE) {
-						StrSound* next = sound->getNext();
-						if (next == 0)
-							next = sound;
-						next->restart();
-						next->setVolume(sound->getVolume());
-						sound = next;
-					}
-				} while (bytesread < STREAMFRAGMENTSIZE);
+				// fill buffer from the decoder's read ahead
+				if (decodeBuffer.read(&fragment[0], STREAMFRAGMENTSIZE) < STREAMFRAGMENTSIZE) {
+					return false;
+				}
 
-				alBufferData(buffer, format, bufferdata, STREAMFRAGMENTSIZE,
-					sound->getInfo()->getSamplesPerSecond());
-				delete[] bufferdata;
+				alBufferData(buffer, format, &fragment[0], STREAMFRAGMENTSIZE, samplesPerSecond);
 				SoundPlayerOpenAL::checkAlError("Couldn't refill audio buffer: ");
 
 				alSourceQueueBuffers(source, 1, &buffer);
@@ -335,6 +341,8 @@ namespace Shared {
 				device = 0;
 				context = 0;
 				initOk = false;
+				mutexStaticSources = new Mutex(CODE_AT_LINE);
+				SoundCache::addListener(this);
 
 				if (SystemFlags::getSystemSettingType(SystemFlags::debugSound).enabled) SystemFlags::OutputDebug(SystemFlags::debugSound, "In [%s::%s %d]\n", __FILE__, __FUNCTION__, __LINE__);
 			}
@@ -342,9 +350,13 @@ namespace Shared {
 			SoundPlayerOpenAL::~SoundPlayerOpenAL() {
 				if (SystemFlags::getSystemSettingType(SystemFlags::debugSound).enabled) SystemFlags::OutputDebug(SystemFlags::debugSound, "In [%s::%s %d]\n", __FILE__, __FUNCTION__, __LINE__);
 
+				SoundCache::removeListener(this);
 				end();
 				initOk = false;
 
+				delete mutexStaticSources;
+				mutexStaticSources = NULL;
+
 				if (SystemFlags::getSystemSettingType(SystemFlags::debugSound).enabled) SystemFlags::OutputDebug(SystemFlags::debugSound, "In [%s::%s %d]\n", __FILE__, __FUNCTION__, __LINE__);
 			}
 
@@ -456,7 +468,7 @@ namespace Shared {
 
 				if (SystemFlags::getSystemSettingType(SystemFlags::debugSound).enabled) SystemFlags::OutputDebug(SystemFlags::debugSound, "In [%s::%s %d]\n", __FILE__, __FUNCTION__, __LINE__);
 
-
+				MutexSafeWrapper safeMutex(mutexStaticSources, CODE_AT_LINE);
 				for (StaticSoundSources::iterator i = staticSources.begin();
 					i != staticSources.end(); ++i) {
 					StaticSoundSource *src = (*i);
@@ -470,6 +482,7 @@ namespace Shared {
 					StreamSoundSource *src = (*i);
 					src->stop();
 				}
+				StreamDecoder::shutdown();
 
 				if (SystemFlags::getSystemSettingType(SystemFlags::debugSound).enabled) SystemFlags::OutputDebug(SystemFlags::debugSound, "In [%s::%s %d]\n", __FILE__, __FUNCTION__, __LINE__);
 
@@ -478,6 +491,8 @@ namespace Shared {
 					delete *i;
 				}
 				staticSources.clear();
+				deleteStaticBuffers();
+				safeMutex.ReleaseLock();
 
 				if (SystemFlags::getSystemSettingType(SystemFlags::debugSound).enabled) SystemFlags::OutputDebug(SystemFlags::debugSound, "In [%s::%s %d]\n", __FILE__, __FUNCTION__, __LINE__);
 
@@ -516,7 +531,11 @@ namespace Shared {
 
 				if (initOk == false) return;
 
+				MutexSafeWrapper safeMutex(mutexStaticSources, CODE_AT_LINE);
 				try {
+					ALuint buffer = getStaticBuffer(staticSound);
+					if (buffer == 0) return;
+
 					StaticSoundSource* source = findStaticSoundSource();
 
 					if (source == 0) {
@@ -528,7 +547,7 @@ namespace Shared {
 							source->stop();
 						}
 					}
-					source->play(staticSound);
+					source->play(staticSound, buffer);
 				} catch (std::exception& e) {
 					SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error [%s]\n", __FILE__, __FUNCTION__, __LINE__, e.what());
 					std::cerr << "Couldn't play static sound: [" << e.what() << "]\n";
@@ -566,11 +585,13 @@ namespace Shared {
 			void SoundPlayerOpenAL::stopAllSounds(int64 fadeOff) {
 				if (initOk == false) return;
 
+				MutexSafeWrapper safeMutex(mutexStaticSources, CODE_AT_LINE);
 				for (StaticSoundSources::iterator i = staticSources.begin();
 					i != staticSources.end(); ++i) {
 					StaticSoundSource* source = *i;
 					source->stop();
 				}
+				safeMutex.ReleaseLock();
 				for (StreamSoundSources::iterator i = streamSources.begin();
 					i != streamSources.end(); ++i) {
 					StreamSoundSource* source = *i;
@@ -645,11 +666,12 @@ namespace Shared {
 			StreamSoundSource* SoundPlayerOpenAL::findStreamSoundSource() {
 				if (initOk == false) return NULL;
 
-				// try to find a stopped source
+				// try to find a stopped source, a started one may still be
+				// waiting for its first fragments
 				for (StreamSoundSources::iterator i = streamSources.begin();
 					i != streamSources.end(); ++i) {
 					StreamSoundSource* source = *i;
-					if (!source->playing()) {
+					if (source->sound == 0 && !source->playing()) {
 						return source;
 					}
 				}
@@ -669,6 +691,72 @@ namespace Shared {
 				return source;
 			}
 
+			// Caller holds mutexStaticSources
+			ALuint SoundPlayerOpenAL::getStaticBuffer(StaticSound *staticSound) {
+				const int8 *samples = staticSound->getSamples();
+				if (samples == NULL) {
+					return 0;
+				}
+
+				std::map<const int8 *, ALuint>::iterator iterFind = staticBuffers.find(samples);
+				if (iterFind != staticBuffers.end()) {
+					return iterFind->second;
+				}
+
+				ALenum format = SoundSource::getFormat(staticSound);
+
+				ALuint buffer = 0;
+				alGenBuffers(1, &buffer);
+				checkAlError("Couldn't create audio buffer: ");
+
+				if (SystemFlags::getSystemSettingType(SystemFlags::debugSound).enabled) SystemFlags::OutputDebug(SystemFlags::debugSound, "In [%s::%s Line: %d] filename [%s] format = %d, sound->getInfo()->getSize() = %d, sound->getInfo()->getSamplesPerSecond() = %d\n", __FILE__, __FUNCTION__, __LINE__, staticSound->getFileName().c_str(), format, staticSound->getInfo()->getSize(), staticSound->getInfo()->getSamplesPerSecond());
+
+				alBufferData(buffer, format, samples,
+					static_cast<ALsizei> (staticSound->getInfo()->getSize()),
+					static_cast<ALsizei> (staticSound->getInfo()->getSamplesPerSecond()));
+				int err = alGetError();
+				if (err != AL_NO_ERROR) {
+					alDeleteBuffers(1, &buffer);
+					char szBuf[8096] = "";
+					snprintf(szBuf, 8096, "Couldn't fill audio buffer: [%s]", alGetString(err));
+					throw std::runtime_error(szBuf);
+				}
+
+				staticBuffers[samples] = buffer;
+				return buffer;
+			}
+
+			// Caller holds mutexStaticSources
+			void SoundPlayerOpenAL::deleteStaticBuffers() {
+				for (std::map<const int8 *, ALuint>::iterator iterMap = staticBuffers.begin();
+					iterMap != staticBuffers.end(); ++iterMap) {
+					alDeleteBuffers(1, &iterMap->second);
+				}
+				staticBuffers.clear();
+			}
+
+			void SoundPlayerOpenAL::SoundCache_SamplesFreed(const int8 *samples) {
+				MutexSafeWrapper safeMutex(mutexStaticSources, CODE_AT_LINE);
+				std::map<const int8 *, ALuint>::iterator iterFind = staticBuffers.find(samples);
+				if (iterFind == staticBuffers.end()) {
+					return;
+				}
+
+				ALuint buffer = iterFind->second;
+				staticBuffers.erase(iterFind);
+
+				// AL refuses to delete a buffer still attached to a source
+				for (StaticSoundSources::iterator i = staticSources.begin();
+					i != staticSources.end(); ++i) {
+					StaticSoundSource* source = *i;
+					if (source->buffer == buffer) {
+						source->stop();
+						source->buffer = 0;
+					}
+				}
+				alDeleteBuffers(1, &buffer);
+			}
+
 			void SoundPlayerOpenAL::checkAlcError(string message) {
 				int err = alcGetError(device);
 				if (err != ALC_NO_ERROR) {
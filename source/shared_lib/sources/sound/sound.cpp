@@ -22,6 +22,7 @@
 #include <fstream>
 #include <stdexcept>
 #include "util.h"
+#include "sound_cache.h"
 #include "leak_dumper.h"
 
 using namespace Shared::Util;
@@ -68,7 +69,7 @@ namespace Shared {
 
 		void StaticSound::close() {
 			if (samples != NULL) {
-				delete[] samples;
+				SoundCache::release(fileName);
 				samples = NULL;
 			}
 
@@ -87,19 +88,7 @@ namespace Shared {
 			if (GlobalStaticFlags::getIsNonGraphicalModeEnabled() == true) {
 				return;
 			}
-			string ext = (path.empty() == false ? path.substr(path.find_last_of('.') + 1) : "");
-			soundFileLoader = SoundFileLoaderFactory::getInstance()->newInstance(ext);
-
-			if (soundFileLoader == NULL) {
-				throw game_runtime_error("soundFileLoader == NULL");
-			}
-			soundFileLoader->open(path, &info);
-			samples = new int8[info.getSize()];
-			soundFileLoader->read(samples, info.getSize());
-			soundFileLoader->close();
-
-			delete soundFileLoader;
-			soundFileLoader = NULL;
+			samples = SoundCache::acquire(path, &info);
 		}
 
 		// =====================================================
@@ -0,0 +1,223 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+
+#include "sound_cache.h"
+
+#include <algorithm>
+#include "conversion.h"
+#include "util.h"
+#include "leak_dumper.h"
+
+using namespace Shared::Util;
+using namespace Shared::PlatformCommon;
+
+namespace Shared {
+	namespace Sound {
+
+		// =====================================================
+		//	class SoundCache
+		// =====================================================
+
+		Mutex *SoundCache::mutexCache = new Mutex(CODE_AT_LINE);
+		Mutex *SoundCache::mutexListeners = new Mutex(CODE_AT_LINE);
+		map<string, SoundCache::Entry> SoundCache::entryList;
+		vector<SoundCacheListener *> SoundCache::listenerList;
+		uint64 SoundCache::maxUnusedBytes = 32 * 1024 * 1024;
+		uint64 SoundCache::unusedBytes = 0;
+		uint64 SoundCache::totalBytes = 0;
+		uint64 SoundCache::releaseCount = 0;
+		int64 SoundCache::hitCount = 0;
+		int64 SoundCache::missCount = 0;
+		int64 SoundCache::evictionCount = 0;
+
+		int8 * SoundCache::decode(const string &path, SoundInfo *info) {
+			string ext = (path.empty() == false ? path.substr(path.find_last_of('.') + 1) : "");
+			SoundFileLoader *soundFileLoader = SoundFileLoaderFactory::getInstance()->newInstance(ext);
+
+			if (soundFileLoader == NULL) {
+				throw game_runtime_error("soundFileLoader == NULL");
+			}
+
+			int8 *samples = NULL;
+			try {
+				soundFileLoader->open(path, info);
+				samples = new int8[info->getSize()];
+				soundFileLoader->read(samples, info->getSize());
+				soundFileLoader->close();
+			} catch (...) {
+				delete[] samples;
+				delete soundFileLoader;
+				throw;
+			}
+			delete soundFileLoader;
+			return samples;
+		}
+
+		int8 * SoundCache::acquire(const string &path, SoundInfo *info) {
+			MutexSafeWrapper safeMutex(mutexCache, CODE_AT_LINE);
+			map<string, Entry>::iterator iterFind = entryList.find(path);
+			if (iterFind != entryList.end()) {
+				Entry &entry = iterFind->second;
+				if (entry.refCount == 0) {
+					unusedBytes -= entry.info.getSize();
+				}
+				entry.refCount++;
+				hitCount++;
+				*info = entry.info;
+				return entry.samples;
+			}
+			safeMutex.ReleaseLock();
+
+			// Decode without holding the cache, another thread may load the
+			// same file meanwhile in which case its copy wins
+			SoundInfo decodedInfo;
+			int8 *samples = decode(path, &decodedInfo);
+
+			safeMutex.Lock();
+			iterFind = entryList.find(path);
+			if (iterFind != entryList.end()) {
+				Entry &entry = iterFind->second;
+				if (entry.refCount == 0) {
+					unusedBytes -= entry.info.getSize();
+				}
+				entry.refCount++;
+				hitCount++;
+				*info = entry.info;
+				int8 *sharedSamples = entry.samples;
+				safeMutex.ReleaseLock();
+
+				delete[] samples;
+				return sharedSamples;
+			}
+
+			Entry &entry = entryList[path];
+			entry.samples = samples;
+			entry.info = decodedInfo;
+			entry.refCount = 1;
+			entry.lastReleased = 0;
+			totalBytes += decodedInfo.getSize();
+			missCount++;
+			*info = decodedInfo;
+			return samples;
+		}
+
+		void SoundCache::release(const string &path) {
+			vector<int8 *> freeList;
+
+			MutexSafeWrapper safeMutex(mutexCache, CODE_AT_LINE);
+			map<string, Entry>::iterator iterFind = entryList.find(path);
+			if (iterFind == entryList.end() || iterFind->second.refCount <= 0) {
+				SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] release of unknown sound [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, path.c_str());
+				return;
+			}
+
+			Entry &entry = iterFind->second;
+			entry.refCount--;
+			if (entry.refCount == 0) {
+				entry.lastReleased = ++releaseCount;
+				unusedBytes += entry.info.getSize();
+				trim(maxUnusedBytes, freeList);
+			}
+			safeMutex.ReleaseLock();
+
+			freeSamples(freeList);
+		}
+
+		// Caller holds mutexCache
+		void SoundCache::trim(uint64 maxBytes, vector<int8 *> &freeList) {
+			while (unusedBytes > maxBytes) {
+				map<string, Entry>::iterator oldest = entryList.end();
+				for (map<string, Entry>::iterator iterMap = entryList.begin();
+					iterMap != entryList.end(); ++iterMap) {
+					if (iterMap->second.refCount == 0 &&
+						(oldest == entryList.end() || iterMap->second.lastReleased < oldest->second.lastReleased)) {
+						oldest = iterMap;
+					}
+				}
+				if (oldest == entryList.end()) {
+					break;
+				}
+
+				unusedBytes -= oldest->second.info.getSize();
+				totalBytes -= oldest->second.info.getSize();
+				freeList.push_back(oldest->second.samples);
+				entryList.erase(oldest);
+				evictionCount++;
+			}
+		}
+
+		void SoundCache::freeSamples(const vector<int8 *> &freeList) {
+			if (freeList.empty() == true) {
+				return;
+			}
+
+			MutexSafeWrapper safeMutex(mutexListeners, CODE_AT_LINE);
+			for (unsigned int i = 0; i < freeList.size(); ++i) {
+				for (unsigned int j = 0; j < listenerList.size(); ++j) {
+					listenerList[j]->SoundCache_SamplesFreed(freeList[i]);
+				}
+				delete[] freeList[i];
+			}
+		}
+
+		void SoundCache::setMaxUnusedBytes(uint64 value) {
+			vector<int8 *> freeList;
+
+			MutexSafeWrapper safeMutex(mutexCache, CODE_AT_LINE);
+			maxUnusedBytes = value;
+			trim(maxUnusedBytes, freeList);
+			safeMutex.ReleaseLock();
+
+			freeSamples(freeList);
+		}
+
+		void SoundCache::clearUnused() {
+			vector<int8 *> freeList;
+
+			MutexSafeWrapper safeMutex(mutexCache, CODE_AT_LINE);
+			trim(0, freeList);
+			safeMutex.ReleaseLock();
+
+			freeSamples(freeList);
+		}
+
+		void SoundCache::addListener(SoundCacheListener *listener) {
+			MutexSafeWrapper safeMutex(mutexListeners, CODE_AT_LINE);
+			if (std::find(listenerList.begin(), listenerList.end(), listener) == listenerList.end()) {
+				listenerList.push_back(listener);
+			}
+		}
+
+		void SoundCache::removeListener(SoundCacheListener *listener) {
+			MutexSafeWrapper safeMutex(mutexListeners, CODE_AT_LINE);
+			listenerList.erase(std::remove(listenerList.begin(), listenerList.end(), listener), listenerList.end());
+		}
+
+		string SoundCache::getStats() {
+			MutexSafeWrapper safeMutex(mutexCache, CODE_AT_LINE);
+			char szBuf[8096] = "";
+			snprintf(szBuf, 8096, "sounds: %d KB: %s unused KB: %s hits: %lld misses: %lld evictions: %lld",
+				(int) entryList.size(), formatNumber(totalBytes / 1000).c_str(), formatNumber(unusedBytes / 1000).c_str(),
+				(long long int) hitCount, (long long int) missCount, (long long int) evictionCount);
+			return szBuf;
+		}
+
+	}
+} //end namespace
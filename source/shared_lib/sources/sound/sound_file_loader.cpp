@@ -46,7 +46,7 @@ namespace Shared {
 			int count;
 			fileName = path;
 
-			f.open(path.c_str(), ios_base::in | ios_base::binary);
+			f.open(path);
 
 			if (!f.is_open()) {
 				throw game_runtime_error("Error opening wav file: " + string(path), true);
@@ -209,20 +209,43 @@ namespace Shared {
 		//        Ogg Sound File Loader
 		// =======================================
 
+		// vorbisfile callbacks reading from a VirtualFile, so ogg files
+		// can be streamed out of mounted archives as well as loose files
+		static size_t oggRead(void *ptr, size_t size, size_t nmemb, void *datasource) {
+			if (size == 0) {
+				return 0;
+			}
+			VirtualFile *file = static_cast<VirtualFile *>(datasource);
+			return file->read(ptr, size * nmemb) / size;
+		}
+
+		static int oggSeek(void *datasource, ogg_int64_t offset, int whence) {
+			VirtualFile *file = static_cast<VirtualFile *>(datasource);
+			ogg_int64_t position = offset;
+			if (whence == SEEK_CUR) {
+				position += (ogg_int64_t) file->tell();
+			} else if (whence == SEEK_END) {
+				position += (ogg_int64_t) file->getSize();
+			}
+			if (position < 0 || file->seek((uint64) position) == false) {
+				return -1;
+			}
+			return 0;
+		}
+
+		static long oggTell(void *datasource) {
+			VirtualFile *file = static_cast<VirtualFile *>(datasource);
+			return (long) file->tell();
+		}
+
 		OggSoundFileLoader::OggSoundFileLoader() {
 			vf = NULL;
-			f = NULL;
 		}
 
 		void OggSoundFileLoader::open(const string &path, SoundInfo *soundInfo) {
 			fileName = path;
 
-#ifdef WIN32
-			f = _wfopen(utf8_decode(path).c_str(), L"rb");
-#else
-			f = fopen(path.c_str(), "rb");
-#endif
-			if (f == NULL) {
+			if (f.open(path) == false) {
 				throw game_runtime_error("Can't open ogg file: " + path, true);
 			}
 
@@ -231,7 +254,17 @@ namespace Shared {
 				throw game_runtime_error("Can't create ogg object for file: " + path, true);
 			}
 
-			ov_open(f, vf, NULL, 0);
+			ov_callbacks callbacks;
+			callbacks.read_func = oggRead;
+			callbacks.seek_func = oggSeek;
+			callbacks.close_func = NULL;
+			callbacks.tell_func = oggTell;
+			if (ov_open_callbacks(&f, vf, NULL, 0, callbacks) != 0) {
+				delete vf;
+				vf = NULL;
+				f.close();
+				throw game_runtime_error("Can't read ogg stream for file: " + path, true);
+			}
 
 			vorbis_info *vi = ov_info(vf, -1);
 			if (vi == NULL) {
@@ -272,7 +305,7 @@ namespace Shared {
 				delete vf;
 				vf = 0;
 			}
-			//fclose(f);
+			f.close();
 		}
 
 		void OggSoundFileLoader::restart() {
@@ -0,0 +1,157 @@
+// This file is part of ZetaGlest <https://github.com/ZetaGlest>
+//
+// Copyright (C) 2018  The ZetaGlest team
+//
+// ZetaGlest is a fork of MegaGlest <https://megaglest.org>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>
+
+
+#include "sound_stream_decoder.h"
+
+#include <algorithm>
+#include "platform_util.h"
+#include "util.h"
+#include "leak_dumper.h"
+
+using namespace Shared::Util;
+using namespace Shared::Platform;
+using namespace Shared::PlatformCommon;
+
+namespace Shared {
+	namespace Sound {
+
+		// =====================================================
+		//	class StreamDecodeBuffer
+		// =====================================================
+
+		StreamDecodeBuffer::StreamDecodeBuffer(size_t capacity, size_t chunkSize) :
+			chunk(chunkSize), ring(capacity), currentSound(NULL) {
+			sound = NULL;
+		}
+
+		void StreamDecodeBuffer::reset(StrSound *sound) {
+			this->sound = sound;
+			currentSound.store(sound);
+			ring.discard();
+		}
+
+		bool StreamDecodeBuffer::decodeChunk() {
+			if (sound == NULL || ring.capacity() - ring.size() < chunk.size()) {
+				return false;
+			}
+
+			uint32 bytesRead = sound->read(&chunk[0], (uint32) chunk.size());
+			if (bytesRead < chunk.size()) {
+				// End of the file, continue with the next sound of the chain
+				StrSound *next = sound->getNext();
+				if (next == NULL) {
+					next = sound;
+				}
+				next->restart();
+				sound = next;
+				currentSound.store(next);
+			}
+			if (bytesRead == 0) {
+				return false;
+			}
+			ring.write(&chunk[0], bytesRead);
+			return true;
+		}
+
+		// =====================================================
+		//	class StreamDecoder
+		// =====================================================
+
+		Mutex *StreamDecoder::mutexBuffers = new Mutex(CODE_AT_LINE);
+		Semaphore *StreamDecoder::semWork = new Semaphore();
+		vector<StreamDecodeBuffer *> StreamDecoder::bufferList;
+		StreamDecodeThread *StreamDecoder::thread = NULL;
+
+		void StreamDecoder::add(StreamDecodeBuffer *buffer) {
+			MutexSafeWrapper safeMutex(mutexBuffers, CODE_AT_LINE);
+			if (std::find(bufferList.begin(), bufferList.end(), buffer) == bufferList.end()) {
+				bufferList.push_back(buffer);
+			}
+			if (thread == NULL) {
+				thread = new StreamDecodeThread();
+				thread->start();
+			}
+			safeMutex.ReleaseLock();
+
+			semWork->signal();
+		}
+
+		void StreamDecoder::remove(StreamDecodeBuffer *buffer) {
+			MutexSafeWrapper safeMutex(mutexBuffers, CODE_AT_LINE);
+			bufferList.erase(std::remove(bufferList.begin(), bufferList.end(), buffer), bufferList.end());
+		}
+
+		void StreamDecoder::shutdown() {
+			MutexSafeWrapper safeMutex(mutexBuffers, CODE_AT_LINE);
+			StreamDecodeThread *stopThread = thread;
+			thread = NULL;
+			safeMutex.ReleaseLock();
+
+			if (stopThread != NULL) {
+				stopThread->signalQuit();
+				semWork->signal();
+				if (stopThread->shutdownAndWait() == true) {
+					delete stopThread;
+				}
+			}
+		}
+
+		bool StreamDecoder::decodeChunks() {
+			bool decoded = false;
+
+			MutexSafeWrapper safeMutex(mutexBuffers, CODE_AT_LINE);
+			for (unsigned int i = 0; i < bufferList.size(); ++i) {
+				StreamDecodeBuffer *buffer = bufferList[i];
+				try {
+					if (buffer->decodeChunk() == true) {
+						decoded = true;
+					}
+				} catch (const exception &ex) {
+					SystemFlags::OutputDebug(SystemFlags::debugError, "In [%s::%s Line: %d] Error decoding sound stream: %s\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, ex.what());
+					// Stop feeding it, the player runs dry and stops the source
+					buffer->sound = NULL;
+				}
+			}
+			return decoded;
+		}
+
+		void StreamDecoder::wakeUp() {
+			semWork->signal();
+		}
+
+		// =====================================================
+		//	class StreamDecodeThread
+		// =====================================================
+
+		StreamDecodeThread::StreamDecodeThread() : BaseThread() {
+			setUniqueID("StreamDecodeThread");
+		}
+
+		void StreamDecodeThread::execute() {
+			RunningStatusSafeWrapper runningStatus(this);
+			for (; getQuitStatus() == false;) {
+				if (StreamDecoder::decodeChunks() == false) {
+					StreamDecoder::semWork->waitTillSignalled(50);
+				}
+			}
+		}
+
+	}
+} //end namespace
@@ -33,6 +33,7 @@
 #include "platform_common.h"
 #include "conversion.h"
 #include "platform_util.h"
+#include "virtual_file_system.h"
 #include "leak_dumper.h"
 
 using namespace std;
@@ -291,36 +292,26 @@ namespace Shared {
 				fclose(file);
 			*/
 
-#if defined(WIN32) && !defined(__MINGW32__)
-			wstring wstr = utf8_decode(path);
-			FILE *fp = _wfopen(wstr.c_str(), L"rb");
-			ifstream ifs(fp);
-#else
-			ifstream ifs(path.c_str());
-#endif
-
-			if (ifs) {
+			// Archived files sum the same as their extracted copies
+			VirtualFile file;
+			if (file.open(path) == true) {
 				fileExists = true;
 				addString(lastFile(path));
 
 				bool isXMLFile = (EndsWith(path, ".xml") == true);
 
-				// Determine the file length
-				ifs.seekg(0, ios::end);
-				std::streamoff size = ifs.tellg();
-				ifs.seekg(0, ios::beg);
-
-				unsigned int bufSize = (unsigned int) size / sizeof(char);
-				// Create a vector to store the data
-				std::vector<char> buf(bufSize);
-				// Load the data
-				ifs.read((char*) &buf[0], buf.size());
+				// Mapped or pointing into the archive, no copy
+				unsigned int bufSize = (unsigned int) file.getSize();
+				const char *buf = file.getData();
+				if (buf == NULL) {
+					bufSize = 0;
+				}
 
-				if (SystemFlags::getSystemSettingType(SystemFlags::debugSystem).enabled) SystemFlags::OutputDebug(SystemFlags::debugSystem, "In [%s::%s Line: %d] buf.size() = %d, path [%s], isXMLFile = %d\n", __FILE__, __FUNCTION__, __LINE__, buf.size(), path.c_str(), isXMLFile);
+				if (SystemFlags::getSystemSettingType(SystemFlags::debugSystem).enabled) SystemFlags::OutputDebug(SystemFlags::debugSystem, "In [%s::%s Line: %d] bufSize = %d, path [%s], isXMLFile = %d\n", __FILE__, __FUNCTION__, __LINE__, bufSize, path.c_str(), isXMLFile);
 
 				if (isXMLFile == true) {
 					bool inCommentTag = false;
-					for (std::size_t i = 0; i < buf.size(); ++i) {
+					for (std::size_t i = 0; i < bufSize; ++i) {
 						// Ignore Spaces in XML files as they are
 						// ONLY for formatting
 						//if(isXMLFile == true) {
@@ -349,21 +340,15 @@ namespace Shared {
 						//}
 						uint32 cipher = addByte(buf[i]);
 
-						if (SystemFlags::getSystemSettingType(SystemFlags::debugSystem).enabled) SystemFlags::OutputDebug(SystemFlags::debugSystem, "In [%s::%s Line: %d] %d / %d, cipher = %u\n", __FILE__, __FUNCTION__, __LINE__, i, buf.size(), cipher);
+						if (SystemFlags::getSystemSettingType(SystemFlags::debugSystem).enabled) SystemFlags::OutputDebug(SystemFlags::debugSystem, "In [%s::%s Line: %d] %d / %d, cipher = %u\n", __FILE__, __FUNCTION__, __LINE__, i, bufSize, cipher);
 					}
 				} else {
-					uint32 cipher = addBytes(&buf[0], buf.size());
-					if (SystemFlags::getSystemSettingType(SystemFlags::debugSystem).enabled) SystemFlags::OutputDebug(SystemFlags::debugSystem, "In [%s::%s Line: %d] %d, cipher = %u\n", __FILE__, __FUNCTION__, __LINE__, buf.size(), cipher);
+					uint32 cipher = addBytes(buf, bufSize);
+					if (SystemFlags::getSystemSettingType(SystemFlags::debugSystem).enabled) SystemFlags::OutputDebug(SystemFlags::debugSystem, "In [%s::%s Line: %d] %d, cipher = %u\n", __FILE__, __FUNCTION__, __LINE__, bufSize, cipher);
 				}
 
-				// Close the file
-				ifs.close();
+				file.close();
 			}
-#if defined(WIN32) && !defined(__MINGW32__)
-			if (fp) {
-				fclose(fp);
-			}
-#endif
 
 			return fileExists;
 		}
@@ -432,6 +417,10 @@ namespace Shared {
 		void Checksum::clearFileCache() {
 			MutexSafeWrapper safeMutexSocketDestructorFlag(&Checksum::fileListCacheSynchAccessor, string(__FILE__) + "_" + intToStr(__LINE__));
 			Checksum::fileListCache.clear();
+			safeMutexSocketDestructorFlag.ReleaseLock();
+
+			// Called whenever content on disk changed, so is the file index
+			VirtualFileSystem::refresh();
 		}
 
 	}
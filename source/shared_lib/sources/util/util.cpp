@@ -106,6 +106,20 @@ namespace Shared {
 			return realsize;
 		}
 
+		// Keeps the ETag of the last header block, a redirect starts a new block
+		static size_t httpHeaderETagCallback(char *buffer, size_t size, size_t nitems, void *data) {
+			size_t realsize = size * nitems;
+			string *etag = (string *) data;
+			string header(buffer, realsize);
+
+			if (StartsWith(header, "HTTP/") == true) {
+				etag->clear();
+			} else if (header.size() > 5 && toLower(header.substr(0, 5)) == "etag:") {
+				*etag = trim(trim_right(header.substr(5), "\r\n"));
+			}
+			return realsize;
+		}
+
 		std::string SystemFlags::escapeURL(std::string URL, CURL *handle) {
 			string result = URL;
 
@@ -189,6 +203,48 @@ namespace Shared {
 			return serverResponse;
 		}
 
+		std::string SystemFlags::getHTTPIfChanged(std::string URL, std::string &etag, bool &notModified,
+			CURL *handle, int timeOut, CURLcode *savedResult) {
+			if (handle == NULL) {
+				handle = SystemFlags::curl_handle;
+			}
+
+			struct curl_slist *headerList = NULL;
+			if (etag != "") {
+				string ifNoneMatch = "If-None-Match: " + etag;
+				headerList = curl_slist_append(headerList, ifNoneMatch.c_str());
+			}
+			string receivedETag = "";
+			curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headerList);
+			curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, httpHeaderETagCallback);
+			curl_easy_setopt(handle, CURLOPT_HEADERDATA, (void *) &receivedETag);
+
+			CURLcode result = CURLE_OK;
+			std::string serverResponse = SystemFlags::getHTTP(URL, handle, timeOut, &result);
+
+			long responseCode = 0;
+			if (result == CURLE_OK) {
+				curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &responseCode);
+			}
+
+			// The handle is reused for plain requests afterwards
+			curl_easy_setopt(handle, CURLOPT_HTTPHEADER, NULL);
+			curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, NULL);
+			curl_easy_setopt(handle, CURLOPT_HEADERDATA, NULL);
+			curl_slist_free_all(headerList);
+
+			notModified = (result == CURLE_OK && responseCode == 304);
+			if (result == CURLE_OK && responseCode == 200) {
+				etag = receivedETag;
+			}
+			if (SystemFlags::getSystemSettingType(SystemFlags::debugNetwork).enabled) SystemFlags::OutputDebug(SystemFlags::debugNetwork, "In [%s::%s Line %d] responseCode = %ld notModified = %d etag [%s]\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, responseCode, notModified, etag.c_str());
+
+			if (savedResult != NULL) {
+				*savedResult = result;
+			}
+			return serverResponse;
+		}
+
 		CURL *SystemFlags::initHTTP() {
 			if (SystemFlags::curl_global_init_called == false) {
 				SystemFlags::curl_global_init_called = true;
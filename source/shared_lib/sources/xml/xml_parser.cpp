@@ -21,6 +21,7 @@
 #include "xml_parser.h"
 
 #include <fstream>
+#include <cstring>
 #include <stdexcept>
 #include <vector>
 #include <algorithm>
@@ -40,6 +41,8 @@
 #include "platform_common.h"
 #include "platform_util.h"
 #include "cache_manager.h"
+#include "virtual_file_system.h"
+#include "compression_utils.h"
 
 #include "rapidxml/rapidxml_print.hpp"
 #include "leak_dumper.h"
@@ -339,6 +342,42 @@ namespace Shared {
 			cleanup();
 		}
 
+		// Removes every <!-- --> comment and the character following it in
+		// place, the same result replaceAllBetweenTokens gives without
+		// copying the document into a string and shifting the rest of it
+		// for every comment. Returns the new size
+		static size_t stripXmlComments(char *data, size_t size) {
+			static const char startToken[] = "<!--";
+			static const char endToken[] = "-->";
+			const size_t startTokenSize = sizeof(startToken) - 1;
+			const size_t endTokenSize = sizeof(endToken) - 1;
+
+			size_t readPos = 0;
+			size_t writePos = 0;
+			for (;;) {
+				char *found = std::search(data + readPos, data + size, startToken, startToken + startTokenSize);
+				if (found == data + size) {
+					break;
+				}
+				size_t foundHere = found - data;
+				char *foundEnd = std::search(data + foundHere + 1, data + size, endToken, endToken + endTokenSize);
+				if (foundEnd == data + size) {
+					break;
+				}
+				size_t removeEnd = min((size_t) (foundEnd - data) + endTokenSize + 1, size);
+
+				if (writePos != readPos) {
+					memmove(data + writePos, data + readPos, foundHere - readPos);
+				}
+				writePos += foundHere - readPos;
+				readPos = removeEnd;
+			}
+			if (writePos != readPos) {
+				memmove(data + writePos, data + readPos, size - readPos);
+			}
+			return writePos + (size - readPos);
+		}
+
 		XmlNode *XmlIoRapid::load(const string &path, const std::map<string, string> &mapTagReplacementValues,
 			bool noValidation, bool skipStackTrace, bool skipUpdatePathClimbingParts) {
 			bool showPerfStats = SystemFlags::VERBOSE_MODE_ENABLED;
@@ -354,34 +393,14 @@ namespace Shared {
 					throw game_runtime_error("Can not open file: [" + path + "] as it is a folder!", true);
 				}
 
-#if defined(WIN32) && !defined(__MINGW32__)
-				FILE *fp = _wfopen(utf8_decode(path).c_str(), L"rb");
-				ifstream xmlFile(fp);
-#else
-				ifstream xmlFile(path.c_str(), ios::binary);
-#endif
-				if (xmlFile.is_open() == false) {
+				VirtualFile xmlFile;
+				if (xmlFile.open(path) == false) {
 					throw game_runtime_error("Can not open file: [" + path + "]", true);
 				}
 
 				if (showPerfStats) printf("In [%s::%s Line: %d] took msecs: " I64_SPECIFIER "\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, chrono.getMillis());
 
-				xmlFile.unsetf(ios::skipws);
-
-				// Determine stream size
-				int64 file_size = -1;
-				if ((double) xmlFile.tellg() != -1) {
-					streampos size1 = xmlFile.tellg();
-					xmlFile.seekg(0, ios::end);
-					if ((double) xmlFile.tellg() != -1) {
-						streampos size2 = xmlFile.tellg();
-						xmlFile.seekg(0);
-						file_size = size2 - size1;
-					}
-				}
-
-				if (showPerfStats) printf("In [%s::%s Line: %d] took msecs: " I64_SPECIFIER "\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, chrono.getMillis());
-
+				int64 file_size = (int64) xmlFile.getSize();
 				if (file_size <= 0) {
 					throw game_runtime_error("Invalid file size for file: [" + path + "] size = " + intToStr(file_size));
 				}
@@ -390,14 +409,17 @@ namespace Shared {
 				// Load data and add terminating 0
 				vector<char> buffer;
 				buffer.resize((unsigned int) file_size + 100);
-				xmlFile.read(&buffer.front(), static_cast<streamsize>(file_size));
+				if (xmlFile.read(&buffer.front(), (size_t) file_size) != (size_t) file_size) {
+					throw game_runtime_error("Error reading file: [" + path + "]", true);
+				}
 				buffer[(unsigned int) file_size] = 0;
 
 				if (showPerfStats) printf("In [%s::%s Line: %d] took msecs: " I64_SPECIFIER "\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, chrono.getMillis());
 
 				// This is required because rapidxml seems to choke when we load lua
 				// scenarios that have lua + xml style comments
-				replaceAllBetweenTokens(buffer, "<!--", "-->", "", true);
+				size_t dataSize = stripXmlComments(&buffer.front(), (size_t) file_size);
+				buffer[dataSize] = 0;
 
 				if (showPerfStats) printf("In [%s::%s Line: %d] took msecs: " I64_SPECIFIER "\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, chrono.getMillis());
 
@@ -409,12 +431,6 @@ namespace Shared {
 				rootNode = new XmlNode(doc.first_node(), mapTagReplacementValues, skipUpdatePathClimbingParts);
 
 				if (showPerfStats) printf("In [%s::%s Line: %d] took msecs: " I64_SPECIFIER "\n", extractFileFromDirectoryPath(__FILE__).c_str(), __FUNCTION__, __LINE__, chrono.getMillis());
-
-#if defined(WIN32) && !defined(__MINGW32__)
-				if (fp) {
-					fclose(fp);
-				}
-#endif
 			} catch (parse_error& ex) {
 				//		char szBuf[8096]="";
 				//		snprintf(szBuf,8096,"%s",ex.where<char>());
@@ -591,6 +607,624 @@ namespace Shared {
 			}
 		}
 
+		// Binary layout: magic, version, a table of all distinct strings and
+		// then the nodes depth first, each as name and text string indexes,
+		// the attribute name / value index pairs and the child count. All
+		// numbers are little endian base 128 varints.
+		static const char xmlBinaryMagic[4] = { 'Z', 'G', 'X', 'B' };
+		static const char xmlBinaryVersion = 1;
+		static const int xmlBinaryMaxDepth = 512;
+
+		static void writeXmlBinaryVarint(std::vector<char> &buffer, uint32 value) {
+			while (value >= 0x80) {
+				buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+				value >>= 7;
+			}
+			buffer.push_back(static_cast<char>(value));
+		}
+
+		static uint32 readXmlBinaryVarint(const char *data, size_t dataSize, size_t &offset) {
+			uint32 value = 0;
+			for (int shift = 0; shift < 35; shift += 7) {
+				if (offset >= dataSize) {
+					throw game_runtime_error("Error reading binary xml, truncated data");
+				}
+				unsigned char byte = static_cast<unsigned char>(data[offset++]);
+				value |= static_cast<uint32>(byte & 0x7F) << shift;
+				if ((byte & 0x80) == 0) {
+					return value;
+				}
+			}
+			throw game_runtime_error("Error reading binary xml, invalid number");
+		}
+
+		static uint32 getXmlBinaryStringIndex(const string &value, std::map<string, uint32> &stringIndexList, vector<const string *> &stringList) {
+			std::map<string, uint32>::iterator iterFind = stringIndexList.find(value);
+			if (iterFind != stringIndexList.end()) {
+				return iterFind->second;
+			}
+			uint32 index = (uint32) stringList.size();
+			std::pair<std::map<string, uint32>::iterator, bool> inserted = stringIndexList.insert(std::make_pair(value, index));
+			stringList.push_back(&inserted.first->first);
+			return index;
+		}
+
+		static void writeXmlBinaryNode(const XmlNode *node, std::vector<char> &nodeBuffer, std::map<string, uint32> &stringIndexList, vector<const string *> &stringList) {
+			writeXmlBinaryVarint(nodeBuffer, getXmlBinaryStringIndex(node->getName(), stringIndexList, stringList));
+			writeXmlBinaryVarint(nodeBuffer, getXmlBinaryStringIndex(node->getText(), stringIndexList, stringList));
+
+			writeXmlBinaryVarint(nodeBuffer, (uint32) node->getAttributeCount());
+			for (unsigned int i = 0; i < node->getAttributeCount(); ++i) {
+				const XmlAttribute *attribute = node->getAttribute(i);
+				writeXmlBinaryVarint(nodeBuffer, getXmlBinaryStringIndex(attribute->getName(), stringIndexList, stringList));
+				writeXmlBinaryVarint(nodeBuffer, getXmlBinaryStringIndex(attribute->getValue(), stringIndexList, stringList));
+			}
+
+			writeXmlBinaryVarint(nodeBuffer, (uint32) node->getChildCount());
+			for (unsigned int i = 0; i < node->getChildCount(); ++i) {
+				writeXmlBinaryNode(node->getChild(i), nodeBuffer, stringIndexList, stringList);
+			}
+		}
+
+		static const string &readXmlBinaryString(const char *data, size_t dataSize, size_t &offset, const vector<string> &stringList) {
+			uint32 index = readXmlBinaryVarint(data, dataSize, offset);
+			if (index >= stringList.size()) {
+				throw game_runtime_error("Error reading binary xml, invalid string index: " + uIntToStr(index));
+			}
+			return stringList[index];
+		}
+
+		static void writeXmlBinaryRapidNode(xml_node<> *node, std::vector<char> &nodeBuffer, std::map<string, uint32> &stringIndexList, vector<const string *> &stringList) {
+			uint32 childCount = 0;
+			for (xml_node<> *child = node->first_node(); child != NULL; child = child->next_sibling()) {
+				if (child->type() == node_element) {
+					childCount++;
+				}
+			}
+			uint32 attributeCount = 0;
+			for (xml_attribute<> *attribute = node->first_attribute(); attribute != NULL; attribute = attribute->next_attribute()) {
+				attributeCount++;
+			}
+
+			// Same rules as the XmlNode constructor, only leaf elements keep their text
+			string text = (childCount == 0 ? node->value() : "");
+			writeXmlBinaryVarint(nodeBuffer, getXmlBinaryStringIndex(node->name(), stringIndexList, stringList));
+			writeXmlBinaryVarint(nodeBuffer, getXmlBinaryStringIndex(text, stringIndexList, stringList));
+
+			writeXmlBinaryVarint(nodeBuffer, attributeCount);
+			for (xml_attribute<> *attribute = node->first_attribute(); attribute != NULL; attribute = attribute->next_attribute()) {
+				writeXmlBinaryVarint(nodeBuffer, getXmlBinaryStringIndex(attribute->name(), stringIndexList, stringList));
+				writeXmlBinaryVarint(nodeBuffer, getXmlBinaryStringIndex(attribute->value(), stringIndexList, stringList));
+			}
+
+			writeXmlBinaryVarint(nodeBuffer, childCount);
+			for (xml_node<> *child = node->first_node(); child != NULL; child = child->next_sibling()) {
+				if (child->type() == node_element) {
+					writeXmlBinaryRapidNode(child, nodeBuffer, stringIndexList, stringList);
+				}
+			}
+		}
+
+		static void writeXmlBinary(std::vector<char> &buffer, const vector<const string *> &stringList, const std::vector<char> &nodeBuffer) {
+			buffer.insert(buffer.end(), xmlBinaryMagic, xmlBinaryMagic + sizeof(xmlBinaryMagic));
+			buffer.push_back(xmlBinaryVersion);
+			writeXmlBinaryVarint(buffer, (uint32) stringList.size());
+			for (unsigned int i = 0; i < stringList.size(); ++i) {
+				const string &value = *stringList[i];
+				writeXmlBinaryVarint(buffer, (uint32) value.size());
+				buffer.insert(buffer.end(), value.begin(), value.end());
+			}
+			buffer.insert(buffer.end(), nodeBuffer.begin(), nodeBuffer.end());
+		}
+
+		static void readXmlBinaryNodeContent(XmlNode *node, const char *data, size_t dataSize, size_t &offset,
+			const vector<string> &stringList, const std::map<string, string> &mapTagReplacementValues,
+			const std::map<string, string> *mapTextTagReplacementValues, bool skipUpdatePathClimbingParts, int depth) {
+			if (depth > xmlBinaryMaxDepth) {
+				throw game_runtime_error("Error reading binary xml, nodes nested too deep");
+			}
+
+			uint32 attributeCount = readXmlBinaryVarint(data, dataSize, offset);
+			for (uint32 i = 0; i < attributeCount; ++i) {
+				const string &name = readXmlBinaryString(data, dataSize, offset, stringList);
+				const string &value = readXmlBinaryString(data, dataSize, offset, stringList);
+				node->addAttribute(name, value, mapTagReplacementValues);
+			}
+
+			uint32 childCount = readXmlBinaryVarint(data, dataSize, offset);
+			for (uint32 i = 0; i < childCount; ++i) {
+				const string &name = readXmlBinaryString(data, dataSize, offset, stringList);
+				const string &text = readXmlBinaryString(data, dataSize, offset, stringList);
+				XmlNode *child = NULL;
+				if (mapTextTagReplacementValues != NULL && text.empty() == false) {
+					string value = text;
+					Properties::applyTagsToValue(value, mapTextTagReplacementValues, skipUpdatePathClimbingParts);
+					child = node->addChild(name, value);
+				} else {
+					child = node->addChild(name, text);
+				}
+				readXmlBinaryNodeContent(child, data, dataSize, offset, stringList, mapTagReplacementValues,
+					mapTextTagReplacementValues, skipUpdatePathClimbingParts, depth + 1);
+			}
+		}
+
+		void XmlTree::saveToBinary(std::vector<char> &buffer) const {
+			buffer.clear();
+			if (rootNode == NULL) {
+				throw game_runtime_error("Cannot save an empty xml tree");
+			}
+
+			std::map<string, uint32> stringIndexList;
+			vector<const string *> stringList;
+			std::vector<char> nodeBuffer;
+			writeXmlBinaryNode(rootNode, nodeBuffer, stringIndexList, stringList);
+			writeXmlBinary(buffer, stringList, nodeBuffer);
+		}
+
+		void XmlTree::parseFileToBinary(const string &path, std::vector<char> &buffer) {
+			buffer.clear();
+			try {
+				if (folderExists(path) == true) {
+					throw game_runtime_error("Can not open file: [" + path + "] as it is a folder!", true);
+				}
+
+				VirtualFile xmlFile;
+				if (xmlFile.open(path) == false) {
+					throw game_runtime_error("Can not open file: [" + path + "]", true);
+				}
+
+				int64 file_size = (int64) xmlFile.getSize();
+				if (file_size <= 0) {
+					throw game_runtime_error("Invalid file size for file: [" + path + "] size = " + intToStr(file_size));
+				}
+
+				vector<char> fileBuffer;
+				fileBuffer.resize((unsigned int) file_size + 100);
+				if (xmlFile.read(&fileBuffer.front(), (size_t) file_size) != (size_t) file_size) {
+					throw game_runtime_error("Error reading file: [" + path + "]", true);
+				}
+				fileBuffer[(unsigned int) file_size] = 0;
+
+				// Same as XmlIoRapid::load, rapidxml chokes on lua style comments
+				size_t dataSize = stripXmlComments(&fileBuffer.front(), (size_t) file_size);
+				fileBuffer[dataSize] = 0;
+
+				xml_document<> doc;
+				doc.parse<parse_no_data_nodes | parse_validate_closing_tags>(&fileBuffer.front());
+				if (doc.first_node() == NULL) {
+					throw game_runtime_error("XML structure seems to be corrupt!", true);
+				}
+
+				std::map<string, uint32> stringIndexList;
+				vector<const string *> stringList;
+				std::vector<char> nodeBuffer;
+				writeXmlBinaryRapidNode(doc.first_node(), nodeBuffer, stringIndexList, stringList);
+				writeXmlBinary(buffer, stringList, nodeBuffer);
+			} catch (parse_error& ex) {
+				throw game_runtime_error("Error loading XML: " + path + "\nMessage: " + ex.what(), true);
+			} catch (game_runtime_error& ex) {
+				throw game_runtime_error("Error loading XML: " + path + "\nMessage: " + ex.what(), !ex.wantStackTrace());
+			}
+		}
+
+		void XmlTree::loadFromBinary(const char *data, size_t dataSize, const std::map<string, string> &mapTagReplacementValues, bool applyTagsToText) {
+			clearRootNode();
+
+			if (data == NULL || dataSize < sizeof(xmlBinaryMagic) + 1 ||
+				memcmp(data, xmlBinaryMagic, sizeof(xmlBinaryMagic)) != 0) {
+				throw game_runtime_error("Error reading binary xml, bad header");
+			}
+			size_t offset = sizeof(xmlBinaryMagic);
+			if (data[offset++] != xmlBinaryVersion) {
+				throw game_runtime_error("Error reading binary xml, unsupported version: " + intToStr(data[offset - 1]));
+			}
+
+			uint32 stringCount = readXmlBinaryVarint(data, dataSize, offset);
+			if (stringCount > dataSize) {
+				throw game_runtime_error("Error reading binary xml, invalid string count: " + uIntToStr(stringCount));
+			}
+			vector<string> stringList(stringCount);
+			for (uint32 i = 0; i < stringCount; ++i) {
+				uint32 length = readXmlBinaryVarint(data, dataSize, offset);
+				if (length > dataSize - offset) {
+					throw game_runtime_error("Error reading binary xml, truncated string");
+				}
+				stringList[i].assign(data + offset, length);
+				offset += length;
+			}
+
+			const string &name = readXmlBinaryString(data, dataSize, offset, stringList);
+			const string &text = readXmlBinaryString(data, dataSize, offset, stringList);
+			this->rootNode = new XmlNode(name);
+			this->rootNode->text = text;
+			const std::map<string, string> *mapTextTagReplacementValues = (applyTagsToText == true ? &mapTagReplacementValues : NULL);
+			if (mapTextTagReplacementValues != NULL && text.empty() == false) {
+				Properties::applyTagsToValue(this->rootNode->text, mapTextTagReplacementValues, skipUpdatePathClimbingParts);
+			}
+			try {
+				readXmlBinaryNodeContent(this->rootNode, data, dataSize, offset, stringList, mapTagReplacementValues,
+					mapTextTagReplacementValues, skipUpdatePathClimbingParts, 0);
+			} catch (...) {
+				delete this->rootNode;
+				this->rootNode = NULL;
+				throw;
+			}
+		}
+
+		// Save game file layout: magic, version and then a run of chunks,
+		// each with a one byte type, its raw and stored sizes as little
+		// endian uint32 and the (optionally zlib compressed) payload. The
+		// payload stream is the node layout of the in memory binary form,
+		// except that strings are defined where first used: index 0 is
+		// followed by a new string, any other value refers to string
+		// index - 1. An end chunk closes the file so truncated saves are
+		// detected. Both sides only ever hold one chunk of encoded data.
+		static const char xmlChunkedMagic[4] = { 'Z', 'G', 'S', 'V' };
+		static const char xmlChunkedVersion = 1;
+		static const uint32 xmlChunkedChunkSize = 1024 * 1024;
+		static const unsigned char xmlChunkedTypeRaw = 0;
+		static const unsigned char xmlChunkedTypeCompressed = 1;
+		static const unsigned char xmlChunkedTypeEnd = 0xFF;
+
+		static void writeXmlChunkedUInt32(char *buffer, uint32 value) {
+			for (int i = 0; i < 4; ++i) {
+				buffer[i] = static_cast<char>((value >> (i * 8)) & 0xFF);
+			}
+		}
+
+		static uint32 readXmlChunkedUInt32(const char *buffer) {
+			uint32 value = 0;
+			for (int i = 0; i < 4; ++i) {
+				value |= static_cast<uint32>(static_cast<unsigned char>(buffer[i])) << (i * 8);
+			}
+			return value;
+		}
+
+		class XmlChunkedFileWriter {
+		private:
+			ostream &out;
+			int compressionLevel;
+			std::vector<char> chunk;
+			std::map<string, uint32> stringIndexList;
+
+			void writeChunk(unsigned char type, const char *data, uint32 rawSize, uint32 storedSize) {
+				char header[9];
+				header[0] = static_cast<char>(type);
+				writeXmlChunkedUInt32(&header[1], rawSize);
+				writeXmlChunkedUInt32(&header[5], storedSize);
+				out.write(header, sizeof(header));
+				if (storedSize > 0) {
+					out.write(data, storedSize);
+				}
+				if (out.fail()) {
+					throw game_runtime_error("Error writing save game file");
+				}
+			}
+
+		public:
+			XmlChunkedFileWriter(ostream &out, int compressionLevel) : out(out) {
+				this->compressionLevel = compressionLevel;
+				chunk.reserve(xmlChunkedChunkSize + 1024);
+
+				out.write(xmlChunkedMagic, sizeof(xmlChunkedMagic));
+				out.put(xmlChunkedVersion);
+			}
+
+			void flushChunk() {
+				if (chunk.empty() == true) {
+					return;
+				}
+				uint32 rawSize = (uint32) chunk.size();
+				if (compressionLevel > 0) {
+					std::pair<unsigned char *, unsigned long> compressed =
+						Shared::CompressionUtil::compressMemoryToMemory(
+							reinterpret_cast<unsigned char *>(&chunk[0]), rawSize, compressionLevel);
+					if (compressed.second < rawSize) {
+						writeChunk(xmlChunkedTypeCompressed, reinterpret_cast<const char *>(compressed.first), rawSize, (uint32) compressed.second);
+					} else {
+						writeChunk(xmlChunkedTypeRaw, &chunk[0], rawSize, rawSize);
+					}
+					delete[] compressed.first;
+				} else {
+					writeChunk(xmlChunkedTypeRaw, &chunk[0], rawSize, rawSize);
+				}
+				chunk.clear();
+			}
+
+			void writeVarint(uint32 value) {
+				writeXmlBinaryVarint(chunk, value);
+			}
+
+			void writeString(const string &value) {
+				std::map<string, uint32>::iterator iterFind = stringIndexList.find(value);
+				if (iterFind != stringIndexList.end()) {
+					writeVarint(iterFind->second + 1);
+					return;
+				}
+				uint32 index = (uint32) stringIndexList.size();
+				stringIndexList[value] = index;
+				writeVarint(0);
+				writeVarint((uint32) value.size());
+				chunk.insert(chunk.end(), value.begin(), value.end());
+			}
+
+			void writeNode(const XmlNode *node) {
+				writeString(node->getName());
+				writeString(node->getText());
+
+				writeVarint((uint32) node->getAttributeCount());
+				for (unsigned int i = 0; i < node->getAttributeCount(); ++i) {
+					const XmlAttribute *attribute = node->getAttribute(i);
+					writeString(attribute->getName());
+					writeString(attribute->getValue());
+				}
+
+				if (chunk.size() >= xmlChunkedChunkSize) {
+					flushChunk();
+				}
+
+				writeVarint((uint32) node->getChildCount());
+				for (unsigned int i = 0; i < node->getChildCount(); ++i) {
+					writeNode(node->getChild(i));
+				}
+			}
+
+			void finish() {
+				flushChunk();
+				writeChunk(xmlChunkedTypeEnd, NULL, 0, 0);
+				out.flush();
+			}
+		};
+
+		class XmlChunkedFileReader {
+		private:
+			istream &in;
+			std::vector<char> chunk;
+			size_t offset;
+			bool ended;
+			vector<string> stringList;
+			const std::map<string, string> &mapTagReplacementValues;
+
+			void readChunk() {
+				char header[9];
+				in.read(header, sizeof(header));
+				if (in.gcount() != (streamsize) sizeof(header)) {
+					throw game_runtime_error("Error reading save game file, truncated data");
+				}
+				unsigned char type = static_cast<unsigned char>(header[0]);
+				uint32 rawSize = readXmlChunkedUInt32(&header[1]);
+				uint32 storedSize = readXmlChunkedUInt32(&header[5]);
+
+				chunk.clear();
+				offset = 0;
+				if (type == xmlChunkedTypeEnd) {
+					ended = true;
+					return;
+				}
+				// The writer never produces much more than one chunk at a time
+				if (rawSize > xmlChunkedChunkSize * 4 || storedSize > xmlChunkedChunkSize * 4) {
+					throw game_runtime_error("Error reading save game file, invalid chunk size: " + uIntToStr(rawSize));
+				}
+
+				std::vector<char> stored(storedSize);
+				if (storedSize > 0) {
+					in.read(&stored[0], storedSize);
+					if (in.gcount() != (streamsize) storedSize) {
+						throw game_runtime_error("Error reading save game file, truncated chunk");
+					}
+				}
+
+				if (type == xmlChunkedTypeRaw) {
+					if (rawSize != storedSize) {
+						throw game_runtime_error("Error reading save game file, invalid chunk");
+					}
+					chunk.swap(stored);
+				} else if (type == xmlChunkedTypeCompressed) {
+					std::pair<unsigned char *, unsigned long> extracted =
+						Shared::CompressionUtil::extractMemoryToMemory(
+							reinterpret_cast<unsigned char *>(&stored[0]), storedSize, rawSize);
+					if (extracted.second != rawSize) {
+						delete[] extracted.first;
+						throw game_runtime_error("Error reading save game file, bad compressed chunk");
+					}
+					chunk.assign(extracted.first, extracted.first + extracted.second);
+					delete[] extracted.first;
+				} else {
+					throw game_runtime_error("Error reading save game file, unknown chunk type: " + intToStr(type));
+				}
+			}
+
+			unsigned char readByte() {
+				while (offset >= chunk.size()) {
+					if (ended == true) {
+						throw game_runtime_error("Error reading save game file, unexpected end of data");
+					}
+					readChunk();
+				}
+				return static_cast<unsigned char>(chunk[offset++]);
+			}
+
+		public:
+			uint32 readVarint() {
+				uint32 value = 0;
+				for (int shift = 0; shift < 35; shift += 7) {
+					unsigned char byte = readByte();
+					value |= static_cast<uint32>(byte & 0x7F) << shift;
+					if ((byte & 0x80) == 0) {
+						return value;
+					}
+				}
+				throw game_runtime_error("Error reading save game file, invalid number");
+			}
+
+			const string &readString() {
+				uint32 index = readVarint();
+				if (index > 0) {
+					if (index > stringList.size()) {
+						throw game_runtime_error("Error reading save game file, invalid string index: " + uIntToStr(index));
+					}
+					return stringList[index - 1];
+				}
+
+				uint32 length = readVarint();
+				stringList.push_back(string());
+				string &value = stringList.back();
+				while (length > 0) {
+					if (offset >= chunk.size()) {
+						readByte();
+						offset--;
+					}
+					uint32 available = (uint32) min<size_t>(length, chunk.size() - offset);
+					value.append(&chunk[offset], available);
+					offset += available;
+					length -= available;
+				}
+				return value;
+			}
+
+			XmlChunkedFileReader(istream &in, const std::map<string, string> &mapTagReplacementValues) :
+				in(in), mapTagReplacementValues(mapTagReplacementValues) {
+				offset = 0;
+				ended = false;
+
+				char header[sizeof(xmlChunkedMagic) + 1];
+				in.read(header, sizeof(header));
+				if (in.gcount() != (streamsize) sizeof(header) ||
+					memcmp(header, xmlChunkedMagic, sizeof(xmlChunkedMagic)) != 0) {
+					throw game_runtime_error("Error reading save game file, bad header");
+				}
+				if (header[sizeof(xmlChunkedMagic)] != xmlChunkedVersion) {
+					throw game_runtime_error("Error reading save game file, unsupported version: " + intToStr(header[sizeof(xmlChunkedMagic)]));
+				}
+			}
+
+			void readNodeContent(XmlNode *node, int depth) {
+				if (depth > xmlBinaryMaxDepth) {
+					throw game_runtime_error("Error reading save game file, nodes nested too deep");
+				}
+
+				uint32 attributeCount = readVarint();
+				for (uint32 i = 0; i < attributeCount; ++i) {
+					string name = readString();
+					const string &value = readString();
+					node->addAttribute(name, value, mapTagReplacementValues);
+				}
+
+				uint32 childCount = readVarint();
+				for (uint32 i = 0; i < childCount; ++i) {
+					string name = readString();
+					const string &text = readString();
+					XmlNode *child = node->addChild(name, text);
+					readNodeContent(child, depth + 1);
+				}
+			}
+
+			void checkEnd() {
+				if (offset < chunk.size()) {
+					throw game_runtime_error("Error reading save game file, trailing data");
+				}
+				if (ended == false) {
+					readChunk();
+				}
+				if (ended == false) {
+					throw game_runtime_error("Error reading save game file, missing end marker");
+				}
+			}
+		};
+
+		void XmlTree::saveToChunkedBinaryFile(const string &path, int compressionLevel) const {
+			if (rootNode == NULL) {
+				throw game_runtime_error("Cannot save an empty xml tree");
+			}
+
+#if defined(WIN32) && !defined(__MINGW32__)
+			FILE *fp = _wfopen(utf8_decode(path).c_str(), L"wb");
+			ofstream saveFile(fp);
+#else
+			ofstream saveFile(path.c_str(), ios::binary);
+#endif
+			if (saveFile.is_open() == false) {
+				throw game_runtime_error("Can not open file: [" + path + "]");
+			}
+
+			XmlChunkedFileWriter writer(saveFile, compressionLevel);
+			writer.writeNode(rootNode);
+			writer.finish();
+
+#if defined(WIN32) && !defined(__MINGW32__)
+			if (fp) {
+				fclose(fp);
+			}
+#endif
+		}
+
+		void XmlTree::loadFromChunkedBinaryFile(const string &path, const std::map<string, string> &mapTagReplacementValues) {
+			clearRootNode();
+
+#if defined(WIN32) && !defined(__MINGW32__)
+			FILE *fp = _wfopen(utf8_decode(path).c_str(), L"rb");
+			ifstream loadFile(fp);
+#else
+			ifstream loadFile(path.c_str(), ios::binary);
+#endif
+			if (loadFile.is_open() == false) {
+				throw game_runtime_error("Can not open file: [" + path + "]", true);
+			}
+
+			try {
+				XmlChunkedFileReader reader(loadFile, mapTagReplacementValues);
+				// Copies, the string list may grow while reading the content
+				string name = reader.readString();
+				string text = reader.readString();
+				XmlNode *node = new XmlNode(name);
+				node->text = text;
+				try {
+					reader.readNodeContent(node, 0);
+					reader.checkEnd();
+				} catch (...) {
+					delete node;
+					throw;
+				}
+				this->rootNode = node;
+				this->loadPath = path;
+			} catch (const exception &ex) {
+#if defined(WIN32) && !defined(__MINGW32__)
+				if (fp) {
+					fclose(fp);
+				}
+#endif
+				throw game_runtime_error("Error loading [" + path + "] msg: " + ex.what());
+			}
+
+#if defined(WIN32) && !defined(__MINGW32__)
+			if (fp) {
+				fclose(fp);
+			}
+#endif
+		}
+
+		bool XmlTree::isChunkedBinaryFile(const string &path) {
+#if defined(WIN32) && !defined(__MINGW32__)
+			FILE *fp = _wfopen(utf8_decode(path).c_str(), L"rb");
+			ifstream loadFile(fp);
+#else
+			ifstream loadFile(path.c_str(), ios::binary);
+#endif
+			bool result = false;
+			if (loadFile.is_open() == true) {
+				char header[sizeof(xmlChunkedMagic)];
+				loadFile.read(header, sizeof(header));
+				result = (loadFile.gcount() == (streamsize) sizeof(header) &&
+					memcmp(header, xmlChunkedMagic, sizeof(xmlChunkedMagic)) == 0);
+			}
+#if defined(WIN32) && !defined(__MINGW32__)
+			if (fp) {
+				fclose(fp);
+			}
+#endif
+			return result;
+		}
+
 		void XmlTree::clearRootNode() {
 			if (this->skipStackCheck == false) {
 				LoadStack &loadStack = CacheManager::getCachedItem<LoadStack>(loadStackCacheName);
@@ -676,8 +1310,22 @@ namespace Shared {
 
 			//get name
 			name = node->name();
-			children.reserve(1000);
-			attributes.reserve(1000);
+
+			// Size the lists up front, documents have a lot of small nodes
+			size_t childCount = 0;
+			for (xml_node<> *currentNode = node->first_node();
+				currentNode; currentNode = currentNode->next_sibling()) {
+				if (currentNode->type() == node_element) {
+					childCount++;
+				}
+			}
+			size_t attributeCount = 0;
+			for (xml_attribute<> *attr = node->first_attribute();
+				attr; attr = attr->next_attribute()) {
+				attributeCount++;
+			}
+			children.reserve(childCount);
+			attributes.reserve(attributeCount);
 
 			//check document
 			if (node->type() == node_document) {
@@ -971,13 +1619,12 @@ namespace Shared {
 
 			skipRestrictionCheck = false;
 			usesCommondata = false;
-			this->mapTagReplacementValues = mapTagReplacementValues;
 			char str[strSize] = "";
 
 			XMLString::transcode(attribute->getNodeValue(), str, strSize - 1);
 			value = str;
 			usesCommondata = ((value.find("$COMMONDATAPATH") != string::npos) || (value.find("%%COMMONDATAPATH%%") != string::npos));
-			skipRestrictionCheck = Properties::applyTagsToValue(this->value, &this->mapTagReplacementValues);
+			skipRestrictionCheck = Properties::applyTagsToValue(this->value, &mapTagReplacementValues);
 
 			XMLString::transcode(attribute->getNodeName(), str, strSize - 1);
 			name = str;
@@ -992,15 +1639,12 @@ namespace Shared {
 
 			skipRestrictionCheck = false;
 			usesCommondata = false;
-			if (mapTagReplacementValues.size() > 0) {
-				this->mapTagReplacementValues = mapTagReplacementValues;
-			}
 			//char str[strSize]				= "";
 
 			//XMLString::transcode(attribute->getNodeValue(), str, strSize-1);
 			value = attribute->value();
 			usesCommondata = ((value.find("$COMMONDATAPATH") != string::npos) || (value.find("%%COMMONDATAPATH%%") != string::npos));
-			skipRestrictionCheck = Properties::applyTagsToValue(this->value, &this->mapTagReplacementValues);
+			skipRestrictionCheck = Properties::applyTagsToValue(this->value, &mapTagReplacementValues);
 
 			//XMLString::transcode(attribute->getNodeName(), str, strSize-1);
 			name = attribute->name();
@@ -1009,14 +1653,11 @@ namespace Shared {
 		XmlAttribute::XmlAttribute(const string &name, const string &value, const std::map<string, string> &mapTagReplacementValues) {
 			skipRestrictionCheck = false;
 			usesCommondata = false;
-			if (mapTagReplacementValues.size() > 0) {
-				this->mapTagReplacementValues = mapTagReplacementValues;
-			}
 			this->name = name;
 			this->value = value;
 
 			usesCommondata = ((value.find("$COMMONDATAPATH") != string::npos) || (value.find("%%COMMONDATAPATH%%") != string::npos));
-			skipRestrictionCheck = Properties::applyTagsToValue(this->value, &this->mapTagReplacementValues);
+			skipRestrictionCheck = Properties::applyTagsToValue(this->value, &mapTagReplacementValues);
 		}
 
 		bool XmlAttribute::getBoolValue() const {